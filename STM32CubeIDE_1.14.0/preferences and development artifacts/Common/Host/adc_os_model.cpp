@@ -0,0 +1,119 @@
+/**
+ ******************************************************************************
+ * @file           : adc_os_model.cpp
+ * @brief          : Noise vs throughput of the adc_os profiles (host model)
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/adc_os.c -o adc_os.o
+ *   c++ -O2 -std=c++17 -I../Inc adc_os_model.cpp adc_os.o -o adc_os_model
+ *
+ * Usage:
+ *   adc_os_model [noise_lsb results trigger_hz]
+ *
+ *   noise_lsb   input-referred white noise, 16-bit LSB rms (default 3.0,
+ *               >= 0.5: below that the conversions are not dithered and
+ *               the quantisation terms of the model do not hold)
+ *   results     output samples per profile                 (default 20000)
+ *   trigger_hz  timer trigger of the _TRIG profile         (default 16000)
+ *
+ * Each result holds one input level (uniform over an LSB, redrawn per
+ * result); every conversion adds Gaussian noise and is quantised to 16
+ * bits, and the oversampler sums `ratio` of them and shifts by `shift`,
+ * rounding to nearest. Per profile:
+ *
+ *   rms      output error against the input level, 16-bit LSB
+ *   model    sqrt((noise^2 + 1/12) / ratio + 1/12): averaged input noise
+ *            and conversion quantisation, plus the requantisation of the
+ *            shifted result (none for ratio 1). Once (noise^2 + 1/12) / ratio drops below
+ *            1/12 the last term dominates and more ratio buys < 0.5 bit
+ *   ENOB     16 - log2(rms * sqrt(12)), gain against the table's enob_gain
+ *   S/s      adc_os_rate_mhz at 20 MHz and the TSENSE sampling time
+ *            (trigger / ratio for the _TRIG profile), against the adc_os.h
+ *            table
+ *
+ * Checks: table consistent (shift = log2 ratio, enob_gain = shift / 2),
+ * rms within 5 % of the model, rates within 0.1 % of adc_os.h. Exit
+ * status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "adc_os.h"
+
+namespace {
+
+constexpr uint32_t kAdcHz = 20000000;  // PLL2P, the workspace default
+
+// Output rates from the adc_os.h table, S/s (0: trigger-paced)
+const double kTableSps[ADC_OS_PROFILE_COUNT] = {24420.0, 6105.0, 1526.0, 381.5, 95.4, 0.0};
+
+struct Row {
+  double rms;
+  double model;
+  double enob;
+};
+
+Row Measure(const adc_os_profile_t* p, double noise, uint32_t results, std::mt19937_64* rng) {
+  std::normal_distribution<double> gauss(0.0, noise);
+  std::uniform_real_distribution<double> level(20000.0, 20001.0);
+  double err2 = 0;
+
+  for (uint32_t r = 0; r < results; r++) {
+    double in = level(*rng);
+    uint64_t acc = 0;
+    for (uint32_t i = 0; i < p->ratio; i++) {
+      double v = std::nearbyint(in + gauss(*rng));
+      acc += (uint64_t) (v < 0 ? 0 : (v > 65535 ? 65535 : v));
+    }
+    uint64_t out = (p->shift == 0) ? acc : (acc + (1ULL << (p->shift - 1))) >> p->shift;
+    err2 += ((double) out - in) * ((double) out - in);
+  }
+  Row row;
+  row.rms = std::sqrt(err2 / results);
+  row.model = std::sqrt((noise * noise + 1.0 / 12.0) / p->ratio + (p->shift ? 1.0 / 12.0 : 0.0));
+  row.enob = 16.0 - std::log2(row.rms * std::sqrt(12.0));
+  return row;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  double noise = (argc > 1) ? std::strtod(argv[1], nullptr) : 3.0;
+  uint32_t results = (argc > 2) ? (uint32_t) std::strtoul(argv[2], nullptr, 0) : 20000;
+  uint32_t trig = (argc > 3) ? (uint32_t) std::strtoul(argv[3], nullptr, 0) : 16000;
+  std::mt19937_64 rng(1);
+  bool ok = true;
+  double enob0 = 0;
+
+  if (noise < 0.5 || results < 100 || trig == 0) {
+    std::fprintf(stderr, "usage: adc_os_model [noise_lsb >= 0.5  results >= 100  trigger_hz]\n");
+    return 2;
+  }
+  std::printf("input noise %.2f LSB rms, %u results per profile, f_adc %u Hz\n", noise, results,
+              kAdcHz);
+  std::printf("  profile     ratio shift    rms    model   ENOB  gain (table)        S/s (table)\n");
+  for (int id = 0; id < ADC_OS_PROFILE_COUNT; id++) {
+    const adc_os_profile_t* p = adc_os_profile((adc_os_profile_id_t) id);
+    Row r = Measure(p, noise, results, &rng);
+    double sps = p->per_trigger ? (double) trig / p->ratio
+                                : adc_os_rate_mhz(p, kAdcHz, ADC_OS_TSENSE_HALF_CYCLES) / 1000.0;
+    bool table = (1U << p->shift) == p->ratio && p->enob_gain * 2U == p->shift;
+    bool noise_ok = std::fabs(r.rms / r.model - 1.0) < 0.05;
+    bool rate_ok = p->per_trigger || std::fabs(sps / kTableSps[id] - 1.0) < 1e-3;
+    if (id == ADC_OS_OFF) {
+      enob0 = r.enob;
+    }
+    std::printf("  %-10s %5u %5u  %6.3f  %6.3f  %5.2f  %+5.2f (+%u)  %10.1f (%s)  %s\n", p->name,
+                p->ratio, p->shift, r.rms, r.model, r.enob, r.enob - enob0, p->enob_gain, sps,
+                p->per_trigger ? "trigger / ratio" : "adc_os.h",
+                table && noise_ok && rate_ok ? "ok" : "FAIL");
+    ok = ok && table && noise_ok && rate_ok;
+  }
+  std::printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
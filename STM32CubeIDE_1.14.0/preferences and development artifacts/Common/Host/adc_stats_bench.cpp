@@ -0,0 +1,316 @@
+/**
+ ******************************************************************************
+ * @file           : adc_stats_bench.cpp
+ * @brief          : adc_stats kernel and merge checks, portable vs packed path
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/adc_stats.c -o adc_stats.o
+ *   c++ -O2 -std=c++17 -I../Inc adc_stats_bench.cpp adc_stats.o -o adc_stats_bench
+ *
+ * Usage:
+ *   adc_stats_bench [samples]          timing trace length (default 1M)
+ *
+ * adc_stats.o is the portable path. The packed path (USUB16 + SEL,
+ * SMLAD, SMLALD) is adc_stats.c compiled a second time inside this file,
+ * with ADC_STATS_USE_SIMD forced on and bit-exact C models of the
+ * instructions, GE flags included.
+ *
+ * Checks:
+ *   scan    portable vs packed adc_stats_scan, every field equal: random
+ *           blocks of 0 .. ADC_STATS_CHUNK codes (odd tails included) and
+ *           the corner blocks (all 0, all 65535, alternating, ramps)
+ *   merge   adc_stats_push_block of random block sizes (some past
+ *           ADC_STATS_CHUNK) against a two-pass long double reference over
+ *           the whole trace: count / min / max exact, mean within 1e-9
+ *           codes, variance within 1e-9 relative; EMA against the block
+ *           means; both paths
+ *
+ * Timing (ns/sample on this host): per-sample Welford, portable scan +
+ * merge, packed models (not representative of the M7). Exit status 1
+ * when a check fails.
+ ******************************************************************************
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "adc_stats.h"
+
+// Bit-exact models of the instructions the packed kernel uses
+static uint32_t g_ge;  // APSR.GE, one bit per byte lane as on the core
+
+static uint32_t Usub16(uint32_t a, uint32_t b) {
+  uint32_t r = 0;
+  g_ge = 0;
+  for (int lane = 0; lane < 2; lane++) {
+    uint32_t x = (a >> (16 * lane)) & 0xFFFFU;
+    uint32_t y = (b >> (16 * lane)) & 0xFFFFU;
+    if (x >= y) {
+      g_ge |= 3U << (2 * lane);
+    }
+    r |= ((x - y) & 0xFFFFU) << (16 * lane);
+  }
+  return r;
+}
+
+static uint32_t Sel(uint32_t a, uint32_t b) {
+  uint32_t r = 0;
+  for (int byte = 0; byte < 4; byte++) {
+    uint32_t m = 0xFFU << (8 * byte);
+    r |= ((g_ge >> byte) & 1U) ? (a & m) : (b & m);
+  }
+  return r;
+}
+
+static int32_t __smlad(uint32_t a, uint32_t b, int32_t acc) {
+  int32_t p = (int32_t) (int16_t) a * (int16_t) b + (int32_t) (int16_t) (a >> 16) * (int16_t) (b >> 16);
+  return (int32_t) ((uint32_t) acc + (uint32_t) p);  // wraps, Q flag not modelled
+}
+
+static int64_t __smlald(uint32_t a, uint32_t b, int64_t acc) {
+  return acc + (int64_t) (int16_t) a * (int16_t) b + (int64_t) (int16_t) (a >> 16) * (int16_t) (b >> 16);
+}
+
+// the asm helpers of adc_stats.c: USUB16 then SEL on its GE flags
+static uint32_t adc_stats_min16(uint32_t a, uint32_t b) {
+  (void) Usub16(a, b);
+  return Sel(b, a);
+}
+
+static uint32_t adc_stats_max16(uint32_t a, uint32_t b) {
+  (void) Usub16(a, b);
+  return Sel(a, b);
+}
+
+// adc_stats.c again, packed path, public names prefixed with dsp_
+#define ADC_STATS_USE_SIMD 1
+#define ADC_STATS_DSP_MODELS 1
+#define adc_stats_init dsp_adc_stats_init
+#define adc_stats_scan dsp_adc_stats_scan
+#define adc_stats_push_block dsp_adc_stats_push_block
+#define adc_stats_snapshot dsp_adc_stats_snapshot
+#define adc_stats_merge dsp_adc_stats_merge
+#include "../Src/adc_stats.c"
+#undef adc_stats_init
+#undef adc_stats_scan
+#undef adc_stats_push_block
+#undef adc_stats_snapshot
+#undef adc_stats_merge
+#undef ADC_STATS_USE_SIMD
+#undef ADC_STATS_BARRIER
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool Same(const adc_stats_block_t& a, const adc_stats_block_t& b) {
+  return a.n == b.n && a.sum_c == b.sum_c && a.sumsq_c == b.sumsq_c && a.min == b.min &&
+         a.max == b.max;
+}
+
+bool CheckScan(std::mt19937* rng) {
+  std::vector<uint16_t> x(ADC_STATS_CHUNK + 1);
+  uint32_t bad = 0, runs = 0;
+
+  auto one = [&](uint32_t n, uint32_t off) {
+    adc_stats_block_t p, d;
+    adc_stats_scan(&x[off], n, &p);
+    dsp_adc_stats_scan(&x[off], n, &d);
+    runs++;
+    if (!Same(p, d)) {
+      if (bad++ < 5) {
+        std::printf("    n %u: portable sum %d sq %lld min %u max %u, packed %d %lld %u %u\n", n,
+                    p.sum_c, (long long) p.sumsq_c, p.min, p.max, d.sum_c,
+                    (long long) d.sumsq_c, d.min, d.max);
+      }
+    }
+  };
+
+  // corner blocks at full length and with an odd tail
+  const uint32_t kFill[] = {0, 65535, 32768, 32767};
+  for (uint32_t f : kFill) {
+    std::fill(x.begin(), x.end(), (uint16_t) f);
+    one(ADC_STATS_CHUNK, 0);
+    one(ADC_STATS_CHUNK - 1, 1);
+  }
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = (i & 1) ? 65535 : 0;
+  }
+  one(ADC_STATS_CHUNK, 0);
+  one(ADC_STATS_CHUNK - 1, 1);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = (uint16_t) (i * 16);
+  }
+  one(ADC_STATS_CHUNK, 0);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = (uint16_t) (65535 - i * 16);
+  }
+  one(ADC_STATS_CHUNK, 0);
+  one(0, 0);
+  one(1, 0);
+
+  std::uniform_int_distribution<uint32_t> len(0, ADC_STATS_CHUNK);
+  std::uniform_int_distribution<uint32_t> code(0, 65535);
+  std::normal_distribution<double> noisy(20000.0, 300.0);
+  for (int r = 0; r < 2000; r++) {
+    bool wide = r & 1;
+    for (auto& v : x) {
+      v = wide ? (uint16_t) code(*rng) : (uint16_t) std::fmin(std::fmax(noisy(*rng), 0), 65535);
+    }
+    uint32_t n = len(*rng);
+    one(n, (n < ADC_STATS_CHUNK) ? (uint32_t) (r & 1) : 0);
+  }
+  std::printf("  scan   portable vs packed: %u blocks, %u differ  %s\n", runs, bad,
+              bad == 0 ? "ok" : "FAIL");
+  return bad == 0;
+}
+
+template <typename Init, typename Push, typename Snap>
+bool CheckMerge(const char* name, Init init, Push push, Snap snap, std::mt19937* rng) {
+  bool ok = true;
+  double worst_mean = 0, worst_var = 0, worst_ema = 0;
+
+  for (int trial = 0; trial < 50; trial++) {
+    std::normal_distribution<double> noisy(1000.0 + 1200.0 * trial, 5.0 + 40.0 * (trial % 7));
+    std::uniform_int_distribution<uint32_t> len(1, (trial % 5 == 0) ? 3 * ADC_STATS_CHUNK : 200);
+    std::vector<uint16_t> all;
+    std::vector<double> means;
+    adc_stats_t s;
+    uint8_t shift = (uint8_t) (trial % 6);
+    init(&s, shift);
+    for (int b = 0; b < 300; b++) {
+      uint32_t n = len(*rng);
+      size_t at = all.size();
+      double sum = 0;
+      for (uint32_t i = 0; i < n; i++) {
+        double v = std::nearbyint(noisy(*rng) + 50.0 * std::sin(b * 0.05));
+        all.push_back((uint16_t) std::fmin(std::fmax(v, 0), 65535));
+      }
+      push(&s, &all[at], n);
+      // push_block splits past ADC_STATS_CHUNK: one EMA step per chunk
+      for (uint32_t c = 0; c < n; c += ADC_STATS_CHUNK) {
+        uint32_t m = std::min<uint32_t>(ADC_STATS_CHUNK, n - c);
+        sum = 0;
+        for (uint32_t i = 0; i < m; i++) {
+          sum += all[at + c + i];
+        }
+        means.push_back(sum / m);
+      }
+    }
+
+    long double mean = 0, m2 = 0;
+    uint16_t lo = 65535, hi = 0;
+    for (uint16_t v : all) {
+      mean += v;
+      lo = std::min(lo, v);
+      hi = std::max(hi, v);
+    }
+    mean /= (long double) all.size();
+    for (uint16_t v : all) {
+      m2 += ((long double) v - mean) * ((long double) v - mean);
+    }
+    long double var = m2 / (long double) (all.size() - 1);
+    double ema = means[0];
+    for (size_t i = 1; i < means.size(); i++) {
+      ema += (means[i] - ema) / (double) (1UL << shift);
+    }
+
+    adc_stats_snapshot_t st;
+    snap(&s, &st);
+    double dm = std::fabs(st.mean - (double) mean);
+    double dv = std::fabs(adc_stats_variance(&st) / (double) var - 1.0);
+    double de = std::fabs(st.ema - ema);
+    worst_mean = std::fmax(worst_mean, dm);
+    worst_var = std::fmax(worst_var, dv);
+    worst_ema = std::fmax(worst_ema, de);
+    if (st.count != all.size() || st.blocks != means.size() || st.min != lo || st.max != hi ||
+        dm > 1e-9 || dv > 1e-9 || de > 1e-9) {
+      ok = false;
+    }
+  }
+  std::printf("  merge  %-8s 50 traces: mean %.1e codes, variance %.1e rel, EMA %.1e  %s\n", name,
+              worst_mean, worst_var, worst_ema, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+volatile double g_sink;  // keeps the timed loops from being optimised away
+
+template <typename F>
+double NsPerSample(size_t n, F&& f) {
+  uint64_t reps = 0;
+  auto t0 = Clock::now();
+  std::chrono::duration<double> dt{};
+  do {
+    f();
+    reps++;
+    dt = Clock::now() - t0;
+  } while (dt.count() < 0.2);
+  return dt.count() * 1e9 / ((double) reps * (double) n);
+}
+
+void Bench(size_t n, std::mt19937* rng) {
+  constexpr uint32_t kBlock = 64;  // ADC_STREAM_BLOCK_LEN
+  std::normal_distribution<double> noisy(20000.0, 30.0);
+  std::vector<uint16_t> x(n);
+  for (auto& v : x) {
+    v = (uint16_t) std::nearbyint(noisy(*rng));
+  }
+
+  double welford = NsPerSample(n, [&] {
+    double mean = 0, m2 = 0;
+    for (size_t i = 0; i < n; i++) {
+      double d = x[i] - mean;
+      mean += d / (double) (i + 1);
+      m2 += d * (x[i] - mean);
+    }
+    g_sink = g_sink + m2;
+  });
+  adc_stats_t s;
+  double portable = NsPerSample(n, [&] {
+    adc_stats_init(&s, 4);
+    for (size_t i = 0; i + kBlock <= n; i += kBlock) {
+      adc_stats_push_block(&s, &x[i], kBlock);
+    }
+    g_sink = g_sink + s.st.m2;
+  });
+  double packed = NsPerSample(n, [&] {
+    dsp_adc_stats_init(&s, 4);
+    for (size_t i = 0; i + kBlock <= n; i += kBlock) {
+      dsp_adc_stats_push_block(&s, &x[i], kBlock);
+    }
+    g_sink = g_sink + s.st.m2;
+  });
+
+  std::printf("\n%zu samples in blocks of %u, ns/sample:\n", n, kBlock);
+  std::printf("  per-sample Welford        %6.2f\n", welford);
+  std::printf("  adc_stats portable        %6.2f  (%.2fx)\n", portable, welford / portable);
+  std::printf("  adc_stats packed models   %6.2f  (C models, not representative)\n", packed);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t n = (argc > 1) ? (size_t) std::strtoul(argv[1], nullptr, 0) : (1U << 20);
+  std::mt19937 rng(7);
+  bool ok = true;
+
+  if (n < 64) {
+    std::fprintf(stderr, "usage: adc_stats_bench [samples >= 64]\n");
+    return 2;
+  }
+  std::printf("adc_stats checks:\n");
+  ok = CheckScan(&rng) && ok;
+  ok = CheckMerge("portable", adc_stats_init, adc_stats_push_block, adc_stats_snapshot, &rng) && ok;
+  ok = CheckMerge("packed", dsp_adc_stats_init, dsp_adc_stats_push_block, dsp_adc_stats_snapshot,
+                  &rng) && ok;
+  Bench(n, &rng);
+  std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
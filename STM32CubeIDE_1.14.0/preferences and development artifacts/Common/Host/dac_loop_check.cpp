@@ -0,0 +1,332 @@
+/**
+ ******************************************************************************
+ * @file           : dac_loop_check.cpp
+ * @brief          : dac_loop analysis against synthetic loopback captures
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/dac_loop.c
+ *   c++ -O2 -std=c++17 -I../Inc dac_loop_check.cpp dac_loop.o -lm \
+ *       -o dac_loop_check
+ *
+ * Usage:
+ *   dac_loop_check [-n chains] [-s seed]
+ *
+ * A chain model stands in for DAC1 -> ADC2: gain, offset, a parabolic
+ * bow (INL), Gaussian noise, 12-bit rounding; for the step a pure delay
+ * plus a first-order settling (tau) sampled once per trigger, and DWT
+ * stamps of both DMA interrupts with entry jitter. Per random chain
+ * (-n, default 2000):
+ *   - fit: gain / offset / INL equal a double least-squares fit of the
+ *     same means (within the Q16 / Q8 rounding), and the chain's true
+ *     values within the noise of the averaged captures
+ *   - step: edge equals the double interpolation of the same capture
+ *     (1/256 sample), latency within the interpolation bias of the true
+ *     crossing, dma_cycles within the stamp jitter
+ * Then one chain per failure (gain, offset, INL, no step, late step,
+ * single code) must set exactly its DAC_LOOP_FAIL_* bit, a nominal one
+ * none. Exit status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "dac_loop.h"
+
+namespace {
+
+constexpr uint32_t kSteps = 17;     // SineWaveVoltageOutput LOOP_STEPS
+constexpr uint32_t kAvg = 64;       // samples averaged per step
+constexpr uint32_t kCap = 128;      // step capture
+constexpr uint32_t kStepAt = 64;    // DAC element of the step (half)
+constexpr uint32_t kCps = 250;      // 64 MHz / 256 kHz
+constexpr uint16_t kLo = 1024, kHi = 3072;      // step
+constexpr uint16_t kFirst = 256, kLast = 3840;  // staircase, off the rails
+
+struct Chain {
+  double gain = 1.0;
+  double offset = 0.0;   // LSB
+  double bow = 0.0;      // LSB at mid-scale, 0 at the ends
+  double noise = 1.0;    // LSB rms
+  double delay = 1.3;    // samples, step element -> output starts moving
+  double tau = 0.4;      // samples
+  double jitter = 12;    // DWT cycles, interrupt entry
+  bool step = true;
+};
+
+std::mt19937 g_rng;
+
+double Transfer(const Chain& c, double code) {
+  double u = code / 4095.0;
+  return c.offset + c.gain * code + c.bow * 4.0 * u * (1.0 - u);
+}
+
+uint16_t Adc(double v, const Chain& c) {
+  std::normal_distribution<double> n(0.0, c.noise);
+  double q = std::nearbyint(v + n(g_rng));
+  return (uint16_t) (q < 0.0 ? 0.0 : (q > 4095.0 ? 4095.0 : q));
+}
+
+double Output(const Chain& c, double t) {
+  double t0 = kStepAt + c.delay;
+  if (!c.step || t < t0) {
+    return Transfer(c, kLo);
+  }
+  double lo = Transfer(c, kLo);
+  return lo + (Transfer(c, kHi) - lo) * (1.0 - std::exp(-(t - t0) / c.tau));
+}
+
+struct Run {
+  dac_loop_result_t r{};
+  std::vector<dac_loop_point_t> pts;
+  std::vector<uint16_t> cap;
+  uint32_t t_dac = 0, t_adc = 0;
+  double true_cross = 0;  // samples
+};
+
+Run Measure(const Chain& c, uint32_t steps = kSteps, uint16_t lo = kFirst, uint16_t hi = kLast) {
+  Run run;
+  std::vector<uint16_t> buf(kAvg);
+  std::normal_distribution<double> jit(0.0, c.jitter);
+
+  for (uint32_t k = 0; k < steps; k++) {
+    uint16_t code = dac_loop_code(k, steps, lo, hi);
+    for (uint32_t i = 0; i < kAvg; i++) {
+      buf[i] = Adc(Transfer(c, code), c);
+    }
+    run.pts.push_back({code, dac_loop_mean_q8(buf.data(), kAvg)});
+  }
+  (void) dac_loop_fit(run.pts.data(), (uint32_t) run.pts.size(), &run.r);
+
+  run.cap.resize(kCap);
+  for (uint32_t j = 0; j < kCap; j++) {
+    run.cap[j] = Adc(Output(c, j), c);
+  }
+  // trigger 0 at DWT 1e6; interrupts a fixed entry time plus jitter later
+  uint32_t t0 = 1000000U;
+  run.t_dac = t0 + (kStepAt - 1U) * kCps + 40U + (uint32_t) std::fabs(jit(g_rng));
+  run.t_adc = t0 + (kCap - 1U) * kCps + 40U + (uint32_t) std::fabs(jit(g_rng));
+  run.true_cross = kStepAt + c.delay + c.tau * std::log(2.0);
+  dac_loop_latency(&run.r, dac_loop_edge_q8(run.cap.data(), kCap, kLo, kHi), kStepAt, kCps,
+                   run.t_dac, run.t_adc, kCap - 1U);
+  return run;
+}
+
+struct Worst {
+  double gain_fit = 0, offset_fit = 0, inl_fit = 0;  // vs double fit, Q16 / Q8 units
+  double gain_true = 0, offset_true = 0, inl_true = 0;  // vs chain, sigma of a mean
+  double edge = 0, lat = 0, dma = 0;
+};
+
+// Least squares in double
+void DoubleFit(const std::vector<double>& x, const std::vector<double>& y, double& g, double& o,
+               double& inl) {
+  double n = (double) x.size(), sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (size_t i = 0; i < x.size(); i++) {
+    sx += x[i];
+    sy += y[i];
+    sxx += x[i] * x[i];
+    sxy += x[i] * y[i];
+  }
+  g = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+  o = (sy - g * sx) / n;
+  inl = 0;
+  for (size_t i = 0; i < x.size(); i++) {
+    inl = std::fmax(inl, std::fabs(y[i] - (o + g * x[i])));
+  }
+}
+
+// ... of the same averaged points
+void DoubleFit(const std::vector<dac_loop_point_t>& p, double& g, double& o, double& inl) {
+  std::vector<double> x, y;
+  for (const auto& q : p) {
+    x.push_back(q.dac);
+    y.push_back(q.adc_q8 / 256.0);
+  }
+  DoubleFit(x, y, g, o, inl);
+}
+
+// ... of the noise-free chain: what the fit should find
+void TrueFit(const Chain& c, double& g, double& o, double& inl) {
+  std::vector<double> x, y;
+  for (uint32_t k = 0; k < kSteps; k++) {
+    x.push_back(dac_loop_code(k, kSteps, kFirst, kLast));
+    y.push_back(Transfer(c, x.back()));
+  }
+  DoubleFit(x, y, g, o, inl);
+}
+
+double EdgeDouble(const std::vector<uint16_t>& cap) {
+  double mid = (kLo + kHi) / 2.0;
+  for (size_t i = 1; i < cap.size(); i++) {
+    if (cap[i] >= mid) {
+      return (double) (i - 1) + (mid - cap[i - 1]) / (double) (cap[i] - cap[i - 1]);
+    }
+  }
+  return -1;
+}
+
+bool Random(uint32_t chains) {
+  std::uniform_real_distribution<double> gain(0.98, 1.02), off(-15.0, 15.0), bow(-4.0, 4.0),
+      noise(0.3, 3.0), delay(0.2, 2.5), tau(0.1, 0.8);
+  Worst w;
+  bool ok = true;
+
+  for (uint32_t i = 0; i < chains; i++) {
+    Chain c;
+    c.gain = gain(g_rng);
+    c.offset = off(g_rng);
+    c.bow = bow(g_rng);
+    c.noise = noise(g_rng);
+    c.delay = delay(g_rng);
+    c.tau = tau(g_rng);
+    Run run = Measure(c);
+    double g, o, inl, tg, to, tinl;
+    DoubleFit(run.pts, g, o, inl);
+    TrueFit(c, tg, to, tinl);
+
+    w.gain_fit = std::fmax(w.gain_fit, std::fabs(run.r.gain_q16 - g * 65536.0));
+    w.offset_fit = std::fmax(w.offset_fit, std::fabs(run.r.offset_q8 - o * 256.0));
+    w.inl_fit = std::fmax(w.inl_fit, std::fabs(run.r.inl_q8 - inl * 256.0));
+    // in units of the noise of a kAvg mean (gain: over the full scale)
+    double sigma = c.noise / std::sqrt((double) kAvg);
+    w.gain_true =
+        std::fmax(w.gain_true, std::fabs(run.r.gain_q16 / 65536.0 - tg) * 4095.0 / sigma);
+    w.offset_true = std::fmax(w.offset_true, std::fabs(run.r.offset_q8 / 256.0 - to) / sigma);
+    w.inl_true = std::fmax(w.inl_true, std::fabs(run.r.inl_q8 / 256.0 - tinl) / sigma);
+
+    double e = EdgeDouble(run.cap);
+    w.edge = std::fmax(w.edge, std::fabs(run.r.lat_q8 / 256.0 + kStepAt - e));
+    w.lat = std::fmax(w.lat, std::fabs(run.r.lat_q8 / 256.0 + kStepAt - run.true_cross));
+    double dma_true = (double) (int32_t) (run.t_adc - run.t_dac) - (kCap - 1U - e) * kCps;
+    w.dma = std::fmax(w.dma, std::fabs(run.r.dma_cycles - dma_true));
+  }
+
+  auto row = [&ok](const char* what, double got, double limit, const char* unit) {
+    bool row_ok = got <= limit;
+    std::printf("  %-38s %8.3f %-10s (limit %6.3f)  %s\n", what, got, unit, limit,
+                row_ok ? "ok" : "FAIL");
+    ok = ok && row_ok;
+  };
+  std::printf("random chains: %u (gain 0.98..1.02, offset +/-15, bow +/-4 LSB, noise 0.3..3 "
+              "LSB rms,\n  delay 0.2..2.5, tau 0.1..0.8 samples, %u steps x %u samples)\n",
+              chains, kSteps, kAvg);
+  // gain: rounded once; offset / INL: plus the gain rounding over x <= 4095
+  row("gain vs double fit", w.gain_fit, 0.5 + 1e-6, "Q16");
+  row("offset vs double fit", w.offset_fit, 0.5 + 0.5 * 4095.0 / 256.0, "1/256 LSB");
+  row("INL vs double fit", w.inl_fit, 1.0 + 0.5 * 4095.0 / 256.0, "1/256 LSB");
+  // statistical: a few sigma of the per-step mean
+  row("gain vs chain", w.gain_true, 6.0, "sigma");
+  row("offset vs chain", w.offset_true, 6.0, "sigma");
+  row("INL vs chain", w.inl_true, 6.0, "sigma");
+  row("edge vs double interpolation", w.edge, 1.0 / 256.0, "samples");
+  // linear interpolation of an exponential: at most tau x ln2 early/late
+  row("latency vs true crossing", w.lat, 0.8 * std::log(2.0) + 0.05, "samples");
+  row("dma_cycles vs stamps", w.dma, kCps / 256.0 + 1.0, "cycles");
+  return ok;
+}
+
+bool Expect(const char* what, const Run& run, uint32_t want) {
+  dac_loop_limits_t lim = DAC_LOOP_LIMITS_DEFAULT;
+  dac_loop_result_t r = run.r;
+  uint32_t got = dac_loop_check(&r, &lim);
+  bool ok = got == want;
+  std::printf("  %-22s gain %7.4f offset %+7.2f INL %5.2f LSB lat %5.2f samples (%4d cyc, "
+              "DMA %5d cyc) fails 0x%02x  %s\n",
+              what, r.gain_q16 / 65536.0, r.offset_q8 / 256.0, r.inl_q8 / 256.0, r.lat_q8 / 256.0,
+              r.lat_cycles, r.dma_cycles, got, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+bool Limits() {
+  Chain nominal;
+  nominal.gain = 0.996;
+  nominal.offset = 3.2;
+  nominal.bow = 1.5;
+  bool ok = true;
+
+  std::printf("\nlimits (DAC_LOOP_LIMITS_DEFAULT):\n");
+  ok = Expect("nominal", Measure(nominal), 0) && ok;
+  Chain c = nominal;
+  c.gain = 0.97;
+  ok = Expect("gain 0.97", Measure(c), DAC_LOOP_FAIL_GAIN) && ok;
+  c = nominal;
+  c.offset = -25.0;
+  ok = Expect("offset -25 LSB", Measure(c), DAC_LOOP_FAIL_OFFSET) && ok;
+  c = nominal;
+  c.bow = 16.0;
+  ok = Expect("bow 16 LSB", Measure(c), DAC_LOOP_FAIL_INL) && ok;
+  c = nominal;
+  c.step = false;
+  ok = Expect("no step", Measure(c), DAC_LOOP_FAIL_EDGE) && ok;
+  c = nominal;
+  c.delay = 6.0;
+  ok = Expect("step 6 samples late", Measure(c), DAC_LOOP_FAIL_LATENCY) && ok;
+  ok = Expect("one code", Measure(nominal, kSteps, 2048, 2048), DAC_LOOP_FAIL_FIT) && ok;
+
+  // falling step: same crossing, mirrored search
+  std::vector<uint16_t> down(kCap);
+  for (uint32_t j = 0; j < kCap; j++) {
+    down[j] = (uint16_t) (kLo + kHi - Adc(Output(nominal, j), Chain{}));
+  }
+  int32_t e = dac_loop_edge_q8(down.data(), kCap, kHi, kLo);
+  double want = kStepAt + nominal.delay + nominal.tau * std::log(2.0);
+  bool fall_ok = e >= 0 && std::fabs(e / 256.0 - want) < 0.5;
+  std::printf("  %-22s edge %.3f samples, true crossing %.3f  %s\n", "falling step", e / 256.0,
+              want, fall_ok ? "ok" : "FAIL");
+  return ok && fall_ok;
+}
+
+void Cost() {
+  Chain c;
+  Run run = Measure(c);
+  std::vector<uint16_t> buf(kAvg, 2048);
+  volatile uint32_t sink = 0;
+  const int reps = 20000;
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; i++) {
+    dac_loop_result_t r{};
+    for (uint32_t k = 0; k < kSteps; k++) {
+      buf[k] = (uint16_t) (buf[k] + 1U);
+      run.pts[k].adc_q8 = dac_loop_mean_q8(buf.data(), kAvg) + k;
+    }
+    dac_loop_fit(run.pts.data(), kSteps, &r);
+    dac_loop_latency(&r, dac_loop_edge_q8(run.cap.data(), kCap, kLo, kHi), kStepAt, kCps,
+                     run.t_dac, run.t_adc, kCap - 1U);
+    sink = sink + r.inl_q8;
+  }
+  std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+  std::printf("\nanalysis cost on this host: %.2f us per self-test (%u means of %u, fit, edge)\n",
+              dt.count() * 1e6 / reps, kSteps, kAvg);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t chains = 2000;
+  uint32_t seed = 1;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "-n") == 0) {
+      chains = (uint32_t) std::strtoul(argv[i + 1], nullptr, 0);
+    } else if (std::strcmp(argv[i], "-s") == 0) {
+      seed = (uint32_t) std::strtoul(argv[i + 1], nullptr, 0);
+    } else {
+      std::fprintf(stderr, "usage: dac_loop_check [-n chains] [-s seed]\n");
+      return 2;
+    }
+  }
+  g_rng.seed(seed);
+  bool ok = Random(chains);
+  ok = Limits() && ok;
+  Cost();
+  std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+/**
+ ******************************************************************************
+ * @file           : dac_stream_sim.cpp
+ * @brief          : dac_stream against a simulated ADC -> main loop -> DAC chain
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/dac_stream.c -o dac_stream.o
+ *   cc  -O2 -I../Inc -c ../Src/adc_stream.c -o adc_stream.o
+ *   c++ -O2 -std=c++17 -I../Inc dac_stream_sim.cpp dac_stream.o adc_stream.o -o dac_stream_sim
+ *
+ * Usage:
+ *   dac_stream_sim [blocks work jitter]
+ *
+ *   blocks  ADC blocks simulated                          (default 1000)
+ *   work    main-loop cycles to fill one DAC half         (default 20000)
+ *   jitter  ISR entry delay, 0 .. jitter cycles, random   (default 0)
+ *
+ * The temp_h7_cm7_dma timing at 64 MHz: ADC3 and TIM7 both at 1 kS/s
+ * (64000 cycles per sample), ADC_STREAM_BLOCK_LEN samples per half, TIM7
+ * started half a block into ADC block 0 (DAC_Output_Start). The ADC half
+ * callbacks stamp the cycle counter and post to adc_stream. The main loop
+ * polls adc_stream; its block callback acquires the idle DAC half, writes
+ * one code per `work / N` cycles and commits the half with the ADC stamp.
+ * The DAC DMA takes one code per TIM7 trigger from the circular buffer and
+ * calls dac_stream_half_isr / dac_stream_full_isr at the half boundaries.
+ *
+ * Every code carries its block and sample index, so each played half is
+ * classified: whole and next in order, a repeat of an old block (stale), a
+ * mix of blocks (torn), or a block skipped. After the configuration given,
+ * work is swept from 0.25 to 1.5 times the N/2-sample deadline.
+ *
+ * Checks per run: within the deadline every half after the first is the
+ * next block, whole, with no underrun or late commit, and the latency
+ * histogram holds the single value N/2 sample periods + the TIM7 start
+ * offset (spread <= 2 x jitter). Past the deadline, every stale, torn or
+ * skipped half is covered by an underrun or a late commit: nothing bad goes
+ * uncounted. A late commit may still have won the race against the DMA
+ * reading the half, so the flags can outnumber the bad halves.
+ * Exit status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "adc_stream.h"
+#include "dac_stream.h"
+
+namespace {
+
+constexpr uint64_t kCoreHz = 64000000;
+constexpr uint64_t kPeriod = 64000;        // 1 kS/s, ADC and DAC
+constexpr uint32_t kN = ADC_STREAM_BLOCK_LEN;
+constexpr uint64_t kStartOffset = 100;     // TIM7 start after NDTR <= 1.5 N
+constexpr uint32_t kEmpty = UINT32_MAX;
+
+struct Sim {
+  uint64_t now = 0;
+  uint64_t work = 0;
+  uint32_t jitter = 0;
+  uint32_t lcg = 1;
+  // ADC
+  uint64_t adc_done = 0;                  // samples converted
+  std::vector<uint16_t> adc_buf;
+  uint32_t adc_stamp[2] = {0, 0};
+  adc_stream_t in;
+  // DAC
+  uint64_t dac_t0 = 0;                    // TIM7 start
+  uint64_t dac_done = 0;                  // codes taken by the DMA
+  std::vector<uint32_t> dac_buf;          // block << 16 | sample
+  dac_stream_t out;
+  // played halves
+  std::vector<uint32_t> half_seen;        // codes of the half playing
+  int64_t last_block = -1;
+  uint64_t halves = 0;
+  uint64_t in_order = 0;
+  uint64_t stale = 0;
+  uint64_t torn = 0;
+  uint64_t skipped = 0;
+  uint64_t block = 0;                     // next block index from the ADC
+};
+
+Sim g;
+
+uint32_t Jitter() {
+  if (g.jitter == 0U) {
+    return 0;
+  }
+  g.lcg = g.lcg * 1664525U + 1013904223U;
+  return (g.lcg >> 8) % (g.jitter + 1U);
+}
+
+// Classify the half that just finished playing
+void CloseHalf() {
+  const std::vector<uint32_t>& h = g.half_seen;
+  g.halves++;
+  if (h[0] == kEmpty) {
+    return;  // zeros before the first commit, not counted by dac_stream either
+  }
+  uint32_t b = h[0] >> 16;
+  bool whole = true;
+  for (uint32_t i = 0; i < kN; i++) {
+    whole = whole && h[i] == ((b << 16) | i);
+  }
+  if (!whole) {
+    g.torn++;
+  } else if ((int64_t) b <= g.last_block) {
+    g.stale++;
+  } else {
+    g.skipped += (uint64_t) ((int64_t) b - g.last_block - 1);
+    g.in_order++;
+    g.last_block = b;
+  }
+}
+
+// ADC samples, DAC triggers and their interrupts up to cycle `until`
+void AdvanceTo(uint64_t until) {
+  for (;;) {
+    uint64_t adc_due = (g.adc_done + 1) * kPeriod;
+    uint64_t dac_due = g.dac_t0 + (g.dac_done + 1) * kPeriod;
+    uint64_t due = (adc_due < dac_due) ? adc_due : dac_due;
+    if (due > until) {
+      break;
+    }
+    g.now = due;
+    if (due == adc_due) {
+      uint32_t slot = (uint32_t) (g.adc_done % (2U * kN));
+      g.adc_buf[slot] = (uint16_t) g.adc_done;
+      g.adc_done++;
+      if (g.adc_done % kN == 0) {
+        uint32_t half = (slot == kN - 1U) ? 0U : 1U;
+        g.adc_stamp[half] = (uint32_t) (g.now + Jitter());
+        if (half == 0U) {
+          adc_stream_half_isr(&g.in);
+        } else {
+          adc_stream_full_isr(&g.in);
+        }
+      }
+    } else {
+      uint32_t slot = (uint32_t) (g.dac_done % (2U * kN));
+      g.half_seen[slot % kN] = g.dac_buf[slot];
+      g.dac_done++;
+      if (g.dac_done % kN == 0) {
+        CloseHalf();
+        uint32_t stamp = (uint32_t) (g.now + Jitter());
+        if (slot == kN - 1U) {
+          dac_stream_half_isr(&g.out, stamp);  // half 1 starts
+        } else {
+          dac_stream_full_isr(&g.out, stamp);  // half 0 starts
+        }
+      }
+    }
+  }
+  if (g.now < until) {
+    g.now = until;
+  }
+}
+
+// ADC_ProcessBlock, DAC part
+void OnBlock(const uint16_t* block, uint32_t len, void* ctx) {
+  (void) ctx;
+  uint32_t in = (block == g.adc_buf.data()) ? 0U : 1U;
+  uint32_t b = (uint32_t) (g.block++);
+  uint32_t half = dac_stream_acquire(&g.out);
+  uint64_t t0 = g.now;
+  for (uint32_t i = 0; i < len; i++) {
+    AdvanceTo(t0 + g.work * (i + 1U) / len);
+    g.dac_buf[half * kN + i] = (b << 16) | i;
+  }
+  dac_stream_commit(&g.out, half, g.adc_stamp[in]);
+}
+
+bool Run(const char* name, uint64_t blocks, uint64_t work, uint32_t jitter) {
+  g = Sim();
+  g.work = work;
+  g.jitter = jitter;
+  g.adc_buf.assign(2U * kN, 0);
+  g.dac_buf.assign(2U * kN, kEmpty);
+  g.half_seen.assign(kN, kEmpty);
+  g.dac_t0 = kN / 2U * kPeriod + kStartOffset;
+  adc_stream_init(&g.in, g.adc_buf.data(), kN, OnBlock, nullptr);
+  dac_stream_init(&g.out, kN, (uint32_t) (kCoreHz / 100000U));
+
+  uint64_t end = (blocks + 1U) * kN * kPeriod + kStartOffset;
+  while (g.now < end) {
+    if (adc_stream_poll(&g.in) == 0 && !adc_stream_pending(&g.in)) {
+      AdvanceTo(((g.adc_done / kN) + 1U) * kN * kPeriod);  // WFI
+    }
+  }
+
+  const dac_stream_hist_t& h = g.out.lat;
+  uint64_t deadline = kN / 2U * kPeriod;
+  uint32_t expect = (uint32_t) (deadline + kStartOffset);
+  bool in_time = work + jitter < deadline;
+  // a late commit can still win the race against the DMA, so flags may
+  // outnumber bad halves, never the other way round
+  bool ok = g.stale + g.torn + g.skipped <= g.out.underruns + g.out.late &&
+            g.out.blocks == g.block && g.in.overruns == 0;
+  if (in_time) {
+    // every start after the zeros half is fresh and timed
+    ok = ok && g.out.underruns == 0 && g.out.late == 0 && g.stale == 0 && g.torn == 0 &&
+         g.skipped == 0 && g.in_order + 1U == g.halves && h.count == g.halves &&
+         h.max - h.min <= 2U * jitter && (jitter != 0U || h.min == expect);
+  }
+  std::printf("  %-6s work %4.2f  blocks %5llu  halves %5llu  in order %5llu  stale %4llu"
+              "  torn %4llu  underruns %4u  late %4u  latency %7.3f .. %7.3f ms  %s\n",
+              name, (double) work / (double) deadline, (unsigned long long) g.block,
+              (unsigned long long) g.halves, (unsigned long long) g.in_order,
+              (unsigned long long) g.stale, (unsigned long long) g.torn, g.out.underruns,
+              g.out.late, h.count ? h.min * 1e3 / kCoreHz : 0.0,
+              h.count ? h.max * 1e3 / kCoreHz : 0.0, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint64_t blocks = (argc > 1) ? std::strtoull(argv[1], nullptr, 0) : 1000;
+  uint64_t work = (argc > 2) ? std::strtoull(argv[2], nullptr, 0) : 20000;
+  uint32_t jitter = (argc > 3) ? (uint32_t) std::strtoul(argv[3], nullptr, 0) : 0;
+  static const double kLoads[] = {0.25, 0.5, 0.9, 1.1, 1.5};
+  uint64_t deadline = kN / 2U * kPeriod;
+  bool ok = true;
+
+  if (blocks == 0 || jitter >= kPeriod / 4U) {
+    std::fprintf(stderr, "usage: dac_stream_sim [blocks work jitter(< %llu)]\n",
+                 (unsigned long long) (kPeriod / 4U));
+    return 2;
+  }
+  std::printf("N = %u, %llu cycles per sample at %llu Hz, deadline N/2 = %llu cycles, expected"
+              " latency %.3f ms\n",
+              kN, (unsigned long long) kPeriod, (unsigned long long) kCoreHz,
+              (unsigned long long) deadline, (deadline + kStartOffset) * 1e3 / kCoreHz);
+  ok &= Run("given", blocks, work, jitter);
+  for (double load : kLoads) {
+    char name[16];
+    std::snprintf(name, sizeof(name), "x%.2f", load);
+    ok &= Run(name, blocks, (uint64_t) (load * deadline), jitter);
+  }
+  std::printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+/**
+ ******************************************************************************
+ * @file           : delta_pack.hpp
+ * @brief          : Host decoder for delta_pack frames (header only)
+ ******************************************************************************
+ *
+ * Counterpart of Common/Src/delta_pack.c. Link telem.o (telem_unframe)
+ * when using Stream:
+ *
+ *   delta_pack::Stream rx;
+ *   rx.Feed(bytes, n, [](uint64_t index, int16_t v) { ... });
+ *
+ * Stream takes the link bytes in any chunking (20-byte notifications,
+ * whole captures), splits on 0x00, checks COBS and CRC, decodes
+ * TELEM_FRAME_PACKED frames and hands every sample over with a 64-bit
+ * index unwrapped from the 16-bit one on the wire. Other telem frames on
+ * the same link are counted and skipped. Decode() works on one raw frame
+ * for callers with their own framing loop (telem_decode).
+ ******************************************************************************
+ */
+#ifndef DELTA_PACK_HPP
+#define DELTA_PACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "delta_pack.h"
+#include "telem.h"
+
+namespace delta_pack {
+
+struct Frame {
+  uint16_t idx = 0;  // sample index of values[0]
+  std::vector<int16_t> values;
+};
+
+// One raw frame as returned by telem_unframe() (CRC stripped). False if it
+// is not a TELEM_FRAME_PACKED frame or a varint / value is malformed.
+inline bool Decode(const uint8_t* raw, size_t len, Frame& f) {
+  if (len < DELTA_PACK_HDR_LEN || raw[0] != ((TELEM_VERSION << 4) | TELEM_FRAME_PACKED)) {
+    return false;
+  }
+  f.idx = (uint16_t) (raw[1] | (raw[2] << 8));
+  int32_t v = (int16_t) (raw[3] | (raw[4] << 8));
+  f.values.assign(1, (int16_t) v);
+
+  size_t i = DELTA_PACK_HDR_LEN;
+  while (i < len) {
+    uint32_t zz = 0;
+    uint32_t shift = 0;
+    uint8_t b;
+    do {
+      if (i >= len || shift >= 7 * DELTA_PACK_VARINT_MAX) {
+        return false;
+      }
+      b = raw[i++];
+      zz |= (uint32_t) (b & 0x7F) << shift;
+      shift += 7;
+    } while (b & 0x80);
+    v += (zz & 1) ? -(int32_t) (zz >> 1) - 1 : (int32_t) (zz >> 1);
+    if (v < INT16_MIN || v > INT16_MAX) {
+      return false;
+    }
+    f.values.push_back((int16_t) v);
+  }
+  return true;
+}
+
+// 16-bit frame index -> 64-bit sample index, counting skipped samples
+class IndexUnwrap {
+ public:
+  // Index of the frame's first sample; n = samples in the frame
+  uint64_t Next(uint16_t idx, size_t n) {
+    uint64_t base = idx;
+    if (next_ >= 0) {
+      uint16_t gap = (uint16_t) (idx - (uint16_t) next_);
+      base = (uint64_t) next_ + gap;
+      lost_ += gap;
+    }
+    next_ = (int64_t) (base + n);
+    return base;
+  }
+  uint64_t lost() const { return lost_; }
+
+ private:
+  int64_t next_ = -1;
+  uint64_t lost_ = 0;
+};
+
+class Stream {
+ public:
+  struct Stats {
+    uint64_t frames = 0;
+    uint64_t bad = 0;    // COBS / CRC / varint errors
+    uint64_t other = 0;  // valid telem frames of another type
+    uint64_t samples = 0;
+    uint64_t lost = 0;   // samples missing from the indices
+  };
+
+  // sink(uint64_t index, int16_t value), called once per sample in order
+  template <class Sink>
+  void Feed(const uint8_t* p, size_t n, Sink&& sink) {
+    for (size_t k = 0; k < n; k++) {
+      if (p[k] != 0) {
+        enc_.push_back(p[k]);
+      } else if (!enc_.empty()) {
+        OnFrame(sink);
+        enc_.clear();
+      }
+    }
+  }
+
+  Stats stats() const {
+    Stats s = st_;
+    s.lost = unwrap_.lost();
+    return s;
+  }
+
+ private:
+  template <class Sink>
+  void OnFrame(Sink& sink) {
+    raw_.resize(enc_.size());
+    int32_t len = telem_unframe(enc_.data(), (uint32_t) enc_.size(), raw_.data());
+    if (len < 0) {
+      st_.bad++;
+      return;
+    }
+    if ((raw_[0] & 0x0F) != TELEM_FRAME_PACKED) {
+      st_.other++;
+      return;
+    }
+    if (!Decode(raw_.data(), (size_t) len, frame_)) {
+      st_.bad++;
+      return;
+    }
+    uint64_t base = unwrap_.Next(frame_.idx, frame_.values.size());
+    for (size_t i = 0; i < frame_.values.size(); i++) {
+      sink(base + i, frame_.values[i]);
+    }
+    st_.frames++;
+    st_.samples += frame_.values.size();
+  }
+
+  std::vector<uint8_t> enc_;
+  std::vector<uint8_t> raw_;
+  delta_pack::Frame frame_;
+  IndexUnwrap unwrap_;
+  Stats st_;
+};
+
+}  // namespace delta_pack
+
+#endif  // DELTA_PACK_HPP
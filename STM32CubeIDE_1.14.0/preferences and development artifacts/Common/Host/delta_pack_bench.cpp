@@ -0,0 +1,336 @@
+/**
+ ******************************************************************************
+ * @file           : delta_pack_bench.cpp
+ * @brief          : delta_pack round-trip checks and compression benchmark
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/telem.c ../Src/delta_pack.c
+ *   c++ -O2 -std=c++17 -I../Inc delta_pack_bench.cpp telem.o delta_pack.o -o delta_pack_bench
+ *
+ * Usage:
+ *   delta_pack_bench [-f frame_bytes] [trace ...]
+ *
+ *   frame_bytes  encoded frame budget (default 20, one BLE notification)
+ *   trace        recorded temperatures: telem_decode CSV (temp_c rows) or
+ *                one value per line, deg C; without traces two synthetic
+ *                ones are used (slow die warm-up with ADC noise, and a
+ *                step / noise mix)
+ *
+ * Round trip: every series (the traces plus edge cases: constant, full
+ * int16 swings, alternating extremes) is packed, fed back through
+ * delta_pack::Stream in 20-byte and odd-sized chunks and must come back
+ * bit-exact with consecutive indices. A dropped frame must show up as
+ * exactly its samples lost; a corrupted byte as one bad frame.
+ *
+ * Benchmark per trace: samples per frame, bytes per sample, ratio against
+ * plain int16 and against 10-sample TELEM_FRAME_TEMP frames (39 bytes),
+ * and encode time per sample on this host. Exit status 1 when a round
+ * trip fails.
+ ******************************************************************************
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "delta_pack.h"
+#include "delta_pack.hpp"
+
+namespace {
+
+struct Series {
+  std::string name;
+  std::vector<int16_t> v;  // deg C x 100, as in TELEM_F_TEMP_CENTI
+};
+
+struct Packed {
+  std::vector<uint8_t> bytes;
+  std::vector<size_t> frame_end;  // offset after each frame
+  uint32_t min_samples = UINT32_MAX;
+};
+
+Packed Pack(const std::vector<int16_t>& v, uint32_t frame_bytes, uint16_t first_idx) {
+  Packed out;
+  delta_pack_t p;
+  uint8_t buf[DELTA_PACK_FRAME_MAX];
+  uint32_t before = 0;
+
+  delta_pack_init(&p, frame_bytes, first_idx);
+  auto take = [&](uint32_t n) {
+    if (n == 0) {
+      return;
+    }
+    out.bytes.insert(out.bytes.end(), buf, buf + n);
+    out.frame_end.push_back(out.bytes.size());
+    uint32_t s = p.samples - before;
+    before = p.samples;
+    if (s < out.min_samples) {
+      out.min_samples = s;
+    }
+  };
+  for (int16_t x : v) {
+    take(delta_pack_push(&p, x, buf));
+  }
+  take(delta_pack_flush(&p, buf));
+  return out;
+}
+
+// Feeds bytes in chunks of `chunk` (0: alternating 1, 7, 13), checks every
+// sample and its index; lost / bad are returned for the caller to check
+bool Unpack(const std::vector<uint8_t>& bytes,
+            size_t chunk,
+            const std::vector<int16_t>& expect,
+            delta_pack::Stream::Stats& st) {
+  delta_pack::Stream rx;
+  bool ok = true;
+  uint64_t first = UINT64_MAX;
+  uint64_t got = 0;
+  static const size_t kOdd[] = {1, 7, 13};
+
+  auto sink = [&](uint64_t index, int16_t value) {
+    if (first == UINT64_MAX) {
+      first = index;
+    }
+    uint64_t k = index - first;
+    if (k >= expect.size() || expect[k] != value) {
+      ok = false;
+    }
+    got++;
+  };
+  for (size_t i = 0, j = 0; i < bytes.size(); j++) {
+    size_t n = (chunk != 0) ? chunk : kOdd[j % 3];
+    if (n > bytes.size() - i) {
+      n = bytes.size() - i;
+    }
+    rx.Feed(&bytes[i], n, sink);
+    i += n;
+  }
+  st = rx.stats();
+  return ok && got + st.lost == expect.size();
+}
+
+bool RoundTrip(const Series& s, uint32_t frame_bytes) {
+  // start near the 16-bit wrap so the unwrapping is exercised too
+  Packed pk = Pack(s.v, frame_bytes, (uint16_t) (65536 - s.v.size() / 2));
+  delta_pack::Stream::Stats st;
+  bool ok = true;
+
+  for (size_t chunk : {(size_t) DELTA_PACK_BLE_FRAME, (size_t) 0, pk.bytes.size()}) {
+    if (!Unpack(pk.bytes, chunk, s.v, st) || st.lost != 0 || st.bad != 0 ||
+        st.samples != s.v.size()) {
+      std::printf("  FAIL %s: chunk %zu, samples %llu lost %llu bad %llu\n", s.name.c_str(),
+                  chunk, (unsigned long long) st.samples, (unsigned long long) st.lost,
+                  (unsigned long long) st.bad);
+      ok = false;
+    }
+  }
+
+  if (pk.frame_end.size() >= 3) {
+    // drop the second frame: its samples lost, the rest exact
+    size_t a = pk.frame_end[0];
+    size_t b = pk.frame_end[1];
+    std::vector<uint8_t> cut(pk.bytes.begin(), pk.bytes.begin() + a);
+    cut.insert(cut.end(), pk.bytes.begin() + b, pk.bytes.end());
+    std::vector<int16_t> exp = s.v;
+    delta_pack::Stream rx;
+    uint64_t want_lost = 0;
+    bool exact = true;
+    {
+      // count the samples of frame 1 by decoding it alone
+      std::vector<uint8_t> one(pk.bytes.begin() + a, pk.bytes.begin() + b);
+      delta_pack::Stream probe;
+      probe.Feed(one.data(), one.size(), [](uint64_t, int16_t) {});
+      want_lost = probe.stats().samples;
+    }
+    uint64_t first = UINT64_MAX;
+    rx.Feed(cut.data(), cut.size(), [&](uint64_t index, int16_t value) {
+      if (first == UINT64_MAX) {
+        first = index;
+      }
+      if (index - first >= exp.size() || exp[index - first] != value) {
+        exact = false;
+      }
+    });
+    if (!exact || rx.stats().lost != want_lost) {
+      std::printf("  FAIL %s: dropped frame, lost %llu (want %llu)\n", s.name.c_str(),
+                  (unsigned long long) rx.stats().lost, (unsigned long long) want_lost);
+      ok = false;
+    }
+
+    // flip one payload bit in the first frame: one bad frame, no samples
+    std::vector<uint8_t> bad = pk.bytes;
+    bad[2] ^= (bad[2] == 0x01) ? 0x03 : 0x01;  // never produce a 0x00
+    delta_pack::Stream rx2;
+    rx2.Feed(bad.data(), bad.size(), [](uint64_t, int16_t) {});
+    if (rx2.stats().bad != 1 || rx2.stats().frames != pk.frame_end.size() - 1) {
+      std::printf("  FAIL %s: corrupted frame, bad %llu\n", s.name.c_str(),
+                  (unsigned long long) rx2.stats().bad);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+volatile uint32_t g_sink;  // keeps the timed loop from being optimised away
+
+void Bench(const Series& s, uint32_t frame_bytes) {
+  Packed pk = Pack(s.v, frame_bytes, 0);
+  double n = (double) s.v.size();
+  double bps = (double) pk.bytes.size() / n;
+
+  // encode time: repeat until ~50 ms so the clock resolution does not matter
+  delta_pack_t p;
+  uint8_t buf[DELTA_PACK_FRAME_MAX];
+  uint32_t sink = 0;
+  uint64_t reps = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  std::chrono::duration<double> dt{};
+  do {
+    delta_pack_init(&p, frame_bytes, 0);
+    for (int16_t x : s.v) {
+      sink += delta_pack_push(&p, x, buf);
+    }
+    sink += delta_pack_flush(&p, buf);
+    reps++;
+    dt = std::chrono::steady_clock::now() - t0;
+  } while (dt.count() < 0.05);
+
+  std::printf("%-22s %7zu samples  %5zu frames  %5.2f samples/frame (min %u)\n",
+              s.name.c_str(), s.v.size(), pk.frame_end.size(),
+              n / (double) pk.frame_end.size(), pk.min_samples);
+  g_sink = sink;
+  std::printf("%-22s %5.2f B/sample  ratio %4.2fx vs int16, %4.2fx vs TELEM_FRAME_TEMP  "
+              "encode %.1f ns/sample\n",
+              "", bps, 2.0 / bps, 3.9 / bps, dt.count() * 1e9 / ((double) reps * n));
+}
+
+// telem_decode CSV (seq,t_ms,temp_c,23.45) or one value per line
+bool LoadTrace(const char* path, Series& s) {
+  std::FILE* f = std::fopen(path, "r");
+  if (f == nullptr) {
+    std::perror(path);
+    return false;
+  }
+  char line[256];
+  s.name = path;
+  while (std::fgets(line, sizeof(line), f) != nullptr) {
+    const char* val = line;
+    if (std::strchr(line, ',') != nullptr) {
+      const char* field = std::strstr(line, ",temp_c,");
+      if (field == nullptr) {
+        continue;
+      }
+      val = field + 8;
+    }
+    char* end;
+    double c = std::strtod(val, &end);
+    if (end == val) {
+      continue;  // header or blank line
+    }
+    s.v.push_back((int16_t) std::lround(c * 100.0));
+  }
+  std::fclose(f);
+  return !s.v.empty();
+}
+
+uint32_t g_lcg = 12345;
+int32_t Noise(int32_t amp) {
+  g_lcg = g_lcg * 1664525U + 1013904223U;
+  return (int32_t) ((g_lcg >> 16) % (uint32_t) (2 * amp + 1)) - amp;
+}
+
+std::vector<Series> Synthetic() {
+  std::vector<Series> out;
+
+  // die warm-up 28 -> 46 C, tau 5 min at 100 ms, +-3 centi of ADC noise
+  Series warm{"synthetic warm-up", {}};
+  for (int i = 0; i < 36000; i++) {
+    double t = 28.0 + 18.0 * (1.0 - std::exp(-i / 3000.0));
+    warm.v.push_back((int16_t) (std::lround(t * 100.0) + Noise(3)));
+  }
+  out.push_back(warm);
+
+  // fan switching every 2 min: 1.5 C steps, +-8 centi of noise
+  Series steps{"synthetic steps", {}};
+  for (int i = 0; i < 36000; i++) {
+    int32_t t = ((i / 1200) % 2) ? 3650 : 3500;
+    steps.v.push_back((int16_t) (t + Noise(8)));
+  }
+  out.push_back(steps);
+  return out;
+}
+
+std::vector<Series> EdgeCases() {
+  std::vector<Series> out;
+  out.push_back({"single", {-1}});
+  out.push_back({"constant", std::vector<int16_t>(1000, 2500)});
+  Series swing{"full swing", {}};
+  for (int i = 0; i < 1000; i++) {
+    swing.v.push_back((i % 2) ? INT16_MAX : INT16_MIN);
+  }
+  out.push_back(swing);
+  Series ramp{"all deltas", {}};
+  for (int32_t d = -300; d <= 300; d++) {
+    ramp.v.push_back((int16_t) (d * 109));  // crosses the 1/2/3-byte varint limits
+  }
+  ramp.v.push_back(0);
+  ramp.v.push_back(8191);
+  ramp.v.push_back(0);
+  ramp.v.push_back(-8192);
+  ramp.v.push_back(0);
+  out.push_back(ramp);
+  return out;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t frame_bytes = DELTA_PACK_BLE_FRAME;
+  std::vector<Series> traces;
+  int i = 1;
+
+  if (argc > 2 && std::strcmp(argv[1], "-f") == 0) {
+    frame_bytes = (uint32_t) std::strtoul(argv[2], nullptr, 0);
+    i = 3;
+  }
+  if (frame_bytes < DELTA_PACK_FRAME_MIN || frame_bytes > DELTA_PACK_FRAME_MAX) {
+    std::fprintf(stderr, "frame_bytes %u..%u\n", DELTA_PACK_FRAME_MIN, DELTA_PACK_FRAME_MAX);
+    return 2;
+  }
+  for (; i < argc; i++) {
+    Series s;
+    if (!LoadTrace(argv[i], s)) {
+      return 2;
+    }
+    traces.push_back(s);
+  }
+  if (traces.empty()) {
+    traces = Synthetic();
+  }
+
+  bool ok = true;
+  std::vector<Series> all = traces;
+  for (const Series& s : EdgeCases()) {
+    all.push_back(s);
+  }
+  for (const Series& s : all) {
+    for (uint32_t fb : {frame_bytes, (uint32_t) DELTA_PACK_FRAME_MIN,
+                        (uint32_t) DELTA_PACK_FRAME_MAX}) {
+      ok = RoundTrip(s, fb) && ok;
+    }
+  }
+  std::printf("round trip (%zu series, 3 frame sizes): %s\n\n", all.size(),
+              ok ? "bit-exact" : "FAILED");
+
+  std::printf("frame budget %u bytes\n", frame_bytes);
+  for (const Series& s : traces) {
+    Bench(s, frame_bytes);
+  }
+  std::printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
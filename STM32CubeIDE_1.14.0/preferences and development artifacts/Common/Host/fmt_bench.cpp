@@ -0,0 +1,338 @@
+/**
+ ******************************************************************************
+ * @file           : fmt_bench.cpp
+ * @brief          : fmt output and speed against snprintf, plus size probes
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/fmt.c -o fmt.o
+ *   c++ -O2 -std=c++17 -I../Inc fmt_bench.cpp fmt.o -o fmt_bench
+ *
+ * Usage:
+ *   fmt_bench [values]
+ *
+ *   values  random values per check (default 1M), corner values always
+ *
+ * Output: every fmt_* call against snprintf on corner and random values:
+ * fmt_u32 / fmt_i32 vs %u / %d, fmt_u32_pad vs %*u / %0*u, fmt_hex vs
+ * %0*X, fmt_dec vs the integer split v / 10^d, fmt_q16 vs the exact
+ * Q16.16 value rounded half away from zero and vs %.*f of the same value.
+ * glibc rounds exact decimal ties to even and prints "-0.00" for a
+ * negative value that rounds to zero; those differences are counted
+ * apart, any other is a FAIL. A line cut short by a small buffer has to be
+ * the NUL-terminated prefix of the full line, flagged as overflow.
+ *
+ * Timing (ns/line on this host): the Temp_H7_print line
+ * "ADC = 12345  TEMP = 25.31 C\n" by snprintf with %.2f, by snprintf with
+ * integers only, and by fmt.
+ *
+ * Size (flash): the same file built as C with -DFMT_BENCH_SIZE_PROBE=1
+ * (fmt), =2 (snprintf %.2f) or =3 (snprintf, integers only) is a
+ * one-line program. Link each with the target toolchain and compare text:
+ *   arm-none-eabi-gcc -Os -mcpu=cortex-m7 -mthumb --specs=nano.specs
+ *     --specs=nosys.specs -x c -DFMT_BENCH_SIZE_PROBE=1 -I../Inc
+ *     fmt_bench.cpp ../Src/fmt.c -o probe1.elf
+ *   arm-none-eabi-size probe1.elf probe2.elf probe3.elf
+ * with -u _printf_float added for =2 (what CubeIDE adds when "use float
+ * with printf" is ticked). Host static links do not separate them: glibc
+ * start-up code pulls in stdio and its float printf whatever main calls.
+ *
+ * Exit status 1 when a check fails.
+ ******************************************************************************
+ */
+#if defined(FMT_BENCH_SIZE_PROBE)
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "fmt.h"
+
+volatile uint32_t g_adc = 12345;
+volatile int32_t g_q16 = 1658839;  // 25.31 C
+
+int main() {
+  char line[48];
+  uint32_t len;
+#if FMT_BENCH_SIZE_PROBE == 1
+  fmt_t f;
+  fmt_init(&f, line, sizeof(line));
+  fmt_str(&f, "ADC = ");
+  fmt_u32(&f, g_adc);
+  fmt_str(&f, "  TEMP = ");
+  fmt_q16(&f, g_q16, 2);
+  fmt_str(&f, " C\n");
+  len = fmt_end(&f);
+#elif FMT_BENCH_SIZE_PROBE == 2
+  len = (uint32_t) snprintf(line, sizeof(line), "ADC = %lu  TEMP = %.2f C\n",
+                            (unsigned long) g_adc, g_q16 / 65536.0);
+#else
+  int32_t c = (g_q16 * 100 + 32768) >> 16;
+  len = (uint32_t) snprintf(line, sizeof(line), "ADC = %lu  TEMP = %ld.%02ld C\n",
+                            (unsigned long) g_adc, (long) (c / 100), (long) (c % 100));
+#endif
+  return (int) line[len / 2];
+}
+
+#else
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "fmt.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const uint32_t kPow10[FMT_DEC_MAX + 1] = {1,      10,      100,      1000,      10000,
+                                          100000, 1000000, 10000000, 100000000, 1000000000};
+
+struct Count {
+  const char* name;
+  uint64_t checked = 0;
+  uint64_t bad = 0;
+  uint64_t ties = 0;   // glibc round-half-even on an exact tie
+  uint64_t minus0 = 0; // glibc "-0.00"
+};
+
+uint32_t g_lcg = 2024;
+
+uint32_t Rand() {
+  g_lcg = g_lcg * 1664525U + 1013904223U;
+  uint32_t hi = g_lcg;
+  g_lcg = g_lcg * 1664525U + 1013904223U;
+  // mix magnitudes: full range, 16 bit, 8 bit
+  uint32_t v = (hi & 0xFFFF0000U) | (g_lcg >> 16);
+  switch (g_lcg & 3U) {
+    case 0:
+      return v & 0xFFFFU;
+    case 1:
+      return v & 0xFFU;
+    default:
+      return v;
+  }
+}
+
+template <typename Build>
+std::string Fmt(Build&& build) {
+  char buf[64];
+  fmt_t f;
+  fmt_init(&f, buf, sizeof(buf));
+  build(&f);
+  fmt_end(&f);
+  return buf;
+}
+
+void Compare(Count* c, const std::string& got, const char* want, uint64_t shown_at = 3) {
+  c->checked++;
+  if (got != want && c->bad++ < shown_at) {
+    std::printf("    %s: \"%s\" expected \"%s\"\n", c->name, got.c_str(), want);
+  }
+}
+
+const uint32_t kCorner[] = {0,          1,          9,          10,         99,
+                            100,        65535,      65536,      999999999,  1000000000,
+                            2147483647, 2147483648, 4294967294, 4294967295};
+
+void CheckInts(uint64_t n, Count* u, Count* i, Count* pad, Count* hex) {
+  char want[320];  // room for any %0*u width gcc can see
+  auto one = [&](uint32_t v) {
+    std::snprintf(want, sizeof(want), "%" PRIu32, v);
+    Compare(u, Fmt([&](fmt_t* f) { fmt_u32(f, v); }), want);
+    std::snprintf(want, sizeof(want), "%" PRId32, (int32_t) v);
+    Compare(i, Fmt([&](fmt_t* f) { fmt_i32(f, (int32_t) v); }), want);
+    uint8_t width = (uint8_t) (v % 13U);
+    std::snprintf(want, sizeof(want), (v & 16U) ? "%0*" PRIu32 : "%*" PRIu32, width, v);
+    Compare(pad, Fmt([&](fmt_t* f) { fmt_u32_pad(f, v, width, (v & 16U) ? '0' : ' '); }), want);
+    uint8_t digits = (uint8_t) (1U + (v >> 5) % 8U);
+    uint32_t mask = (digits == 8U) ? 0xFFFFFFFFU : ((1U << (4U * digits)) - 1U);
+    std::snprintf(want, sizeof(want), "%0*" PRIX32, digits, v & mask);
+    Compare(hex, Fmt([&](fmt_t* f) { fmt_hex(f, v, digits); }), want);
+  };
+  for (uint32_t v : kCorner) {
+    one(v);
+    one(0U - v);
+  }
+  for (uint64_t k = 0; k < n; k++) {
+    one(Rand());
+  }
+}
+
+void CheckDec(uint64_t n, Count* dec, Count* q16, Count* q16_libc, uint64_t* clamped) {
+  char want[320];  // room for any %0*u width gcc can see
+  auto one = [&](int32_t v, uint8_t d) {
+    // fmt_dec: sign, |v| / 10^d, '.', |v| % 10^d with d digits
+    uint32_t a = (v < 0) ? 0U - (uint32_t) v : (uint32_t) v;
+    if (d == 0) {
+      std::snprintf(want, sizeof(want), "%s%" PRIu32, v < 0 ? "-" : "", a);
+    } else {
+      std::snprintf(want, sizeof(want), "%s%" PRIu32 ".%0*" PRIu32, v < 0 ? "-" : "",
+                    a / kPow10[d], (int) d, a % kPow10[d]);
+    }
+    Compare(dec, Fmt([&](fmt_t* f) { fmt_dec(f, v, d); }), want);
+
+    // fmt_q16: exact |v| * 10^d / 2^16 rounded half away from zero
+    uint64_t s = ((uint64_t) a * kPow10[d] + 32768U) >> 16;
+    if (s > INT32_MAX) {
+      (*clamped)++;  // past 32 bits: fmt_q16 saturates, documented
+      return;
+    }
+    std::string got = Fmt([&](fmt_t* f) { fmt_q16(f, v, d); });
+    uint32_t su = (uint32_t) s;
+    const char* sign = (v < 0 && s != 0) ? "-" : "";
+    if (d == 0) {
+      std::snprintf(want, sizeof(want), "%s%" PRIu32, sign, su);
+    } else {
+      std::snprintf(want, sizeof(want), "%s%" PRIu32 ".%0*" PRIu32, sign, su / kPow10[d], (int) d,
+                    su % kPow10[d]);
+    }
+    Compare(q16, got, want);
+
+    // against libc: v / 65536 is exact in a double, so only ties and -0 differ
+    std::snprintf(want, sizeof(want), "%.*f", (int) d, v / 65536.0);
+    q16_libc->checked++;
+    if (got != want) {
+      bool tie = (((uint64_t) a * kPow10[d]) & 0xFFFFU) == 0x8000U;
+      bool minus0 = (v < 0 && s == 0);
+      if (tie) {
+        q16_libc->ties++;
+      } else if (minus0) {
+        q16_libc->minus0++;
+      } else if (q16_libc->bad++ < 3) {
+        std::printf("    %s: \"%s\" libc \"%s\"\n", q16_libc->name, got.c_str(), want);
+      }
+    }
+  };
+  for (uint32_t v : kCorner) {
+    for (uint8_t d = 0; d <= FMT_DEC_MAX; d++) {
+      one((int32_t) v, d);
+      one((int32_t) (0U - v), d);
+    }
+  }
+  // every Q16 fraction of a few integer parts, then random
+  for (int32_t ip : {0, 25, -1, -40}) {
+    for (int32_t fr = 0; fr < 65536; fr++) {
+      one(ip * 65536 + fr, (uint8_t) (fr % 4));
+    }
+  }
+  for (uint64_t k = 0; k < n; k++) {
+    uint32_t v = Rand();
+    one((int32_t) v, (uint8_t) ((v >> 7) % (FMT_DEC_MAX + 1U)));
+  }
+}
+
+// Truncation: every buffer size gives a NUL-terminated prefix, flagged
+void CheckCut(Count* cut) {
+  const char* full = "ADC = 4294967295  TEMP = -40.00 C\n";
+  size_t n = std::strlen(full);
+  for (uint32_t size = 1; size <= n + 2; size++) {
+    char buf[64];
+    std::memset(buf, 'x', sizeof(buf));
+    fmt_t f;
+    fmt_init(&f, buf, size);
+    fmt_str(&f, "ADC = ");
+    fmt_u32(&f, 4294967295U);
+    fmt_str(&f, "  TEMP = ");
+    fmt_q16(&f, -40 * 65536, 2);
+    fmt_str(&f, " C\n");
+    uint32_t len = fmt_end(&f);
+    size_t keep = (size - 1U < n) ? size - 1U : n;
+    bool ok = len == keep && buf[len] == '\0' && std::strncmp(buf, full, keep) == 0 &&
+              (f.overflow != 0) == (keep < n) && buf[size] == 'x';
+    cut->checked++;
+    if (!ok && cut->bad++ < 3) {
+      std::printf("    cut at %u: \"%s\" overflow %u\n", size, buf, f.overflow);
+    }
+  }
+}
+
+volatile uint32_t g_sink;  // keeps the timed loops from being optimised away
+
+template <typename F>
+double NsPerCall(F&& f) {
+  uint64_t reps = 0;
+  auto t0 = Clock::now();
+  std::chrono::duration<double> dt{};
+  do {
+    f();
+    reps++;
+    dt = Clock::now() - t0;
+  } while (dt.count() < 0.2);
+  return dt.count() * 1e9 / (double) reps;
+}
+
+void Bench() {
+  char line[48];
+  uint32_t adc = 12345;
+  int32_t q16 = 1658839;
+  double flt = NsPerCall([&] {
+    adc = (adc + 7U) & 0xFFFFU;
+    int n = std::snprintf(line, sizeof(line), "ADC = %lu  TEMP = %.2f C\n", (unsigned long) adc,
+                          q16 / 65536.0);
+    g_sink = g_sink + (uint32_t) n + (uint8_t) line[10];
+  });
+  double ints = NsPerCall([&] {
+    adc = (adc + 7U) & 0xFFFFU;
+    int32_t c = (q16 * 100 + 32768) >> 16;
+    int n = std::snprintf(line, sizeof(line), "ADC = %lu  TEMP = %ld.%02ld C\n",
+                          (unsigned long) adc, (long) (c / 100), (long) (c % 100));
+    g_sink = g_sink + (uint32_t) n + (uint8_t) line[10];
+  });
+  double typed = NsPerCall([&] {
+    adc = (adc + 7U) & 0xFFFFU;
+    fmt_t f;
+    fmt_init(&f, line, sizeof(line));
+    fmt_str(&f, "ADC = ");
+    fmt_u32(&f, adc);
+    fmt_str(&f, "  TEMP = ");
+    fmt_q16(&f, q16, 2);
+    fmt_str(&f, " C\n");
+    g_sink = g_sink + fmt_end(&f) + (uint8_t) line[10];
+  });
+  std::printf("\n\"ADC = 12345  TEMP = 25.31 C\", ns/line:\n");
+  std::printf("  snprintf %%.2f          %7.1f\n", flt);
+  std::printf("  snprintf integers only %7.1f  (%.2fx)\n", ints, flt / ints);
+  std::printf("  fmt                    %7.1f  (%.2fx)\n", typed, flt / typed);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint64_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 0) : 1000000;
+  Count u{"fmt_u32"}, i{"fmt_i32"}, pad{"fmt_u32_pad"}, hex{"fmt_hex"}, dec{"fmt_dec"},
+      q16{"fmt_q16"}, q16_libc{"fmt_q16 vs %.*f"}, cut{"truncation"};
+  uint64_t clamped = 0;
+  bool ok = true;
+
+  if (n == 0) {
+    std::fprintf(stderr, "usage: fmt_bench [values]\n");
+    return 2;
+  }
+  CheckInts(n, &u, &i, &pad, &hex);
+  CheckDec(n, &dec, &q16, &q16_libc, &clamped);
+  CheckCut(&cut);
+  for (const Count* c : {&u, &i, &pad, &hex, &dec, &q16, &cut}) {
+    std::printf("  %-16s %9llu checked  %llu differ  %s\n", c->name,
+                (unsigned long long) c->checked, (unsigned long long) c->bad,
+                c->bad == 0 ? "ok" : "FAIL");
+    ok = ok && c->bad == 0;
+  }
+  std::printf("  %-16s %9llu checked  %llu differ (+%llu exact ties, +%llu \"-0\")  %s\n",
+              q16_libc.name, (unsigned long long) q16_libc.checked,
+              (unsigned long long) q16_libc.bad, (unsigned long long) q16_libc.ties,
+              (unsigned long long) q16_libc.minus0, q16_libc.bad == 0 ? "ok" : "FAIL");
+  std::printf("  (%llu fmt_q16 calls past 32 bits of decimals skipped)\n",
+              (unsigned long long) clamped);
+  ok = ok && q16_libc.bad == 0;
+
+  Bench();
+  std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
+
+#endif
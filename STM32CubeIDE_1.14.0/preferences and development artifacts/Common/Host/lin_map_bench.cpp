@@ -0,0 +1,279 @@
+/**
+ ******************************************************************************
+ * @file           : lin_map_bench.cpp
+ * @brief          : lin_map equivalence checks and timing against clamp+divide
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/temp_probe.c -o temp_probe.o
+ *   c++ -O2 -std=c++17 -I../Inc lin_map_bench.cpp temp_probe.o -o lin_map_bench
+ *
+ *   add -DLIN_MAP_MODEL_DSP to the second line to run the block forms
+ *   through C models of SSAT16 / QSUB16 / SMULWB / SMULWT / USAT16, i.e.
+ *   the pair path the M7 build takes
+ *
+ * Usage:
+ *   lin_map_bench [samples]          timing trace length (default 1M)
+ *
+ * Checks, each against the clamp-then-divide reference (the form
+ * temp_probe_dac had before lin_map):
+ *   scalar   every int32 input in -2^20 .. 2^20, plus INT32_MIN/MAX
+ *   block    every int16 input, in blocks of 64 and of 63 (odd tail)
+ *   maps     temp_probe_ch1 / temp_probe_ch2 and four other spans,
+ *            offsets and widths
+ *   probe    temp_probe_dac_block vs the old per-sample temp_probe_dac
+ *            for all 65536 ADC codes and three calibrations
+ *
+ * Timing (ns/sample on this host, both DAC channels): old clamp+divide,
+ * lin_map scalar, lin_map block, and the whole code -> DAC path per
+ * sample vs temp_probe_dac_block. Target cycles are a separate
+ * measurement (probe_cycles_* in temp_h7_cm7_dma). Exit status 1 when a
+ * check fails.
+ ******************************************************************************
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#ifdef LIN_MAP_MODEL_DSP
+// Bit-exact models of the ACLE intrinsics the pair path uses
+typedef int32_t int16x2_t;
+
+static int32_t Lane(int32_t w, int hi) {
+  return (int16_t) (hi ? ((uint32_t) w >> 16) : ((uint32_t) w & 0xFFFFU));
+}
+static int32_t Pack(int32_t lo, int32_t hi) {
+  return (int32_t) (((uint32_t) lo & 0xFFFFU) | ((uint32_t) hi << 16));
+}
+static int32_t Sat(int32_t v, int32_t lo, int32_t hi) {
+  return v < lo ? lo : (v > hi ? hi : v);
+}
+static int16x2_t __ssat16(int16x2_t w, int bits) {
+  int32_t m = 1 << (bits - 1);
+  return Pack(Sat(Lane(w, 0), -m, m - 1), Sat(Lane(w, 1), -m, m - 1));
+}
+static int16x2_t __usat16(int16x2_t w, int bits) {
+  int32_t m = (1 << bits) - 1;
+  return Pack(Sat(Lane(w, 0), 0, m), Sat(Lane(w, 1), 0, m));
+}
+static int16x2_t __qsub16(int16x2_t a, int16x2_t b) {
+  return Pack(Sat(Lane(a, 0) - Lane(b, 0), -32768, 32767),
+              Sat(Lane(a, 1) - Lane(b, 1), -32768, 32767));
+}
+static int32_t __smulwb(int32_t a, int16x2_t b) {
+  return (int32_t) (((int64_t) a * Lane(b, 0)) >> 16);
+}
+static int32_t __smulwt(int32_t a, int16x2_t b) {
+  return (int32_t) (((int64_t) a * Lane(b, 1)) >> 16);
+}
+#define LIN_MAP_USE_SIMD 1
+#endif
+
+#include "lin_map.h"
+#include "temp_probe.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t ADC_BLOCK = 64;  // ADC_STREAM_BLOCK_LEN
+
+// Other shapes the static checks allow, so the kernel is not only right
+// for 66 / 25+33 at 12 bits
+LIN_MAP_DEFINE(map_a, 5, 100, 10)
+LIN_MAP_DEFINE(map_b, 0, 127, 8)
+LIN_MAP_DEFINE(map_c, 20, 50, 12)
+LIN_MAP_DEFINE(map_d, 0, 1, 6)
+
+struct Map {
+  const char* name;
+  int32_t offset, span, bits;
+  uint16_t (*one)(int32_t);
+  void (*block)(const int16_t*, uint16_t*, uint32_t);
+};
+
+const Map kMaps[] = {
+    {"temp_probe_ch1", 0, TEMP_PROBE_CH1_SPAN_C, TEMP_PROBE_DAC_BITS, temp_probe_ch1,
+     temp_probe_ch1_block},
+    {"temp_probe_ch2", TEMP_PROBE_CH2_OFFSET_C, TEMP_PROBE_CH2_SPAN_C, TEMP_PROBE_DAC_BITS,
+     temp_probe_ch2, temp_probe_ch2_block},
+    {"5+100 @10", 5, 100, 10, map_a, map_a_block},
+    {"0+127 @8", 0, 127, 8, map_b, map_b_block},
+    {"20+50 @12", 20, 50, 12, map_c, map_c_block},
+    {"0+1 @6", 0, 1, 6, map_d, map_d_block},
+};
+
+uint16_t Ref(const Map& m, int64_t x) {
+  int64_t d = x - m.offset;
+  d = d < 0 ? 0 : (d > m.span ? m.span : d);
+  return (uint16_t) ((d * ((1 << m.bits) - 1)) / m.span);
+}
+
+// temp_probe_dac before lin_map: clamp, then divide
+void OldDac(int32_t temp_c, uint16_t* ch1, uint16_t* ch2) {
+  uint32_t te = temp_c < 0 ? 0U
+                : temp_c > TEMP_PROBE_CH1_SPAN_C ? (uint32_t) TEMP_PROBE_CH1_SPAN_C
+                                                 : (uint32_t) temp_c;
+  uint32_t room = (te > TEMP_PROBE_CH2_OFFSET_C) ? te - TEMP_PROBE_CH2_OFFSET_C : 0U;
+  if (room > TEMP_PROBE_CH2_SPAN_C) {
+    room = TEMP_PROBE_CH2_SPAN_C;
+  }
+  *ch1 = (uint16_t) ((te * TEMP_PROBE_DAC_FULL) / TEMP_PROBE_CH1_SPAN_C);
+  *ch2 = (uint16_t) ((room * TEMP_PROBE_DAC_FULL) / TEMP_PROBE_CH2_SPAN_C);
+}
+
+bool CheckMap(const Map& m) {
+  uint64_t bad = 0;
+  uint64_t n = 0;
+
+  for (int64_t x = -(1 << 20); x <= (1 << 20); x++, n++) {
+    bad += m.one((int32_t) x) != Ref(m, x);
+  }
+  bad += m.one(INT32_MIN) != Ref(m, INT32_MIN);
+  bad += m.one(INT32_MAX) != Ref(m, INT32_MAX);
+  n += 2;
+
+  std::vector<int16_t> in(65536);
+  std::vector<uint16_t> out(65536);
+  for (int32_t i = 0; i < 65536; i++) {
+    in[(size_t) i] = (int16_t) (i - 32768);
+  }
+  for (uint32_t len : {64U, 63U}) {
+    for (size_t i = 0; i < in.size(); i += len) {
+      uint32_t k = (uint32_t) std::min<size_t>(len, in.size() - i);
+      m.block(&in[i], &out[i], k);
+    }
+    for (size_t i = 0; i < in.size(); i++, n++) {
+      bad += out[i] != Ref(m, in[i]);
+    }
+  }
+  std::printf("  %-16s mul %8d  %10llu inputs  %llu mismatches\n", m.name,
+              (int) (((((1U << m.bits) - 1U) << 16) + (uint32_t) m.span - 1U) /
+                     (uint32_t) m.span),
+              (unsigned long long) n, (unsigned long long) bad);
+  return bad == 0;
+}
+
+bool CheckProbe() {
+  const temp_probe_cal_t cals[] = {
+      {12400, 15900, 30, 110, 3300, 3300, 16},
+      {11800, 16400, 30, 130, 3300, 3000, 16},  // other part / VREF+
+      {775, 994, 30, 110, 3300, 3300, 12},      // 12-bit codes
+  };
+  bool ok = true;
+
+  for (const temp_probe_cal_t& c : cals) {
+    uint32_t codes = 1U << c.res_bits;
+    std::vector<uint16_t> in(codes), ch1(codes), ch2(codes);
+    uint64_t bad = 0;
+    for (uint32_t i = 0; i < codes; i++) {
+      in[i] = (uint16_t) i;
+    }
+    for (uint32_t i = 0; i < codes; i += ADC_BLOCK) {
+      temp_probe_dac_block(&c, &in[i], std::min(ADC_BLOCK, codes - i), &ch1[i], &ch2[i]);
+    }
+    for (uint32_t i = 0; i < codes; i++) {
+      uint16_t r1, r2;
+      OldDac(temp_probe_celsius(&c, in[i]), &r1, &r2);
+      bad += (ch1[i] != r1) + (ch2[i] != r2);
+    }
+    std::printf("  temp_probe_dac_block  cal %u/%u @%u bit  %u codes  %llu mismatches\n",
+                c.ts_cal1, c.ts_cal2, c.res_bits, codes, (unsigned long long) bad);
+    ok = ok && bad == 0;
+  }
+  return ok;
+}
+
+volatile uint32_t g_sink;  // keeps the timed loops from being optimised away
+
+template <typename F>
+double NsPerSample(size_t n, F&& f) {
+  uint64_t reps = 0;
+  auto t0 = Clock::now();
+  std::chrono::duration<double> dt{};
+  do {
+    f();
+    reps++;
+    dt = Clock::now() - t0;
+  } while (dt.count() < 0.2);
+  return dt.count() * 1e9 / ((double) reps * (double) n);
+}
+
+void Bench(size_t n) {
+  // codes around room temperature with a few LSB of noise and a slow ramp
+  const temp_probe_cal_t cal = {12400, 15900, 30, 110, 3300, 3300, 16};
+  std::vector<uint16_t> codes(n), ch1(n), ch2(n);
+  std::vector<int32_t> temps(n);
+  std::vector<int16_t> temps16(n);
+  uint32_t lcg = 12345;
+  for (size_t i = 0; i < n; i++) {
+    lcg = lcg * 1664525U + 1013904223U;
+    codes[i] = (uint16_t) (11000 + (i * 5000) / n + (lcg >> 28));
+    temps[i] = temp_probe_celsius(&cal, codes[i]);
+    temps16[i] = lin_map_in(temps[i]);
+  }
+
+  double old_map = NsPerSample(n, [&] {
+    for (size_t i = 0; i < n; i++) {
+      OldDac(temps[i], &ch1[i], &ch2[i]);
+    }
+    g_sink = g_sink + ch1[n / 2] + ch2[n / 3];
+  });
+  double one = NsPerSample(n, [&] {
+    for (size_t i = 0; i < n; i++) {
+      ch1[i] = temp_probe_ch1(temps[i]);
+      ch2[i] = temp_probe_ch2(temps[i]);
+    }
+    g_sink = g_sink + ch1[n / 2] + ch2[n / 3];
+  });
+  double block = NsPerSample(n, [&] {
+    for (size_t i = 0; i + ADC_BLOCK <= n; i += ADC_BLOCK) {
+      temp_probe_ch1_block(&temps16[i], &ch1[i], ADC_BLOCK);
+      temp_probe_ch2_block(&temps16[i], &ch2[i], ADC_BLOCK);
+    }
+    g_sink = g_sink + ch1[n / 2] + ch2[n / 3];
+  });
+  double old_path = NsPerSample(n, [&] {
+    for (size_t i = 0; i < n; i++) {
+      OldDac(temp_probe_celsius(&cal, codes[i]), &ch1[i], &ch2[i]);
+    }
+    g_sink = g_sink + ch1[n / 2] + ch2[n / 3];
+  });
+  double new_path = NsPerSample(n, [&] {
+    for (size_t i = 0; i + ADC_BLOCK <= n; i += ADC_BLOCK) {
+      temp_probe_dac_block(&cal, &codes[i], ADC_BLOCK, &ch1[i], &ch2[i]);
+    }
+    g_sink = g_sink + ch1[n / 2] + ch2[n / 3];
+  });
+
+  std::printf("\n%zu samples, both channels, ns/sample%s:\n", n,
+              LIN_MAP_USE_SIMD ? " (DSP models, not representative)" : "");
+  std::printf("  map   clamp + divide    %6.2f\n", old_map);
+  std::printf("  map   lin_map scalar    %6.2f  (%.2fx)\n", one, old_map / one);
+  std::printf("  map   lin_map block     %6.2f  (%.2fx)\n", block, old_map / block);
+  std::printf("  code -> DAC, per sample %6.2f\n", old_path);
+  std::printf("  temp_probe_dac_block    %6.2f  (%.2fx)\n", new_path, old_path / new_path);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t n = (argc > 1) ? (size_t) std::strtoul(argv[1], nullptr, 0) : (1U << 20);
+  bool ok = true;
+
+  if (n < ADC_BLOCK) {
+    std::fprintf(stderr, "usage: lin_map_bench [samples >= %u]\n", ADC_BLOCK);
+    return 2;
+  }
+  std::printf("lin_map checks (%s block path):\n", LIN_MAP_USE_SIMD ? "SIMD" : "portable");
+  for (const Map& m : kMaps) {
+    ok = CheckMap(m) && ok;
+  }
+  ok = CheckProbe() && ok;
+  Bench(n);
+  std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
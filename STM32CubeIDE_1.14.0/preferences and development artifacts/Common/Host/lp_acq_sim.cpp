@@ -0,0 +1,187 @@
+/**
+ ******************************************************************************
+ * @file           : lp_acq_sim.cpp
+ * @brief          : lp_acq against a simulated clock and interrupt sources
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/lp_acq.c -o lp_acq.o
+ *   c++ -O2 -std=c++17 -I../Inc lp_acq_sim.cpp lp_acq.o -o lp_acq_sim
+ *
+ * Usage:
+ *   lp_acq_sim [sample_period work seconds]
+ *
+ *   sample_period  cycles between ADC events       (default 52416: x64
+ *                  oversampled TSENSE at 20 MHz, 381 S/s)
+ *   work           loop cycles per sample event    (default 600)
+ *   seconds        simulated time at 20 MHz        (default 10)
+ *
+ * The port below runs lp_acq.c unchanged on a virtual cycle clock. Two
+ * interrupt sources are modelled: the ADC event (posts LP_ACQ_EV_SAMPLE)
+ * and SysTick every 20000 cycles (posts nothing, like the HAL tick). A
+ * source that comes due while interrupts are masked stays pending, and
+ * idle() returns on it just like WFI. Handler entry, body and return cost
+ * fixed cycles.
+ *
+ * Checks: every posted sample is returned by lp_acq_wait() (missed = 0),
+ * and the measured residency matches the analytic busy fraction. Exit
+ * status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "lp_acq.h"
+
+namespace {
+
+constexpr uint64_t kCoreHz = 20000000;
+constexpr uint64_t kTickPeriod = kCoreHz / 1000;
+constexpr uint64_t kIsrEntry = 12;  // exception entry, stacking
+constexpr uint64_t kIsrBody = 40;   // HAL handler + callback
+constexpr uint64_t kIsrExit = 10;
+
+struct Source {
+  uint64_t next;
+  uint64_t period;
+  bool pending;
+  bool posts;
+};
+
+uint64_t g_now = 0;
+bool g_masked = false;
+Source g_src[2];
+lp_acq_t g_acq;
+uint64_t g_posted = 0;  // sample events posted by the simulated ISR
+
+void RunPending();
+
+// Mark every source due by `until` pending; run it at once if unmasked
+void AdvanceTo(uint64_t until) {
+  for (;;) {
+    Source* due = nullptr;
+    for (Source& s : g_src) {
+      if (s.next <= until && (due == nullptr || s.next < due->next)) {
+        due = &s;
+      }
+    }
+    if (due == nullptr) {
+      break;
+    }
+    if (g_now < due->next) {
+      g_now = due->next;
+    }
+    due->pending = true;
+    due->next += due->period;
+    if (!g_masked) {
+      RunPending();
+    }
+  }
+  if (g_now < until) {
+    g_now = until;
+  }
+}
+
+// Loop work with interrupts live: handlers preempt it and stretch it
+void Work(uint64_t cycles) {
+  while (cycles != 0) {
+    uint64_t next = (g_src[0].next < g_src[1].next) ? g_src[0].next : g_src[1].next;
+    if (next >= g_now + cycles) {
+      g_now += cycles;
+      break;
+    }
+    if (next > g_now) {
+      cycles -= next - g_now;
+    }
+    AdvanceTo(next);  // runs the handler, which adds its own cycles
+  }
+}
+
+void RunPending() {
+  for (Source& s : g_src) {
+    if (s.pending) {
+      s.pending = false;
+      g_now += kIsrEntry;
+      if (s.posts) {
+        lp_acq_post(&g_acq, LP_ACQ_EV_SAMPLE);
+        g_posted++;
+      }
+      g_now += kIsrBody + kIsrExit;
+    }
+  }
+}
+
+uint32_t SimNow() {
+  return (uint32_t) g_now;
+}
+
+void SimIrqOff() {
+  g_masked = true;
+}
+
+void SimIrqOn() {
+  g_masked = false;
+  RunPending();
+}
+
+void SimIdle() {
+  uint64_t wake = UINT64_MAX;
+  for (const Source& s : g_src) {
+    if (s.pending) {
+      return;  // WFI does not sleep with an interrupt already pending
+    }
+    if (s.next < wake) {
+      wake = s.next;
+    }
+  }
+  AdvanceTo(wake);
+}
+
+const lp_acq_port_t kSimPort = {SimNow, SimIrqOff, SimIrqOn, SimIdle};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint64_t period = (argc > 1) ? std::strtoull(argv[1], nullptr, 0) : 52416;
+  uint64_t work = (argc > 2) ? std::strtoull(argv[2], nullptr, 0) : 600;
+  uint64_t seconds = (argc > 3) ? std::strtoull(argv[3], nullptr, 0) : 10;
+  uint64_t end = seconds * kCoreHz;
+
+  if (period == 0 || work >= period) {
+    std::fprintf(stderr, "usage: %s [sample_period work seconds], work < sample_period\n",
+                 argv[0]);
+    return 2;
+  }
+  g_src[0] = {period, period, false, true};
+  g_src[1] = {kTickPeriod, kTickPeriod, false, false};
+  lp_acq_init(&g_acq, &kSimPort);
+
+  uint64_t taken = 0;
+  while (g_now < end) {
+    uint32_t ev = lp_acq_wait(&g_acq);
+    if (ev & LP_ACQ_EV_SAMPLE) {
+      taken++;
+      Work(work);
+    }
+  }
+
+  lp_acq_report_t r;
+  lp_acq_report(&g_acq, &r);
+  double isr = (double) (kIsrEntry + kIsrBody + kIsrExit);
+  double busy = (work + isr) / (double) period + isr / (double) kTickPeriod;
+  uint32_t expect_pm = (uint32_t) ((1.0 - busy) * 1000.0);
+  // work < period: every posted sample gets its own return, the last one
+  // may still be pending when the simulation stops
+  uint64_t missed = g_posted - taken - ((g_acq.pending != 0) ? 1 : 0);
+  std::printf("simulated %.3f s, %llu samples posted, %llu taken, missed %llu\n",
+              (double) g_now / kCoreHz, (unsigned long long) g_posted,
+              (unsigned long long) taken, (unsigned long long) missed);
+  std::printf("residency %u.%u %% (analytic %u.%u %%), sleeps %u, empty wakes %u\n",
+              r.residency_pm / 10, r.residency_pm % 10, expect_pm / 10, expect_pm % 10, r.sleeps,
+              r.empty_wakes);
+  std::printf("latency cycles min %u avg %u max %u\n", r.lat_min, r.lat_avg, r.lat_max);
+  bool ok = missed == 0 && r.residency_pm + 2 >= expect_pm && r.residency_pm <= expect_pm + 2;
+  std::printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+/**
+ ******************************************************************************
+ * @file           : swo_demux.cpp
+ * @brief          : Host demultiplexer for raw SWO (ITM) captures
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   c++ -O2 -std=c++17 swo_demux.cpp -o swo_demux
+ *
+ * Usage:
+ *   swo_demux capture.bin [prefix]        (prefix defaults to "swo")
+ *
+ * The input is the raw ITM byte stream as it leaves the SWO pin with the
+ * TPIU formatter bypassed (e.g. OpenOCD "tpiu ... -output capture.bin",
+ * or any SWV raw dump). Software source packets are split by stimulus
+ * port, following the swo_trace.h port map:
+ *
+ *   port 0  text       -> <prefix>_text.txt     bytes as received
+ *   port 1  samples    -> <prefix>_samples.csv  index,word,lo16,hi16
+ *                         (lo16 unsigned, hi16 signed)
+ *   port 2  events     -> <prefix>_events.csv   index,id,cyc24,delta
+ *                         (delta = cycles since the previous event,
+ *                          modulo 2^24)
+ *   other ports        counted only
+ *
+ * Sync, timestamp, extension and hardware (DWT) packets are skipped.
+ * Overflow packets mean the target's ITM FIFO overflowed; with swo_trace
+ * the pump never overruns it, so a non-zero count points at another
+ * ITM writer. Summary on stderr.
+ ******************************************************************************
+ */
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+struct Stats {
+  uint64_t port_bytes[32] = {};
+  uint64_t packets = 0;
+  uint64_t overflow = 0;
+  uint64_t skipped = 0; // timestamp / extension / hardware packets
+  uint64_t truncated = 0;
+};
+
+// Skip continuation bytes (bit 7 set means another byte follows)
+bool SkipContinuation(std::FILE* in, int header) {
+  int c = header;
+  while (c & 0x80) {
+    if ((c = std::fgetc(in)) == EOF) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s capture.bin [prefix]\n", argv[0]);
+    return 2;
+  }
+  std::FILE* in = std::fopen(argv[1], "rb");
+  if (in == nullptr) {
+    std::perror(argv[1]);
+    return 1;
+  }
+  std::string prefix = (argc > 2) ? argv[2] : "swo";
+  std::FILE* text = std::fopen((prefix + "_text.txt").c_str(), "wb");
+  std::FILE* samples = std::fopen((prefix + "_samples.csv").c_str(), "w");
+  std::FILE* events = std::fopen((prefix + "_events.csv").c_str(), "w");
+  if (text == nullptr || samples == nullptr || events == nullptr) {
+    std::perror(prefix.c_str());
+    return 1;
+  }
+  std::fprintf(samples, "index,word,lo16,hi16\n");
+  std::fprintf(events, "index,id,cyc24,delta\n");
+
+  Stats st;
+  uint64_t n_samples = 0;
+  uint64_t n_events = 0;
+  int64_t last_cyc = -1;
+  int h;
+
+  while ((h = std::fgetc(in)) != EOF) {
+    if (h == 0x00 || h == 0x80) {
+      continue;  // synchronisation (zeros, then 0x80) / idle
+    }
+    if ((h & 0x03) != 0) {  // source packet, 1 / 2 / 4 payload bytes
+      static const int kSize[4] = {0, 1, 2, 4};
+      int size = kSize[h & 0x03];
+      uint8_t b[4];
+      int got = (int) std::fread(b, 1, (size_t) size, in);
+      if (got != size) {
+        st.truncated++;
+        break;
+      }
+      if (h & 0x04) {  // hardware source (DWT)
+        st.skipped++;
+        continue;
+      }
+      uint32_t port = (uint32_t) h >> 3;
+      uint32_t w = 0;
+      for (int i = size - 1; i >= 0; i--) {
+        w = (w << 8) | b[i];
+      }
+      st.packets++;
+      st.port_bytes[port] += (uint64_t) size;
+      if (port == 0) {
+        std::fwrite(b, 1, (size_t) size, text);
+      } else if (port == 1 && size == 4) {
+        std::fprintf(samples, "%llu,%u,%u,%d\n", (unsigned long long) n_samples++, w,
+                     w & 0xFFFFu, (int) (int16_t) (w >> 16));
+      } else if (port == 2 && size == 4) {
+        uint32_t cyc = w & 0x00FFFFFFu;
+        uint32_t delta = (last_cyc < 0) ? 0 : ((cyc - (uint32_t) last_cyc) & 0x00FFFFFFu);
+        std::fprintf(events, "%llu,%u,%u,%u\n", (unsigned long long) n_events++, w >> 24, cyc,
+                     delta);
+        last_cyc = cyc;
+      }
+      continue;
+    }
+    // protocol packets: bits [1:0] == 00
+    if (h == 0x70) {
+      st.overflow++;
+    } else if (!SkipContinuation(in, h)) {  // timestamps, extension, global ts
+      st.truncated++;
+      break;
+    } else {
+      st.skipped++;
+    }
+  }
+
+  std::fprintf(stderr, "packets %llu  overflow %llu  skipped %llu  truncated %llu\n",
+               (unsigned long long) st.packets, (unsigned long long) st.overflow,
+               (unsigned long long) st.skipped, (unsigned long long) st.truncated);
+  for (int p = 0; p < 32; p++) {
+    if (st.port_bytes[p] != 0) {
+      std::fprintf(stderr, "  port %2d: %llu bytes\n", p, (unsigned long long) st.port_bytes[p]);
+    }
+  }
+  std::fprintf(stderr, "  samples %llu  events %llu\n", (unsigned long long) n_samples,
+               (unsigned long long) n_events);
+  std::fclose(in);
+  std::fclose(text);
+  std::fclose(samples);
+  std::fclose(events);
+  return 0;
+}
@@ -0,0 +1,227 @@
+/**
+ ******************************************************************************
+ * @file           : telem_decode.cpp
+ * @brief          : Host decoder, captured telem byte stream -> CSV
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/telem.c -o telem.o
+ *   c++ -O2 -std=c++17 -I../Inc telem_decode.cpp telem.o -o telem_decode
+ *
+ * Usage:
+ *   telem_decode [-p period_ms] capture.bin > samples.csv   (or stdin)
+ *
+ * One CSV row per value: seq,t_ms,field,value. Array fields get one row
+ * per element, with t_ms advanced by the frame's period field. Frames that
+ * fail COBS/CRC are skipped and counted; sequence gaps count lost frames.
+ * The summary goes to stderr so the CSV stays clean.
+ *
+ * TELEM_FRAME_PACKED (delta_pack.h) carries no timestamp: its rows get
+ * seq = 16-bit sample index and t_ms = unwrapped index x period_ms
+ * (default 100, the h7_temp_bluetooth sample period). Index gaps count
+ * lost samples.
+ ******************************************************************************
+ */
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "delta_pack.hpp"
+#include "telem.h"
+
+namespace {
+
+struct Stats {
+  uint64_t frames = 0;
+  uint64_t bad = 0;  // COBS / CRC / field errors
+  uint64_t lost = 0; // frames missing from the seq numbers
+  uint64_t values = 0;
+  uint64_t lost_samples = 0; // TELEM_FRAME_PACKED index gaps
+};
+
+const char* FieldName(uint8_t type, uint8_t id) {
+  if (type == TELEM_FRAME_TEMP) {
+    switch (id) {
+      case TELEM_F_PERIOD_MS:
+        return "period_ms";
+      case TELEM_F_TEMP_CENTI:
+        return "temp_c";
+      case TELEM_F_ADC_CODE:
+        return "adc_code";
+      default:
+        break;
+    }
+  } else if (type == TELEM_FRAME_CAL) {
+    switch (id) {
+      case TELEM_F_CAL_STATUS:
+        return "cal_status";
+      case TELEM_F_CAL_SEQ:
+        return "cal_seq";
+      case TELEM_F_CAL_POINTS:
+        return "cal_points";
+      case TELEM_F_CAL_CODE:
+        return "cal_code";
+      default:
+        break;
+    }
+  }
+  return nullptr;
+}
+
+uint32_t Le(const uint8_t* p, int n) {
+  uint32_t v = 0;
+  for (int i = n - 1; i >= 0; i--) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+void PrintValue(uint16_t seq, uint32_t t_ms, uint8_t type, uint8_t id, int64_t v) {
+  const char* name = FieldName(type, id);
+  std::string field = name ? name : "f" + std::to_string(type) + "_" + std::to_string(id);
+
+  if (type == TELEM_FRAME_TEMP && id == TELEM_F_TEMP_CENTI) {
+    // centi-degrees printed as degrees, exact to 0.01
+    std::printf("%u,%u,%s,%s%lld.%02lld\n", seq, t_ms, field.c_str(), v < 0 ? "-" : "",
+                (long long) (v < 0 ? -v : v) / 100, (long long) (v < 0 ? -v : v) % 100);
+  } else {
+    std::printf("%u,%u,%s,%lld\n", seq, t_ms, field.c_str(), (long long) v);
+  }
+}
+
+// Walks the fields of one raw frame (CRC already stripped)
+bool DecodeFrame(const uint8_t* raw, int32_t len, Stats& st, int64_t& last_seq) {
+  if (len < (int32_t) TELEM_HDR_LEN || (raw[0] >> 4) != TELEM_VERSION) {
+    return false;
+  }
+  uint8_t type = raw[0] & 0x0F;
+  uint16_t seq = (uint16_t) Le(&raw[1], 2);
+  uint32_t t_ms = Le(&raw[3], 4);
+  uint32_t period = 0;
+
+  if (last_seq >= 0) {
+    st.lost += (uint16_t) (seq - (uint16_t) last_seq - 1U);
+  }
+  last_seq = seq;
+
+  int32_t i = TELEM_HDR_LEN;
+  while (i < len) {
+    uint8_t tag = raw[i++];
+    uint8_t id = tag >> 4;
+    static const int kSize[] = {1, 2, 2, 4, 4};
+
+    if ((tag & 0x0F) == TELEM_I16_ARRAY) {
+      if (i >= len) {
+        return false;
+      }
+      uint8_t n = raw[i++];
+      if (i + 2 * n > len) {
+        return false;
+      }
+      for (uint32_t k = 0; k < n; k++) {
+        PrintValue(seq, t_ms + k * period, type, id, (int16_t) Le(&raw[i + 2 * k], 2));
+      }
+      i += 2 * n;
+      st.values += n;
+      continue;
+    }
+    if ((tag & 0x0F) > TELEM_U32) {
+      return false;
+    }
+    int size = kSize[tag & 0x0F];
+    if (i + size > len) {
+      return false;
+    }
+    uint32_t u = Le(&raw[i], size);
+    int64_t v = u;
+    if ((tag & 0x0F) == TELEM_I16) {
+      v = (int16_t) u;
+    } else if ((tag & 0x0F) == TELEM_I32) {
+      v = (int32_t) u;
+    }
+    if (type == TELEM_FRAME_TEMP && id == TELEM_F_PERIOD_MS) {
+      period = u;
+    }
+    PrintValue(seq, t_ms, type, id, v);
+    i += size;
+    st.values++;
+  }
+  return true;
+}
+
+// One delta_pack frame: a temp_c row per sample
+bool DecodePacked(const uint8_t* raw,
+                  int32_t len,
+                  Stats& st,
+                  delta_pack::IndexUnwrap& unwrap,
+                  uint32_t period_ms) {
+  delta_pack::Frame f;
+
+  if (!delta_pack::Decode(raw, (size_t) len, f)) {
+    return false;
+  }
+  uint64_t index = unwrap.Next(f.idx, f.values.size());
+  for (size_t k = 0; k < f.values.size(); k++) {
+    PrintValue((uint16_t) (f.idx + k), (uint32_t) ((index + k) * period_ms), TELEM_FRAME_TEMP,
+               TELEM_F_TEMP_CENTI, f.values[k]);
+  }
+  st.values += f.values.size();
+  st.lost_samples = unwrap.lost();
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::FILE* in = stdin;
+  uint32_t period_ms = 100;
+  int arg = 1;
+
+  if (argc > 2 && std::string(argv[1]) == "-p") {
+    period_ms = (uint32_t) std::stoul(argv[2]);
+    arg = 3;
+  }
+  if (argc > arg && (in = std::fopen(argv[arg], "rb")) == nullptr) {
+    std::perror(argv[arg]);
+    return 1;
+  }
+
+  Stats st;
+  int64_t last_seq = -1;
+  delta_pack::IndexUnwrap unwrap;
+  std::vector<uint8_t> enc;
+  std::vector<uint8_t> raw;
+  int c;
+
+  std::printf("seq,t_ms,field,value\n");
+  while ((c = std::fgetc(in)) != EOF) {
+    if (c != 0) {
+      enc.push_back((uint8_t) c);
+      continue;
+    }
+    if (enc.empty()) {
+      continue;  // idle delimiters
+    }
+    raw.resize(enc.size());
+    int32_t len = telem_unframe(enc.data(), (uint32_t) enc.size(), raw.data());
+    bool ok = len > 0 && ((raw[0] & 0x0F) == TELEM_FRAME_PACKED
+                              ? DecodePacked(raw.data(), len, st, unwrap, period_ms)
+                              : DecodeFrame(raw.data(), len, st, last_seq));
+    if (!ok) {
+      st.bad++;
+    } else {
+      st.frames++;
+    }
+    enc.clear();
+  }
+
+  std::fprintf(stderr, "frames %llu  bad %llu  lost %llu  values %llu  lost samples %llu\n",
+               (unsigned long long) st.frames, (unsigned long long) st.bad,
+               (unsigned long long) st.lost, (unsigned long long) st.values,
+               (unsigned long long) st.lost_samples);
+  if (in != stdin) {
+    std::fclose(in);
+  }
+  return 0;
+}
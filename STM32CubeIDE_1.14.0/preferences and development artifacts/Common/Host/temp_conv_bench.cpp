@@ -0,0 +1,242 @@
+/**
+ ******************************************************************************
+ * @file           : temp_conv_bench.cpp
+ * @brief          : temp_conv accuracy and timing against the float RM formula
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/temp_conv.c -o temp_conv.o
+ *   c++ -O2 -std=c++17 -I../Inc temp_conv_bench.cpp temp_conv.o -o temp_conv_bench
+ *
+ * Usage:
+ *   temp_conv_bench [samples pairs]
+ *
+ *   samples  timing trace length           (default 1M)
+ *   pairs    random calibrations checked   (default 200)
+ *
+ * Accuracy: for every 16-bit code and each calibration (fixed ones plus
+ * random pairs of span 1 .. 32767 codes, rising and falling, assorted T1 /
+ * T2), temp_conv_q16 and temp_conv_block against the exact formula rounded
+ * half-up to Q16.16 (128-bit integer reference). Any mismatch is a FAIL,
+ * and so is a usable calibration rejected or an unusable one accepted.
+ * The float formula the projects used before (RM0399, single precision)
+ * and its double form are held against the same reference, in m°C.
+ *
+ * Timing (ns/sample on this host): float formula per sample,
+ * temp_conv_q16, temp_conv_block. Target cycles are a separate
+ * measurement. Exit status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "temp_conv.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Cal {
+  uint16_t code1, code2;
+  double t1, t2;
+};
+
+// H7 factory-like spans, a falling one, a near-limit one
+const Cal kCals[] = {
+    {12400, 15900, 30.0, 110.0},
+    {12000, 16100, 30.0, 110.0},
+    {15900, 12400, 30.0, 110.0},
+    {1000, 33000, -40.0, 125.0},
+    {20000, 20200, 25.5, 85.25},
+};
+
+// temp_conv_init has to refuse these (equal codes, >= 0.5 °C/code)
+const Cal kRejects[] = {
+    {20000, 20000, 30.0, 110.0},
+    {20000, 20160, 30.0, 110.0},
+    {20000, 20001, 25.5, 85.25},
+};
+
+// floor(a / b) for b > 0
+__int128 FloorDiv(__int128 a, __int128 b) {
+  __int128 q = a / b;
+  return (a % b != 0 && a < 0) ? q - 1 : q;
+}
+
+// T1 + (T2 - T1) * (code - C1) / (C2 - C1), Q16.16, rounded half-up
+int32_t Exact(int32_t t1_q16, int32_t t2_q16, int32_t c1, int32_t c2, int32_t code) {
+  __int128 num = (__int128) (t2_q16 - t1_q16) * (code - c1);
+  __int128 den = c2 - c1;
+  if (den < 0) {
+    num = -num;
+    den = -den;
+  }
+  return t1_q16 + (int32_t) FloorDiv(2 * num + den, 2 * den);
+}
+
+float RmFloat(const Cal& c, uint16_t code) {
+  return ((float) ((int32_t) code - c.code1) * (float) (c.t2 - c.t1)) /
+             (float) ((int32_t) c.code2 - c.code1) +
+         (float) c.t1;
+}
+
+struct Stats {
+  uint32_t bad = 0;        // temp_conv vs exact
+  double float_max = 0;    // m°C
+  double double_max = 0;
+};
+
+// false when the calibration is rejected (expected only past the limits)
+bool Check(const Cal& c, Stats* st) {
+  temp_conv_t tc;
+  int32_t t1 = TEMP_CONV_Q16(c.t1);
+  int32_t t2 = TEMP_CONV_Q16(c.t2);
+  if (temp_conv_init(&tc, c.code1, c.code2, t1, t2) != 0) {
+    return false;
+  }
+  static std::vector<uint16_t> codes(65536);
+  static std::vector<int32_t> out(65536);
+  for (uint32_t i = 0; i < 65536U; i++) {
+    codes[i] = (uint16_t) i;
+  }
+  temp_conv_block(&tc, codes.data(), out.data(), 65536U);
+  for (uint32_t code = 0; code < 65536U; code++) {
+    int32_t ref = Exact(t1, t2, c.code1, c.code2, (int32_t) code);
+    if (temp_conv_q16(&tc, (uint16_t) code) != ref || out[code] != ref) {
+      if (st->bad++ < 5) {
+        std::printf("    mismatch cal %u/%u code %u: %d, block %d, exact %d\n", c.code1,
+                    c.code2, code, temp_conv_q16(&tc, (uint16_t) code), out[code], ref);
+      }
+    }
+    double ref_c = ref / 65536.0;
+    double d = c.t1 + (c.t2 - c.t1) * ((double) code - c.code1) / ((double) c.code2 - c.code1);
+    st->float_max = std::fmax(st->float_max, std::fabs(RmFloat(c, (uint16_t) code) - ref_c) * 1e3);
+    st->double_max = std::fmax(st->double_max, std::fabs(d - ref_c) * 1e3);
+  }
+  return true;
+}
+
+volatile int32_t g_sink;  // keeps the timed loops from being optimised away
+
+template <typename F>
+double NsPerSample(size_t n, F&& f) {
+  uint64_t reps = 0;
+  auto t0 = Clock::now();
+  std::chrono::duration<double> dt{};
+  do {
+    f();
+    reps++;
+    dt = Clock::now() - t0;
+  } while (dt.count() < 0.2);
+  return dt.count() * 1e9 / ((double) reps * (double) n);
+}
+
+void Bench(size_t n) {
+  const Cal& c = kCals[0];
+  temp_conv_t tc;
+  temp_conv_init(&tc, c.code1, c.code2, TEMP_CONV_Q16(c.t1), TEMP_CONV_Q16(c.t2));
+  // codes around room temperature with a few LSB of noise and a slow ramp
+  std::vector<uint16_t> codes(n);
+  std::vector<int32_t> q16(n);
+  std::vector<float> fl(n);
+  uint32_t lcg = 12345;
+  for (size_t i = 0; i < n; i++) {
+    lcg = lcg * 1664525U + 1013904223U;
+    codes[i] = (uint16_t) (11000 + (i * 5000) / n + (lcg >> 28));
+  }
+
+  double flt = NsPerSample(n, [&] {
+    for (size_t i = 0; i < n; i++) {
+      fl[i] = RmFloat(c, codes[i]);
+    }
+    g_sink = g_sink + (int32_t) fl[n / 2];
+  });
+  double one = NsPerSample(n, [&] {
+    for (size_t i = 0; i < n; i++) {
+      q16[i] = temp_conv_q16(&tc, codes[i]);
+    }
+    g_sink = g_sink + q16[n / 2];
+  });
+  double block = NsPerSample(n, [&] {
+    temp_conv_block(&tc, codes.data(), q16.data(), (uint32_t) n);
+    g_sink = g_sink + q16[n / 2];
+  });
+
+  std::printf("\n%zu samples, ns/sample:\n", n);
+  std::printf("  float RM formula   %6.2f\n", flt);
+  std::printf("  temp_conv_q16      %6.2f  (%.2fx)\n", one, flt / one);
+  std::printf("  temp_conv_block    %6.2f  (%.2fx)\n", block, flt / block);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t n = (argc > 1) ? (size_t) std::strtoul(argv[1], nullptr, 0) : (1U << 20);
+  uint32_t pairs = (argc > 2) ? (uint32_t) std::strtoul(argv[2], nullptr, 0) : 200;
+  static const double kTemps[][2] = {{30, 110}, {-40, 125}, {25.5, 85.25}, {110, 30}};
+  bool ok = true;
+
+  if (n == 0) {
+    std::fprintf(stderr, "usage: temp_conv_bench [samples pairs]\n");
+    return 2;
+  }
+  std::printf("all 65536 codes vs exact Q16.16 (half-up):\n");
+  for (const Cal& c : kCals) {
+    Stats st;
+    if (!Check(c, &st)) {
+      std::printf("  cal %5u/%5u  rejected  FAIL\n", c.code1, c.code2);
+      ok = false;
+      continue;
+    }
+    std::printf("  cal %5u/%5u %7.2f/%7.2f C  mismatches %u  float %7.3f m°C  double %.6f m°C  %s\n",
+                c.code1, c.code2, c.t1, c.t2, st.bad, st.float_max, st.double_max,
+                st.bad == 0 ? "ok" : "FAIL");
+    ok = ok && st.bad == 0;
+  }
+
+  for (const Cal& c : kRejects) {
+    temp_conv_t tc;
+    bool rej = temp_conv_init(&tc, c.code1, c.code2, TEMP_CONV_Q16(c.t1), TEMP_CONV_Q16(c.t2)) != 0;
+    std::printf("  cal %5u/%5u %7.2f/%7.2f C  rejected %s\n", c.code1, c.code2, c.t1, c.t2,
+                rej ? "ok" : "FAIL");
+    ok = ok && rej;
+  }
+
+  Stats all;
+  uint32_t rejected = 0;
+  uint32_t lcg = 2024;
+  for (uint32_t i = 0; i < pairs; i++) {
+    lcg = lcg * 1664525U + 1013904223U;
+    uint16_t c1 = (uint16_t) (lcg >> 16);
+    lcg = lcg * 1664525U + 1013904223U;
+    int32_t span = 1 + (int32_t) ((lcg >> 8) % 32767U);
+    int32_t c2 = (lcg & 1U) ? c1 + span : c1 - span;
+    if (c2 < 0 || c2 > 65535) {
+      c2 = (lcg & 1U) ? c1 - span : c1 + span;
+    }
+    if (c2 < 0 || c2 > 65535) {
+      continue;
+    }
+    const double* t = kTemps[i % 4];
+    Cal c = {c1, (uint16_t) c2, t[0], t[1]};
+    if (!Check(c, &all)) {
+      rejected++;  // slope >= 0.5 °C/code: only for spans below 160 codes here
+      if (span >= 170) {
+        std::printf("  cal %u/%u rejected  FAIL\n", c1, c2);
+        ok = false;
+      }
+    }
+  }
+  std::printf("  %u random calibrations (%u rejected, slope >= 0.5 C/code): mismatches %u,"
+              " float worst %.3f m°C  %s\n",
+              pairs, rejected, all.bad, all.float_max, all.bad == 0 ? "ok" : "FAIL");
+  ok = ok && all.bad == 0;
+
+  Bench(n);
+  std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,289 @@
+/**
+ ******************************************************************************
+ * @file           : temp_lut_bench.cpp
+ * @brief          : temp_lut error and timing against the formula it replaces
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/temp_lut.c -o temp_lut.o
+ *   cc  -O2 -I../Inc -c ../Src/temp_conv.c -o temp_conv.o
+ *   c++ -O2 -std=c++17 -I../Inc temp_lut_bench.cpp temp_lut.o temp_conv.o -o temp_lut_bench
+ *
+ * Usage:
+ *   temp_lut_bench [samples]
+ *
+ *   samples  timing trace length (default 1M)
+ *
+ * Accuracy: every 16-bit code through temp_lut_q16 and temp_lut_block,
+ * against the exact piecewise-linear curve through the points (double,
+ * outer segments extended), in Q16.16 LSB:
+ *
+ *   factory   TS_CAL1/TS_CAL2 only; also against temp_conv_q16, the
+ *             two-point formula the table replaces
+ *   on grid   interior points on 256-code cell starts (outer points
+ *             anywhere: their segments extend, no corner)
+ *   off grid  interior points inside a cell; the cells holding such a
+ *             corner are reported apart (smoothed over one cell by design)
+ *
+ * Limits from temp_lut.h: within 6 LSB (< 0.0001 deg C) everywhere for the
+ * factory and on-grid sets and outside the corner cells otherwise, and the
+ * corner cells within the curve's own bend over one cell. temp_lut_build
+ * has to refuse 1 or 9 points, a repeated code and a slope above 1/8
+ * deg C per code.
+ *
+ * Timing (ns/sample on this host): float RM formula, temp_conv_q16,
+ * temp_lut_q16, temp_lut_block, and the curve evaluated per sample
+ * (segment search plus a division, what the table avoids). Target cycles
+ * come from Temp_H7_print (conv_cycles_formula / conv_cycles_lut). Exit
+ * status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "temp_conv.h"
+#include "temp_lut.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double kMaxLsb = 6.0;  // < 0.0001 deg C
+
+struct Set {
+  const char* name;
+  std::vector<temp_lut_point_t> pts;
+};
+
+temp_lut_point_t P(uint16_t code, double t) {
+  return {code, TEMP_CONV_Q16(t)};
+}
+
+// Curve through the points as temp_lut defines it, Q16.16, unrounded
+double Curve(std::vector<temp_lut_point_t> p, double c) {
+  for (size_t i = 1; i < p.size(); i++) {
+    for (size_t j = i; j > 0 && p[j - 1].code > p[j].code; j--) {
+      std::swap(p[j - 1], p[j]);
+    }
+  }
+  size_t k = 0;
+  while (k + 2 < p.size() && c > p[k + 1].code) {
+    k++;
+  }
+  return p[k].t_q16 + (double) (p[k + 1].t_q16 - p[k].t_q16) * (c - p[k].code) /
+                          ((double) p[k + 1].code - p[k].code);
+}
+
+// Cell holds an interior point (a real corner) strictly inside it; the
+// outer points do not bend the curve, their segments extend
+bool CornerCell(const std::vector<temp_lut_point_t>& p, uint32_t cell) {
+  uint16_t lo = 0xFFFF, hi = 0;
+  for (const temp_lut_point_t& q : p) {
+    lo = (q.code < lo) ? q.code : lo;
+    hi = (q.code > hi) ? q.code : hi;
+  }
+  for (const temp_lut_point_t& q : p) {
+    if (q.code != lo && q.code != hi && (q.code >> TEMP_LUT_SHIFT) == cell &&
+        (q.code & TEMP_LUT_MASK) != 0U) {
+      return true;
+    }
+  }
+  return false;
+}
+
+struct Err {
+  double max = 0;         // LSB, outside corner cells
+  double corner = 0;      // LSB, inside corner cells
+  double corner_bend = 0; // LSB, largest corner-cell deviation allowed
+  uint32_t block_diff = 0;
+};
+
+Err Check(const std::vector<temp_lut_point_t>& pts, const temp_lut_t& lut) {
+  static std::vector<uint16_t> codes(65536);
+  static std::vector<int32_t> out(65536);
+  Err e;
+  for (uint32_t i = 0; i < 65536U; i++) {
+    codes[i] = (uint16_t) i;
+  }
+  temp_lut_block(&lut, codes.data(), out.data(), 65536U);
+  for (uint32_t c = 0; c < 65536U; c++) {
+    int32_t got = temp_lut_q16(&lut, (uint16_t) c);
+    double d = std::fabs(got - Curve(pts, c));
+    if (out[c] != got) {
+      e.block_diff++;
+    }
+    uint32_t cell = c >> TEMP_LUT_SHIFT;
+    if (CornerCell(pts, cell)) {
+      e.corner = std::fmax(e.corner, d);
+      // the chord over the cell against the curve: how far the bend is
+      double c0 = (double) (cell << TEMP_LUT_SHIFT);
+      double c1 = c0 + (1U << TEMP_LUT_SHIFT);
+      double chord = Curve(pts, c0) + (Curve(pts, c1) - Curve(pts, c0)) * (c - c0) / (c1 - c0);
+      e.corner_bend = std::fmax(e.corner_bend, std::fabs(chord - Curve(pts, c)) + kMaxLsb);
+    } else {
+      e.max = std::fmax(e.max, d);
+    }
+  }
+  return e;
+}
+
+volatile int32_t g_sink;  // keeps the timed loops from being optimised away
+
+template <typename F>
+double NsPerSample(size_t n, F&& f) {
+  uint64_t reps = 0;
+  auto t0 = Clock::now();
+  std::chrono::duration<double> dt{};
+  do {
+    f();
+    reps++;
+    dt = Clock::now() - t0;
+  } while (dt.count() < 0.2);
+  return dt.count() * 1e9 / ((double) reps * (double) n);
+}
+
+// Per-sample evaluation of the sorted points, the work the table saves
+int32_t Direct(const temp_lut_point_t* p, uint32_t n, uint16_t code) {
+  uint32_t k = 0;
+  while (k + 2U < n && code > p[k + 1U].code) {
+    k++;
+  }
+  int64_t dc = (int64_t) p[k + 1U].code - p[k].code;
+  int64_t num = ((int64_t) p[k + 1U].t_q16 - p[k].t_q16) * ((int64_t) code - p[k].code);
+  num += (num >= 0) ? dc / 2 : -(dc / 2);
+  return p[k].t_q16 + (int32_t) (num / dc);
+}
+
+void Bench(size_t n) {
+  const uint16_t cal1 = 12400, cal2 = 15900;
+  const temp_lut_point_t pts[] = {P(cal1, 30.0), P(13000, 41.5), P(cal2, 110.0)};
+  temp_conv_t tc;
+  static temp_lut_t lut;
+  temp_conv_init(&tc, cal1, cal2, TEMP_CONV_Q16(30.0), TEMP_CONV_Q16(110.0));
+  temp_lut_build(&lut, pts, 3);
+
+  std::vector<uint16_t> codes(n);
+  std::vector<int32_t> q16(n);
+  std::vector<float> fl(n);
+  uint32_t lcg = 12345;
+  for (size_t i = 0; i < n; i++) {
+    lcg = lcg * 1664525U + 1013904223U;
+    codes[i] = (uint16_t) (11000 + (i * 5000) / n + (lcg >> 28));
+  }
+
+  double flt = NsPerSample(n, [&] {
+    for (size_t i = 0; i < n; i++) {
+      fl[i] = ((float) ((int32_t) codes[i] - cal1) * 80.0f) / (float) (cal2 - cal1) + 30.0f;
+    }
+    g_sink = g_sink + (int32_t) fl[n / 2];
+  });
+  double conv = NsPerSample(n, [&] {
+    for (size_t i = 0; i < n; i++) {
+      q16[i] = temp_conv_q16(&tc, codes[i]);
+    }
+    g_sink = g_sink + q16[n / 2];
+  });
+  double one = NsPerSample(n, [&] {
+    for (size_t i = 0; i < n; i++) {
+      q16[i] = temp_lut_q16(&lut, codes[i]);
+    }
+    g_sink = g_sink + q16[n / 2];
+  });
+  double block = NsPerSample(n, [&] {
+    temp_lut_block(&lut, codes.data(), q16.data(), (uint32_t) n);
+    g_sink = g_sink + q16[n / 2];
+  });
+  double direct = NsPerSample(n, [&] {
+    for (size_t i = 0; i < n; i++) {
+      q16[i] = Direct(pts, 3, codes[i]);
+    }
+    g_sink = g_sink + q16[n / 2];
+  });
+  double build = NsPerSample(1, [&] {
+    temp_lut_build(&lut, pts, 3);
+    g_sink = g_sink + lut.base[100];
+  });
+
+  std::printf("\n%zu samples, ns/sample:\n", n);
+  std::printf("  float RM formula      %6.2f  (2 points only)\n", flt);
+  std::printf("  temp_conv_q16         %6.2f  (2 points only)\n", conv);
+  std::printf("  curve per sample      %6.2f  (3 points: search + divide)\n", direct);
+  std::printf("  temp_lut_q16          %6.2f  (%.2fx the curve)\n", one, direct / one);
+  std::printf("  temp_lut_block        %6.2f  (%.2fx the curve)\n", block, direct / block);
+  std::printf("  temp_lut_build        %6.0f us once at boot\n", build / 1000.0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t n = (argc > 1) ? (size_t) std::strtoul(argv[1], nullptr, 0) : (1U << 20);
+  bool ok = true;
+
+  if (n == 0) {
+    std::fprintf(stderr, "usage: temp_lut_bench [samples]\n");
+    return 2;
+  }
+  const Set sets[] = {
+      {"factory", {P(12400, 30.0), P(15900, 110.0)}},
+      {"factory b", {P(11950, 30.0), P(16200, 110.0)}},
+      {"on grid", {P(12400, 30.0), P(15900, 110.0), P(12800, 39.5)}},
+      {"on grid 6", {P(11776, 15.0), P(12288, 27.4), P(13056, 44.0), P(14336, 74.0),
+                     P(15872, 109.4), P(17408, 141.0)}},
+      {"off grid", {P(12400, 30.0), P(15900, 110.0), P(13001, 41.0)}},
+      {"off grid 8", {P(12400, 30.0), P(15900, 110.0), P(11000, -2.0), P(12111, 23.1),
+                      P(13333, 52.0), P(14000, 66.6), P(15000, 90.3), P(18000, 155.5)}},
+  };
+
+  std::printf("all 65536 codes vs the exact piecewise-linear curve, Q16.16 LSB:\n");
+  for (const Set& s : sets) {
+    static temp_lut_t lut;
+    if (temp_lut_build(&lut, s.pts.data(), (uint32_t) s.pts.size()) != 0) {
+      std::printf("  %-10s rejected  FAIL\n", s.name);
+      ok = false;
+      continue;
+    }
+    Err e = Check(s.pts, lut);
+    bool pass = e.max <= kMaxLsb && e.corner <= e.corner_bend && e.block_diff == 0;
+    std::printf("  %-10s %u pts  max %5.2f LSB (%.6f C)", s.name, (unsigned) s.pts.size(), e.max,
+                e.max / 65536.0);
+    if (e.corner > 0) {
+      std::printf("  corner cells %7.1f LSB (%.4f C, bend %.1f)", e.corner, e.corner / 65536.0,
+                  e.corner_bend);
+    }
+    if (s.pts.size() == 2) {
+      temp_conv_t tc;
+      int32_t worst = 0;
+      temp_conv_init(&tc, s.pts[0].code, s.pts[1].code, s.pts[0].t_q16, s.pts[1].t_q16);
+      for (uint32_t c = 0; c < 65536U; c++) {
+        int32_t d = temp_lut_q16(&lut, (uint16_t) c) - temp_conv_q16(&tc, (uint16_t) c);
+        worst = (std::abs(d) > worst) ? std::abs(d) : worst;
+      }
+      std::printf("  vs temp_conv %d LSB", worst);
+      pass = pass && worst <= (int32_t) kMaxLsb;
+    }
+    std::printf("  %s\n", pass ? "ok" : "FAIL");
+    ok = ok && pass;
+  }
+
+  const Set rejects[] = {
+      {"1 point", {P(12400, 30.0)}},
+      {"9 points", {P(1000, 0), P(2000, 1), P(3000, 2), P(4000, 3), P(5000, 4), P(6000, 5),
+                    P(7000, 6), P(8000, 7), P(9000, 8)}},
+      {"same code", {P(12400, 30.0), P(15900, 110.0), P(12400, 31.0)}},
+      {"too steep", {P(12400, 30.0), P(12407, 31.0)}},
+  };
+  for (const Set& s : rejects) {
+    static temp_lut_t lut;
+    bool rej = temp_lut_build(&lut, s.pts.data(), (uint32_t) s.pts.size()) != 0;
+    std::printf("  %-10s rejected %s\n", s.name, rej ? "ok" : "FAIL");
+    ok = ok && rej;
+  }
+
+  Bench(n);
+  std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
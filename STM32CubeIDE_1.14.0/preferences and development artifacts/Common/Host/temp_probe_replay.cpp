@@ -0,0 +1,333 @@
+/**
+ ******************************************************************************
+ * @file           : temp_probe_replay.cpp
+ * @brief          : Replays ADC code traces through temp_probe, per-stage timing
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/temp_probe.c -o temp_probe.o
+ *   c++ -O2 -std=c++17 -I../Inc temp_probe_replay.cpp temp_probe.o -o temp_probe_replay
+ *
+ * Usage:
+ *   temp_probe_replay [options] trace.csv     text: last number of each line
+ *   temp_probe_replay [options] -b trace.bin  little-endian uint16 codes
+ *   temp_probe_replay [options] -g ramp|noise|step[:n]   generated codes
+ *
+ *   -c cal1,cal2  TS_CAL1 / TS_CAL2 words      (default 12400,15900)
+ *   -t t1,t2      their temperatures, deg C    (default 30,110)
+ *   -v mv         VREF+ of the trace           (default 3300)
+ *   -n len        codes per block              (default ADC_STREAM_BLOCK_LEN)
+ *   -o out.csv    output trace, one row per block
+ *   -r ref.csv    compare the output trace with a previous one, exit 1 on
+ *                 any difference (numeric regression check)
+ *
+ * The trace is cut into DMA-half blocks and run through the same
+ * temp_probe.c as temp_h7_cm7_dma: mean -> celsius -> dac. Timing:
+ *   throughput  each stage alone over the whole trace, repeated >= 0.2 s
+ *   latency     every call stamped, p50 / p90 / p99 / max in ns, with the
+ *               cost of an empty stamp pair subtracted
+ * Host numbers are for comparing changes; cycles on the target are a
+ * separate measurement (DWT).
+ ******************************************************************************
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "adc_stream.h"
+#include "temp_probe.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double Ns(Clock::duration d) {
+  return std::chrono::duration<double, std::nano>(d).count();
+}
+
+bool LoadText(const char* path, std::vector<uint16_t>& codes) {
+  std::FILE* f = std::fopen(path, "r");
+  if (f == nullptr) {
+    std::perror(path);
+    return false;
+  }
+  char line[512];
+  while (std::fgets(line, sizeof(line), f) != nullptr) {
+    const char* last = std::strrchr(line, ',');
+    last = (last != nullptr) ? last + 1 : line;
+    char* end;
+    long v = std::strtol(last, &end, 0);
+    if (end == last || v < 0 || v > 0xFFFF) {
+      continue;  // header, blank or out-of-range line
+    }
+    codes.push_back((uint16_t) v);
+  }
+  std::fclose(f);
+  return true;
+}
+
+bool LoadBinary(const char* path, std::vector<uint16_t>& codes) {
+  std::FILE* f = std::fopen(path, "rb");
+  if (f == nullptr) {
+    std::perror(path);
+    return false;
+  }
+  uint8_t b[2];
+  while (std::fread(b, 1, 2, f) == 2) {
+    codes.push_back((uint16_t) (b[0] | (b[1] << 8)));
+  }
+  std::fclose(f);
+  return true;
+}
+
+// Codes a sensor at deg C would give, with +-noise codes
+bool Generate(const std::string& spec, const temp_probe_cal_t& c, std::vector<uint16_t>& codes) {
+  std::string kind = spec.substr(0, spec.find(':'));
+  size_t n = (spec.find(':') != std::string::npos)
+                 ? std::strtoul(spec.c_str() + spec.find(':') + 1, nullptr, 0)
+                 : 64000;
+  double per_c = ((double) c.ts_cal2 - c.ts_cal1) / (double) (c.cal2_temp - c.cal1_temp);
+  uint32_t lcg = 1;
+  auto noise = [&](int amp) {
+    lcg = lcg * 1664525U + 1013904223U;
+    return (int) ((lcg >> 16) % (uint32_t) (2 * amp + 1)) - amp;
+  };
+
+  for (size_t i = 0; i < n; i++) {
+    double t;
+    if (kind == "ramp") {
+      t = -20.0 + 120.0 * (double) i / (double) n;  // every clamp edge
+    } else if (kind == "noise") {
+      t = 45.0;
+    } else if (kind == "step") {
+      t = ((i / 4096) % 2) ? 60.0 : 20.0;
+    } else {
+      return false;
+    }
+    long code = std::lround(c.ts_cal1 + (t - c.cal1_temp) * per_c) + noise(12);
+    codes.push_back((uint16_t) std::clamp(code, 0L, 65535L));
+  }
+  return true;
+}
+
+struct Stage {
+  const char* name;
+  std::vector<double> lat;  // ns per call
+  double throughput = 0;    // calls per second, stage alone
+  double items = 1;         // items per call (codes for mean)
+};
+
+double Percentile(std::vector<double>& v, double p) {
+  size_t k = (size_t) (p * (double) (v.size() - 1));
+  std::nth_element(v.begin(), v.begin() + k, v.end());
+  return v[k];
+}
+
+// Runs fn over every block until >= 0.2 s, returns calls per second
+template <class Fn>
+double Throughput(size_t blocks, Fn fn) {
+  uint64_t calls = 0;
+  auto t0 = Clock::now();
+  Clock::duration dt{};
+  do {
+    for (size_t b = 0; b < blocks; b++) {
+      fn(b);
+    }
+    calls += blocks;
+    dt = Clock::now() - t0;
+  } while (dt < std::chrono::milliseconds(200));
+  return (double) calls / (Ns(dt) * 1e-9);
+}
+
+volatile uint32_t g_sink;  // keeps the timed stages from being optimised away
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  temp_probe_cal_t cal = {12400, 15900, 30, 110, 3300, 3300, 16};
+  uint32_t block = ADC_STREAM_BLOCK_LEN;
+  const char* out_path = nullptr;
+  const char* ref_path = nullptr;
+  const char* gen = nullptr;
+  const char* trace = nullptr;
+  bool binary = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    bool has = i + 1 < argc;
+    if (a == "-b") {
+      binary = true;
+    } else if (a == "-g" && has) {
+      gen = argv[++i];
+    } else if (a == "-c" && has) {
+      unsigned c1, c2;
+      if (std::sscanf(argv[++i], "%u,%u", &c1, &c2) != 2) {
+        return 2;
+      }
+      cal.ts_cal1 = (uint16_t) c1;
+      cal.ts_cal2 = (uint16_t) c2;
+    } else if (a == "-t" && has) {
+      if (std::sscanf(argv[++i], "%d,%d", &cal.cal1_temp, &cal.cal2_temp) != 2) {
+        return 2;
+      }
+    } else if (a == "-v" && has) {
+      cal.vref_mv = (uint32_t) std::strtoul(argv[++i], nullptr, 0);
+    } else if (a == "-n" && has) {
+      block = (uint32_t) std::strtoul(argv[++i], nullptr, 0);
+    } else if (a == "-o" && has) {
+      out_path = argv[++i];
+    } else if (a == "-r" && has) {
+      ref_path = argv[++i];
+    } else if (a[0] != '-') {
+      trace = argv[i];
+    } else {
+      trace = nullptr;
+      gen = nullptr;
+      break;
+    }
+  }
+  if ((trace == nullptr) == (gen == nullptr) || block == 0 || cal.ts_cal1 == cal.ts_cal2 ||
+      cal.cal_vref_mv == 0) {
+    std::fprintf(stderr,
+                 "usage: %s [-c cal1,cal2] [-t t1,t2] [-v mv] [-n len] [-o out.csv] "
+                 "[-r ref.csv] (trace.csv | -b trace.bin | -g ramp|noise|step[:n])\n",
+                 argv[0]);
+    return 2;
+  }
+
+  std::vector<uint16_t> codes;
+  bool loaded = gen ? Generate(gen, cal, codes)
+                    : (binary ? LoadBinary(trace, codes) : LoadText(trace, codes));
+  if (!loaded) {
+    return 2;
+  }
+  size_t blocks = codes.size() / block;
+  if (blocks == 0) {
+    std::fprintf(stderr, "%zu codes: less than one block of %u\n", codes.size(), block);
+    return 2;
+  }
+
+  // Functional pass: output trace
+  std::vector<temp_probe_out_t> out(blocks);
+  for (size_t b = 0; b < blocks; b++) {
+    temp_probe_block(&cal, &codes[b * block], block, &out[b]);
+  }
+  std::vector<std::string> rows;
+  rows.push_back("block,mean,temp_c,temp_equivalent,dac_temp,roomtemp,dac_roomtemp");
+  for (size_t b = 0; b < blocks; b++) {
+    char line[128];
+    std::snprintf(line, sizeof(line), "%zu,%u,%d,%u,%u,%u,%u", b, out[b].mean, out[b].temp_c,
+                  out[b].temp_equivalent, out[b].dac_temp, out[b].roomtemp, out[b].dac_roomtemp);
+    rows.push_back(line);
+  }
+  if (out_path != nullptr) {
+    std::FILE* f = std::fopen(out_path, "w");
+    if (f == nullptr) {
+      std::perror(out_path);
+      return 2;
+    }
+    for (const std::string& r : rows) {
+      std::fprintf(f, "%s\n", r.c_str());
+    }
+    std::fclose(f);
+  }
+
+  // Latency pass: every call stamped
+  Stage st[4] = {{"mean", {}, 0, (double) block}, {"celsius", {}, 0, 1}, {"dac", {}, 0, 1},
+                 {"block", {}, 0, (double) block}};
+  std::vector<double> empty;
+  uint32_t sink = 0;
+  for (int pass = 0; pass < 20 || empty.size() < 100000; pass++) {
+    for (size_t b = 0; b < blocks; b++) {
+      const uint16_t* p = &codes[b * block];
+      temp_probe_out_t o;
+      auto t0 = Clock::now();
+      auto t1 = Clock::now();
+      uint16_t m = temp_probe_mean(p, block);
+      auto t2 = Clock::now();
+      int32_t c = temp_probe_celsius(&cal, m);
+      auto t3 = Clock::now();
+      temp_probe_dac(c, &o);
+      auto t4 = Clock::now();
+      temp_probe_block(&cal, p, block, &o);
+      auto t5 = Clock::now();
+      sink += o.dac_temp;
+      empty.push_back(Ns(t1 - t0));
+      st[0].lat.push_back(Ns(t2 - t1));
+      st[1].lat.push_back(Ns(t3 - t2));
+      st[2].lat.push_back(Ns(t4 - t3));
+      st[3].lat.push_back(Ns(t5 - t4));
+    }
+  }
+  double stamp = Percentile(empty, 0.5);
+
+  // Throughput pass: each stage alone, no stamps
+  std::vector<uint16_t> means(blocks);
+  std::vector<int32_t> temps(blocks);
+  for (size_t b = 0; b < blocks; b++) {
+    means[b] = out[b].mean;
+    temps[b] = out[b].temp_c;
+  }
+  st[0].throughput =
+      Throughput(blocks, [&](size_t b) { sink += temp_probe_mean(&codes[b * block], block); });
+  st[1].throughput =
+      Throughput(blocks, [&](size_t b) { sink += (uint32_t) temp_probe_celsius(&cal, means[b]); });
+  st[2].throughput = Throughput(blocks, [&](size_t b) {
+    temp_probe_out_t o;
+    temp_probe_dac(temps[b], &o);
+    sink += o.dac_roomtemp;
+  });
+  st[3].throughput = Throughput(blocks, [&](size_t b) {
+    temp_probe_out_t o;
+    temp_probe_block(&cal, &codes[b * block], block, &o);
+    sink += o.dac_temp;
+  });
+  g_sink = sink;
+
+  std::printf("%zu codes, %zu blocks of %u, cal %u/%u at %d/%d C, vref %u mV\n", codes.size(),
+              blocks, block, cal.ts_cal1, cal.ts_cal2, cal.cal1_temp, cal.cal2_temp, cal.vref_mv);
+  std::printf("stamp overhead %.1f ns (subtracted)\n", stamp);
+  std::printf("%-8s %14s %14s %8s %8s %8s %8s\n", "stage", "calls/s", "codes/s", "p50 ns",
+              "p90 ns", "p99 ns", "max ns");
+  for (Stage& s : st) {
+    for (double& v : s.lat) {
+      v = std::max(0.0, v - stamp);
+    }
+    double mx = *std::max_element(s.lat.begin(), s.lat.end());
+    std::printf("%-8s %14.0f %14.0f %8.1f %8.1f %8.1f %8.1f\n", s.name, s.throughput,
+                s.throughput * s.items, Percentile(s.lat, 0.50), Percentile(s.lat, 0.90),
+                Percentile(s.lat, 0.99), mx);
+  }
+
+  if (ref_path != nullptr) {
+    std::FILE* f = std::fopen(ref_path, "r");
+    if (f == nullptr) {
+      std::perror(ref_path);
+      return 2;
+    }
+    char line[256];
+    size_t n = 0;
+    size_t diff = 0;
+    while (std::fgets(line, sizeof(line), f) != nullptr) {
+      line[std::strcspn(line, "\r\n")] = '\0';
+      if (n >= rows.size() || rows[n] != line) {
+        if (diff++ == 0) {
+          std::printf("first difference, row %zu:\n  ref %s\n  now %s\n", n, line,
+                      (n < rows.size()) ? rows[n].c_str() : "(missing)");
+        }
+      }
+      n++;
+    }
+    std::fclose(f);
+    diff += (rows.size() > n) ? rows.size() - n : 0;
+    std::printf("regression vs %s: %zu differing rows\n", ref_path, diff);
+    return (diff == 0) ? 0 : 1;
+  }
+  return 0;
+}
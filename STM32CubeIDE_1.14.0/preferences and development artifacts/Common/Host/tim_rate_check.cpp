@@ -0,0 +1,221 @@
+/**
+ ******************************************************************************
+ * @file           : tim_rate_check.cpp
+ * @brief          : tim_rate solver against a brute-force search, jitter tracker
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/tim_rate.c -o tim_rate.o
+ *   c++ -O2 -std=c++17 -I../Inc tim_rate_check.cpp tim_rate.o -o tim_rate_check
+ *
+ * Usage:
+ *   tim_rate_check [random_targets]   (default 2000 per timer clock)
+ *
+ * Checks:
+ *   - exact rates: the project settings (16 kHz and 1 kHz from 20 MHz give
+ *     PSC 0 with ARR 1249 / 19999, 10 Hz gives 31 x 64516) come out with
+ *     0 ppm and PSC/ARR that reproduce the rate
+ *   - rates that cannot be hit exactly, log-uniform over the whole 16-bit
+ *     range at 20, 64, 200 and 240 MHz: the error is the smallest a full
+ *     search over every PSC (ARR rounded both ways) finds, rate_mhz is
+ *     f / ((PSC + 1) (ARR + 1)) rounded, error_ppm matches rate_mhz
+ *   - out of range: target 0, above the timer clock or closer to it than
+ *     to f / 2 (ARR 0 stops the counter), below f / 2^32 return non-zero
+ *   - tim_jitter_stamp: intervals across a CYCCNT wrap, min / max / worst
+ *     deviation and count against a reference, first stamp only arms
+ * Cost: ns per tim_rate_solve on this host. Exit status 1 when a check
+ * fails.
+ ******************************************************************************
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+
+#include "tim_rate.h"
+
+namespace {
+
+// Rate of a PSC/ARR pair in mHz, rounded like tim_rate_solve
+uint64_t RateMhz(uint64_t f_mhz, uint64_t p, uint64_t a) {
+  return (f_mhz + (p * a) / 2U) / (p * a);
+}
+
+uint64_t AbsDiff(uint64_t x, uint64_t y) {
+  return (x > y) ? x - y : y - x;
+}
+
+// Smallest achievable |rate - target| over every prescaler
+uint64_t BruteError(uint32_t f_hz, uint32_t target) {
+  uint64_t f_mhz = (uint64_t) f_hz * 1000U;
+  uint64_t best = UINT64_MAX;
+  for (uint64_t p = 1; p <= 65536U; p++) {
+    uint64_t a0 = f_mhz / ((uint64_t) target * p);
+    for (uint64_t a : {a0, a0 + 1U}) {
+      if (a < 2U || a > 65536U) {  // ARR >= 1
+        continue;
+      }
+      uint64_t err = AbsDiff(RateMhz(f_mhz, p, a), target);
+      best = (err < best) ? err : best;
+    }
+    if (a0 == 0U) {
+      break;  // larger prescalers only slow down further
+    }
+  }
+  return best;
+}
+
+bool CheckResult(uint32_t f_hz, uint32_t target, const tim_rate_t& r, uint64_t* err_out) {
+  uint64_t f_mhz = (uint64_t) f_hz * 1000U;
+  uint64_t rate = RateMhz(f_mhz, r.psc + 1ULL, r.arr + 1ULL);
+  int64_t ppm = ((int64_t) r.rate_mhz - (int64_t) target) * 1000000 / (int64_t) target;
+  *err_out = AbsDiff(r.rate_mhz, target);
+  return rate == r.rate_mhz && ppm == r.error_ppm;
+}
+
+bool Exact(uint32_t f_hz, uint32_t hz, uint32_t psc, uint32_t arr) {
+  tim_rate_t r{};
+  uint64_t err = 0;
+  int rc = tim_rate_solve(f_hz, hz * 1000U, &r);
+  bool ok = rc == 0 && CheckResult(f_hz, hz * 1000U, r, &err) && err == 0 &&
+            r.error_ppm == 0 && (uint64_t) (r.psc + 1U) * (r.arr + 1U) == (uint64_t) (psc + 1U) * (arr + 1U) &&
+            (psc != 0U || r.psc == 0U) && (psc != 0U || r.arr == arr);
+  std::printf("  %9u Hz from %9u Hz: PSC %5u ARR %5u  %u mHz  %d ppm  %s\n", hz, f_hz, r.psc,
+              r.arr, r.rate_mhz, r.error_ppm, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+bool OutOfRange(const char* what, uint32_t f_hz, uint32_t target) {
+  tim_rate_t r{};
+  int rc = tim_rate_solve(f_hz, target, &r);
+  std::printf("  %-28s %9u Hz, %10u mHz: rc %d  %s\n", what, f_hz, target, rc,
+              rc != 0 ? "ok" : "FAIL");
+  return rc != 0;
+}
+
+uint32_t Lcg(uint32_t* s) {
+  *s = *s * 1664525U + 1013904223U;
+  return *s;
+}
+
+bool Random(uint32_t f_hz, uint32_t n) {
+  uint32_t seed = f_hz;
+  uint32_t worse = 0;
+  uint32_t bad = 0;
+  uint32_t exact = 0;
+  int32_t worst_ppm = 0;
+  // reachable targets: f / 2^32 .. f / 2 (mHz), capped at the uint32_t target
+  double lo = (double) f_hz * 1000.0 / 4294967296.0 + 1.0;
+  double hi = (double) f_hz * 500.0;
+  hi = (hi > 4294967295.0) ? 4294967295.0 : hi;
+  for (uint32_t i = 0; i < n; i++) {
+    double u = (Lcg(&seed) >> 8) / 16777216.0;
+    uint32_t target = (uint32_t) (lo * __builtin_pow(hi / lo, u));
+    tim_rate_t r{};
+    uint64_t err = 0;
+    if (tim_rate_solve(f_hz, target, &r) != 0 || !CheckResult(f_hz, target, r, &err)) {
+      bad++;
+      continue;
+    }
+    uint64_t best = BruteError(f_hz, target);
+    worse += err > best;
+    exact += err == 0;
+    int32_t ppm = (r.error_ppm < 0) ? -r.error_ppm : r.error_ppm;
+    worst_ppm = (ppm > worst_ppm) ? ppm : worst_ppm;
+  }
+  bool ok = bad == 0 && worse == 0;
+  std::printf("  %9u Hz: %u targets, %u exact, %u worse than the full search, %u bad"
+              " results, worst %d ppm  %s\n",
+              f_hz, n, exact, worse, bad, worst_ppm, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+bool Jitter() {
+  // 1 kHz blocks at 400 MHz with +-d cycles of jitter, across the wrap
+  const uint32_t nominal = 400000;
+  const int32_t d[] = {0, 120, -75, 300, -310, 5, 0, -1, 250, -40};
+  tim_jitter_t j;
+  uint32_t t = 0xFFFFFFFFU - 3U * nominal;  // wraps after the third event
+  uint32_t min = UINT32_MAX, max = 0, worst = 0, count = 0;
+  bool wrapped = false;
+  bool ok = true;
+
+  tim_jitter_init(&j, nominal);
+  tim_jitter_stamp(&j, t);
+  ok = ok && j.count == 0 && j.armed;
+  for (int32_t e : d) {
+    uint32_t dt = nominal + (uint32_t) e;
+    uint32_t next = t + dt;
+    wrapped = wrapped || next < t;
+    t = next;
+    tim_jitter_stamp(&j, t);
+    min = (dt < min) ? dt : min;
+    max = (dt > max) ? dt : max;
+    uint32_t dev = (uint32_t) ((e < 0) ? -e : e);
+    worst = (dev > worst) ? dev : worst;
+    count++;
+  }
+  ok = ok && wrapped && j.count == count && j.min == min && j.max == max && j.worst == worst;
+  std::printf("  %u intervals across the CYCCNT wrap: min %u max %u worst %u (want %u %u %u)  %s\n",
+              j.count, j.min, j.max, j.worst, min, max, worst, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+volatile uint32_t g_sink;  // keeps the timed loops from being optimised away
+
+template <typename F>
+double NsPerCall(F&& f) {
+  uint64_t reps = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  std::chrono::duration<double> dt{};
+  do {
+    f();
+    reps++;
+    dt = std::chrono::steady_clock::now() - t0;
+  } while (dt.count() < 0.2);
+  return dt.count() * 1e9 / (double) reps;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t n = (argc > 1) ? (uint32_t) std::strtoul(argv[1], nullptr, 0) : 2000;
+  bool ok = true;
+
+  if (n == 0) {
+    std::fprintf(stderr, "usage: tim_rate_check [random_targets]\n");
+    return 2;
+  }
+  std::printf("exact rates:\n");
+  ok = Exact(20000000U, 16000U, 0, 1249) && ok;
+  ok = Exact(20000000U, 1000U, 0, 19999) && ok;
+  ok = Exact(20000000U, 10U, 30, 64515) && ok;
+  ok = Exact(64000000U, 1000U, 0, 63999) && ok;
+  ok = Exact(1000000U, 500000U, 0, 1) && ok;  // f / 2: the fastest a timer goes
+
+  std::printf("\nrandom targets vs a search over every PSC:\n");
+  for (uint32_t f : {20000000U, 64000000U, 200000000U, 240000000U}) {
+    ok = Random(f, n) && ok;
+  }
+
+  std::printf("\nout of range:\n");
+  ok = OutOfRange("target 0", 20000000U, 0U) && ok;
+  ok = OutOfRange("above the timer clock", 1000000U, 3000000000U) && ok;
+  ok = OutOfRange("0.8 x the timer clock", 1000000U, 800000000U) && ok;
+  ok = OutOfRange("below f / 2^32", 20000000U, 4U) && ok;
+  ok = OutOfRange("below f / 2^32, 240 MHz", 240000000U, 55U) && ok;
+
+  std::printf("\njitter tracker:\n");
+  ok = Jitter() && ok;
+
+  tim_rate_t r;
+  uint32_t target = 1234567U;
+  double ns = NsPerCall([&] {
+    g_sink = g_sink + (uint32_t) tim_rate_solve(20000000U, target, &r) + r.arr;
+    target = (target * 7U + 13U) % 20000000U + 1U;
+  });
+  std::printf("\ntim_rate_solve %.0f ns/call on this host (boot only)\n", ns);
+  std::printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
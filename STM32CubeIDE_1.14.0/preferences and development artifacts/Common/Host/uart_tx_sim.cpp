@@ -0,0 +1,276 @@
+/**
+ ******************************************************************************
+ * @file           : uart_tx_sim.cpp
+ * @brief          : tx_ring against a simulated UART drain and a slow link
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/uart_tx.c -o uart_tx.o
+ *   c++ -O2 -std=c++17 -I../Inc uart_tx_sim.cpp uart_tx.o -o uart_tx_sim
+ *
+ * Usage:
+ *   uart_tx_sim [baud ring frame_bytes period_ms seconds]
+ *
+ *   baud         link rate, 10 bits per byte           (default 9600)
+ *   ring         tx_ring size, power of two            (default 256)
+ *   frame_bytes  mean message length, +-25 % per frame (default 39)
+ *   period_ms    producer period                       (default 1000)
+ *   seconds      simulated time                        (default 600)
+ *
+ * The producer is the h7_temp_bluetooth main loop: one tx_ring_write per
+ * period, never waiting. The consumer is uart_tx_hal.c: when idle it
+ * claims the oldest contiguous span (at most 256 bytes, UART_TX_MAX_CHUNK),
+ * the UART needs 10 bit times per byte, and the TX complete releases the
+ * span and starts the next one. Each message carries a sequence number and
+ * a payload derived from it, so the receiver sees exactly which messages
+ * arrived, whole or not.
+ *
+ * After the configuration given, the producer period is swept so the
+ * offered rate runs from 0.25 to 3 times the link rate.
+ *
+ * Checks per run: every received message is whole and in order; messages
+ * missing at the receiver equal ring.drops, bytes received equal
+ * ring.queued, queued + dropped equal the bytes offered; the link never
+ * idles while bytes are queued; high_water stays within the ring. Below
+ * half the link rate nothing is dropped; at or above the link rate the
+ * delivered rate is within 1 % of it, provided the ring holds two of the
+ * largest frames. A smaller ring starves the link under overload (a frame
+ * only fits once the previous one has almost left); that is reported
+ * ("ring < 2 frames"), not failed. Also reports the host cost of a
+ * tx_ring_write against the time a blocking HAL_UART_Transmit of the same
+ * frame holds the CPU. Exit status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "uart_tx.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t kMaxChunk = 256;  // UART_TX_MAX_CHUNK
+constexpr uint32_t kHeader = 4;      // 0xA5, seq (2), length
+constexpr uint8_t kMark = 0xA5;
+
+struct Result {
+  uint64_t offered = 0;     // messages
+  uint64_t received = 0;    // messages whole and in order
+  uint64_t missing = 0;     // sequence gaps at the receiver
+  uint64_t bad = 0;         // torn, reordered or corrupted
+  uint64_t bytes_in = 0;    // bytes offered
+  uint64_t bytes_out = 0;   // bytes that left the UART
+  uint64_t idle_queued = 0; // bit times the link idled with bytes queued
+  double link_sps = 0;      // delivered bytes/s
+  tx_ring_t ring{};
+  bool ok = false;
+};
+
+uint32_t Lcg(uint32_t* s) {
+  *s = *s * 1664525U + 1013904223U;
+  return *s >> 8;
+}
+
+// Message `seq` of `len` bytes (len >= kHeader)
+void Build(uint8_t* m, uint16_t seq, uint32_t len) {
+  m[0] = kMark;
+  m[1] = (uint8_t) seq;
+  m[2] = (uint8_t) (seq >> 8);
+  m[3] = (uint8_t) len;
+  for (uint32_t i = kHeader; i < len; i++) {
+    m[i] = (uint8_t) (seq * 31U + i);
+  }
+}
+
+// Receiver: parses the byte stream back into messages
+struct Receiver {
+  std::vector<uint8_t> msg;
+  uint32_t next_seq = 0;
+  Result* r = nullptr;
+
+  void Put(uint8_t b) {
+    msg.push_back(b);
+    if (msg.size() < kHeader || msg.size() < msg[3]) {
+      return;
+    }
+    uint16_t seq = (uint16_t) (msg[1] | (msg[2] << 8));
+    bool whole = msg[0] == kMark && msg[3] >= kHeader;
+    for (uint32_t i = kHeader; whole && i < msg.size(); i++) {
+      whole = msg[i] == (uint8_t) (seq * 31U + i);
+    }
+    uint16_t gap = (uint16_t) (seq - (uint16_t) next_seq);
+    if (!whole || gap >= 0x8000U) {
+      r->bad++;
+    } else {
+      r->missing += gap;
+      r->received++;
+      next_seq += gap + 1U;
+    }
+    msg.clear();
+  }
+};
+
+Result Run(uint32_t baud, uint32_t size, uint32_t frame, uint64_t period_bits, uint64_t seconds) {
+  Result r;
+  std::vector<uint8_t> buf(size);
+  Receiver rx;
+  rx.r = &r;
+  tx_ring_init(&r.ring, buf.data(), size);
+
+  // time in bit times of the link
+  uint64_t end = seconds * baud;
+  uint64_t now = 0;
+  uint64_t next_frame = 0;
+  uint64_t done = UINT64_MAX;  // TX complete of the span in flight
+  const uint8_t* span = nullptr;
+  uint32_t in_flight = 0;
+  uint32_t lcg = 7;
+  uint8_t m[256];
+
+  auto kick = [&]() {
+    if (in_flight == 0U) {
+      in_flight = tx_ring_claim(&r.ring, &span, kMaxChunk);
+      if (in_flight != 0U) {
+        done = now + 10ULL * in_flight;
+      }
+    }
+  };
+
+  while (now < end) {
+    uint64_t t = (next_frame < done) ? next_frame : done;
+    if (in_flight == 0U && tx_ring_used(&r.ring) != 0U) {
+      r.idle_queued += t - now;
+    }
+    now = t;
+    if (now == done) {
+      for (uint32_t i = 0; i < in_flight; i++) {
+        rx.Put(span[i]);
+      }
+      r.bytes_out += in_flight;
+      tx_ring_release(&r.ring, in_flight);
+      in_flight = 0;
+      done = UINT64_MAX;
+      kick();  // uart_tx_cplt_isr
+    } else {
+      uint32_t len = frame - frame / 4U + Lcg(&lcg) % (frame / 2U + 1U);
+      len = (len < kHeader) ? kHeader : (len > 255U ? 255U : len);
+      Build(m, (uint16_t) r.offered, len);
+      r.offered++;
+      r.bytes_in += len;
+      tx_ring_write(&r.ring, m, len);
+      kick();  // uart_tx_write
+      next_frame += period_bits;
+    }
+  }
+  r.link_sps = (double) r.bytes_out * baud / (double) now;
+
+  // uart_tx_flush: stop producing and drain, then every queued message
+  // has arrived and messages after the last one received were dropped
+  while (in_flight != 0U) {
+    now = done;
+    for (uint32_t i = 0; i < in_flight; i++) {
+      rx.Put(span[i]);
+    }
+    r.bytes_out += in_flight;
+    tx_ring_release(&r.ring, in_flight);
+    in_flight = 0;
+    kick();
+  }
+  r.missing += r.offered - rx.next_seq;
+
+  r.ok = r.bad == 0 && r.missing == r.ring.drops && r.received + r.missing == r.offered &&
+         r.bytes_out == r.ring.queued && r.ring.queued + r.ring.dropped == r.bytes_in &&
+         r.idle_queued == 0 && r.ring.high_water <= size;
+  return r;
+}
+
+volatile uint32_t g_sink;  // keeps the timed loops from being optimised away
+
+template <typename F>
+double NsPerCall(F&& f) {
+  uint64_t reps = 0;
+  auto t0 = Clock::now();
+  std::chrono::duration<double> dt{};
+  do {
+    f();
+    reps++;
+    dt = Clock::now() - t0;
+  } while (dt.count() < 0.2);
+  return dt.count() * 1e9 / (double) reps;
+}
+
+bool Print(const char* name, uint32_t baud, uint32_t size, uint32_t frame, uint64_t period_bits,
+           uint64_t seconds) {
+  Result r = Run(baud, size, frame, period_bits, seconds);
+  double cap = baud / 10.0;
+  double load = (double) r.bytes_in / (double) seconds / cap;
+  uint32_t largest = frame - frame / 4U + frame / 2U;
+  bool ok = r.ok;
+  if (load <= 0.5) {
+    ok = ok && r.ring.drops == 0;
+  }
+  if (load >= 1.0 && size >= 2U * largest) {
+    ok = ok && r.link_sps >= 0.99 * cap;
+  }
+  std::printf("  %-6s load %4.2f  msgs %7llu  drops %6u (%5.1f %%)  bytes %8u / %8u dropped"
+              "  %7.1f B/s (%5.1f %%)  high %4u  %s%s\n",
+              name, load, (unsigned long long) r.offered, r.ring.drops,
+              100.0 * r.ring.drops / (double) (r.offered ? r.offered : 1), r.ring.queued,
+              r.ring.dropped, r.link_sps, 100.0 * r.link_sps / cap, r.ring.high_water,
+              ok ? "ok" : "FAIL",
+              (load >= 1.0 && size < 2U * largest) ? "  (ring < 2 frames)" : "");
+  if (r.bad != 0 || r.missing != r.ring.drops || r.idle_queued != 0) {
+    std::printf("         torn %llu, missing %llu vs drops %u, idle with data %llu bit times\n",
+                (unsigned long long) r.bad, (unsigned long long) r.missing, r.ring.drops,
+                (unsigned long long) r.idle_queued);
+  }
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t baud = (argc > 1) ? (uint32_t) std::strtoul(argv[1], nullptr, 0) : 9600;
+  uint32_t size = (argc > 2) ? (uint32_t) std::strtoul(argv[2], nullptr, 0) : 256;
+  uint32_t frame = (argc > 3) ? (uint32_t) std::strtoul(argv[3], nullptr, 0) : 39;
+  uint32_t period_ms = (argc > 4) ? (uint32_t) std::strtoul(argv[4], nullptr, 0) : 1000;
+  uint64_t seconds = (argc > 5) ? std::strtoull(argv[5], nullptr, 0) : 600;
+  static const double kLoads[] = {0.25, 0.5, 0.9, 1.0, 1.5, 2.0, 3.0};
+  bool ok = true;
+
+  if (baud < 10 || size == 0 || (size & (size - 1U)) != 0 || frame < kHeader || frame > 200 ||
+      period_ms == 0 || seconds == 0) {
+    std::fprintf(stderr, "usage: uart_tx_sim [baud ring(2^n) frame_bytes(4..200) period_ms"
+                         " seconds]\n");
+    return 2;
+  }
+  double cap = baud / 10.0;
+  std::printf("link %u baud = %.0f B/s, ring %u bytes, frames %u +-25 %% bytes\n", baud, cap, size,
+              frame);
+  ok &= Print("given", baud, size, frame, (uint64_t) period_ms * baud / 1000U, seconds);
+  for (double load : kLoads) {
+    char name[16];
+    std::snprintf(name, sizeof(name), "x%.2f", load);
+    uint64_t period_bits = (uint64_t) (frame * 10.0 / load);
+    ok &= Print(name, baud, size, frame, period_bits, seconds);
+  }
+
+  // producer cost: copying a frame in vs holding the CPU for the whole line
+  std::vector<uint8_t> buf(size);
+  tx_ring_t ring;
+  uint8_t m[256];
+  tx_ring_init(&ring, buf.data(), size);
+  Build(m, 1, frame);
+  double ns = NsPerCall([&] {
+    g_sink = g_sink + tx_ring_write(&ring, m, frame);
+    tx_ring_release(&ring, tx_ring_used(&ring));
+  });
+  std::printf("\n%u-byte frame: tx_ring_write %.1f ns (host), blocking HAL_UART_Transmit %.1f ms\n",
+              frame, ns, frame * 10.0 * 1e3 / baud);
+  std::printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
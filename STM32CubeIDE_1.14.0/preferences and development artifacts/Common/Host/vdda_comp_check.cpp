@@ -0,0 +1,223 @@
+/**
+ ******************************************************************************
+ * @file           : vdda_comp_check.cpp
+ * @brief          : vdda_comp_block against a double-precision reference
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/vdda_comp.c -o vdda_comp.o
+ *   c++ -O2 -std=c++17 -I../Inc vdda_comp_check.cpp vdda_comp.o -o vdda_comp_check
+ *
+ * Usage:
+ *   vdda_comp_check [pairs]   (pairs per block, default 32 as in temp_h7_m7_voltref)
+ *
+ * For three VREFINT_CAL words, VDDA is swept over 1620 .. 3600 mV in 1 mV
+ * steps: the VREFINT codes of each block are cal * 3300 / VDDA with +-3
+ * codes of dither, so the mean falls between codes and on both sides of
+ * VREFINT_CAL. The TSENSE codes are random over the whole 16-bit range
+ * plus 0, 1, 65534, 65535. Against the reference in double
+ * (VDDA = 3300 cal / mean, ts' = ts cal / mean, saturated at 65535):
+ *   - vdda_mv within 0.5 mV + the Q16 rounding of k
+ *   - every ts' within 0.5 LSB + ts times the rounding of k (Q16 up to
+ *     3.3 V, Q15 above), and 65535 wherever the reference saturates
+ *   - up to VDDA = 3.3 V, bit-identical to the 64-bit multiply it replaced
+ * Corners: no usable VREFINT (all zero, mean below one code, no pairs)
+ * returns 0 and leaves the state and the output alone; an absurd k
+ * (cal 65535, VREFINT mean 1) saturates instead of wrapping.
+ * Cost: ns/pair of the block against the old 64-bit pass on this host.
+ * Exit status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "vdda_comp.h"
+
+namespace {
+
+uint32_t Lcg(uint32_t* s) {
+  *s = *s * 1664525U + 1013904223U;
+  return *s;
+}
+
+// vdda_comp_block before its per-sample pass was kept in 32 bits
+uint32_t OldBlock(uint16_t cal, const uint16_t* scan, uint32_t pairs, uint16_t* out) {
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < pairs; i++) {
+    sum += scan[2U * i + 1U];
+  }
+  if (sum == 0U) {
+    return 0;
+  }
+  uint32_t k = (uint32_t) (((((uint64_t) cal * pairs) << 16) + sum / 2U) / sum);
+  for (uint32_t i = 0; i < pairs; i++) {
+    uint32_t c = (uint32_t) (((uint64_t) scan[2U * i] * k + 32768U) >> 16);
+    out[i] = (uint16_t) ((c > 0xFFFFU) ? 0xFFFFU : c);
+  }
+  return (uint32_t) (((uint64_t) VDDA_COMP_CAL_MV * k + 32768U) >> 16);
+}
+
+struct Stats {
+  uint64_t blocks = 0;
+  uint64_t samples = 0;
+  uint64_t vdda_bad = 0;
+  uint64_t ts_bad = 0;
+  uint64_t sat_bad = 0;
+  uint64_t old_diff = 0;     // VDDA <= 3.3 V only
+  double vdda_err = 0;       // worst |vdda_mv - ref|, mV
+  double ts_err_q16 = 0;     // worst |ts' - ref|, LSB, VDDA <= 3.3 V
+  double ts_err_q15 = 0;     // above 3.3 V
+};
+
+void Sweep(uint16_t cal, uint32_t pairs, Stats* st) {
+  std::vector<uint16_t> scan(2U * pairs);
+  std::vector<uint16_t> out(pairs);
+  std::vector<uint16_t> old(pairs);
+  uint32_t seed = cal;
+  vdda_comp_t v;
+
+  vdda_comp_init(&v, cal);
+  for (uint32_t mv = 1620; mv <= 3600; mv++) {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < pairs; i++) {
+      uint32_t ts = Lcg(&seed) >> 16;
+      if (i < 4U) {
+        const uint32_t kCorner[] = {0, 1, 65534, 65535};
+        ts = kCorner[i];
+      }
+      int32_t dither = (int32_t) ((Lcg(&seed) >> 8) % 7U) - 3;
+      int32_t vref = (int32_t) std::lround((double) cal * 3300.0 / mv) + dither;
+      scan[2U * i] = (uint16_t) ts;
+      scan[2U * i + 1U] = (uint16_t) vref;
+      sum += (uint64_t) vref;
+    }
+    double mean = (double) sum / pairs;
+    double ratio = cal / mean;  // VDDA / 3.3 V
+    uint32_t got = vdda_comp_block(&v, scan.data(), pairs, out.data());
+
+    double vdda_ref = 3300.0 * ratio;
+    double vdda_err = std::fabs((double) got - vdda_ref);
+    st->vdda_err = std::fmax(st->vdda_err, vdda_err);
+    st->vdda_bad += vdda_err > 0.5 + 3300.0 / 131072.0 + 1e-9;
+    st->blocks++;
+
+    bool q15 = v.k_q16 > 0x10000U;
+    double k_round = 0.5 / 65536.0 + (q15 ? 0.5 / 32768.0 : 0.0);
+    for (uint32_t i = 0; i < pairs; i++) {
+      double ts = scan[2U * i];
+      double ref = ts * ratio;
+      if (ref >= 65535.0) {
+        st->sat_bad += out[i] != 65535U;
+        ref = 65535.0;
+      }
+      double err = std::fabs((double) out[i] - ref);
+      st->ts_bad += err > 0.5 + ts * k_round + 1e-9;
+      double* worst = q15 ? &st->ts_err_q15 : &st->ts_err_q16;
+      *worst = std::fmax(*worst, err);
+    }
+    st->samples += pairs;
+    if (!q15) {
+      uint32_t old_mv = OldBlock(cal, scan.data(), pairs, old.data());
+      st->old_diff += old_mv != got ||
+                      std::memcmp(old.data(), out.data(), pairs * sizeof(uint16_t)) != 0;
+    }
+  }
+}
+
+bool Corners() {
+  bool ok = true;
+  vdda_comp_t v;
+  uint16_t scan[8] = {100, 0, 200, 0, 300, 0, 400, 0};
+  uint16_t out[4] = {7, 7, 7, 7};
+
+  vdda_comp_init(&v, 24000);
+  vdda_comp_t before = v;
+  bool none = vdda_comp_block(&v, scan, 4, out) == 0;
+  scan[3] = 3;  // sum 3 over 4 pairs: mean below one code
+  none = none && vdda_comp_block(&v, scan, 4, out) == 0;
+  none = none && vdda_comp_block(&v, scan, 0, out) == 0;
+  none = none && std::memcmp(&v, &before, sizeof(v)) == 0 && out[0] == 7 && out[3] == 7;
+  std::printf("  no usable VREFINT: returns 0, state and output untouched  %s\n",
+              none ? "ok" : "FAIL");
+  ok = ok && none;
+
+  // cal 65535 over a VREFINT mean of 1: k = 65535, taken in Q0 per sample
+  uint16_t wide[4] = {0, 1, 65535, 1};
+  uint16_t wout[2];
+  vdda_comp_init(&v, 65535);
+  uint32_t mv = vdda_comp_block(&v, wide, 2, wout);
+  bool sat = mv == 216265500U && v.k_q16 == 65535U * 65536U && wout[0] == 0 && wout[1] == 65535;
+  std::printf("  cal 65535 / mean 1: k %u, VDDA %u mV, codes %u %u  %s\n", v.k_q16, mv, wout[0],
+              wout[1], sat ? "ok" : "FAIL");
+  return ok && sat;
+}
+
+volatile uint32_t g_sink;  // keeps the timed loops from being optimised away
+
+template <typename F>
+double NsPerCall(F&& f) {
+  uint64_t reps = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  std::chrono::duration<double> dt{};
+  do {
+    f();
+    reps++;
+    dt = std::chrono::steady_clock::now() - t0;
+  } while (dt.count() < 0.2);
+  return dt.count() * 1e9 / (double) reps;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t pairs = (argc > 1) ? (uint32_t) std::strtoul(argv[1], nullptr, 0) : 32;
+  bool ok = true;
+
+  if (pairs < 4 || pairs > 4096) {
+    std::fprintf(stderr, "usage: vdda_comp_check [pairs(4 .. 4096)]\n");
+    return 2;
+  }
+  std::printf("VDDA 1620 .. 3600 mV, %u pairs per block:\n", pairs);
+  for (uint16_t cal : {(uint16_t) 22500, (uint16_t) 24149, (uint16_t) 26000}) {
+    Stats st;
+    Sweep(cal, pairs, &st);
+    bool pass = st.vdda_bad == 0 && st.ts_bad == 0 && st.sat_bad == 0 && st.old_diff == 0;
+    std::printf("  cal %5u: %llu blocks, %llu codes  VDDA worst %.3f mV  ts' worst %.3f LSB"
+                " (<= 3.3 V) %.3f LSB (above)  %llu bad  %llu unsaturated  %llu blocks off"
+                " the 64-bit pass  %s\n",
+                cal, (unsigned long long) st.blocks, (unsigned long long) st.samples, st.vdda_err,
+                st.ts_err_q16, st.ts_err_q15, (unsigned long long) (st.vdda_bad + st.ts_bad),
+                (unsigned long long) st.sat_bad, (unsigned long long) st.old_diff,
+                pass ? "ok" : "FAIL");
+    ok = pass && ok;
+  }
+
+  std::printf("\ncorners:\n");
+  ok = Corners() && ok;
+
+  std::vector<uint16_t> scan(2U * pairs);
+  std::vector<uint16_t> out(pairs);
+  uint32_t seed = 1;
+  for (uint32_t i = 0; i < pairs; i++) {
+    scan[2U * i] = (uint16_t) (Lcg(&seed) >> 16);
+    scan[2U * i + 1U] = 24149U + (uint16_t) (i & 3U);
+  }
+  vdda_comp_t v;
+  vdda_comp_init(&v, 24149);
+  double ns_new = NsPerCall([&] {
+    g_sink = g_sink + vdda_comp_block(&v, scan.data(), pairs, out.data()) + out[1];
+  });
+  double ns_old = NsPerCall([&] {
+    g_sink = g_sink + OldBlock(24149, scan.data(), pairs, out.data()) + out[1];
+  });
+  std::printf("\ncost on this host: %.2f ns/pair, %.2f with the 64-bit pass (a 64-bit host"
+              " multiplies both ways alike; the difference is on the M7)\n",
+              ns_new / pairs, ns_old / pairs);
+  std::printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+/**
+ ******************************************************************************
+ * @file           : wave_dds_model.cpp
+ * @brief          : wave_gen DDS model: frequency accuracy, continuity, cost
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/wave_gen.c ../Src/wave_tables.c
+ *   c++ -O2 -std=c++17 -I../Inc wave_dds_model.cpp wave_gen.o wave_tables.o \
+ *       -lm -o wave_dds_model
+ *
+ * Usage:
+ *   wave_dds_model [-s fs_hz] [-n seconds] [f_hz ...]
+ *
+ *   fs_hz    DAC sample rate (default 256000, TIM6 in SineWaveVoltageOutput)
+ *   seconds  simulated output per frequency (default 60)
+ *   f_hz     target frequencies (default: a spread from 0.25 Hz to fs/4
+ *            with sub-mHz digits)
+ *
+ * Per frequency: tuning word, exact DDS frequency tw * fs / 2^32 and its
+ * error against the target (must be within half a step, fs / 2^33), and
+ * the frequency measured on the generated codes (256-entry sine, 64-code
+ * DMA halves): interpolated mid-scale crossings over the whole run,
+ * least-squares slope. The measured error is table / code quantisation
+ * jitter averaged out, it has to agree with the exact value to < 1 ppm.
+ *
+ * Checks: tuning word changes and step <-> DDS switches never jump the
+ * output by more than the steepest slope allows, and a committed table
+ * only takes over right after a phase wrap. Cost: ns/sample for step and
+ * DDS fills on this host. Exit status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "wave_gen.h"
+
+namespace {
+
+constexpr uint32_t kHalf = 64;  // DAC_HALF
+constexpr double kTwoPow32 = 4294967296.0;
+
+wave_gen_t g_wave;  // 1 KiB of tables, keep it off the stack
+
+struct Fit {
+  double f_hz = 0;
+  uint64_t crossings = 0;
+};
+
+// Rising mid-scale crossings, linear interpolation between the two codes,
+// frequency = slope of crossing time over crossing number
+Fit Measure(uint32_t fs, uint32_t tw, double seconds) {
+  wave_cfg_t c = {WAVE_SINE, 256, 0, 4095, 0, nullptr};
+  uint16_t buf[kHalf];
+  uint64_t total = (uint64_t) (seconds * fs);
+  double mid = 2047.5, prev = 0;
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  Fit fit;
+
+  wave_gen_init(&g_wave, &c);
+  wave_gen_set_tuning(&g_wave, tw);
+  for (uint64_t s = 0; s < total; s += kHalf) {
+    wave_gen_fill(&g_wave, buf, kHalf);
+    for (uint32_t i = 0; i < kHalf; i++) {
+      double v = buf[i];
+      uint64_t k = s + i;
+      if (k > 0 && prev < mid && v >= mid) {
+        double t = (double) (k - 1) + (mid - prev) / (v - prev);
+        double x = (double) fit.crossings;
+        sx += x;
+        sy += t;
+        sxx += x * x;
+        sxy += x * t;
+        fit.crossings++;
+      }
+      prev = v;
+    }
+  }
+  if (fit.crossings >= 2) {
+    double n = (double) fit.crossings;
+    double slope = (n * sxy - sx * sy) / (n * sxx - sx * sx);  // samples/cycle
+    fit.f_hz = fs / slope;
+  }
+  return fit;
+}
+
+// Largest code step while the tuning word and the mode change every block
+bool CheckContinuity(uint32_t fs) {
+  wave_cfg_t c = {WAVE_SINE, 256, 0, 4095, 0, nullptr};
+  uint16_t buf[kHalf];
+  uint32_t prev = 0;
+  uint32_t worst = 0;
+  uint32_t tw_max = wave_gen_tuning(fs, 5000000000ULL);  // 5 kHz
+  uint32_t lcg = 1;
+  double f_max = (double) fs / 256.0 > 5000.0 ? (double) fs / 256.0 : 5000.0;
+  // steepest sine step at f_max, plus one entry of table granularity
+  double limit = 2047.5 * 2.0 * M_PI * f_max / fs + 2047.5 * 2.0 * M_PI / 256.0 + 1.0;
+
+  wave_gen_init(&g_wave, &c);
+  for (uint32_t b = 0; b < 200000; b++) {
+    lcg = lcg * 1664525U + 1013904223U;
+    // every 8th block back to step mode, else a random tone up to 5 kHz
+    wave_gen_set_tuning(&g_wave, (b % 8U == 7U) ? 0U : lcg % tw_max + 1U);
+    wave_gen_fill(&g_wave, buf, kHalf);
+    for (uint32_t i = 0; i < kHalf; i++) {
+      if (b + i > 0) {
+        uint32_t d = buf[i] > prev ? buf[i] - prev : prev - buf[i];
+        worst = d > worst ? d : worst;
+      }
+      prev = buf[i];
+    }
+  }
+  std::printf("continuity: tw / mode changed every %u-code block, worst step %u codes "
+              "(limit %.0f)  %s\n",
+              kHalf, worst, limit, worst <= limit ? "ok" : "FAIL");
+  return worst <= limit;
+}
+
+// Tables tagged with their id in the top bits; the id may only change on
+// an output sample whose table index is within one tuning step of 0
+bool CheckSwaps(uint32_t fs) {
+  static uint16_t arb[4][256];
+  uint16_t buf[kHalf];
+  uint32_t bad = 0;
+  uint32_t prev_id = 0;
+  uint32_t tw = wave_gen_tuning(fs, 3333333333ULL);  // 3.333 kHz
+  uint32_t first_max = (uint32_t) ((uint64_t) tw * 256U >> 32) + 1U;
+
+  for (uint32_t id = 0; id < 4; id++) {
+    for (uint32_t i = 0; i < 256; i++) {
+      arb[id][i] = (uint16_t) ((id << 10) | (i * 4U + 1U) % 1024U);
+    }
+  }
+  wave_cfg_t c = {WAVE_ARB, 256, 0, 4095, 0, arb[0]};
+  wave_gen_init(&g_wave, &c);
+  wave_gen_set_tuning(&g_wave, tw);
+  for (uint32_t b = 0; b < 100000; b++) {
+    if (b % 5U == 0U) {
+      c.arb = arb[(b / 5U) % 4U];
+      (void) wave_gen_build(&g_wave, &c);
+    }
+    wave_gen_fill(&g_wave, buf, kHalf);
+    for (uint32_t i = 0; i < kHalf; i++) {
+      uint32_t id = buf[i] >> 10;
+      uint32_t idx = ((buf[i] & 1023U) - 1U) / 4U;
+      if (id != prev_id && idx >= first_max) {
+        bad++;
+      }
+      prev_id = id;
+    }
+  }
+  std::printf("table swaps: %u at phase wraps, %u elsewhere  %s\n", g_wave.swaps, bad,
+              bad == 0 ? "ok" : "FAIL");
+  return bad == 0 && g_wave.swaps > 0;
+}
+
+volatile uint32_t g_sink;  // keeps the timed loops from being optimised away
+
+double NsPerSample(uint32_t tw) {
+  wave_cfg_t c = {WAVE_SINE, 256, 0, 4095, 0, nullptr};
+  uint16_t buf[kHalf];
+  uint64_t n = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  std::chrono::duration<double> dt{};
+
+  wave_gen_init(&g_wave, &c);
+  wave_gen_set_tuning(&g_wave, tw);
+  do {
+    for (int r = 0; r < 1000; r++) {
+      wave_gen_fill(&g_wave, buf, kHalf);
+      g_sink = g_sink + buf[r % kHalf];
+    }
+    n += 1000U * kHalf;
+    dt = std::chrono::steady_clock::now() - t0;
+  } while (dt.count() < 0.3);
+  return dt.count() * 1e9 / (double) n;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t fs = 256000;
+  double seconds = 60;
+  std::vector<double> freqs;
+  bool ok = true;
+
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      fs = (uint32_t) std::strtoul(argv[++i], nullptr, 0);
+    } else if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      seconds = std::strtod(argv[++i], nullptr);
+    } else {
+      freqs.push_back(std::strtod(argv[i], nullptr));
+    }
+  }
+  if (freqs.empty()) {
+    freqs = {0.25, 1.0, 49.9995, 50.0005, 440.0, 1000.0, 1234.567, 9999.999, 12345.678,
+             fs / 4.0};
+  }
+
+  std::printf("fs %u Hz, step fs/2^32 = %.3f uHz, %.0f s per tone\n\n", fs,
+              fs / kTwoPow32 * 1e6, seconds);
+  std::printf("%14s %10s %18s %12s %18s %10s\n", "target Hz", "tw", "exact Hz", "err uHz",
+              "measured Hz", "meas ppm");
+  for (double f : freqs) {
+    uint32_t tw = wave_gen_tuning(fs, (uint64_t) std::llround(f * 1e6));
+    double exact = tw * (double) fs / kTwoPow32;
+    double err = (exact - std::round(f * 1e6) / 1e6) * 1e6;
+    // measure at least ~20 cycles even for slow tones (up to an hour)
+    double secs = std::max(seconds, std::min(20.0 / f, 3600.0));
+    Fit m = Measure(fs, tw, secs);
+    double ppm = (m.f_hz - exact) / exact * 1e6;
+    bool row_ok = tw != 0 && std::fabs(err) <= fs / kTwoPow32 / 2.0 * 1e6 + 1e-6 &&
+                  std::fabs(ppm) < 1.0;
+    std::printf("%14.4f %10u %18.9f %12.3f %18.9f %10.4f%s\n", f, tw, exact, err, m.f_hz, ppm,
+                row_ok ? "" : "  FAIL");
+    ok = ok && row_ok;
+  }
+  std::printf("\n");
+  ok = CheckContinuity(fs) && ok;
+  ok = CheckSwaps(fs) && ok;
+
+  double step = NsPerSample(0);
+  double dds = NsPerSample(wave_gen_tuning(fs, 1234567000ULL));
+  std::printf("\ncost per sample (this host, %u-code fills): step %.2f ns, DDS %.2f ns\n",
+              kHalf, step, dds);
+  std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
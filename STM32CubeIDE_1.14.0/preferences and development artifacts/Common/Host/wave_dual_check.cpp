@@ -0,0 +1,236 @@
+/**
+ ******************************************************************************
+ * @file           : wave_dual_check.cpp
+ * @brief          : wave_gen dual-channel (DHR12RD) packing and phase checks
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/wave_gen.c ../Src/wave_tables.c
+ *   c++ -O2 -std=c++17 -I../Inc wave_dual_check.cpp wave_gen.o \
+ *       wave_tables.o -lm -o wave_dual_check
+ *
+ * Every check runs in step and in DDS mode with 64-word fills (DAC_HALF):
+ *   - packing: bits 11:0 of each word equal the wave_gen_fill codes of an
+ *     identical single-channel generator, bits 15:12 and 31:28 are zero
+ *   - WAVE_CH2_PHASE: CH2 equals a single-channel generator started at the
+ *     offset position (0, 90, 180, 270 degrees and an odd offset), and the
+ *     I/Q sine pair measured by correlation is 90 degrees apart
+ *   - WAVE_CH2_INVERT: CH1 + CH2 == 4095 on every word
+ *   - table swaps: both channels change table on the same word
+ * Cost: ns/sample single vs dual fill on this host. Exit status 1 when a
+ * check fails.
+ ******************************************************************************
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+
+#include "wave_gen.h"
+
+namespace {
+
+constexpr uint32_t kHalf = 64;    // DAC_HALF
+constexpr uint32_t kBlocks = 4000;
+
+wave_gen_t g_dual;
+wave_gen_t g_ref;
+
+struct Mode {
+  const char* name;
+  uint32_t tw;  // 0: step
+};
+// 256 kHz: step mode (1 kHz at len 256) and a 1234.567 Hz DDS tone
+const Mode kModes[] = {{"step", 0}, {"DDS", 20712597U}};
+
+// Single-channel reference positioned offset / 2^32 of a period ahead
+void StartRef(const wave_cfg_t& c, uint32_t tw, uint32_t offset) {
+  wave_gen_init(&g_ref, &c);
+  wave_gen_set_tuning(&g_ref, tw);
+  if (tw != 0U) {
+    g_ref.phase = offset;
+    g_ref.dds = 1;
+  } else {
+    g_ref.idx = (uint32_t) (((uint64_t) offset * g_ref.tab[0].len) >> 32);
+  }
+}
+
+bool CheckPhase(const Mode& m, uint32_t len, uint32_t offset) {
+  wave_cfg_t c = {WAVE_SINE, len, 0, 4095, 0, nullptr};
+  uint32_t words[kHalf];
+  uint16_t ch1[kHalf], ch2[kHalf];
+  wave_gen_t ref1;
+  uint32_t bad_pack = 0, bad_ch1 = 0, bad_ch2 = 0;
+
+  wave_gen_init(&ref1, &c);
+  wave_gen_set_tuning(&ref1, m.tw);
+  wave_gen_init(&g_dual, &c);
+  wave_gen_set_tuning(&g_dual, m.tw);
+  wave_gen_set_ch2(&g_dual, WAVE_CH2_PHASE, offset);
+  StartRef(c, m.tw, offset);
+  for (uint32_t b = 0; b < kBlocks; b++) {
+    wave_gen_fill_dual(&g_dual, words, kHalf);
+    wave_gen_fill(&ref1, ch1, kHalf);
+    wave_gen_fill(&g_ref, ch2, kHalf);
+    for (uint32_t i = 0; i < kHalf; i++) {
+      bad_pack += (words[i] & 0xF000F000U) != 0U;
+      bad_ch1 += (words[i] & 0xFFFU) != ch1[i];
+      bad_ch2 += ((words[i] >> 16) & 0xFFFU) != ch2[i];
+    }
+  }
+  bool ok = bad_pack == 0 && bad_ch1 == 0 && bad_ch2 == 0;
+  std::printf("  %-4s len %4u offset 0x%08x: %u pack, %u CH1, %u CH2 mismatches  %s\n", m.name,
+              len, offset, bad_pack, bad_ch1, bad_ch2, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// Phase of CH2 relative to CH1 from correlation with cos / sin of CH1's
+// own period, in degrees
+bool CheckQuadrature(const Mode& m) {
+  wave_cfg_t c = {WAVE_SINE, 256, 0, 4095, 0, nullptr};
+  uint32_t words[kHalf];
+  double period = m.tw != 0U ? 4294967296.0 / m.tw : 256.0;
+  double i1 = 0, q1 = 0, i2 = 0, q2 = 0;
+  uint64_t k = 0;
+  // whole periods only
+  uint64_t total = (uint64_t) (std::floor(kBlocks * kHalf / period) * period);
+
+  wave_gen_init(&g_dual, &c);
+  wave_gen_set_tuning(&g_dual, m.tw);
+  wave_gen_set_ch2(&g_dual, WAVE_CH2_PHASE, 0x40000000U);
+  for (uint32_t b = 0; b < kBlocks; b++) {
+    wave_gen_fill_dual(&g_dual, words, kHalf);
+    for (uint32_t i = 0; i < kHalf && k < total; i++, k++) {
+      double w = 2.0 * M_PI * k / period;
+      double a = (words[i] & 0xFFFU) - 2047.5;
+      double d = (words[i] >> 16) - 2047.5;
+      i1 += a * std::cos(w);
+      q1 += a * std::sin(w);
+      i2 += d * std::cos(w);
+      q2 += d * std::sin(w);
+    }
+  }
+  double deg = (std::atan2(i2, q2) - std::atan2(i1, q1)) * 180.0 / M_PI;
+  deg = std::fmod(deg + 360.0, 360.0);
+  // one table entry of the 256-sample period is 1.4 degrees
+  bool ok = std::fabs(deg - 90.0) < 360.0 / 256.0;
+  std::printf("  %-4s I/Q sine: CH2 leads CH1 by %.3f degrees  %s\n", m.name, deg,
+              ok ? "ok" : "FAIL");
+  return ok;
+}
+
+bool CheckInvert(const Mode& m) {
+  wave_cfg_t c = {WAVE_BURST, 200, 300, 3900, 0, nullptr};
+  uint32_t words[kHalf];
+  uint32_t bad = 0;
+
+  wave_gen_init(&g_dual, &c);
+  wave_gen_set_tuning(&g_dual, m.tw);
+  wave_gen_set_ch2(&g_dual, WAVE_CH2_INVERT, 0);
+  for (uint32_t b = 0; b < kBlocks; b++) {
+    wave_gen_fill_dual(&g_dual, words, kHalf);
+    for (uint32_t i = 0; i < kHalf; i++) {
+      bad += (words[i] & 0xFFFU) + (words[i] >> 16) != WAVE_GEN_CODE_MAX;
+    }
+  }
+  std::printf("  %-4s differential: %u words with CH1 + CH2 != 4095  %s\n", m.name, bad,
+              bad == 0 ? "ok" : "FAIL");
+  return bad == 0;
+}
+
+// Tables tagged with their id in bits 11:10: the id of CH1 and CH2 must
+// change together
+bool CheckSwaps(const Mode& m) {
+  static uint16_t arb[4][256];
+  uint32_t words[kHalf];
+  uint32_t split = 0;
+
+  for (uint32_t id = 0; id < 4; id++) {
+    for (uint32_t i = 0; i < 256; i++) {
+      arb[id][i] = (uint16_t) ((id << 10) | i);
+    }
+  }
+  wave_cfg_t c = {WAVE_ARB, 256, 0, 4095, 0, arb[0]};
+  wave_gen_init(&g_dual, &c);
+  wave_gen_set_tuning(&g_dual, m.tw);
+  wave_gen_set_ch2(&g_dual, WAVE_CH2_PHASE, 0x60000000U);
+  for (uint32_t b = 0; b < kBlocks; b++) {
+    if (b % 3U == 0U) {
+      c.arb = arb[(b / 3U) % 4U];
+      (void) wave_gen_build(&g_dual, &c);
+    }
+    wave_gen_fill_dual(&g_dual, words, kHalf);
+    for (uint32_t i = 0; i < kHalf; i++) {
+      split += ((words[i] >> 10) & 3U) != ((words[i] >> 26) & 3U);
+    }
+  }
+  bool ok = split == 0 && g_dual.swaps > 0;
+  std::printf("  %-4s table swaps: %u, %u words with CH1 / CH2 on different tables  %s\n",
+              m.name, g_dual.swaps, split, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+volatile uint32_t g_sink;
+
+template <typename F>
+double NsPerSample(F fill) {
+  uint64_t n = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  std::chrono::duration<double> dt{};
+  do {
+    for (int r = 0; r < 1000; r++) {
+      fill();
+    }
+    n += 1000U * kHalf;
+    dt = std::chrono::steady_clock::now() - t0;
+  } while (dt.count() < 0.3);
+  return dt.count() * 1e9 / (double) n;
+}
+
+void Cost(const Mode& m) {
+  wave_cfg_t c = {WAVE_SINE, 256, 0, 4095, 0, nullptr};
+  uint16_t codes[kHalf];
+  uint32_t words[kHalf];
+
+  wave_gen_init(&g_dual, &c);
+  wave_gen_set_tuning(&g_dual, m.tw);
+  double single = NsPerSample([&] {
+    wave_gen_fill(&g_dual, codes, kHalf);
+    g_sink = g_sink + codes[5];
+  });
+  wave_gen_set_ch2(&g_dual, WAVE_CH2_PHASE, 0x40000000U);
+  double dual = NsPerSample([&] {
+    wave_gen_fill_dual(&g_dual, words, kHalf);
+    g_sink = g_sink + words[5];
+  });
+  std::printf("  %-4s single %.2f ns/sample, dual %.2f ns/sample (both channels)\n", m.name,
+              single, dual);
+}
+
+}  // namespace
+
+int main() {
+  bool ok = true;
+
+  std::printf("packing and CH2 phase offset:\n");
+  for (const Mode& m : kModes) {
+    for (uint32_t len : {256U, 200U, WAVE_TABLES_N}) {
+      for (uint32_t off : {0U, 0x40000000U, 0x80000000U, 0xC0000000U, 0x12345678U}) {
+        ok = CheckPhase(m, len, off) && ok;
+      }
+    }
+  }
+  std::printf("\nquadrature, differential, swaps:\n");
+  for (const Mode& m : kModes) {
+    ok = CheckQuadrature(m) && ok;
+    ok = CheckInvert(m) && ok;
+    ok = CheckSwaps(m) && ok;
+  }
+  std::printf("\ncost on this host (%u-sample fills):\n", kHalf);
+  for (const Mode& m : kModes) {
+    Cost(m);
+  }
+  std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
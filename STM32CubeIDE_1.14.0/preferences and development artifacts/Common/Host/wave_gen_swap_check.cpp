@@ -0,0 +1,185 @@
+/**
+ ******************************************************************************
+ * @file           : wave_gen_swap_check.cpp
+ * @brief          : wave_gen table builds and period-boundary swaps under load
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/wave_gen.c ../Src/wave_tables.c
+ *   c++ -O2 -std=c++17 -I../Inc wave_gen_swap_check.cpp wave_gen.o \
+ *       wave_tables.o -o wave_gen_swap_check
+ *
+ * Usage:
+ *   wave_gen_swap_check [samples build_every]
+ *
+ *   samples      samples played per refill size    (default 3250000)
+ *   build_every  refills between build attempts    (default 7)
+ *
+ * 16 arbitrary tables of lengths 16 .. 256 are cycled through the engine
+ * in step mode, the way SineWaveVoltageOutput does it: the main loop
+ * calls wave_gen_build every build_every refills and retries a refused
+ * one, the DMA callbacks refill 64 codes (DAC_HALF), 17 codes (refills
+ * that end mid-period) or 1 code (a swap test on every sample).
+ *
+ * Every code is tagged with its table id (bits 11:8) and index (7:0), so
+ * the receiver checks each sample: on the same table the index follows
+ * the previous one (no phase break); a new table starts at index 0 right
+ * after the last index of the old one, and it is the table committed last
+ * (no torn period, no stale or skipped build). Also: every build accepted
+ * is played (swaps == commits, one may still be pending at the end), a
+ * build is refused only while a swap is pending, and refused == the -1
+ * returns. Cost: ns/sample of a 64-code refill and ns per 256-entry build
+ * on this host. Exit status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+
+#include "wave_gen.h"
+
+namespace {
+
+constexpr uint32_t kTables = 16;
+constexpr uint32_t kMaxRefill = 64;
+
+uint16_t g_arb[kTables][WAVE_GEN_TABLE_MAX];
+uint32_t g_len[kTables];
+wave_gen_t g_gen;
+
+void MakeTables() {
+  for (uint32_t id = 0; id < kTables; id++) {
+    g_len[id] = 16U + (id * 240U) / (kTables - 1U);  // 16 .. 256
+    for (uint32_t i = 0; i < g_len[id]; i++) {
+      g_arb[id][i] = (uint16_t) ((id << 8) | i);
+    }
+  }
+}
+
+wave_cfg_t Cfg(uint32_t id) {
+  return wave_cfg_t{WAVE_ARB, g_len[id], 0, WAVE_GEN_CODE_MAX, 0, g_arb[id]};
+}
+
+struct Result {
+  uint64_t samples = 0;
+  uint64_t commits = 0;
+  uint64_t refused = 0;         // -1 returns
+  uint64_t refused_idle = 0;    // -1 with no swap pending
+  uint64_t switches = 0;        // table changes seen at the output
+  uint64_t phase_breaks = 0;    // index jump within a table
+  uint64_t torn = 0;            // table change off a period boundary
+  uint64_t wrong_table = 0;     // switched to a table other than the last commit
+};
+
+Result Run(uint32_t refill, uint64_t samples, uint32_t build_every) {
+  Result r;
+  wave_cfg_t c = Cfg(0);
+  uint16_t out[kMaxRefill];
+  uint32_t cur = 0;                 // table id playing
+  uint32_t last = g_len[0] - 1U;    // index before the first sample
+  uint32_t committed = 0;           // id of the last accepted build
+  uint32_t next = 1;                // id to build next
+  uint64_t refills = 0;
+
+  wave_gen_init(&g_gen, &c);
+  while (r.samples < samples) {
+    if (refills++ % build_every == 0U) {
+      bool was_pending = g_gen.pending != 0U;
+      c = Cfg(next);
+      int32_t rc = wave_gen_build(&g_gen, &c);
+      if (rc == 0) {
+        committed = next;
+        next = (next + 1U) % kTables;
+        r.commits++;
+      } else {
+        r.refused++;
+        r.refused_idle += !was_pending;
+      }
+    }
+    wave_gen_fill(&g_gen, out, refill);
+    for (uint32_t i = 0; i < refill; i++) {
+      uint32_t id = out[i] >> 8;
+      uint32_t idx = out[i] & 0xFFU;
+      if (id == cur) {
+        r.phase_breaks += idx != (last + 1U) % g_len[cur];
+      } else {
+        r.switches++;
+        r.torn += last != g_len[cur] - 1U || idx != 0U;
+        r.wrong_table += id != committed;
+        cur = id;
+      }
+      last = idx;
+    }
+    r.samples += refill;
+  }
+  return r;
+}
+
+volatile uint32_t g_sink;  // keeps the timed loops from being optimised away
+
+template <typename F>
+double NsPerCall(F&& f) {
+  uint64_t reps = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  std::chrono::duration<double> dt{};
+  do {
+    f();
+    reps++;
+    dt = std::chrono::steady_clock::now() - t0;
+  } while (dt.count() < 0.2);
+  return dt.count() * 1e9 / (double) reps;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint64_t samples = (argc > 1) ? std::strtoull(argv[1], nullptr, 0) : 3250000;
+  uint32_t build_every = (argc > 2) ? (uint32_t) std::strtoul(argv[2], nullptr, 0) : 7;
+  uint64_t total = 0;
+  uint64_t switches = 0;
+  bool ok = true;
+
+  if (samples == 0 || build_every == 0) {
+    std::fprintf(stderr, "usage: wave_gen_swap_check [samples build_every]\n");
+    return 2;
+  }
+  MakeTables();
+  std::printf("%u arbitrary tables, %u .. %u samples, a build every %u refills:\n", kTables,
+              g_len[0], g_len[kTables - 1U], build_every);
+  for (uint32_t refill : {kMaxRefill, 17U, 1U}) {
+    Result r = Run(refill, samples, build_every);
+    // the last commit may still be waiting for its period boundary
+    bool played = r.switches == r.commits || r.switches + 1U == r.commits;
+    bool pass = r.phase_breaks == 0 && r.torn == 0 && r.wrong_table == 0 && played &&
+                r.refused_idle == 0 && r.refused == g_gen.refused && r.switches == g_gen.swaps;
+    std::printf("  refill %2u: %9llu samples  %6llu commits  %6llu refused  %6llu switches"
+                "  %llu torn  %llu phase breaks  %llu wrong table  %s\n",
+                refill, (unsigned long long) r.samples, (unsigned long long) r.commits,
+                (unsigned long long) r.refused, (unsigned long long) r.switches,
+                (unsigned long long) r.torn, (unsigned long long) r.phase_breaks,
+                (unsigned long long) r.wrong_table, pass ? "ok" : "FAIL");
+    total += r.samples;
+    switches += r.switches;
+    ok = pass && ok;
+  }
+  std::printf("  total %llu samples, %llu switches\n", (unsigned long long) total,
+              (unsigned long long) switches);
+
+  wave_cfg_t c = Cfg(kTables - 1U);
+  uint16_t out[kMaxRefill];
+  wave_gen_init(&g_gen, &c);
+  double fill = NsPerCall([&] {
+    wave_gen_fill(&g_gen, out, kMaxRefill);
+    g_sink = g_sink + out[3];
+  });
+  double build = NsPerCall([&] {
+    g_gen.pending = 0;  // as if the ISR had swapped
+    g_sink = g_sink + (uint32_t) wave_gen_build(&g_gen, &c);
+  });
+  std::printf("\ncost on this host: refill %.2f ns/sample, %u-entry build %.0f ns\n",
+              fill / kMaxRefill, g_len[kTables - 1U], build);
+  std::printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
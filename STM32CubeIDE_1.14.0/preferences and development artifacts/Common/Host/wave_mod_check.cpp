@@ -0,0 +1,317 @@
+/**
+ ******************************************************************************
+ * @file           : wave_mod_check.cpp
+ * @brief          : wave_mod unit checks and fill-time benchmark
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/wave_gen.c ../Src/wave_mod.c ../Src/wave_tables.c
+ *   c++ -O2 -std=c++17 -I../Inc wave_mod_check.cpp wave_gen.o wave_mod.o \
+ *       wave_tables.o -lm -o wave_mod_check
+ *
+ * Usage:
+ *   wave_mod_check [-s fs_hz]     (default 256000, SineWaveVoltageOutput)
+ *
+ * Checks, 64-sample fills (DAC_HALF) at fs:
+ *   - off: bit-exact wave_gen_fill; FM with a == b: bit-exact DDS
+ *   - AM (LFO) and envelope (ramp): every code within 1 LSB of a double
+ *     model (carrier code x gain(m) about the center)
+ *   - FM (LFO) and sweep (ramp): instantaneous frequency from mid-scale
+ *     crossings follows the model within the crossing resolution, and
+ *     the output never steps more than the steepest carrier slope allows
+ *   - table swaps under FM only right after a phase wrap
+ * Cost: ns/sample and the 99.9th percentile 64-sample fill per mode,
+ * single and dual, against the half-buffer deadline (64 / fs). Host
+ * numbers (the host maximum is OS preemption); the target reports its
+ * own worst case (fill_cycles_max). Exit status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "wave_mod.h"
+
+namespace {
+
+constexpr uint32_t kHalf = 64;  // DAC_HALF
+constexpr double kTwoPow32 = 4294967296.0;
+
+uint32_t g_fs = 256000;
+wave_gen_t g_wave;
+wave_gen_t g_ref;
+wave_mod_t g_mod;
+
+uint32_t Tw(double hz) { return wave_gen_tuning(g_fs, (uint64_t) std::llround(hz * 1e6)); }
+
+void StartCarrier(wave_gen_t* g, uint32_t tw) {
+  wave_cfg_t c = {WAVE_SINE, WAVE_TABLES_N, 0, WAVE_TABLES_FULL, 0, nullptr};
+  wave_gen_init(g, &c);
+  wave_gen_set_tuning(g, tw);
+}
+
+double RampModel(const wave_mod_cfg_t& c, uint64_t k) {
+  uint64_t p = k % c.period;
+  if (p < c.rise) {
+    return (double) p / c.rise;
+  }
+  return (c.period == c.rise) ? 1.0 : 1.0 - (double) (p - c.rise) / (c.period - c.rise);
+}
+
+double MModel(const wave_mod_cfg_t& c, uint64_t k) {
+  if (c.src == WAVE_MOD_LFO) {
+    double ph = (double) (uint32_t) (k * c.lfo_tw) / kTwoPow32;
+    return (1.0 + std::sin(2.0 * M_PI * ph)) / 2.0;
+  }
+  return RampModel(c, k);
+}
+
+bool CheckExact() {
+  uint16_t a[kHalf], b[kHalf];
+  uint32_t bad_off = 0, bad_fm = 0;
+  wave_mod_cfg_t c = {};
+  uint32_t tw = Tw(1234.567);
+
+  StartCarrier(&g_wave, 0);
+  StartCarrier(&g_ref, 0);
+  wave_mod_init(&g_mod);
+  for (uint32_t blk = 0; blk < 2000; blk++) {
+    wave_mod_fill(&g_mod, &g_wave, a, kHalf);
+    wave_gen_fill(&g_ref, b, kHalf);
+    bad_off += std::memcmp(a, b, sizeof(a)) != 0;
+  }
+
+  StartCarrier(&g_wave, 0);
+  StartCarrier(&g_ref, tw);
+  c.src = WAVE_MOD_LFO;
+  c.dst = WAVE_MOD_FREQUENCY;
+  c.lfo_tw = Tw(3.0);
+  c.a = tw;
+  c.b = tw;
+  wave_mod_set(&g_mod, &c);
+  for (uint32_t blk = 0; blk < 2000; blk++) {
+    wave_mod_fill(&g_mod, &g_wave, a, kHalf);
+    wave_gen_fill(&g_ref, b, kHalf);
+    bad_fm += std::memcmp(a, b, sizeof(a)) != 0;
+  }
+  bool ok = bad_off == 0 && bad_fm == 0;
+  std::printf("  off == wave_gen_fill: %u blocks differ; FM a == b == DDS: %u differ  %s\n",
+              bad_off, bad_fm, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+bool CheckAmplitude(const char* name, const wave_mod_cfg_t& c, uint32_t carrier_tw) {
+  uint16_t out[kHalf], car[kHalf];
+  double worst = 0;
+  uint64_t k = 0;
+
+  StartCarrier(&g_wave, carrier_tw);
+  StartCarrier(&g_ref, carrier_tw);
+  wave_mod_init(&g_mod);
+  if (wave_mod_set(&g_mod, &c) != 0) {
+    std::printf("  %-9s rejected  FAIL\n", name);
+    return false;
+  }
+  for (uint32_t blk = 0; blk < 8000; blk++) {
+    wave_mod_fill(&g_mod, &g_wave, out, kHalf);
+    wave_gen_fill(&g_ref, car, kHalf);
+    for (uint32_t i = 0; i < kHalf; i++, k++) {
+      double gain = (c.a + ((double) c.b - c.a) * MModel(c, k)) / 65536.0;
+      double want = c.center + ((double) car[i] - c.center) * gain;
+      want = std::min(std::max(want, 0.0), 4095.0);
+      worst = std::max(worst, std::fabs(out[i] - want));
+    }
+  }
+  bool ok = worst <= 1.0;
+  std::printf("  %-9s max |err| vs model %.3f LSB  %s\n", name, worst, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// Instantaneous frequency from rising mid-scale crossings (interpolated):
+// one cycle per interval, so 1 / interval is the mean model frequency
+// over it
+bool CheckFrequency(const char* name, const wave_mod_cfg_t& c) {
+  uint16_t out[kHalf];
+  double prev = 0, last_t = -1, worst_rel = 0;
+  uint32_t prev_code = 0, worst_step = 0;
+  uint64_t k = 0, crossings = 0;
+  double f_hi = std::max(c.a, c.b) * (double) g_fs / kTwoPow32;
+  double f_lo = std::min(c.a, c.b) * (double) g_fs / kTwoPow32;
+  // steepest step of a full-scale sine at the top frequency, plus one
+  // flash-table entry (the index is truncated) and rounding
+  double step_limit =
+      2047.5 * 2.0 * M_PI * (f_hi / g_fs + 1.0 / WAVE_TABLES_N) + 1.0;
+
+  StartCarrier(&g_wave, 0);
+  wave_mod_init(&g_mod);
+  wave_mod_set(&g_mod, &c);
+  for (uint32_t blk = 0; blk < 40000; blk++) {
+    wave_mod_fill(&g_mod, &g_wave, out, kHalf);
+    for (uint32_t i = 0; i < kHalf; i++, k++) {
+      double v = out[i];
+      if (k > 0) {
+        uint32_t d = out[i] > prev_code ? out[i] - prev_code : prev_code - out[i];
+        worst_step = std::max(worst_step, d);
+      }
+      if (k > 0 && prev < 2047.5 && v >= 2047.5) {
+        double t = (double) (k - 1) + (2047.5 - prev) / (v - prev);
+        // a ramp restart jumps the frequency inside the interval: skip it
+        bool restart = c.src == WAVE_MOD_RAMP && last_t >= 0 &&
+                       (uint64_t) t / c.period != (uint64_t) last_t / c.period;
+        if (last_t >= 0 && !restart) {
+          double f_meas = g_fs / (t - last_t);
+          // average model frequency over the interval (m changes inside it)
+          double f_model = 0;
+          int steps = 16;
+          for (int j = 0; j < steps; j++) {
+            uint64_t kk = (uint64_t) (last_t + (t - last_t) * (j + 0.5) / steps);
+            f_model += (c.a + ((double) c.b - c.a) * MModel(c, kk)) * g_fs / kTwoPow32;
+          }
+          f_model /= steps;
+          worst_rel = std::max(worst_rel, std::fabs(f_meas - f_model) / f_model);
+        }
+        last_t = t;
+        crossings++;
+      }
+      prev = v;
+      prev_code = out[i];
+    }
+  }
+  // crossing time resolution: ~1/4 sample of interpolation error per edge
+  double samples_per_cycle = g_fs / f_hi;
+  double tol = 0.5 / samples_per_cycle;
+  bool ok = worst_rel <= tol && worst_step <= step_limit && crossings > 100;
+  std::printf("  %-9s %.1f..%.1f Hz: %llu cycles, worst inst. freq err %.3f%% (tol %.3f%%), "
+              "worst step %u (limit %.0f)  %s\n",
+              name, f_lo, f_hi, (unsigned long long) crossings, worst_rel * 100.0, tol * 100.0,
+              worst_step, step_limit, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// ARB tables tagged in bits 11:10; under FM the id may only change where
+// the table index restarts near 0
+bool CheckSwaps() {
+  static uint16_t arb[4][256];
+  uint16_t out[kHalf];
+  uint32_t bad = 0, prev_id = 0;
+  wave_mod_cfg_t m = {};
+
+  for (uint32_t id = 0; id < 4; id++) {
+    for (uint32_t i = 0; i < 256; i++) {
+      arb[id][i] = (uint16_t) ((id << 10) | i);
+    }
+  }
+  wave_cfg_t c = {WAVE_ARB, 256, 0, 4095, 0, arb[0]};
+  wave_gen_init(&g_wave, &c);
+  m.src = WAVE_MOD_LFO;
+  m.dst = WAVE_MOD_FREQUENCY;
+  m.lfo_tw = Tw(7.0);
+  m.a = Tw(500.0);
+  m.b = Tw(6000.0);
+  wave_mod_init(&g_mod);
+  wave_mod_set(&g_mod, &m);
+  // largest first index after a wrap: one step at the top frequency
+  uint32_t first_max = (uint32_t) ((uint64_t) m.b * 256U >> 32) + 1U;
+  for (uint32_t blk = 0; blk < 20000; blk++) {
+    if (blk % 3U == 0U) {
+      c.arb = arb[(blk / 3U) % 4U];
+      (void) wave_gen_build(&g_wave, &c);
+    }
+    wave_mod_fill(&g_mod, &g_wave, out, kHalf);
+    for (uint32_t i = 0; i < kHalf; i++) {
+      uint32_t id = out[i] >> 10;
+      if (id != prev_id && (out[i] & 1023U) > first_max) {
+        bad++;
+      }
+      prev_id = id;
+    }
+  }
+  bool ok = bad == 0 && g_wave.swaps > 0;
+  std::printf("  FM swaps  %u at phase wraps, %u elsewhere  %s\n", g_wave.swaps, bad,
+              ok ? "ok" : "FAIL");
+  return ok;
+}
+
+volatile uint32_t g_sink;
+
+void Bench(const char* name, const wave_mod_cfg_t& c) {
+  static double ns[200000];
+  uint16_t out[kHalf];
+  uint32_t words[kHalf];
+  double deadline_ns = kHalf * 1e9 / g_fs;
+
+  for (int dual = 0; dual < 2; dual++) {
+    uint32_t fills = 0;
+    double total = 0;
+    StartCarrier(&g_wave, Tw(1000.0));
+    wave_gen_set_ch2(&g_wave, WAVE_CH2_PHASE, 0x40000000U);
+    wave_mod_init(&g_mod);
+    wave_mod_set(&g_mod, &c);
+    while (fills < sizeof(ns) / sizeof(ns[0])) {
+      auto t0 = std::chrono::steady_clock::now();
+      if (dual) {
+        wave_mod_fill_dual(&g_mod, &g_wave, words, kHalf);
+      } else {
+        wave_mod_fill(&g_mod, &g_wave, out, kHalf);
+      }
+      ns[fills] =
+          std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+      total += ns[fills];
+      fills++;
+      g_sink = g_sink + (dual ? words[3] : out[3]);
+    }
+    // the host max is the OS preempting the loop, not the fill
+    std::sort(ns, ns + fills);
+    double p999 = ns[(size_t) (fills * 0.999)];
+    std::printf("  %-9s %-6s %6.2f ns/sample, fill p99.9 %6.0f ns = %5.2f%% of %.0f ns\n", name,
+                dual ? "dual" : "single", total / fills / kHalf, p999,
+                p999 / deadline_ns * 100.0, deadline_ns);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool ok = true;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "-s") == 0) {
+      g_fs = (uint32_t) std::strtoul(argv[i + 1], nullptr, 0);
+    }
+  }
+
+  wave_mod_cfg_t am = {WAVE_MOD_LFO, WAVE_MOD_AMPLITUDE, Tw(13.0), 0, 0, 16384, 65536, 2048};
+  wave_mod_cfg_t env = {WAVE_MOD_RAMP, WAVE_MOD_AMPLITUDE, 0, 25600, 2560, 0, 65536, 2048};
+  wave_mod_cfg_t boost = {WAVE_MOD_RAMP, WAVE_MOD_AMPLITUDE, 0, 9999, 9999, 0, 131072, 2048};
+  wave_mod_cfg_t fm = {WAVE_MOD_LFO, WAVE_MOD_FREQUENCY, Tw(5.0), 0, 0, Tw(800.0), Tw(1200.0), 0};
+  wave_mod_cfg_t sweep = {WAVE_MOD_RAMP, WAVE_MOD_FREQUENCY, 0, 256000, 256000, Tw(100.0),
+                          Tw(5000.0), 0};
+  wave_mod_cfg_t down = {WAVE_MOD_RAMP, WAVE_MOD_FREQUENCY, 0, 128000, 0, Tw(200.0), Tw(2000.0),
+                         0};
+
+  std::printf("fs %u Hz, %u-sample fills\n\nbit-exact paths:\n", g_fs, kHalf);
+  ok = CheckExact() && ok;
+  std::printf("\namplitude (vs double model):\n");
+  ok = CheckAmplitude("AM 75%", am, Tw(1000.0)) && ok;
+  ok = CheckAmplitude("envelope", env, Tw(1000.0)) && ok;
+  ok = CheckAmplitude("gain 0..2", boost, 0) && ok;
+  std::printf("\nfrequency (mid-scale crossings):\n");
+  ok = CheckFrequency("FM", fm) && ok;
+  ok = CheckFrequency("sweep up", sweep) && ok;
+  ok = CheckFrequency("sweep dn", down) && ok;
+  ok = CheckSwaps() && ok;
+
+  std::printf("\ncost on this host (1 kHz carrier):\n");
+  wave_mod_cfg_t off = {};
+  Bench("off", off);
+  Bench("AM", am);
+  Bench("envelope", env);
+  Bench("FM", fm);
+  Bench("sweep", sweep);
+  std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
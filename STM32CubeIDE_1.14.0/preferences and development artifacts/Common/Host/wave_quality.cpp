@@ -0,0 +1,472 @@
+/**
+ ******************************************************************************
+ * @file           : wave_quality.cpp
+ * @brief          : THD / SFDR / SNR / ENOB of generated DAC sequences
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/wave_gen.c ../Src/wave_tables.c
+ *   c++ -O2 -std=c++17 -I../Inc wave_quality.cpp wave_gen.o wave_tables.o \
+ *       -lm -o wave_quality
+ *
+ * Usage:
+ *   wave_quality [-s fs_hz] [-b bw_hz] [-H harmonics] [-Z]
+ *                [-r baseline | -w baseline] [-f codes [-k cycles]]
+ *
+ *   fs_hz      DAC update rate (default 256000, TIM6 in
+ *              SineWaveVoltageOutput)
+ *   bw_hz      analysis bandwidth (default fs / 2: ideal reconstruction
+ *              filter; above it the ZOH images count as spurs)
+ *   harmonics  THD up to this harmonic, aliased into the band (default 10)
+ *   -Z         no ZOH: metrics of the sampled sequence itself
+ *   -r / -w    compare against / write a baseline (wave_quality_baseline.txt
+ *              next to this file, taken with the defaults)
+ *   -f codes   analyse one sequence instead: numbers separated by blanks,
+ *              commas or newlines ('#' starts a comment), rounded to 12-bit
+ *              codes, whole periods of a tone; cycles = periods in the file
+ *              (default: the largest non-DC bin)
+ *
+ * Every record holds a whole number of periods (wave_gen step mode: one
+ * table period; DDS: 65536 samples with an integer number of cycles), so
+ * the metrics are exact and need no window (wave_quality.hpp). Sines are
+ * analysed as tones; the other shapes against their unquantised ideal, the
+ * difference being the noise + distortion (THD / SNR do not apply).
+ * "ideal" rows are the sine rounded to 12 bits in double precision: the
+ * best a table of that length can do.
+ *
+ * Checks: the analyser against signals of known quality (unquantised,
+ * 12-bit rounded, a -60 dBc third harmonic, ZOH droop), then one row per
+ * waveform configuration; with -r each row's SINAD / SFDR / THD has to
+ * stay within 0.05 dB of the baseline. Exit status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "wave_gen.h"
+#include "wave_quality.hpp"
+#include "wave_tables.h"
+#include "wave_tables_shapes.hpp"
+
+namespace {
+
+using wave_quality::Metrics;
+using wave_quality::Setup;
+
+constexpr uint32_t kHalf = 64;        // DAC_HALF
+constexpr uint32_t kDdsRecord = 65536;
+constexpr uint32_t kBits = 12;
+constexpr double kTol = 0.05;         // dB, baseline comparison
+
+wave_gen_t g_wave;
+
+struct Record {
+  std::vector<double> codes;
+  std::vector<double> ideal;  // empty: tone
+  uint32_t cycles = 1;
+};
+
+void Fill(uint32_t n, Record& r) {
+  std::vector<uint16_t> buf(n);
+  for (uint32_t i = 0; i < n; i += kHalf) {
+    wave_gen_fill(&g_wave, &buf[i], (n - i < kHalf) ? n - i : kHalf);
+  }
+  r.codes.assign(buf.begin(), buf.end());
+}
+
+double SineIdeal(const wave_cfg_t& c, double x) {
+  return c.lo + (std::sin(2.0 * M_PI * x) + 1.0) * 0.5 * (c.hi - c.lo);
+}
+
+// Unquantised shape of cfg at x in [0, 1), as wave_gen defines it
+double ShapeIdeal(const wave_cfg_t& c, double x) {
+  double span = c.hi - c.lo;
+  switch (c.shape) {
+    case WAVE_TRIANGLE:
+      return c.lo + span * (x <= 0.5 ? 2.0 * x : 2.0 * (1.0 - x));
+    case WAVE_SQUARE:
+      return (x * c.len < c.duty) ? c.hi : c.lo;
+    case WAVE_SAW:
+      return c.lo + span * x * c.len / (c.len - 1U);
+    case WAVE_BURST:
+      return c.lo + wave_tables::Ideal(wave_tables::kShapes[1], x, 1.0) * span;
+    case WAVE_GAUSS:
+      return c.lo + wave_tables::Ideal(wave_tables::kShapes[2], x, 1.0) * span;
+    case WAVE_SINC:
+      return c.lo + wave_tables::Ideal(wave_tables::kShapes[3], x, 1.0) * span;
+    default:
+      return SineIdeal(c, x);
+  }
+}
+
+// One table period in step mode
+Record Step(wave_cfg_t c) {
+  Record r;
+  wave_gen_init(&g_wave, &c);
+  Fill(c.len, r);
+  if (c.shape != WAVE_SINE) {
+    for (uint32_t i = 0; i < c.len; i++) {
+      r.ideal.push_back(ShapeIdeal(c, (double) i / c.len));
+    }
+  }
+  return r;
+}
+
+// kDdsRecord samples holding cycles periods: tw = cycles * 2^32 / record
+Record Dds(wave_cfg_t c, uint32_t cycles) {
+  Record r;
+  wave_gen_init(&g_wave, &c);
+  wave_gen_set_tuning(&g_wave, cycles * (uint32_t) (4294967296ULL / kDdsRecord));
+  Fill(kDdsRecord, r);
+  r.cycles = cycles;
+  return r;
+}
+
+// Sine rounded to 12 bits in double precision
+Record IdealSine(uint32_t n) {
+  wave_cfg_t c = {WAVE_SINE, n, 0, 4095, 0, nullptr};
+  Record r;
+  for (uint32_t i = 0; i < n; i++) {
+    r.codes.push_back(wave_quality::Quantize(SineIdeal(c, (double) i / n), kBits));
+  }
+  return r;
+}
+
+// SineWaveVoltageOutput's Generate_Sine before wave_gen (VMIN 0, VMAX 3.3,
+// VREF 3.3, DAC_RES 4095, 256 samples): float sinf, truncated
+Record LegacyFull() {
+  Record r;
+  uint16_t dac_min = (uint16_t) ((0.0f / 3.3f) * 4095.0f);
+  uint16_t dac_max = (uint16_t) ((3.3f / 3.3f) * 4095.0f);
+  for (uint32_t i = 0; i < 256; i++) {
+    float s = sinf(2.0f * (float) M_PI * i / 256);
+    r.codes.push_back(dac_min + (uint16_t) (((s + 1.0f) / 2.0f) * (dac_max - dac_min)));
+  }
+  return r;
+}
+
+// Its commented "Half Sine Wave": DAC_OFFSET + (uint16_t)(DAC_AMPL * sinf),
+// DAC_OFFSET 2048, DAC_AMPL 50. The M7's float -> unsigned conversion
+// saturates, so the negative half is held at DAC_OFFSET
+Record LegacyHalf() {
+  Record r;
+  for (uint32_t i = 0; i < 256; i++) {
+    float v = 50.0f * sinf(2.0f * (float) M_PI * i / 256);
+    r.codes.push_back(2048U + (v < 0.0f ? 0U : (uint16_t) v));
+  }
+  return r;
+}
+
+struct Case {
+  const char* name;
+  std::function<Record()> make;
+};
+
+std::vector<Case> Cases() {
+  auto sine = [](uint32_t len, uint16_t lo, uint16_t hi) {
+    return wave_cfg_t{WAVE_SINE, len, lo, hi, 0, nullptr};
+  };
+  auto shape = [](uint32_t s, uint32_t len) {
+    return wave_cfg_t{s, len, 0, 4095, len / 2U, nullptr};
+  };
+  return {
+      // SineWaveVoltageOutput boot: flash sine in place, DDS 1 kHz
+      {"boot_dds_1k", [=] { return Dds(sine(WAVE_TABLES_N, 0, WAVE_TABLES_FULL), 256); }},
+      {"legacy_full_256", LegacyFull},
+      {"legacy_half_256", LegacyHalf},
+      {"ideal_sine_64", [] { return IdealSine(64); }},
+      {"ideal_sine_256", [] { return IdealSine(256); }},
+      {"ideal_sine_1024", [] { return IdealSine(1024); }},
+      {"sine_64", [=] { return Step(sine(64, 0, 4095)); }},
+      {"sine_100", [=] { return Step(sine(100, 0, 4095)); }},
+      {"sine_128", [=] { return Step(sine(128, 0, 4095)); }},
+      {"sine_200", [=] { return Step(sine(200, 0, 4095)); }},
+      {"sine_256", [=] { return Step(sine(256, 0, 4095)); }},
+      {"sine_1024", [=] { return Step(sine(WAVE_TABLES_N, 0, WAVE_TABLES_FULL)); }},
+      {"sine_256_0_2047", [=] { return Step(sine(256, 0, 2047)); }},
+      {"sine_256_1000_3000", [=] { return Step(sine(256, 1000, 3000)); }},
+      // the half-sine range of main.c: DAC_OFFSET -/+ DAC_AMPL
+      {"sine_256_1998_2098", [=] { return Step(sine(256, 1998, 2098)); }},
+      {"dds_1024_1k", [=] { return Dds(sine(WAVE_TABLES_N, 0, WAVE_TABLES_FULL), 257); }},
+      {"dds_1024_16k", [=] { return Dds(sine(WAVE_TABLES_N, 0, WAVE_TABLES_FULL), 4099); }},
+      {"dds_256_1k", [=] { return Dds(sine(256, 0, 4095), 257); }},
+      {"dds_256_16k", [=] { return Dds(sine(256, 0, 4095), 4099); }},
+      {"triangle_256", [=] { return Step(shape(WAVE_TRIANGLE, 256)); }},
+      {"square_256", [=] { return Step(shape(WAVE_SQUARE, 256)); }},
+      {"saw_256", [=] { return Step(shape(WAVE_SAW, 256)); }},
+      {"burst_1024", [=] { return Step(shape(WAVE_BURST, WAVE_TABLES_N)); }},
+      {"burst_200", [=] { return Step(shape(WAVE_BURST, 200)); }},
+      {"gauss_1024", [=] { return Step(shape(WAVE_GAUSS, WAVE_TABLES_N)); }},
+      {"gauss_256", [=] { return Step(shape(WAVE_GAUSS, 256)); }},
+      {"sinc_1024", [=] { return Step(shape(WAVE_SINC, WAVE_TABLES_N)); }},
+      {"sinc_200", [=] { return Step(shape(WAVE_SINC, 200)); }},
+  };
+}
+
+Metrics Analyze(const Record& r, const Setup& s) {
+  return r.ideal.empty() ? wave_quality::AnalyzeTone(r.codes, r.cycles, s)
+                         : wave_quality::AnalyzeShape(r.codes, r.ideal, r.cycles, s);
+}
+
+void PrintHeader() {
+  std::printf("  %-20s %6s %9s %7s %7s %7s %7s %6s %7s %7s\n", "config", "N", "f0 Hz", "SNR",
+              "THD", "SFDR", "SINAD", "ENOB", "droop", "image");
+}
+
+void PrintRow(const char* name, size_t n, const Metrics& m) {
+  char snr[16] = "      -", thd[16] = "      -";
+  if (!std::isnan(m.snr_db)) {
+    std::snprintf(snr, sizeof(snr), "%7.2f", m.snr_db);
+    std::snprintf(thd, sizeof(thd), "%7.2f", m.thd_db);
+  }
+  std::printf("  %-20s %6zu %9.2f %s %s %7.2f %7.2f %6.2f %7.3f %7.2f", name, n, m.f0, snr, thd,
+              m.sfdr_db, m.sinad_db, m.enob, m.droop_db, m.image_dbc);
+}
+
+bool Near(const char* what, double got, double want, double tol) {
+  bool ok = std::fabs(got - want) <= tol;
+  std::printf("  %-44s %9.3f (expect %8.3f +/- %.3f)  %s\n", what, got, want, tol,
+              ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// The analyser on signals whose metrics are known in closed form
+bool SelfTest() {
+  Setup raw;
+  raw.zoh = false;
+  const uint32_t n = kDdsRecord, k = 1021;  // prime: quantisation error spreads
+  std::vector<double> pure(n), q(n), h3(n);
+  bool ok = true;
+
+  for (uint32_t i = 0; i < n; i++) {
+    double w = 2.0 * M_PI * (double) k * i / n;
+    pure[i] = 2047.5 + 2047.5 * std::sin(w);
+    q[i] = wave_quality::Quantize(pure[i], kBits);
+    h3[i] = 2047.5 + 2000.0 * std::sin(w) + 2.0 * std::sin(3.0 * w);
+  }
+  std::printf("analyser self-test (N %u, %u cycles, no ZOH):\n", n, k);
+  Metrics m = wave_quality::AnalyzeTone(pure, k, raw);
+  ok = Near("unquantised sine: SINAD > 200 dB", std::fmin(m.sinad_db, 250.0), 250.0, 50.0) && ok;
+  m = wave_quality::AnalyzeTone(q, k, raw);
+  ok = Near("12-bit full-scale sine: SINAD, dB", m.sinad_db, 6.02 * kBits + 1.76, 0.3) && ok;
+  ok = Near("12-bit full-scale sine: ENOB", m.enob, kBits, 0.05) && ok;
+  m = wave_quality::AnalyzeTone(h3, k, raw);
+  ok = Near("-60 dBc 3rd harmonic: THD, dBc", m.thd_db, -60.0, 0.01) && ok;
+  ok = Near("-60 dBc 3rd harmonic: SFDR, dB", m.sfdr_db, 60.0, 0.01) && ok;
+  ok = Near("shape vs ideal, known error: SINAD, dB",
+            wave_quality::AnalyzeShape(h3, pure, k, raw).sinad_db,
+            -20.0 * std::log10(std::hypot(1.0 - 2000.0 / 2047.5, 2.0 / 2047.5)), 0.01) &&
+       ok;
+
+  // ZOH: the tone loses sinc(f0 / fs); with bw = fs its first image at
+  // fs - f0 is the largest spur of an otherwise clean sine
+  Setup zoh;
+  zoh.bw = zoh.fs;
+  uint32_t kq = n / 4U - 1U;
+  for (uint32_t i = 0; i < n; i++) {
+    pure[i] = 2047.5 + 2047.5 * std::sin(2.0 * M_PI * (double) kq * i / n);
+  }
+  double loss = wave_quality::Db(wave_quality::AnalyzeTone(pure, kq, zoh).p1 /
+                                 wave_quality::AnalyzeTone(pure, kq, raw).p1);
+  m = wave_quality::AnalyzeTone(pure, kq, zoh);
+  ok = Near("ZOH loss near fs / 4, dB", loss,
+            20.0 * std::log10(wave_quality::Sinc((double) kq / n)), 1e-6) &&
+       ok;
+  ok = Near("ZOH, bw = fs: SFDR = first image, dB", m.sfdr_db, -m.image_dbc, 1e-6) && ok;
+  return ok;
+}
+
+bool LoadBaseline(const char* path, std::map<std::string, Metrics>& base, std::string& setup) {
+  std::FILE* f = std::fopen(path, "r");
+  if (f == nullptr) {
+    std::perror(path);
+    return false;
+  }
+  char line[256];
+  while (std::fgets(line, sizeof(line), f) != nullptr) {
+    char name[64];
+    Metrics m;
+    if (std::strncmp(line, "# setup ", 8) == 0) {
+      setup = line + 8;
+      setup.erase(setup.find_last_not_of("\r\n") + 1);
+    } else if (line[0] != '#' &&
+               std::sscanf(line, "%63s %lf %lf %lf", name, &m.sinad_db, &m.sfdr_db, &m.thd_db) ==
+                   4) {
+      base[name] = m;
+    }
+  }
+  std::fclose(f);
+  return true;
+}
+
+bool Regression(const Setup& s, const char* read_path, const char* write_path) {
+  std::map<std::string, Metrics> base;
+  std::string setup, want;
+  char buf[128];
+  std::FILE* out = nullptr;
+  bool ok = true;
+
+  std::snprintf(buf, sizeof(buf), "fs %.0f bw %.0f harmonics %u zoh %d", s.fs, s.bw, s.harmonics,
+                s.zoh ? 1 : 0);
+  want = buf;
+  if (read_path != nullptr) {
+    if (!LoadBaseline(read_path, base, setup)) {
+      return false;
+    }
+    if (setup != want) {
+      std::printf("baseline taken with \"%s\", this run is \"%s\"  FAIL\n", setup.c_str(),
+                  want.c_str());
+      return false;
+    }
+  }
+  if (write_path != nullptr) {
+    out = std::fopen(write_path, "w");
+    if (out == nullptr) {
+      std::perror(write_path);
+      return false;
+    }
+    std::fprintf(out, "# wave_quality baseline: config SINAD SFDR THD (dB, nan: not a tone)\n"
+                      "# setup %s\n", want.c_str());
+  }
+
+  std::printf("\nwaveform configurations (fs %.0f Hz, bw %.0f Hz, %s, dB):\n", s.fs, s.bw,
+              s.zoh ? "ZOH" : "sampled");
+  PrintHeader();
+  for (const Case& c : Cases()) {
+    Record r = c.make();
+    Metrics m = Analyze(r, s);
+    PrintRow(c.name, r.codes.size(), m);
+    if (out != nullptr) {
+      std::fprintf(out, "%s %.3f %.3f %.3f\n", c.name, m.sinad_db, m.sfdr_db, m.thd_db);
+    }
+    auto b = base.find(c.name);
+    if (read_path == nullptr) {
+      std::printf("\n");
+    } else if (b == base.end()) {
+      std::printf("  new\n");
+    } else {
+      const Metrics& o = b->second;
+      double d_sinad = m.sinad_db - o.sinad_db;
+      double d_sfdr = m.sfdr_db - o.sfdr_db;
+      double d_thd = std::isnan(m.thd_db) ? 0.0 : o.thd_db - m.thd_db;  // lower THD is better
+      bool worse = d_sinad < -kTol || d_sfdr < -kTol || d_thd < -kTol;
+      bool better = d_sinad > kTol || d_sfdr > kTol || d_thd > kTol;
+      std::printf("  %s (SINAD %+.2f)\n", worse ? "WORSE" : (better ? "better" : "="), d_sinad);
+      ok = ok && !worse;
+    }
+  }
+  if (out != nullptr) {
+    std::fclose(out);
+    std::printf("\nbaseline written to %s\n", write_path);
+  }
+  return ok;
+}
+
+int AnalyzeFile(const char* path, uint32_t cycles, const Setup& s) {
+  std::FILE* f = std::fopen(path, "r");
+  if (f == nullptr) {
+    std::perror(path);
+    return 2;
+  }
+  std::vector<double> codes;
+  int c;
+  std::string tok;
+  bool comment = false;
+  while ((c = std::fgetc(f)) != EOF || !tok.empty()) {
+    if (c == '#') {
+      comment = true;
+    }
+    if (c == EOF || c == ',' || c == '\n' || c == '\r' || c == ' ' || c == '\t' || c == '#') {
+      if (!tok.empty()) {
+        codes.push_back(wave_quality::Quantize(std::strtod(tok.c_str(), nullptr), kBits));
+        tok.clear();
+      }
+      comment = comment && c != '\n';
+      if (c == EOF) {
+        break;
+      }
+    } else if (!comment) {
+      tok += (char) c;
+    }
+  }
+  std::fclose(f);
+  if (codes.size() < 8) {
+    std::fprintf(stderr, "%s: %zu codes, need at least 8\n", path, codes.size());
+    return 2;
+  }
+  if (cycles == 0) {
+    std::vector<double> p = wave_quality::Spectrum(codes);
+    cycles = 1;
+    for (size_t k = 2; k < p.size(); k++) {
+      cycles = (p[k] > p[cycles]) ? (uint32_t) k : cycles;
+    }
+  }
+  if (cycles == 0 || 2U * cycles >= codes.size()) {
+    std::fprintf(stderr, "%s: no tone below fs / 2\n", path);
+    return 2;
+  }
+  PrintHeader();
+  PrintRow(path, codes.size(), wave_quality::AnalyzeTone(codes, cycles, s));
+  std::printf("\n");
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Setup s;
+  bool bw_set = false;
+  const char* read_path = nullptr;
+  const char* write_path = nullptr;
+  const char* file = nullptr;
+  uint32_t cycles = 0;
+
+  for (int i = 1; i < argc; i++) {
+    bool has_arg = i + 1 < argc;
+    if (std::strcmp(argv[i], "-Z") == 0) {
+      s.zoh = false;
+    } else if (std::strcmp(argv[i], "-s") == 0 && has_arg) {
+      s.fs = std::strtod(argv[++i], nullptr);
+    } else if (std::strcmp(argv[i], "-b") == 0 && has_arg) {
+      s.bw = std::strtod(argv[++i], nullptr);
+      bw_set = true;
+    } else if (std::strcmp(argv[i], "-H") == 0 && has_arg) {
+      s.harmonics = (uint32_t) std::strtoul(argv[++i], nullptr, 0);
+    } else if (std::strcmp(argv[i], "-r") == 0 && has_arg) {
+      read_path = argv[++i];
+    } else if (std::strcmp(argv[i], "-w") == 0 && has_arg) {
+      write_path = argv[++i];
+    } else if (std::strcmp(argv[i], "-f") == 0 && has_arg) {
+      file = argv[++i];
+    } else if (std::strcmp(argv[i], "-k") == 0 && has_arg) {
+      cycles = (uint32_t) std::strtoul(argv[++i], nullptr, 0);
+    } else {
+      std::fprintf(stderr,
+                   "usage: wave_quality [-s fs_hz] [-b bw_hz] [-H harmonics] [-Z]\n"
+                   "                    [-r baseline | -w baseline] [-f codes [-k cycles]]\n");
+      return 2;
+    }
+  }
+  if (!bw_set) {
+    s.bw = s.fs / 2.0;
+  }
+  if (s.fs <= 0.0 || s.bw <= 0.0 || s.harmonics < 2) {
+    std::fprintf(stderr, "fs and bw must be > 0, harmonics >= 2\n");
+    return 2;
+  }
+  if (file != nullptr) {
+    return AnalyzeFile(file, cycles, s);
+  }
+
+  bool ok = SelfTest();
+  ok = Regression(s, read_path, write_path) && ok;
+  std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+/**
+ ******************************************************************************
+ * @file           : wave_quality.hpp
+ * @brief          : Spectral quality of DAC code sequences (header only)
+ ******************************************************************************
+ *
+ * The input is one record of DAC codes holding a whole number of periods
+ * (a wave_gen table period, a coherent DDS record), so every component
+ * falls on a bin: no window, no leakage, and the metrics are exact for
+ * the sequence given.
+ *
+ *   Quantize()     double -> nearest code of a bits-wide DAC, clamped
+ *   Spectrum()     one-sided power per bin, a sine of amplitude A -> A^2/2
+ *   AnalyzeTone()  sine: THD, SFDR, SNR, SINAD, ENOB
+ *   AnalyzeShape() any other period: the error against its ideal
+ *                  (unquantised) shape is the noise + distortion
+ *
+ * ZOH: the DAC holds each code for 1 / fs, which multiplies the sampled
+ * spectrum by sinc(f / fs) and repeats it at m fs +/- f. Every baseband
+ * bin is weighted by sinc^2 before the metrics; images are added as
+ * spurs when the analysis bandwidth bw reaches past fs / 2 (bw = fs / 2:
+ * ideal reconstruction filter). The first image of the fundamental is
+ * reported either way.
+ ******************************************************************************
+ */
+#ifndef WAVE_QUALITY_HPP
+#define WAVE_QUALITY_HPP
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+namespace wave_quality {
+
+inline double Quantize(double v, uint32_t bits) {
+  double full = (double) ((1U << bits) - 1U);
+  double q = std::nearbyint(v);
+  return q < 0.0 ? 0.0 : (q > full ? full : q);
+}
+
+// +/- 300 dB at most: an exact sequence (square wave) has no error at all
+inline double Db(double ratio) {
+  return 10.0 * std::log10(ratio < 1e-30 ? 1e-30 : (ratio > 1e30 ? 1e30 : ratio));
+}
+
+// sin(pi x) / (pi x): ZOH amplitude response at x = f / fs
+inline double Sinc(double x) { return x == 0.0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x); }
+
+// Power of bins 0..N/2 of x (radix-2 FFT for power-of-two N, a direct
+// DFT with a twiddle table otherwise)
+inline std::vector<double> Spectrum(const std::vector<double>& x) {
+  size_t n = x.size();
+  std::vector<std::complex<double>> bins(n / 2 + 1);
+
+  if (n >= 2 && (n & (n - 1)) == 0) {
+    std::vector<std::complex<double>> a(x.begin(), x.end());
+    for (size_t i = 1, j = 0; i < n; i++) {
+      size_t bit = n >> 1;
+      for (; j & bit; bit >>= 1) {
+        j ^= bit;
+      }
+      j ^= bit;
+      if (i < j) {
+        std::swap(a[i], a[j]);
+      }
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+      std::complex<double> w(std::cos(-2.0 * M_PI / len), std::sin(-2.0 * M_PI / len));
+      for (size_t i = 0; i < n; i += len) {
+        std::complex<double> t(1.0, 0.0);
+        for (size_t k = 0; k < len / 2; k++) {
+          std::complex<double> u = a[i + k];
+          std::complex<double> v = a[i + k + len / 2] * t;
+          a[i + k] = u + v;
+          a[i + k + len / 2] = u - v;
+          t *= w;
+        }
+      }
+    }
+    std::copy(a.begin(), a.begin() + (long) bins.size(), bins.begin());
+  } else {
+    std::vector<std::complex<double>> tw(n);
+    for (size_t i = 0; i < n; i++) {
+      tw[i] = std::polar(1.0, -2.0 * M_PI * (double) i / (double) n);
+    }
+    for (size_t k = 0; k < bins.size(); k++) {
+      std::complex<double> s = 0;
+      for (size_t i = 0, p = 0; i < n; i++, p = (p + k) % n) {
+        s += x[i] * tw[p];
+      }
+      bins[k] = s;
+    }
+  }
+
+  std::vector<double> p(bins.size());
+  double nn = (double) n * (double) n;
+  for (size_t k = 0; k < bins.size(); k++) {
+    bool edge = (k == 0) || (2 * k == n);
+    p[k] = std::norm(bins[k]) / nn * (edge ? 1.0 : 2.0);
+  }
+  return p;
+}
+
+struct Setup {
+  double fs = 256000.0;   // DAC update rate
+  double bw = 128000.0;   // analysis bandwidth (fs / 2: ideal filter)
+  uint32_t harmonics = 10;
+  bool zoh = true;        // false: the sampled sequence itself
+};
+
+// Baseband powers after the ZOH, and the worst image within bw
+struct Analog {
+  std::vector<double> p;
+  double worst_image = 0.0;
+};
+
+inline Analog Zoh(const std::vector<double>& sampled, size_t n, const Setup& s) {
+  Analog a;
+  if (!s.zoh) {
+    a.p = sampled;
+    return a;
+  }
+  a.p.resize(sampled.size());
+  for (size_t k = 0; k < sampled.size(); k++) {
+    double x = (double) k / (double) n;
+    double g = Sinc(x);
+    a.p[k] = sampled[k] * g * g;
+    for (double m = 1.0; k > 0; m += 1.0) {
+      double lo = (m - x) * s.fs;
+      if (lo > s.bw) {
+        break;
+      }
+      double gl = Sinc(m - x);
+      if (lo > 0.5 * s.fs) {  // fs / 2 itself is the bin, not an image
+        a.worst_image = std::fmax(a.worst_image, sampled[k] * gl * gl);
+      }
+      if ((m + x) * s.fs <= s.bw) {
+        double gh = Sinc(m + x);
+        a.worst_image = std::fmax(a.worst_image, sampled[k] * gh * gh);
+      }
+    }
+  }
+  return a;
+}
+
+struct Metrics {
+  double f0 = 0;          // Hz (tone) or period rate (shape)
+  double p1 = 0;          // tone power after the ZOH, codes^2
+  double thd_db = NAN;    // dBc, tone only
+  double sfdr_db = 0;     // dB below the largest signal component
+  double snr_db = NAN;    // tone only: harmonics excluded
+  double sinad_db = 0;
+  double enob = 0;        // (SINAD - 1.76) / 6.02
+  double droop_db = 0;    // ZOH loss at f0
+  double image_dbc = 0;   // first image (fs - f0) against f0
+};
+
+// codes: whole record, cycles: periods of the tone in it
+inline Metrics AnalyzeTone(const std::vector<double>& codes, uint32_t cycles, const Setup& s) {
+  size_t n = codes.size();
+  size_t half = n / 2;
+  Analog a = Zoh(Spectrum(codes), n, s);
+  std::vector<bool> harm(a.p.size(), false);
+  double p1 = a.p[cycles];
+  double ph = 0, pn = 0, spur = a.worst_image;
+  Metrics m;
+
+  for (uint32_t h = 2; h <= s.harmonics; h++) {
+    size_t b = (size_t) (((uint64_t) h * cycles) % n);
+    b = (b > half) ? n - b : b;
+    if (b != 0 && b != cycles && !harm[b]) {
+      harm[b] = true;
+      ph += a.p[b];
+    }
+  }
+  for (size_t k = 1; k <= half; k++) {
+    if (k == cycles) {
+      continue;
+    }
+    spur = std::fmax(spur, a.p[k]);
+    if (!harm[k]) {
+      pn += a.p[k];
+    }
+  }
+  m.f0 = cycles * s.fs / (double) n;
+  m.p1 = p1;
+  m.thd_db = Db(ph / p1);
+  m.sfdr_db = Db(p1 / spur);
+  m.snr_db = Db(p1 / pn);
+  m.sinad_db = Db(p1 / (ph + pn));
+  m.enob = (m.sinad_db - 1.76) / 6.02;
+  m.droop_db = 20.0 * std::log10(Sinc(m.f0 / s.fs));
+  m.image_dbc = 20.0 * std::log10(std::fabs(Sinc(1.0 - m.f0 / s.fs) / Sinc(m.f0 / s.fs)));
+  return m;
+}
+
+// codes and ideal: one record of periods whole periods; the AC power of
+// ideal is the signal, codes - ideal without its DC (offset) the error
+inline Metrics AnalyzeShape(const std::vector<double>& codes, const std::vector<double>& ideal,
+                            uint32_t periods, const Setup& s) {
+  size_t n = codes.size();
+  std::vector<double> err(n);
+  for (size_t i = 0; i < n; i++) {
+    err[i] = codes[i] - ideal[i];
+  }
+  Analog sig = Zoh(Spectrum(ideal), n, s);
+  Analog e = Zoh(Spectrum(err), n, s);
+  double ps = 0, pe = 0, top = 0, spur = std::fmax(e.worst_image, sig.worst_image);
+  Metrics m;
+
+  for (size_t k = 1; k < sig.p.size(); k++) {
+    ps += sig.p[k];
+    pe += e.p[k];
+    top = std::fmax(top, sig.p[k]);
+    spur = std::fmax(spur, e.p[k]);
+  }
+  m.f0 = periods * s.fs / (double) n;
+  m.sfdr_db = Db(top / spur);
+  m.sinad_db = Db(ps / pe);
+  m.enob = (m.sinad_db - 1.76) / 6.02;
+  m.droop_db = 20.0 * std::log10(Sinc(m.f0 / s.fs));
+  m.image_dbc = 20.0 * std::log10(std::fabs(Sinc(1.0 - m.f0 / s.fs) / Sinc(m.f0 / s.fs)));
+  return m;
+}
+
+}  // namespace wave_quality
+
+#endif  // WAVE_QUALITY_HPP
@@ -0,0 +1,196 @@
+/**
+ ******************************************************************************
+ * @file           : wave_tables_check.cpp
+ * @brief          : Generated flash tables and wave_gen renders vs libm
+ ******************************************************************************
+ *
+ * Build (from Common/Host):
+ *   cc  -O2 -I../Inc -c ../Src/wave_gen.c ../Src/wave_tables.c
+ *   c++ -O2 -std=c++17 -I../Inc wave_tables_check.cpp wave_gen.o \
+ *       wave_tables.o -lm -o wave_tables_check
+ *
+ * Checks, against the double-precision shapes of wave_tables_shapes.hpp:
+ *   - every entry of the compiled wave_table_* arrays: |err| <= 0.5 LSB
+ *     (i.e. they match the current generator and shapes)
+ *   - wave_gen_init of every table shape over a spread of lengths and
+ *     lo / hi ranges: |err| <= 1 LSB where the length divides
+ *     WAVE_TABLES_N (no interpolation), otherwise 1 LSB plus the linear
+ *     interpolation bound of the shape, printed per row
+ *   - a full-scale WAVE_TABLES_N config plays the flash array in place
+ *
+ * Boot cost on this host: the old Generate_Sine (256 x sinf, truncated)
+ * against wave_gen_init of the same 256-sample sine and of the in-place
+ * flash sine. Exit status 1 when a check fails.
+ ******************************************************************************
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "wave_gen.h"
+#include "wave_tables.h"
+#include "wave_tables_shapes.hpp"
+
+namespace {
+
+using wave_tables::kShapes;
+using wave_tables::Shape;
+
+constexpr uint32_t kNumShapes = sizeof(kShapes) / sizeof(kShapes[0]);
+const uint16_t* const kTables[kNumShapes] = {wave_table_sine, wave_table_burst,
+                                             wave_table_gauss, wave_table_sinc};
+constexpr uint32_t kShapeIds[kNumShapes] = {WAVE_SINE, WAVE_BURST, WAVE_GAUSS, WAVE_SINC};
+
+wave_gen_t g_wave;
+
+bool CheckTables() {
+  bool ok = true;
+  std::printf("flash tables (%u x %u bits, %u bytes):\n", WAVE_TABLES_N, WAVE_TABLES_BITS,
+              (unsigned) (kNumShapes * WAVE_TABLES_N * 2U));
+  for (uint32_t s = 0; s < kNumShapes; s++) {
+    double worst = 0;
+    for (uint32_t k = 0; k < WAVE_TABLES_N; k++) {
+      double ideal = wave_tables::Ideal(kShapes[s], (double) k / WAVE_TABLES_N, WAVE_TABLES_FULL);
+      worst = std::fmax(worst, std::fabs(kTables[s][k] - ideal));
+    }
+    bool row_ok = worst <= 0.5 + 1e-9;
+    std::printf("  %-6s max |err| %.3f LSB  %s\n", kShapes[s].name, worst, row_ok ? "ok" : "FAIL");
+    ok = ok && row_ok;
+  }
+  return ok;
+}
+
+// Worst deviation of a straight line through the table from the shape,
+// between two entries (sampled), in LSB of a full-scale table
+double InterpBound(const Shape& s) {
+  double worst = 0;
+  for (uint32_t k = 0; k < WAVE_TABLES_N; k++) {
+    double a = wave_tables::Ideal(s, (double) k / WAVE_TABLES_N, WAVE_TABLES_FULL);
+    double b = wave_tables::Ideal(s, (double) (k + 1U) / WAVE_TABLES_N, WAVE_TABLES_FULL);
+    for (int j = 1; j < 16; j++) {
+      double f = j / 16.0;
+      double x = (k + f) / WAVE_TABLES_N;
+      worst = std::fmax(worst, std::fabs(a + (b - a) * f - wave_tables::Ideal(s, x, WAVE_TABLES_FULL)));
+    }
+  }
+  return worst;
+}
+
+bool CheckRenders() {
+  static const uint32_t kLens[] = {2, 16, 64, 100, 128, 200, 250, 255, 256};
+  static const uint16_t kRanges[][2] = {{0, 4095}, {0, 2047}, {1000, 3000}, {1998, 2098}};
+  bool ok = true;
+
+  std::printf("\nwave_gen renders (%zu lengths x %zu ranges per shape):\n",
+              sizeof(kLens) / sizeof(kLens[0]), sizeof(kRanges) / sizeof(kRanges[0]));
+  for (uint32_t s = 0; s < kNumShapes; s++) {
+    double interp = InterpBound(kShapes[s]);
+    double worst_exact = 0, worst_interp = 0;
+
+    for (uint32_t len : kLens) {
+      for (const auto& r : kRanges) {
+        wave_cfg_t c = {kShapeIds[s], len, r[0], r[1], 0, nullptr};
+        double span = r[1] - r[0];
+        if (wave_gen_init(&g_wave, &c) != 0) {
+          std::printf("  %s len %u rejected  FAIL\n", kShapes[s].name, len);
+          ok = false;
+          continue;
+        }
+        for (uint32_t i = 0; i < len; i++) {
+          double ideal = r[0] + wave_tables::Ideal(kShapes[s], (double) i / len, 1.0) * span;
+          double e = std::fabs(g_wave.tab[0].code[i] - ideal);
+          if (WAVE_TABLES_N % len == 0U) {
+            worst_exact = std::fmax(worst_exact, e);
+          } else {
+            worst_interp = std::fmax(worst_interp, e);
+          }
+        }
+      }
+    }
+    bool row_ok = worst_exact <= 1.0 + 1e-9 && worst_interp <= 1.0 + interp + 1e-9;
+    std::printf("  %-6s max |err| %.3f LSB (len | N), %.3f LSB (other len, bound %.3f)  %s\n",
+                kShapes[s].name, worst_exact, worst_interp, 1.0 + interp, row_ok ? "ok" : "FAIL");
+    ok = ok && row_ok;
+
+    wave_cfg_t full = {kShapeIds[s], WAVE_TABLES_N, 0, WAVE_TABLES_FULL, 0, nullptr};
+    if (wave_gen_init(&g_wave, &full) != 0 || g_wave.tab[0].code != kTables[s]) {
+      std::printf("  %-6s full-scale %u samples not played in place  FAIL\n", kShapes[s].name,
+                  WAVE_TABLES_N);
+      ok = false;
+    }
+  }
+  wave_cfg_t big = {WAVE_SINE, WAVE_TABLES_N, 0, 2047, 0, nullptr};
+  if (WAVE_TABLES_N > WAVE_GEN_TABLE_MAX && wave_gen_init(&g_wave, &big) != -2) {
+    std::printf("  scaled %u-sample sine accepted without RAM for it  FAIL\n", WAVE_TABLES_N);
+    ok = false;
+  }
+  return ok;
+}
+
+// SineWaveVoltageOutput before the flash tables (VMIN 0, VMAX 3.3 V)
+uint16_t g_sine_table[256];
+
+void GenerateSineOld() {
+  uint16_t dac_min = 0, dac_max = 4095;
+  for (uint32_t i = 0; i < 256; i++) {
+    g_sine_table[i] = dac_min + (uint16_t) (((sinf(2.0f * M_PI * i / 256) + 1.0f) / 2.0f) *
+                                            (dac_max - dac_min));
+  }
+}
+
+volatile uint32_t g_sink;
+
+template <typename F>
+double NsPerCall(F f) {
+  uint64_t n = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  std::chrono::duration<double> dt{};
+  do {
+    for (int r = 0; r < 1000; r++) {
+      f();
+    }
+    n += 1000;
+    dt = std::chrono::steady_clock::now() - t0;
+  } while (dt.count() < 0.3);
+  return dt.count() * 1e9 / (double) n;
+}
+
+void BootCost() {
+  wave_cfg_t c256 = {WAVE_SINE, 256, 0, 4095, 0, nullptr};
+  wave_cfg_t cfull = {WAVE_SINE, WAVE_TABLES_N, 0, WAVE_TABLES_FULL, 0, nullptr};
+  double old_err = 0;
+
+  GenerateSineOld();
+  for (uint32_t i = 0; i < 256; i++) {
+    double ideal = wave_tables::Ideal(kShapes[0], i / 256.0, 4095.0);
+    old_err = std::fmax(old_err, std::fabs(g_sine_table[i] - ideal));
+  }
+  double t_old = NsPerCall([] {
+    GenerateSineOld();
+    g_sink = g_sink + g_sine_table[17];
+  });
+  double t_256 = NsPerCall([&] {
+    wave_gen_init(&g_wave, &c256);
+    g_sink = g_sink + g_wave.tab[0].code[17];
+  });
+  double t_full = NsPerCall([&] {
+    wave_gen_init(&g_wave, &cfull);
+    g_sink = g_sink + g_wave.tab[0].code[17];
+  });
+  std::printf("\nboot sine on this host:\n"
+              "  Generate_Sine, 256 x sinf     %9.1f ns  (max |err| %.3f LSB, truncated)\n"
+              "  wave_gen_init, 256 resampled  %9.1f ns\n"
+              "  wave_gen_init, %u in place  %9.1f ns\n",
+              t_old, old_err, t_256, WAVE_TABLES_N, t_full);
+}
+
+}  // namespace
+
+int main() {
+  bool ok = CheckTables();
+  ok = CheckRenders() && ok;
+  BootCost();
+  std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+/**
+ ******************************************************************************
+ * @file           : wave_tables_gen.cpp
+ * @brief          : Generates Inc/wave_tables.h and Src/wave_tables.c
+ ******************************************************************************
+ *
+ * Build and run (from Common/Host):
+ *   c++ -O2 -std=c++17 wave_tables_gen.cpp -lm -o wave_tables_gen
+ *   ./wave_tables_gen [-n size] [-b bits] [-o common_dir]
+ *
+ *   size  entries per table, power of two 64..4096 (default 1024)
+ *   bits  code width 8..16 (default 12, the DAC)
+ *   dir   Common/ folder to write into (default ..)
+ *
+ * One period / pulse per table, sampled at k / size, rounded to the
+ * nearest code in double precision (so every entry is within 0.5 LSB of
+ * libm), stored as const uint16_t: the target keeps them in flash and
+ * never runs sin/exp at boot. Bipolar shapes map -1..1 to 0..full,
+ * unipolar ones 0..1 to 0..full (wave_tables_shapes.hpp):
+ *
+ *   sine   sin(2 pi x)
+ *   burst  sin(2 pi 8 x) * Hann(x): 8-cycle tone burst, windowed
+ *   gauss  exp(-(x - 1/2)^2 / (2 * (1/10)^2)), unipolar pulse
+ *   sinc   sin(pi t) / (pi t), t = 8 (x - 1/2): 4 lobes each side, the
+ *          -0.217 minimum at the bottom of the range
+ *
+ * The generated files are committed; rerun after changing size or bits
+ * (Host/wave_tables_check verifies the compiled result).
+ ******************************************************************************
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "wave_tables_shapes.hpp"
+
+namespace {
+
+bool WriteHeader(const std::string& path, uint32_t n, uint32_t bits) {
+  std::FILE* f = std::fopen(path.c_str(), "w");
+  if (f == nullptr) {
+    std::perror(path.c_str());
+    return false;
+  }
+  std::fprintf(f,
+               "/**\n"
+               " ******************************************************************************\n"
+               " * @file           : wave_tables.h\n"
+               " * @brief          : Waveform tables in flash (generated, do not edit)\n"
+               " ******************************************************************************\n"
+               " *\n"
+               " * Written by Host/wave_tables_gen -n %u -b %u. One period / pulse per\n"
+               " * table, codes 0..2^bits - 1, each within 0.5 LSB of the libm value\n"
+               " * (shapes and ranges: Host/wave_tables_shapes.hpp).\n"
+               " ******************************************************************************\n"
+               " */\n"
+               "#ifndef WAVE_TABLES_H\n"
+               "#define WAVE_TABLES_H\n"
+               "\n"
+               "#include <stdint.h>\n"
+               "\n"
+               "#ifdef __cplusplus\n"
+               "extern \"C\" {\n"
+               "#endif\n"
+               "\n"
+               "#define WAVE_TABLES_N %uU\n"
+               "#define WAVE_TABLES_BITS %uU\n"
+               "#define WAVE_TABLES_FULL %uU\n"
+               "\n",
+               n, bits, n, bits, (1U << bits) - 1U);
+  for (const wave_tables::Shape& s : wave_tables::kShapes) {
+    std::fprintf(f, "extern const uint16_t wave_table_%s[WAVE_TABLES_N];\n", s.name);
+  }
+  std::fprintf(f,
+               "\n"
+               "#ifdef __cplusplus\n"
+               "}\n"
+               "#endif\n"
+               "\n"
+               "#endif /* WAVE_TABLES_H */\n");
+  return std::fclose(f) == 0;
+}
+
+bool WriteSource(const std::string& path, uint32_t n, uint32_t bits) {
+  std::FILE* f = std::fopen(path.c_str(), "w");
+  if (f == nullptr) {
+    std::perror(path.c_str());
+    return false;
+  }
+  std::fprintf(f,
+               "/**\n"
+               " ******************************************************************************\n"
+               " * @file           : wave_tables.c\n"
+               " * @brief          : Waveform tables in flash (generated, do not edit)\n"
+               " ******************************************************************************\n"
+               " */\n"
+               "#include \"wave_tables.h\"\n");
+  for (const wave_tables::Shape& s : wave_tables::kShapes) {
+    std::fprintf(f, "\nconst uint16_t wave_table_%s[WAVE_TABLES_N] = {\n", s.name);
+    for (uint32_t k = 0; k < n; k++) {
+      std::fprintf(f, "%s%5u,%s", (k % 10U == 0U) ? "    " : " ",
+                   wave_tables::Code(s, k, n, bits), (k % 10U == 9U || k + 1U == n) ? "\n" : "");
+    }
+    std::fprintf(f, "};\n");
+  }
+  return std::fclose(f) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t n = 1024;
+  uint32_t bits = 12;
+  std::string dir = "..";
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "-n") == 0) {
+      n = (uint32_t) std::strtoul(argv[i + 1], nullptr, 0);
+    } else if (std::strcmp(argv[i], "-b") == 0) {
+      bits = (uint32_t) std::strtoul(argv[i + 1], nullptr, 0);
+    } else if (std::strcmp(argv[i], "-o") == 0) {
+      dir = argv[i + 1];
+    } else {
+      break;
+    }
+  }
+  if (n < 64 || n > 4096 || (n & (n - 1U)) != 0 || bits < 8 || bits > 16) {
+    std::fprintf(stderr, "usage: wave_tables_gen [-n 64..4096, power of 2] [-b 8..16] [-o dir]\n");
+    return 2;
+  }
+  if (!WriteHeader(dir + "/Inc/wave_tables.h", n, bits) ||
+      !WriteSource(dir + "/Src/wave_tables.c", n, bits)) {
+    return 1;
+  }
+  std::printf("%zu tables x %u entries x %u bits -> %s/Inc/wave_tables.h, %s/Src/wave_tables.c "
+              "(%u bytes of flash)\n",
+              sizeof(wave_tables::kShapes) / sizeof(wave_tables::kShapes[0]), n, bits,
+              dir.c_str(), dir.c_str(),
+              (unsigned) (sizeof(wave_tables::kShapes) / sizeof(wave_tables::kShapes[0]) * n * 2U));
+  return 0;
+}
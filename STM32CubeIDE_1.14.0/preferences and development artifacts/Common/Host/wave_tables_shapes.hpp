@@ -0,0 +1,67 @@
+/**
+ ******************************************************************************
+ * @file           : wave_tables_shapes.hpp
+ * @brief          : libm reference of the generated waveform tables
+ ******************************************************************************
+ *
+ * Shared by wave_tables_gen (writes the tables) and wave_tables_check
+ * (compares the compiled tables and wave_gen output against it), so both
+ * use the same shapes and the same code mapping.
+ ******************************************************************************
+ */
+#ifndef WAVE_TABLES_SHAPES_HPP
+#define WAVE_TABLES_SHAPES_HPP
+
+#include <cmath>
+#include <cstdint>
+
+namespace wave_tables {
+
+struct Shape {
+  const char* name;
+  bool unipolar;           // 0..1 -> 0..full, else -1..1 -> 0..full
+  double (*f)(double x);   // x in [0, 1), one period / pulse
+};
+
+inline double Sine(double x) { return std::sin(2.0 * M_PI * x); }
+
+inline double Burst(double x) {
+  return std::sin(2.0 * M_PI * 8.0 * x) * 0.5 * (1.0 - std::cos(2.0 * M_PI * x));
+}
+
+inline double Gauss(double x) {
+  double d = (x - 0.5) / 0.1;
+  return std::exp(-0.5 * d * d);
+}
+
+// sinc over 4 lobes each side; scaled so its minimum sits at -1
+constexpr double kSincMin = -0.21723362821122166;  // sinc(1.4303)
+inline double Sinc(double x) {
+  double t = 8.0 * (x - 0.5);
+  double s = (t == 0.0) ? 1.0 : std::sin(M_PI * t) / (M_PI * t);
+  return (s - kSincMin) / (1.0 - kSincMin) * 2.0 - 1.0;
+}
+
+// Same order as the wave_shape_t entries that use them
+constexpr Shape kShapes[] = {
+    {"sine", false, Sine},
+    {"burst", false, Burst},
+    {"gauss", true, Gauss},
+    {"sinc", false, Sinc},
+};
+
+// Exact (unrounded) code of shape s at x for a full-scale of full
+inline double Ideal(const Shape& s, double x, double full) {
+  double v = s.f(x);
+  return s.unipolar ? v * full : (v + 1.0) * 0.5 * full;
+}
+
+inline uint32_t Code(const Shape& s, uint32_t k, uint32_t n, uint32_t bits) {
+  double full = (double) ((1U << bits) - 1U);
+  double v = std::nearbyint(Ideal(s, (double) k / n, full));
+  return (uint32_t) (v < 0.0 ? 0.0 : (v > full ? full : v));
+}
+
+}  // namespace wave_tables
+
+#endif  // WAVE_TABLES_SHAPES_HPP
@@ -0,0 +1,100 @@
+/**
+ ******************************************************************************
+ * @file           : adc_os.h
+ * @brief          : ADC hardware oversampling profiles (H7 16-bit ADC)
+ ******************************************************************************
+ *
+ * The H7 ADC can accumulate `ratio` conversions in hardware and right-shift
+ * the sum before it reaches DR, so averaging costs no CPU and no DMA
+ * bandwidth. Every profile shifts by log2(ratio): DR stays a 16-bit average
+ * in the same code domain as TS_CAL1/TS_CAL2 and VREFINT_CAL, so the
+ * calibration math and the halfword DMA are unchanged.
+ *
+ * Figures below for the temperature channel at the workspace defaults:
+ *   f_adc = 20 MHz (PLL2P), 810.5 sampling + 8.5 conversion cycles
+ *   one conversion = 819 cycles = 40.95 us -> 24.42 kS/s
+ *
+ *   Profile            ratio  shift  noise / ENOB   output rate
+ *   ADC_OS_OFF            1     0     x1    +0 bit   24.42 kS/s
+ *   ADC_OS_X4             4     2     /2    +1 bit    6.10 kS/s
+ *   ADC_OS_X16           16     4     /4    +2 bit    1.53 kS/s
+ *   ADC_OS_X64           64     6     /8    +3 bit     381 S/s
+ *   ADC_OS_X256         256     8     /16   +4 bit    95.4 S/s
+ *   ADC_OS_X16_TRIG      16     4     /4    +2 bit   trigger rate / 16
+ *
+ * "noise" is the white-noise stddev reduction sqrt(ratio); the extra bits
+ * are the effective resolution gained below the 16-bit LSB (ENOB gain =
+ * 0.5 * log2(ratio)). Slow drift is not averaged away. The gain is an
+ * upper bound: DR is shifted back to 16 bits, and that requantisation
+ * (1/sqrt(12) LSB) caps it once noise / sqrt(ratio) gets near it. At
+ * 3 LSB rms input noise x256 gives about +3.1 bits; at 1 LSB, x64 and
+ * x256 add only 0.3 / 0.4 bit over x16 (Host/adc_os_model).
+ *
+ * Burst profiles run all `ratio` conversions back to back per trigger
+ * (software start + continuous mode). The _TRIG profile consumes one
+ * external trigger per conversion (TROVS), so a timer sets the spacing.
+ *
+ * adc_os_apply() lives in adc_os_hal.c (target only), the table and the
+ * rate helper here are HAL-free.
+ ******************************************************************************
+ */
+#ifndef ADC_OS_H
+#define ADC_OS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  ADC_OS_OFF = 0,
+  ADC_OS_X4,
+  ADC_OS_X16,
+  ADC_OS_X64,
+  ADC_OS_X256,
+  ADC_OS_X16_TRIG,
+  ADC_OS_PROFILE_COUNT
+} adc_os_profile_id_t;
+
+typedef struct {
+  const char* name;
+  uint16_t ratio;    /* conversions accumulated per result, 1..1024 */
+  uint8_t shift;     /* right shift applied to the sum, 0..11 */
+  uint8_t enob_gain; /* effective bits gained, 0.5 * log2(ratio) */
+  uint8_t per_trigger; /* 1: one conversion per trigger, 0: burst */
+} adc_os_profile_t;
+
+/* Conversion time of the temperature channel, in half ADC clock cycles */
+#define ADC_OS_TSENSE_HALF_CYCLES 1638U /* (810.5 + 8.5) * 2 */
+
+/**
+ * @brief  Profile descriptor, NULL for an out-of-range id.
+ */
+const adc_os_profile_t* adc_os_profile(adc_os_profile_id_t id);
+
+/**
+ * @brief  Output rate of a burst profile.
+ * @param  p: profile
+ * @param  f_adc_hz: ADC kernel clock after prescalers
+ * @param  half_cycles: sampling + conversion time, in half ADC cycles
+ * @retval Results per second, in mHz (24.42 kS/s -> 24420024)
+ */
+uint32_t adc_os_rate_mhz(const adc_os_profile_t* p,
+                         uint32_t f_adc_hz,
+                         uint32_t half_cycles);
+
+#ifdef HAL_ADC_MODULE_ENABLED
+/**
+ * @brief  Program a profile into hadc->Init and re-run HAL_ADC_Init.
+ *         Call from USER CODE ADC3_Init 2, i.e. before the ADC is enabled.
+ * @retval HAL_OK, or HAL_ERROR for an unknown id / HAL_ADC_Init failure
+ */
+HAL_StatusTypeDef adc_os_apply(ADC_HandleTypeDef* hadc, adc_os_profile_id_t id);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADC_OS_H */
@@ -0,0 +1,108 @@
+/**
+ ******************************************************************************
+ * @file           : adc_stats.h
+ * @brief          : Streaming statistics over blocks of ADC codes
+ ******************************************************************************
+ *
+ * Single pass, no allocation. Each block is reduced by an integer kernel
+ * (count, sum, sum of squares, min, max) and then merged into the running
+ * state with Chan's parallel form of Welford's update:
+ *
+ *   delta = mean_b - mean
+ *   mean += delta * n_b / n
+ *   M2   += M2_b + delta^2 * n_a * n_b / n
+ *
+ * so the per-sample work stays in the integer kernel and the double math
+ * runs once per block.
+ *
+ * Kernel: on cores with the DSP extension (__ARM_FEATURE_SIMD32, e.g.
+ * Cortex-M7/M4) two halfwords are processed per word:
+ *   USUB16 + SEL  packed unsigned min / max (one asm statement each)
+ *   SMLAD         packed sum      (codes offset to signed: x ^ 0x8000)
+ *   SMLALD        packed sum of squares into 64 bits
+ * Elsewhere (host, M0) a portable scalar loop gives identical results.
+ *
+ * EMA: exponential average of the block means, alpha = 2^-ema_shift,
+ * i.e. a drift tracker with a time constant of ~2^ema_shift blocks.
+ *
+ * Concurrency: one writer (e.g. the DMA ISR) calls adc_stats_push_block(),
+ * any lower-priority context reads with adc_stats_snapshot(). A sequence
+ * counter (odd while writing) lets the reader retry instead of masking
+ * interrupts, so the writer is never delayed.
+ ******************************************************************************
+ */
+#ifndef ADC_STATS_H
+#define ADC_STATS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Samples reduced per kernel call, keeps the packed 32-bit sum in range */
+#define ADC_STATS_CHUNK 4096U
+
+/* Integer reduction of one block */
+typedef struct {
+  uint32_t n;
+  int32_t sum_c;   /* sum of (x - 32768) */
+  int64_t sumsq_c; /* sum of (x - 32768)^2 */
+  uint16_t min;
+  uint16_t max;
+} adc_stats_block_t;
+
+/* Consistent copy of the running state */
+typedef struct {
+  uint32_t count; /* samples since reset */
+  uint32_t blocks;
+  uint16_t min;
+  uint16_t max;
+  double mean; /* codes */
+  double m2;   /* sum of squared deviations */
+  double ema;  /* EMA of block means, codes */
+} adc_stats_snapshot_t;
+
+typedef struct {
+  volatile uint32_t seq; /* odd while the writer is updating */
+  adc_stats_snapshot_t st;
+  uint8_t ema_shift;
+} adc_stats_t;
+
+/**
+ * @brief  Clear the accumulator.
+ * @param  s: accumulator
+ * @param  ema_shift: EMA weight 2^-ema_shift per block (0 = last block mean)
+ */
+void adc_stats_init(adc_stats_t* s, uint8_t ema_shift);
+
+/**
+ * @brief  Reduce a block with the integer kernel (SIMD when available).
+ * @param  x: codes
+ * @param  n: number of codes, at most ADC_STATS_CHUNK
+ * @param  out: reduction
+ */
+void adc_stats_scan(const uint16_t* x, uint32_t n, adc_stats_block_t* out);
+
+/**
+ * @brief  Feed a block (writer side, ISR safe). n may be any length.
+ */
+void adc_stats_push_block(adc_stats_t* s, const uint16_t* x, uint32_t n);
+
+/**
+ * @brief  Take a consistent copy of the running state (reader side).
+ */
+void adc_stats_snapshot(const adc_stats_t* s, adc_stats_snapshot_t* out);
+
+/**
+ * @brief  Sample variance of a snapshot in codes^2 (0 below two samples).
+ */
+static inline double adc_stats_variance(const adc_stats_snapshot_t* st) {
+  return (st->count > 1U) ? st->m2 / (double) (st->count - 1U) : 0.0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADC_STATS_H */
@@ -0,0 +1,95 @@
+/**
+ ******************************************************************************
+ * @file           : adc_stream.h
+ * @brief          : Ping-pong block acquisition on top of a circular ADC DMA
+ ******************************************************************************
+ *
+ * The DMA runs in circular mode over 2 * block_len halfwords:
+ *
+ *   buf[0 .. block_len-1]            -> block 0, signalled by HalfCplt
+ *   buf[block_len .. 2*block_len-1]  -> block 1, signalled by Cplt
+ *
+ * The DMA callbacks only count completed halves (ISR side, single
+ * writer). The main loop calls adc_stream_poll(), which hands the newest
+ * completed half to the block callback exactly once and then releases it.
+ *
+ * Only the newest half is whole: once the DMA has completed the one after
+ * it, it is already refilling it. So when the consumer falls behind, every
+ * older block is skipped and counted in `overruns` (samples lost), and so
+ * is a half the DMA started refilling while its block callback was still
+ * running (the callback took longer than one block time). Lost data is
+ * never silent.
+ *
+ * No HAL dependency: the same code runs on target and on the host.
+ ******************************************************************************
+ */
+#ifndef ADC_STREAM_H
+#define ADC_STREAM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default samples per half buffer (DMA length = 2 * ADC_STREAM_BLOCK_LEN) */
+#ifndef ADC_STREAM_BLOCK_LEN
+#define ADC_STREAM_BLOCK_LEN 64U
+#endif
+
+typedef void (*adc_stream_block_fn)(const uint16_t* block, uint32_t len, void* ctx);
+
+typedef struct {
+  uint16_t* buf;              /* DMA target, 2 * block_len halfwords */
+  uint32_t block_len;         /* samples per half */
+  volatile uint32_t filled;   /* halves completed, set by ISR (wraps) */
+  uint32_t taken;             /* halves consumed or skipped by the consumer */
+  uint32_t overruns;          /* halves overwritten before or while consumed */
+  uint32_t blocks;            /* blocks consumed */
+  uint32_t samples;           /* samples consumed (wraps) */
+  adc_stream_block_fn on_block;
+  void* ctx;
+} adc_stream_t;
+
+/**
+ * @brief  Bind a stream to its DMA buffer and block callback.
+ * @param  s: stream
+ * @param  buf: DMA buffer of 2 * block_len halfwords
+ * @param  block_len: samples per half
+ * @param  on_block: called from adc_stream_poll() for every ready half
+ * @param  ctx: passed back to on_block
+ */
+void adc_stream_init(adc_stream_t* s,
+                     uint16_t* buf,
+                     uint32_t block_len,
+                     adc_stream_block_fn on_block,
+                     void* ctx);
+
+/**
+ * @brief  Mark the first half as ready. Call from HAL_ADC_ConvHalfCpltCallback.
+ */
+void adc_stream_half_isr(adc_stream_t* s);
+
+/**
+ * @brief  Mark the second half as ready. Call from HAL_ADC_ConvCpltCallback.
+ */
+void adc_stream_full_isr(adc_stream_t* s);
+
+/**
+ * @brief  Consume the newest completed half (main loop context).
+ * @retval 1 when a block was handed to the callback, 0 when idle.
+ */
+uint32_t adc_stream_poll(adc_stream_t* s);
+
+/**
+ * @brief  Non-zero when at least one half is waiting for adc_stream_poll().
+ */
+static inline uint32_t adc_stream_pending(const adc_stream_t* s) {
+  return (uint32_t) (s->filled != s->taken);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADC_STREAM_H */
@@ -0,0 +1,194 @@
+/**
+ ******************************************************************************
+ * @file           : cal_store.h
+ * @brief          : Persistent user calibration record, double-banked, CRC-32
+ ******************************************************************************
+ *
+ * User calibration points (ADC code, deg C) live in a small versioned
+ * record instead of in #defines, so recalibrating no longer means editing
+ * TS_CAL1_TEMP / TS_CAL2_TEMP, rebuilding and reflashing.
+ *
+ * Two copies (banks) of the record are kept. A save writes the bank that
+ * does NOT hold the current record, with seq + 1 and a fresh CRC; a reset
+ * or power loss in the middle of it leaves a bad CRC in that bank and the
+ * previous record intact in the other. Load checks both banks (magic,
+ * version, point count, CRC-32 over the 48 bytes before the crc field)
+ * and takes the valid one with the higher seq: constant time, no search, no flash wear.
+ *
+ * The points feed temp_lut_build() (temp_lut.h) once at load or update:
+ * with CAL_REC_REPLACE_FACTORY and at least two points they replace the
+ * TS_CAL1/TS_CAL2 pair, otherwise they are added to it. The per-sample
+ * conversion stays one table lookup.
+ *
+ * Runtime update is a line protocol (any UART), parsed here:
+ *
+ *   CAL?                  report only
+ *   CAL HERE <mdegC>      add a point at the current ADC code
+ *   CAL ADD <code> <mdegC>
+ *   CAL CLR               drop all user points
+ *   CAL REPLACE <0|1>     add to / replace the factory pair
+ *
+ * A point on an existing code replaces it. Temperatures are milli-deg C,
+ * e.g. "CAL HERE 23500" with a reference thermometer reading 23.5 C.
+ *
+ * The banks sit in the H7 backup SRAM (cal_store_hal.c, target only): it
+ * survives resets and, with VBAT and the backup regulator on, power loss.
+ ******************************************************************************
+ */
+#ifndef CAL_STORE_H
+#define CAL_STORE_H
+
+#include <stdint.h>
+
+#include "temp_lut.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CAL_STORE_MAGIC 0x4C414354UL /* "TCAL" */
+#define CAL_STORE_VERSION 1U
+#define CAL_STORE_MAX_POINTS 4U
+
+/* cal_record_t.flags */
+#define CAL_REC_REPLACE_FACTORY 0x0001U
+
+/* Longest command line, NUL included */
+#define CAL_LINE_MAX 32U
+
+typedef struct {
+  uint16_t code;
+  uint16_t reserved; /* 0, keeps the CRC free of padding */
+  int32_t t_q16;     /* deg C, Q16.16 */
+} cal_point_t;
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t flags;
+  uint32_t seq; /* bumped by every save, newest valid bank wins */
+  uint32_t npoints;
+  cal_point_t pt[CAL_STORE_MAX_POINTS];
+  uint32_t crc; /* CRC-32 of every byte above */
+} cal_record_t;
+
+typedef enum {
+  CAL_CMD_QUERY = 0,
+  CAL_CMD_HERE,
+  CAL_CMD_ADD,
+  CAL_CMD_CLEAR,
+  CAL_CMD_REPLACE
+} cal_cmd_op_t;
+
+typedef struct {
+  cal_cmd_op_t op;
+  uint16_t code;
+  int32_t t_mdeg;
+  uint8_t flag;
+} cal_cmd_t;
+
+/* Line assembly for the UART receive interrupt. buf and len belong to the
+ * ISR while ready is 0 and to the main loop while it is 1; only the main
+ * loop clears ready (cal_line_release). */
+typedef struct {
+  char buf[CAL_LINE_MAX];
+  volatile uint8_t len;
+  volatile uint8_t ready; /* a whole line waits in buf */
+  uint8_t error;          /* ISR only: line being received is dropped */
+  uint32_t dropped;       /* bytes lost: line too long, broken or not yet taken */
+  uint32_t errors;        /* UART receive errors reported */
+} cal_line_t;
+
+/**
+ * @brief  Empty record (no points, flags 0, seq 0), not yet sealed.
+ */
+void cal_record_clear(cal_record_t* r);
+
+/**
+ * @brief  Add a point, or replace the one on the same code.
+ * @retval 0, or -1 when all CAL_STORE_MAX_POINTS are used
+ */
+int cal_record_add(cal_record_t* r, uint16_t code, int32_t t_q16);
+
+/**
+ * @brief  Magic, version, point count and CRC all check out.
+ */
+int cal_record_valid(const cal_record_t* r);
+
+/**
+ * @brief  Points for temp_lut_build(): the factory pair and / or the user
+ *         points, per CAL_REC_REPLACE_FACTORY. r may be NULL (factory only).
+ * @param  out: room for TEMP_LUT_MAX_POINTS
+ * @retval Number of points written
+ */
+uint32_t cal_record_points(const cal_record_t* r,
+                           const temp_lut_point_t factory[2],
+                           temp_lut_point_t* out);
+
+/**
+ * @brief  Newest valid bank, copied to out.
+ * @retval Bank index 0 / 1, or -1 if neither is valid (out cleared)
+ */
+int cal_store_load(const cal_record_t bank[2], cal_record_t* out);
+
+/**
+ * @brief  Seal r (magic, version, seq after the newest bank, CRC) and
+ *         write it over the older or invalid bank.
+ * @retval Bank index written
+ */
+int cal_store_save(cal_record_t bank[2], cal_record_t* r);
+
+uint32_t cal_store_crc32(const void* p, uint32_t n);
+
+/**
+ * @brief  Parse one command line (without the line end).
+ * @retval 0, or -1 for an unknown command or a bad argument
+ */
+int cal_cmd_parse(const char* line, cal_cmd_t* c);
+
+/**
+ * @brief  Apply a parsed command to r; code_now is used by CAL HERE.
+ * @retval 1 if r changed (save and rebuild), 0 if not, -1 if it is full
+ */
+int cal_cmd_apply(const cal_cmd_t* c, cal_record_t* r, uint16_t code_now);
+
+/**
+ * @brief  Feed one received byte. CR or LF ends a non-empty line. ISR safe
+ *         against a main loop that only reads buf while ready is set.
+ *         A line longer than CAL_LINE_MAX - 1, or one that starts while
+ *         the previous line still waits, is dropped whole up to its end:
+ *         neither a truncated command nor the tail of one is parsed.
+ */
+void cal_line_push(cal_line_t* l, uint8_t c);
+
+/**
+ * @brief  Report a UART receive error (overrun, noise, framing) from the
+ *         ISR. The line being received, or the next one if nothing is
+ *         being received, is dropped up to its end; a line already waiting
+ *         (ready) is left to the main loop.
+ */
+void cal_line_error(cal_line_t* l);
+
+/**
+ * @brief  Hand the buffer back after the line was handled. Main loop only.
+ */
+void cal_line_release(cal_line_t* l);
+
+/**
+ * @brief  Backup SRAM banks (cal_store_hal.c): enable the clock, write
+ *         access and the backup regulator.
+ * @retval 0, or -1 if the backup regulator did not come up
+ */
+int cal_store_hal_init(void);
+
+/**
+ * @brief  cal_store_load() / cal_store_save() on the backup SRAM banks.
+ */
+int cal_store_hal_load(cal_record_t* out);
+int cal_store_hal_save(cal_record_t* r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAL_STORE_H */
@@ -0,0 +1,131 @@
+/**
+ ******************************************************************************
+ * @file           : dac_loop.h
+ * @brief          : DAC -> ADC loopback self-test analysis
+ ******************************************************************************
+ *
+ * The DAC drives known codes, an ADC paced by the same timer samples them
+ * back (H7: DAC1 OUT1 -> ADC2 internal channel with
+ * DAC_CHIPCONNECT_ENABLE, or a jumper from the pin to an ADC input), and
+ * this module turns the captures into bring-up numbers:
+ *
+ *   static: dac_loop_code(k) for k = 0..steps-1, a capture per step
+ *           averaged by dac_loop_mean_q8, then dac_loop_fit:
+ *             gain    ADC codes per DAC code, least squares (Q16)
+ *             offset  ADC code at DAC code 0 (1/256 LSB)
+ *             INL     worst point off the fitted line (1/256 LSB)
+ *   step:   the DAC DMA plays lo..lo, hi..hi with the step at element
+ *           step_at, the ADC DMA captures from the same first trigger;
+ *           dac_loop_edge_q8 finds the mid-level crossing (interpolated)
+ *           and dac_loop_latency gives
+ *             lat_q8      ADC sample - DAC element of the step
+ *             lat_cycles  the same in CPU cycles (both DMAs on one timer)
+ *             dma_cycles  DWT, DAC DMA interrupt before the step element
+ *                         -> ADC DMA storing the first sample showing it
+ *   dac_loop_check compares against limits and sets DAC_LOOP_FAIL_* bits.
+ *
+ * Integer only, one pass over each capture, divisions only per step.
+ * No HAL dependency: the same code runs on target and on the host
+ * (Host/dac_loop_check feeds it synthetic captures).
+ ******************************************************************************
+ */
+#ifndef DAC_LOOP_H
+#define DAC_LOOP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DAC_LOOP_STEPS_MAX 64U
+
+/* dac_loop_result_t.fails */
+#define DAC_LOOP_FAIL_GAIN 0x01U
+#define DAC_LOOP_FAIL_OFFSET 0x02U
+#define DAC_LOOP_FAIL_INL 0x04U
+#define DAC_LOOP_FAIL_EDGE 0x08U    /* no step in the capture */
+#define DAC_LOOP_FAIL_LATENCY 0x10U /* step seen too late, or before it left */
+#define DAC_LOOP_FAIL_FIT 0x20U     /* fewer than 2 distinct codes */
+#define DAC_LOOP_FAIL_CAPTURE 0x40U /* a capture never completed (set by the
+                                       target glue, not by this module) */
+
+typedef struct {
+  uint16_t dac;     /* code written */
+  uint32_t adc_q8;  /* mean code read back, 1/256 LSB */
+} dac_loop_point_t;
+
+typedef struct {
+  int32_t gain_q16;    /* 65536 = 1.0 (same reference, same resolution) */
+  int32_t offset_q8;
+  uint32_t inl_q8;
+  uint16_t inl_at;     /* DAC code of the worst point */
+  int32_t lat_q8;      /* samples, 1/256 */
+  int32_t lat_cycles;
+  int32_t dma_cycles;
+  uint32_t fails;
+} dac_loop_result_t;
+
+typedef struct {
+  uint32_t gain_err_q16;  /* |gain - 1| */
+  uint32_t offset_q8;     /* |offset| */
+  uint32_t inl_q8;
+  int32_t lat_max_q8;     /* samples */
+} dac_loop_limits_t;
+
+/* 2 % gain, 20 LSB offset, 6 LSB INL (DAC + ADC datasheet totals, with
+ * margin), step seen within 4 samples */
+#define DAC_LOOP_LIMITS_DEFAULT {1311U, 20U * 256U, 6U * 256U, 4 * 256}
+
+/**
+ * @brief  k-th of steps codes spread evenly over lo..hi (both included).
+ */
+uint16_t dac_loop_code(uint32_t k, uint32_t steps, uint16_t lo, uint16_t hi);
+
+/**
+ * @brief  Mean of n captured codes in 1/256 LSB, rounded (n >= 1).
+ */
+uint32_t dac_loop_mean_q8(const uint16_t* cap, uint32_t n);
+
+/**
+ * @brief  Least-squares line through the points: gain_q16, offset_q8,
+ *         inl_q8 / inl_at of r; the other fields are left alone.
+ * @retval 0, or -2 (and DAC_LOOP_FAIL_FIT) for n < 2 or a single code
+ */
+int32_t dac_loop_fit(const dac_loop_point_t* p, uint32_t n,
+                     dac_loop_result_t* r);
+
+/**
+ * @brief  First crossing of (lo + hi) / 2 in the lo -> hi direction
+ *         (either sign), linear between the two samples around it.
+ * @retval Index of the crossing in 1/256 sample, -1 when the capture
+ *         never crosses or starts beyond the mid level
+ */
+int32_t dac_loop_edge_q8(const uint16_t* cap, uint32_t n, uint16_t lo,
+                         uint16_t hi);
+
+/**
+ * @brief  lat_q8, lat_cycles and dma_cycles of r (DAC_LOOP_FAIL_EDGE for
+ *         edge_q8 < 0).
+ * @param  edge_q8: dac_loop_edge_q8 of the capture
+ * @param  step_at: DAC buffer element holding the first hi code
+ * @param  cps: CPU cycles per trigger
+ * @param  t_dac: DWT at the DAC DMA interrupt after element step_at - 1
+ *         (half transfer when step_at is half the buffer)
+ * @param  t_adc: DWT at the ADC DMA interrupt after element adc_last
+ */
+void dac_loop_latency(dac_loop_result_t* r, int32_t edge_q8, uint32_t step_at,
+                      uint32_t cps, uint32_t t_dac, uint32_t t_adc,
+                      uint32_t adc_last);
+
+/**
+ * @brief  Adds the DAC_LOOP_FAIL_* bits of the limits r exceeds.
+ * @retval r->fails (0: pass)
+ */
+uint32_t dac_loop_check(dac_loop_result_t* r, const dac_loop_limits_t* lim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DAC_LOOP_H */
@@ -0,0 +1,104 @@
+/**
+ ******************************************************************************
+ * @file           : dac_stream.h
+ * @brief          : Ping-pong block output on a circular, timer-paced DAC DMA
+ ******************************************************************************
+ *
+ * Output counterpart of adc_stream.h. The DAC DMA plays 2 * block_len
+ * codes in circular mode, one per timer trigger:
+ *
+ *   HalfCplt -> half 0 played, half 1 starts now
+ *   Cplt     -> half 1 played, half 0 starts now
+ *
+ * The producer (main loop, once per processed block) asks for the half
+ * that is not playing, writes block_len codes into it and commits it with
+ * the cycle stamp of the input the codes came from (e.g. DWT CYCCNT in the
+ * ADC DMA callback). When that half starts playing, the ISR side takes
+ * now - stamp as the input-to-output latency:
+ *
+ *   output timing  fixed by the trigger timer, not by the loop
+ *   latency        constant when the input and output timers run from the
+ *                  same clock at the same block rate; the histogram shows
+ *                  it (one or two bins when deterministic)
+ *
+ * A half that starts without fresh data repeats its old codes and counts
+ * as an underrun; a commit that lands while its half already plays (the
+ * producer was too late, codes may be torn) counts as late.
+ *
+ * No HAL dependency: the same code runs on target and on the host.
+ ******************************************************************************
+ */
+#ifndef DAC_STREAM_H
+#define DAC_STREAM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DAC_STREAM_HIST_BINS 32U
+
+/* Latency histogram, centred on the first latency measured */
+typedef struct {
+  uint32_t bin_cyc;                     /* bin width, cycles */
+  uint32_t lo;                          /* lower edge of bins[0] */
+  uint32_t bins[DAC_STREAM_HIST_BINS];  /* latencies per bin */
+  uint32_t under;                       /* below bins[0] */
+  uint32_t over;                        /* above the last bin */
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+} dac_stream_hist_t;
+
+typedef struct {
+  uint32_t block_len;            /* codes per half */
+  volatile uint8_t playing;      /* half the DMA reads now */
+  volatile uint8_t fresh[2];     /* committed, not started yet */
+  volatile uint32_t stamp[2];    /* input cycle stamp of each half's codes */
+  volatile uint32_t starts;      /* half starts seen (ISR) */
+  uint32_t acquired_at;          /* starts when the producer took a half */
+  volatile uint32_t underruns;   /* halves started with stale codes */
+  uint32_t late;                 /* commits after their half had started */
+  uint32_t blocks;               /* blocks committed */
+  dac_stream_hist_t lat;
+} dac_stream_t;
+
+/**
+ * @brief  Reset the stream; half 0 plays first.
+ * @param  bin_cyc: latency histogram bin width, cycles
+ */
+void dac_stream_init(dac_stream_t* s, uint32_t block_len, uint32_t bin_cyc);
+
+/**
+ * @brief  Half the producer may fill now (the one not playing).
+ */
+uint32_t dac_stream_acquire(dac_stream_t* s);
+
+/**
+ * @brief  Publish a filled half.
+ * @param  stamp: cycle stamp of the input behind these codes
+ */
+void dac_stream_commit(dac_stream_t* s, uint32_t half, uint32_t stamp);
+
+/**
+ * @brief  Half 1 starts playing. Call from the DAC HalfCplt callback.
+ */
+void dac_stream_half_isr(dac_stream_t* s, uint32_t now);
+
+/**
+ * @brief  Half 0 starts playing. Call from the DAC Cplt callback.
+ */
+void dac_stream_full_isr(dac_stream_t* s, uint32_t now);
+
+/**
+ * @brief  Add one latency to a histogram (the first one sets its origin).
+ */
+void dac_stream_hist_add(dac_stream_hist_t* h, uint32_t cycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DAC_STREAM_H */
@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ * @file           : delta_pack.h
+ * @brief          : Streaming delta / zig-zag varint packing of int16 series
+ ******************************************************************************
+ *
+ * Packs consecutive samples (e.g. deg C x 100) into frames that fit one
+ * BLE notification: the first sample of a frame is sent whole, every
+ * following one as the zig-zag varint of its difference to the previous:
+ *
+ *   zz = (d << 1) ^ (d >> 31)        0, -1, 1, -2 ... -> 0, 1, 2, 3 ...
+ *   varint: 7 bits per byte, low group first, bit 7 = more follows
+ *
+ * |d| <= 63 costs one byte, |d| <= 8191 two, any int16 step three. A
+ * slowly drifting temperature changes by a few centi-degrees per sample.
+ *
+ * Raw frame (little endian), then CRC-16 and COBS exactly as telem.h, so
+ * both frame kinds share one link and one receiver:
+ *
+ *   hdr    u8   TELEM_VERSION << 4 | TELEM_FRAME_PACKED
+ *   idx    u16  sample index of base (counts every pushed sample, wraps;
+ *               a gap between frames = samples lost)
+ *   base   i16  first sample
+ *   delta  ...  varints, one per further sample
+ *   crc    u16  telem_crc16() over hdr .. last delta
+ *
+ * 9 bytes of overhead: a 20-byte frame carries 1 + 11 samples at one byte
+ * each, against 3.9 bytes per sample in a 10-sample TELEM_FRAME_TEMP.
+ *
+ * delta_pack_push() closes a frame as soon as no further one-byte delta
+ * fits, or when the next delta does not fit (that sample then opens the
+ * next frame). The host decoder is Common/Host/delta_pack.hpp.
+ ******************************************************************************
+ */
+#ifndef DELTA_PACK_H
+#define DELTA_PACK_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* One BLE notification (ATT MTU 23 - 3) */
+#define DELTA_PACK_BLE_FRAME 20U
+/* frame_max range: COBS code byte + raw frame + 0x00. The smallest one
+ * still takes a base and one three-byte delta */
+#define DELTA_PACK_FRAME_MIN 12U
+#define DELTA_PACK_FRAME_MAX 64U
+#define DELTA_PACK_HDR_LEN 5U
+/* Longest varint: an int16 step needs 17 bits of zig-zag */
+#define DELTA_PACK_VARINT_MAX 3U
+
+typedef struct {
+  uint8_t raw[DELTA_PACK_FRAME_MAX - 2U]; /* open frame, no CRC yet */
+  uint32_t len;                           /* raw bytes used */
+  uint32_t cap;                           /* raw bytes allowed, CRC included */
+  uint16_t idx;                           /* index of the next sample */
+  int16_t prev;                           /* last sample in the open frame */
+  uint32_t n;                             /* samples in the open frame */
+  uint32_t frames;                        /* frames closed */
+  uint32_t samples;                       /* samples in those frames */
+} delta_pack_t;
+
+/**
+ * @brief  Start packing.
+ * @param  frame_max: bytes per encoded frame incl. COBS and 0x00,
+ *         DELTA_PACK_FRAME_MIN .. DELTA_PACK_FRAME_MAX
+ *         (DELTA_PACK_BLE_FRAME for one notification)
+ * @param  first_idx: index given to the first sample
+ * @retval 0, or -1 for a frame_max out of range
+ */
+int delta_pack_init(delta_pack_t* p, uint32_t frame_max, uint16_t first_idx);
+
+/**
+ * @brief  Add one sample.
+ * @param  out: at least frame_max bytes, receives a closed frame
+ * @retval Bytes of the frame written to out (send them as is), 0 if the
+ *         frame is still open
+ */
+uint32_t delta_pack_push(delta_pack_t* p, int16_t v, uint8_t* out);
+
+/**
+ * @brief  Close the open frame, if any (e.g. before a pause).
+ * @retval Bytes written to out, 0 if nothing was open
+ */
+uint32_t delta_pack_flush(delta_pack_t* p, uint8_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DELTA_PACK_H */
@@ -0,0 +1,46 @@
+/**
+ ******************************************************************************
+ * @file           : dwt_cyccnt.h
+ * @brief          : Start the DWT cycle counter (target only)
+ ******************************************************************************
+ *
+ * DWT CYCCNT counts core clock cycles, free-running and wrapping at 2^32.
+ * The projects use it for ISR stamps (tim_jitter, dac_stream), SWO trace
+ * events and the *_cycles counters read in the debugger.
+ *
+ * It counts only with trace enabled in DEMCR, and on the Cortex-M7 the
+ * DWT registers ignore software writes until the lock access register is
+ * unlocked; a debugger session usually does both, so code that forgets
+ * them works under the debugger and reads 0 without it. The counter stops
+ * in Sleep (see lp_acq.h).
+ *
+ * Needs the CMSIS core registers, so it includes the project's main.h,
+ * like the *_hal.c files in Common/Src.
+ ******************************************************************************
+ */
+#ifndef DWT_CYCCNT_H
+#define DWT_CYCCNT_H
+
+#include "main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief  Enable trace, unlock the DWT (Cortex-M7), zero CYCCNT and start it.
+ */
+static inline void dwt_cyccnt_enable(void) {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#if defined(__CORTEX_M) && (__CORTEX_M == 7U)
+  DWT->LAR = 0xC5ACCE55UL;
+#endif
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DWT_CYCCNT_H */
@@ -0,0 +1,95 @@
+/**
+ ******************************************************************************
+ * @file           : fmt.h
+ * @brief          : Float-free text formatting into caller buffers
+ ******************************************************************************
+ *
+ * Replaces printf / snprintf for telemetry lines. A line is built by typed
+ * calls instead of a format string, so the compiler checks every argument
+ * (no %lu vs uint32_t mismatch, no %f promotion to double) and nothing is
+ * parsed at run time:
+ *
+ *   printf("ADC = %u  TEMP = %.2f C\n", adc, temp);
+ *
+ *   fmt_t f;
+ *   fmt_init(&f, line, sizeof(line));
+ *   fmt_str(&f, "ADC = ");
+ *   fmt_u32(&f, adc);
+ *   fmt_str(&f, "  TEMP = ");
+ *   fmt_q16(&f, temp_q16, 2);      // Q16.16 -> "25.31", rounded
+ *   fmt_str(&f, " C\n");
+ *   len = fmt_end(&f);
+ *
+ * Fixed-point values print from integers: fmt_dec(v, d) writes v / 10^d
+ * with d decimals (2531, 2 -> "25.31"), fmt_q16() rounds a Q16.16 value
+ * to d decimals first. No heap, no locale, no float, no newlib: linking
+ * this instead of printf drops _printf_float / _dtoa / locale tables.
+ *
+ * Output past the end of the buffer is cut off and flagged; the result is
+ * always NUL-terminated.
+ ******************************************************************************
+ */
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Characters needed for the widest value of each call, sign included */
+#define FMT_U32_MAX 10U
+#define FMT_I32_MAX 11U
+
+/* Most decimals fmt_dec / fmt_q16 accept */
+#define FMT_DEC_MAX 9U
+
+typedef struct {
+  char* buf;
+  uint32_t cap; /* characters available, excluding the terminating NUL */
+  uint32_t len;
+  uint8_t overflow;
+} fmt_t;
+
+/**
+ * @brief  Start a line in buf (size bytes, at least 1).
+ */
+void fmt_init(fmt_t* f, char* buf, uint32_t size);
+
+void fmt_char(fmt_t* f, char c);
+void fmt_str(fmt_t* f, const char* s);
+void fmt_u32(fmt_t* f, uint32_t v);
+void fmt_i32(fmt_t* f, int32_t v);
+
+/**
+ * @brief  Unsigned, right-aligned in width characters using pad (' ' / '0').
+ */
+void fmt_u32_pad(fmt_t* f, uint32_t v, uint8_t width, char pad);
+
+/**
+ * @brief  Hexadecimal, exactly digits nibbles (1..8), upper case, no "0x".
+ */
+void fmt_hex(fmt_t* f, uint32_t v, uint8_t digits);
+
+/**
+ * @brief  Scaled integer as decimal: v / 10^decimals, e.g. (-505, 2) -> "-5.05".
+ */
+void fmt_dec(fmt_t* f, int32_t v, uint8_t decimals);
+
+/**
+ * @brief  Q16.16 value rounded (half away from zero) to decimals places.
+ */
+void fmt_q16(fmt_t* f, int32_t q16, uint8_t decimals);
+
+/**
+ * @brief  Terminate the line.
+ * @retval Characters written, excluding the NUL
+ */
+uint32_t fmt_end(fmt_t* f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FMT_H */
@@ -0,0 +1,147 @@
+/**
+ ******************************************************************************
+ * @file           : lin_map.h
+ * @brief          : Compile-time linear map / clamp kernels over sample blocks
+ ******************************************************************************
+ *
+ *   y = clamp((x - offset) * full / span, 0, full),   full = 2^bits - 1
+ *
+ * LIN_MAP_DEFINE(name, offset, span, bits) generates, for literal
+ * offset / span / bits:
+ *
+ *   uint16_t name(int32_t x)                                one sample
+ *   void name##_block(const int16_t* x, uint16_t* y, uint32_t n)
+ *
+ * and nothing is left for run time but a multiply, a shift and two
+ * saturations:
+ *
+ *   divide  multiply by LIN_MAP_MUL = ceil(full * 2^16 / span), >> 16;
+ *           exact for every x - offset in 0..span while span^2 < 2^16
+ *   clamp   saturate the scaled value to 0..full (USAT #bits): x - offset
+ *           outside 0..span already scales outside 0..full, so clamping
+ *           before or after the scale gives the same code
+ *   range   inputs saturated to LIN_MAP_IN_BITS signed first (SSAT), so
+ *           the product fits 32 bits and the scaled value an int16; with
+ *           offset + span below that range this changes no output
+ *
+ * The conditions are checked at compile time. With the DSP extension
+ * (Cortex-M4/M7) the block form maps two samples per step: SSAT16,
+ * QSUB16 offset, SMULWB/SMULWT (32 x 16 multiply, >> 16), USAT16, one
+ * word store. Elsewhere both forms use the portable clamps, so the host
+ * runs the same arithmetic (Host/lin_map_bench checks all of it).
+ ******************************************************************************
+ */
+#ifndef LIN_MAP_H
+#define LIN_MAP_H
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__ARM_FEATURE_SAT) || defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* SIMD pair path; the host bench may force it with models of the
+ * intrinsics to check it bit for bit */
+#ifndef LIN_MAP_USE_SIMD
+#if defined(__ARM_FEATURE_SIMD32) && __ARM_FEATURE_SIMD32 && \
+    defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+#define LIN_MAP_USE_SIMD 1
+#else
+#define LIN_MAP_USE_SIMD 0
+#endif
+#endif
+
+#define LIN_MAP_SHIFT 16
+#define LIN_MAP_IN_BITS 8 /* inputs saturate to -128..127 */
+#define LIN_MAP_IN_MAX ((1 << (LIN_MAP_IN_BITS - 1)) - 1)
+#define LIN_MAP_FULL(bits) ((1 << (bits)) - 1)
+#define LIN_MAP_MUL(span, bits)                                      \
+  ((int32_t) ((((uint32_t) LIN_MAP_FULL(bits) << LIN_MAP_SHIFT) +    \
+               (uint32_t) (span) - 1U) /                             \
+              (uint32_t) (span)))
+
+#ifdef __cplusplus
+#define LIN_MAP_STATIC_ASSERT(c, m) static_assert(c, m)
+#else
+#define LIN_MAP_STATIC_ASSERT(c, m) _Static_assert(c, m)
+#endif
+
+/* Saturations with literal widths: USAT/SSAT need immediates */
+#if defined(__ARM_FEATURE_SAT) && __ARM_FEATURE_SAT
+#define LIN_MAP_SSAT(x, bits) __ssat((x), (bits))
+#define LIN_MAP_USAT(x, bits) ((int32_t) __usat((x), (bits)))
+#else
+#define LIN_MAP_SSAT(x, bits) \
+  lin_map_clamp((x), -(1 << ((bits) - 1)), (1 << ((bits) - 1)) - 1)
+#define LIN_MAP_USAT(x, bits) lin_map_clamp((x), 0, LIN_MAP_FULL(bits))
+#endif
+
+static inline int32_t lin_map_clamp(int32_t x, int32_t lo, int32_t hi) {
+  return (x < lo) ? lo : ((x > hi) ? hi : x);
+}
+
+/**
+ * @brief  Narrow an int32 sample for the block form (saturate to int16).
+ */
+static inline int16_t lin_map_in(int32_t x) {
+  return (int16_t) LIN_MAP_SSAT(x, 16);
+}
+
+#if LIN_MAP_USE_SIMD
+#define LIN_MAP_PAIRS(x, y, n, i, offset, mul, bits)                        \
+  for (; (i) + 2U <= (n); (i) += 2U) {                                     \
+    uint32_t w;                                                            \
+    memcpy(&w, &(x)[i], sizeof(w)); /* LDR, unaligned is fine on M7 */    \
+    w = (uint32_t) __ssat16((int16x2_t) w, LIN_MAP_IN_BITS);               \
+    w = (uint32_t) __qsub16((int16x2_t) w,                                 \
+                            (int16x2_t) ((uint32_t) (offset) * 0x10001U)); \
+    w = ((uint32_t) __smulwb((mul), (int16x2_t) w) & 0xFFFFU) |            \
+        ((uint32_t) __smulwt((mul), (int16x2_t) w) << 16);                 \
+    w = (uint32_t) __usat16((int16x2_t) w, (bits));                        \
+    memcpy(&(y)[i], &w, sizeof(w));                                        \
+  }
+#else
+#define LIN_MAP_PAIRS(x, y, n, i, offset, mul, bits)
+#endif
+
+/**
+ * @brief  Generate name() and name##_block() for one mapping.
+ * @param  offset: input value that maps to 0, 0..LIN_MAP_IN_MAX
+ * @param  span:   input range above offset that maps to 0..full
+ * @param  bits:   output width, full = 2^bits - 1 (1..15)
+ */
+#define LIN_MAP_DEFINE(name, offset, span, bits)                             \
+  LIN_MAP_STATIC_ASSERT((span) > 0 && (span) * (span) < (1 << LIN_MAP_SHIFT), \
+                        #name ": multiply-shift not exact for this span");   \
+  LIN_MAP_STATIC_ASSERT((offset) >= 0 && (offset) + (span) <= LIN_MAP_IN_MAX, \
+                        #name ": offset + span beyond LIN_MAP_IN_BITS");     \
+  LIN_MAP_STATIC_ASSERT((bits) >= 1 && (bits) <= 15,                         \
+                        #name ": output width must be 1..15 bits");          \
+  LIN_MAP_STATIC_ASSERT((LIN_MAP_IN_MAX + 1LL + (offset)) *                  \
+                                LIN_MAP_MUL(span, bits) <=                   \
+                            (1LL << 31),                                     \
+                        #name ": scaled value does not fit an int16");       \
+  static inline uint16_t name(int32_t x) {                                   \
+    int32_t d = LIN_MAP_SSAT(x, LIN_MAP_IN_BITS) - (offset);                 \
+    return (uint16_t) LIN_MAP_USAT(                                          \
+        (d * LIN_MAP_MUL(span, bits)) >> LIN_MAP_SHIFT, (bits));             \
+  }                                                                          \
+  static inline void name##_block(const int16_t* x, uint16_t* y,            \
+                                  uint32_t n) {                              \
+    uint32_t i = 0;                                                          \
+    LIN_MAP_PAIRS(x, y, n, i, offset, LIN_MAP_MUL(span, bits), bits)         \
+    for (; i < n; i++) {                                                     \
+      y[i] = name(x[i]);                                                     \
+    }                                                                        \
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIN_MAP_H */
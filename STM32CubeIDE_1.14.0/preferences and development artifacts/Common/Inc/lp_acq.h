@@ -0,0 +1,114 @@
+/**
+ ******************************************************************************
+ * @file           : lp_acq.h
+ * @brief          : Sleep-between-samples main loop with residency / latency counters
+ ******************************************************************************
+ *
+ * Replaces a main loop that spins on an EOC flag. Interrupt handlers
+ * (ADC EOC, DMA half/complete, timers) post event bits; the loop calls
+ * lp_acq_wait(), which puts the core to sleep (WFI) while nothing is
+ * posted and returns the posted bits:
+ *
+ *   ISR:   lp_acq_post(&acq, LP_ACQ_EV_SAMPLE);
+ *   loop:  uint32_t ev = lp_acq_wait(&acq);
+ *          if (ev & LP_ACQ_EV_SAMPLE) { ... }
+ *
+ * The check-then-sleep runs with interrupts masked, so an event posted
+ * just before WFI cannot be missed: a masked pending interrupt still ends
+ * WFI, and the handler runs as soon as lp_acq_wait() unmasks. Wake-ups
+ * with nothing posted (SysTick every 1 ms, other interrupts) return 0 and
+ * are counted as empty wakes; the caller can use them for tick-based work.
+ *
+ * Counters, all in cycles of the port's now():
+ *   residency  time spent inside idle() / total time since init
+ *   latency    lp_acq_post() in the ISR -> lp_acq_wait() returning it,
+ *              i.e. the rest of the ISR, exception return and the loop
+ *              resuming (min / avg / max)
+ *
+ * The platform is a small port (clock, mask, unmask, idle), so the same
+ * state machine runs on the host against a simulated event source
+ * (Host/lp_acq_sim.cpp). The target port is in lp_acq_hal.c. Post from
+ * interrupts of one priority level, or from ones that cannot preempt each
+ * other: `pending` is updated read-modify-write.
+ ******************************************************************************
+ */
+#ifndef LP_ACQ_H
+#define LP_ACQ_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Event bits */
+#define LP_ACQ_EV_SAMPLE (1UL << 0) /* a conversion or block is ready */
+#define LP_ACQ_EV_TICK (1UL << 1)   /* pacing timer */
+#define LP_ACQ_EV_USER (1UL << 8)   /* first application-defined bit */
+
+typedef struct {
+  uint32_t (*now)(void); /* free-running cycle count, must run during idle() */
+  void (*irq_off)(void);
+  void (*irq_on)(void);
+  void (*idle)(void); /* sleep until an interrupt is pending, masked or not */
+} lp_acq_port_t;
+
+typedef struct {
+  const lp_acq_port_t* port;
+  volatile uint32_t pending;   /* posted, not yet returned */
+  volatile uint32_t event_cyc; /* now() at the first post since the last wait */
+  uint32_t t_last;             /* now() at the last accounting point */
+  uint64_t total_cyc;
+  uint64_t sleep_cyc;
+  uint32_t sleeps;      /* idle() calls */
+  uint32_t empty_wakes; /* lp_acq_wait() returns with no event */
+  uint32_t events;      /* lp_acq_wait() returns with events */
+  uint32_t lat_min;
+  uint32_t lat_max;
+  uint64_t lat_sum;
+} lp_acq_t;
+
+typedef struct {
+  uint32_t residency_pm; /* per mille of the time asleep */
+  uint32_t sleeps;
+  uint32_t empty_wakes;
+  uint32_t events;
+  uint32_t lat_min; /* cycles; all 0 before the first event */
+  uint32_t lat_avg;
+  uint32_t lat_max;
+} lp_acq_report_t;
+
+/**
+ * @brief  Bind to a port and start the counters.
+ */
+void lp_acq_init(lp_acq_t* a, const lp_acq_port_t* port);
+
+/**
+ * @brief  Post event bits. ISR context.
+ */
+void lp_acq_post(lp_acq_t* a, uint32_t ev);
+
+/**
+ * @brief  Sleep until something is posted or any interrupt wakes the core,
+ *         unless events are already pending. Main loop only.
+ * @retval Posted bits (cleared), 0 after an empty wake-up
+ */
+uint32_t lp_acq_wait(lp_acq_t* a);
+
+/**
+ * @brief  Residency and latency summary (64-bit divisions; not for the
+ *         fast path).
+ */
+void lp_acq_report(const lp_acq_t* a, lp_acq_report_t* r);
+
+/**
+ * @brief  lp_acq_init() on the target port (lp_acq_hal.c): SysTick-derived
+ *         cycle clock (DWT CYCCNT stops in Sleep), PRIMASK, WFI in Sleep.
+ */
+void lp_acq_hal_init(lp_acq_t* a);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LP_ACQ_H */
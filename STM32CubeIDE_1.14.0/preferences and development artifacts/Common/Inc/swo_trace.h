@@ -0,0 +1,129 @@
+/**
+ ******************************************************************************
+ * @file           : swo_trace.h
+ * @brief          : Buffered, word-wide ITM/SWO trace on several ports
+ ******************************************************************************
+ *
+ * The stock retarget
+ *
+ *   int _write(...) { for (...) ITM_SendChar(ptr[i]); }
+ *
+ * issues one 8-bit stimulus write per character and spins on the FIFO
+ * before each one. An 8-bit write becomes a 2-byte SWO packet (header +
+ * payload), and the ITM FIFO holds about one packet, so the CPU runs at
+ * wire speed for the whole line.
+ *
+ * Here the producer only copies the message into a per-port RAM ring
+ * (tx_ring, see uart_tx.h) and returns; swo_trace_pump(), called from the
+ * main loop, moves 32-bit words into the stimulus ports while the FIFO
+ * reports ready and returns as soon as it does not. Nothing ever waits:
+ * a message that does not fit its ring is dropped whole and counted.
+ *
+ *   per payload byte        ITM_SendChar         swo_trace
+ *   SWO wire bytes          2                    1.25 (5 per 32-bit word)
+ *   CPU in the producer     ~2 wire-byte times   ~2 cycles (ring copy)
+ *   CPU in the pump         -                    ~3 cycles (1 store / 4 B)
+ *
+ * The figures below are worked out from that table, not measured: no
+ * board or debug probe was at hand when this was written, and the cycle
+ * counts depend on the flash wait states, the caches and the SWO
+ * prescaler the debugger sets, so a host run would not stand in for them.
+ * The wire bytes are exact (ITM packet format); the cycles per byte are
+ * instruction counts of the copy and pump loops.
+ *
+ * Setup assumed, as Temp_H7_print runs: 20 MHz core, SWO clock 2 MHz in
+ * NRZ (UART) mode, 10 bits per byte = 200 kB/s = 100 core cycles per wire
+ * byte, and a 30-byte log line ("ADC = 12345  TEMP = 31.25 C\n" is 28).
+ *   ITM_SendChar:  30 B x 2 wire bytes x 100 cycles = ~6000 cycles on
+ *                  the line, 30 / 6000 = 0.005 bytes/cycle
+ *   swo_trace:     30 B x (2 + 3) cycles = ~150 cycles, ~0.2 bytes/cycle;
+ *                  the wire carries 2 / 1.25 = 1.6x more payload
+ * Neither counts the formatting before the write, which is the same.
+ *
+ * To measure them on the board: Temp_H7_print keeps the CPU cycles
+ * between its TRACE_EV_LINE_START and TRACE_EV_LINE_END events (DWT
+ * CYCCNT) in log_line_cycles_last / _max; read them in Live Expressions
+ * with TRACE_BYTEWISE 1 and 0, noting the core and SWO clocks in the SWV
+ * settings and the line length.
+ *
+ * Ports (enable them in the SWV ITM Stimulus Ports dialog):
+ *   SWO_PORT_TEXT     0  printf / log text (the SWV console shows port 0)
+ *   SWO_PORT_SAMPLES  1  binary sample words
+ *   SWO_PORT_EVENTS   2  timing events: id << 24 | CYCCNT[23:0], stamped
+ *                        when queued, so buffering adds no timing error
+ * The pump serves events first, then samples, then text.
+ *
+ * One producer context per port (the main loop in the projects here).
+ * A port the debugger has not enabled is not queued at all.
+ *
+ * Host side: Common/Host/swo_demux.cpp splits a raw SWO capture back into
+ * the three streams.
+ ******************************************************************************
+ */
+#ifndef SWO_TRACE_H
+#define SWO_TRACE_H
+
+#include <stdint.h>
+
+#include "uart_tx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SWO_PORT_TEXT 0U
+#define SWO_PORT_SAMPLES 1U
+#define SWO_PORT_EVENTS 2U
+#define SWO_PORT_COUNT 3U
+
+/* Ring sizes, powers of two */
+#ifndef SWO_TRACE_TEXT_RING
+#define SWO_TRACE_TEXT_RING 1024U
+#endif
+#ifndef SWO_TRACE_SAMPLES_RING
+#define SWO_TRACE_SAMPLES_RING 512U
+#endif
+#ifndef SWO_TRACE_EVENTS_RING
+#define SWO_TRACE_EVENTS_RING 256U
+#endif
+
+typedef struct {
+  tx_ring_t ring[SWO_PORT_COUNT]; /* queued / dropped / high_water per port */
+  uint32_t writes;                /* stimulus writes issued by the pump */
+} swo_trace_t;
+
+extern swo_trace_t swo_trace;
+
+/**
+ * @brief  Bind the port rings and start the DWT cycle counter used by
+ *         swo_trace_event(). ITM and SWO are set up by the debugger (SWV).
+ */
+void swo_trace_init(void);
+
+/**
+ * @brief  Queue a message on a port. Never blocks.
+ * @retval len when queued, 0 when dropped (ring full) or the port is off
+ */
+uint32_t swo_trace_write(uint32_t port, const void* data, uint32_t len);
+
+/**
+ * @brief  Queue one 32-bit word (e.g. a packed sample).
+ */
+uint32_t swo_trace_word(uint32_t port, uint32_t word);
+
+/**
+ * @brief  Queue a timing event on SWO_PORT_EVENTS: id << 24 | CYCCNT[23:0].
+ */
+uint32_t swo_trace_event(uint8_t id);
+
+/**
+ * @brief  Move queued data into the stimulus ports while the FIFO has room.
+ * @retval Stimulus writes issued (0 when idle or the FIFO is busy)
+ */
+uint32_t swo_trace_pump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SWO_TRACE_H */
@@ -0,0 +1,126 @@
+/**
+ ******************************************************************************
+ * @file           : telem.h
+ * @brief          : Binary telemetry frames: typed fields, CRC-16, COBS
+ ******************************************************************************
+ *
+ * Raw frame (little endian):
+ *
+ *   hdr    u8   version << 4 | frame type
+ *   seq    u16  frame counter, gaps = lost frames
+ *   t_ms   u32  sender timestamp (HAL tick)
+ *   field  ...  tag u8 = id << 4 | telem_type_t, then the value:
+ *                 U8 / I16 / U16 / I32 / U32   1 / 2 / 2 / 4 / 4 bytes
+ *                 I16_ARRAY                    count u8, count x i16
+ *   crc    u16  CRC-16/CCITT-FALSE over hdr .. last field
+ *
+ * On the wire the raw frame is COBS encoded and terminated by 0x00, so a
+ * receiver (or a BLE bridge that splits notifications every 20 bytes)
+ * resynchronises on the next zero. The raw frame is limited to 254 bytes:
+ * COBS then adds exactly one code byte, which lets telem_end() encode in
+ * place. Fields are written straight into the caller's buffer, one byte
+ * behind the code byte slot, so no text, no staging copy, no float printf.
+ *
+ * Size example (h7_temp_bluetooth): 10 temperatures in centi-degC per
+ * frame = 7 header + 3 period + 22 array + 3 adc + 2 crc + 2 COBS = 39
+ * bytes, 3.9 bytes/sample against ~20 for "u=%.2f,r=%.2f|°C".
+ *
+ * The host decoder is Common/Host/telem_decode.cpp.
+ ******************************************************************************
+ */
+#ifndef TELEM_H
+#define TELEM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEM_VERSION 1U
+
+/* Largest raw frame (header .. crc) that COBS encodes with one code byte */
+#define TELEM_RAW_MAX 254U
+/* Buffer size for any frame: code byte + raw + 0x00 delimiter */
+#define TELEM_FRAME_MAX (TELEM_RAW_MAX + 2U)
+#define TELEM_HDR_LEN 7U
+#define TELEM_CRC_LEN 2U
+
+typedef enum {
+  TELEM_U8 = 0,
+  TELEM_I16,
+  TELEM_U16,
+  TELEM_I32,
+  TELEM_U32,
+  TELEM_I16_ARRAY,
+} telem_type_t;
+
+/* Frame types */
+#define TELEM_FRAME_TEMP 1U
+#define TELEM_FRAME_CAL 2U    /* reply to a cal_store command */
+#define TELEM_FRAME_PACKED 3U /* delta_pack.h: own short header, no fields */
+
+/* Field ids of TELEM_FRAME_TEMP */
+#define TELEM_F_PERIOD_MS 1U /* U16, spacing of array samples */
+#define TELEM_F_TEMP_CENTI 2U /* I16_ARRAY, deg C x 100 */
+#define TELEM_F_ADC_CODE 3U  /* U16, last raw code */
+
+/* Field ids of TELEM_FRAME_CAL */
+#define TELEM_F_CAL_STATUS 1U /* I16, 0 ok, < 0 see the sender */
+#define TELEM_F_CAL_SEQ 2U    /* U32, seq of the stored record */
+#define TELEM_F_CAL_POINTS 3U /* U8, user points in it */
+#define TELEM_F_CAL_CODE 4U   /* U16, ADC code when the command ran */
+
+#define TELEM_TAG(id, type) ((uint8_t) (((id) << 4) | (type)))
+
+typedef struct {
+  uint8_t* buf; /* buf[0] = COBS code byte, raw frame from buf[1] */
+  uint32_t len; /* raw bytes written */
+  uint32_t cap; /* raw bytes available */
+  uint8_t overflow;
+} telem_frame_t;
+
+/**
+ * @brief  Start a frame in buf.
+ * @param  buf: at least TELEM_FRAME_MAX bytes, or cap + 2
+ * @param  cap: raw bytes allowed, at most TELEM_RAW_MAX
+ */
+void telem_begin(telem_frame_t* f,
+                 uint8_t* buf,
+                 uint32_t cap,
+                 uint8_t type,
+                 uint16_t seq,
+                 uint32_t t_ms);
+
+void telem_put_u8(telem_frame_t* f, uint8_t id, uint8_t v);
+void telem_put_i16(telem_frame_t* f, uint8_t id, int16_t v);
+void telem_put_u16(telem_frame_t* f, uint8_t id, uint16_t v);
+void telem_put_i32(telem_frame_t* f, uint8_t id, int32_t v);
+void telem_put_u32(telem_frame_t* f, uint8_t id, uint32_t v);
+void telem_put_i16_array(telem_frame_t* f, uint8_t id, const int16_t* v, uint8_t n);
+
+/**
+ * @brief  Append the CRC, COBS encode in place and terminate.
+ * @retval Bytes to send from f->buf, 0 if a field did not fit
+ */
+uint32_t telem_end(telem_frame_t* f);
+
+/**
+ * @brief  CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF, no reflection).
+ */
+uint16_t telem_crc16(const uint8_t* p, uint32_t n);
+
+/**
+ * @brief  Undo COBS and check the CRC of one frame (delimiter excluded).
+ * @param  in: encoded bytes between two 0x00
+ * @param  out: at least n bytes
+ * @retval Raw frame length without the CRC, -1 on a COBS or CRC error.
+ *         Only the header byte is guaranteed; check the length per type.
+ */
+int32_t telem_unframe(const uint8_t* in, uint32_t n, uint8_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TELEM_H */
@@ -0,0 +1,135 @@
+/**
+ ******************************************************************************
+ * @file           : temp_alarm.h
+ * @brief          : Temperature alarm on the ADC analog watchdog, with hysteresis
+ ******************************************************************************
+ *
+ * Instead of converting every sample and comparing it in the main loop,
+ * the alarm thresholds are converted once from deg C to raw ADC codes and
+ * loaded into the analog watchdog (AWD). The ADC compares every
+ * conversion in hardware and raises the AWD interrupt only when a code
+ * leaves the window, so between events the alarm costs no CPU, and an
+ * excursion is seen one conversion after it happens (a few us) instead of
+ * at the next 1 s poll.
+ *
+ * Each band has a trip and a clear level; the window follows the state:
+ *
+ *   state    window [LT, HT]           leaves the window when
+ *   NORMAL   [low_trip,  high_trip]    colder than low_trip  -> LOW
+ *                                      hotter than high_trip -> HIGH
+ *   LOW      [0,         low_clear]    hotter than low_clear -> NORMAL
+ *   HIGH     [high_clear, code_max]    colder than high_clear -> NORMAL
+ *
+ * with low_clear = low_trip + hysteresis and high_clear = high_trip -
+ * hysteresis, so a sensor sitting on a threshold does not chatter. A band
+ * left disabled keeps its edge of the window at 0 / code_max, which the
+ * ADC can never cross.
+ *
+ * temp_alarm_update() is the state machine; it is HAL-free and can also be
+ * fed from a polled loop. temp_alarm_hal.c (target only) programs the AWD
+ * on the F4 ADC (HTR/LTR) and the H7 ADC (AWD1, HTR1/LTR1) and runs the
+ * update from HAL_ADC_LevelOutOfWindowCallback().
+ *
+ * Codes are assumed to rise with temperature, which holds for the F4 and
+ * H7 internal sensors.
+ ******************************************************************************
+ */
+#ifndef TEMP_ALARM_H
+#define TEMP_ALARM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  TEMP_ALARM_NORMAL = 0,
+  TEMP_ALARM_LOW,
+  TEMP_ALARM_HIGH
+} temp_alarm_state_t;
+
+/* Straight line through two (code, temperature) points, used to turn deg C
+ * thresholds into codes. H7: TS_CAL1/TS_CAL2. F4: any two codes of the
+ * datasheet V25 / Avg_Slope line. */
+typedef struct {
+  uint16_t code1;
+  uint16_t code2;
+  int32_t t1_q16; /* deg C, Q16.16 */
+  int32_t t2_q16;
+  uint16_t code_max; /* full scale: 4095 for 12 bit, 65535 for 16 bit */
+} temp_alarm_cal_t;
+
+/* Called from the AWD interrupt on every state change */
+typedef void (*temp_alarm_cb_t)(void* ctx, temp_alarm_state_t state, uint16_t code);
+
+typedef struct {
+  temp_alarm_cal_t cal;
+  uint16_t low_trip; /* LOW when code < low_trip, 0 = disabled */
+  uint16_t low_clear;
+  uint16_t high_trip; /* HIGH when code > high_trip, code_max = disabled */
+  uint16_t high_clear;
+  uint16_t win_lo; /* window for the current state */
+  uint16_t win_hi;
+  volatile temp_alarm_state_t state;
+  volatile uint16_t last_code; /* code that caused the last change */
+  volatile uint32_t events;    /* state changes since init */
+  temp_alarm_cb_t cb;
+  void* ctx;
+} temp_alarm_t;
+
+/**
+ * @brief  Both bands disabled, state NORMAL.
+ * @retval 0, or -1 if the calibration points share a code
+ */
+int temp_alarm_init(temp_alarm_t* a, const temp_alarm_cal_t* cal, temp_alarm_cb_t cb, void* ctx);
+
+/**
+ * @brief  Code at which the calibration line reaches t_q16, rounded and
+ *         clamped to 0..code_max.
+ */
+uint16_t temp_alarm_code(const temp_alarm_cal_t* cal, int32_t t_q16);
+
+/**
+ * @brief  Cold alarm: LOW below trip_q16, back to NORMAL above
+ *         trip_q16 + hyst_q16.
+ * @retval 0, or -1 if the hysteresis rounds to no code or the band would
+ *         overlap the high trip
+ */
+int temp_alarm_set_low(temp_alarm_t* a, int32_t trip_q16, int32_t hyst_q16);
+
+/**
+ * @brief  Hot alarm: HIGH above trip_q16, back to NORMAL below
+ *         trip_q16 - hyst_q16.
+ * @retval 0, or -1 as for temp_alarm_set_low()
+ */
+int temp_alarm_set_high(temp_alarm_t* a, int32_t trip_q16, int32_t hyst_q16);
+
+/**
+ * @brief  Run the state machine on a code outside (or inside) the window,
+ *         call the callback on each change and recompute win_lo / win_hi.
+ * @retval 1 if the window changed and must be reprogrammed, else 0
+ */
+int temp_alarm_update(temp_alarm_t* a, uint16_t code);
+
+#ifdef HAL_ADC_MODULE_ENABLED
+/**
+ * @brief  Load the NORMAL window into the analog watchdog on channel and
+ *         enable its interrupt. Call before HAL_ADC_Start / _Start_DMA. If
+ *         the temperature is already out of range the first conversion
+ *         raises the alarm.
+ */
+HAL_StatusTypeDef temp_alarm_hal_start(temp_alarm_t* a, ADC_HandleTypeDef* hadc, uint32_t channel);
+
+/**
+ * @brief  Call from HAL_ADC_LevelOutOfWindowCallback(): reads the code,
+ *         updates the state and rewrites the thresholds.
+ */
+void temp_alarm_hal_isr(temp_alarm_t* a, ADC_HandleTypeDef* hadc);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEMP_ALARM_H */
@@ -0,0 +1,96 @@
+/**
+ ******************************************************************************
+ * @file           : temp_conv.h
+ * @brief          : Integer-only TS_CAL temperature conversion (Q16.16 °C)
+ ******************************************************************************
+ *
+ * Reference formula (RM0399, temperature sensor):
+ *
+ *   T = (T2 - T1) / (TS_CAL2 - TS_CAL1) * (code - TS_CAL1) + T1
+ *
+ * temp_conv_init() folds the slope once at boot:
+ *
+ *   slope_q48 = (T2 - T1)[Q16.16] * 2^32 / (TS_CAL2 - TS_CAL1)
+ *
+ * so every sample costs one subtract, one 32x64 multiply and one shift:
+ *
+ *   T[Q16.16] = T1[Q16.16] + (((code - TS_CAL1) * slope_q48 + 2^31) >> 32)
+ *
+ * The slope is kept rounded up and rounded down; the product always uses
+ * the one that errs upwards, by less than 1 / (2 * |TS_CAL2 - TS_CAL1|) of
+ * an LSB. Exact results sit on multiples of that spacing, so every 16-bit
+ * code gives the same Q16.16 value as the exact formula rounded half-up,
+ * as long as |TS_CAL2 - TS_CAL1| < 32768 (the factory span is ~4000 codes).
+ *
+ * No FPU, no division, no state written: safe in ISR context.
+ ******************************************************************************
+ */
+#ifndef TEMP_CONV_H
+#define TEMP_CONV_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Degrees (integer or float constant) -> Q16.16, folded at compile time */
+#define TEMP_CONV_Q16(deg) ((int32_t) ((deg) * 65536.0))
+
+typedef struct {
+  int32_t cal1_code; /* TS_CAL1 raw code */
+  int32_t t1_q16;    /* temperature at TS_CAL1, Q16.16 °C */
+  int64_t slope_up;  /* °C per code, 48 fractional bits, rounded up */
+  int64_t slope_dn;  /* same, rounded down */
+} temp_conv_t;
+
+/**
+ * @brief  Precompute slope/offset from the two calibration points.
+ * @param  c: converter
+ * @param  cal1_code: raw code at t1 (e.g. *TS_CAL1_ADDR)
+ * @param  cal2_code: raw code at t2 (e.g. *TS_CAL2_ADDR)
+ * @param  t1_q16: temperature of point 1, TEMP_CONV_Q16(30)
+ * @param  t2_q16: temperature of point 2, TEMP_CONV_Q16(110)
+ * @retval 0 on success, -1 if the points are unusable (equal codes, or a
+ *         slope of 0.5 °C/code or more which would overflow the product).
+ */
+int temp_conv_init(temp_conv_t* c,
+                   uint16_t cal1_code,
+                   uint16_t cal2_code,
+                   int32_t t1_q16,
+                   int32_t t2_q16);
+
+/**
+ * @brief  Convert one raw code to Q16.16 °C.
+ */
+static inline int32_t temp_conv_q16(const temp_conv_t* c, uint16_t code) {
+  int64_t d = (int64_t) ((int32_t) code - c->cal1_code);
+  int64_t slope = (d >= 0) ? c->slope_up : c->slope_dn;
+  /* >> on a negative int64 is arithmetic on GCC/ARM: floor, so +2^31 rounds */
+  return c->t1_q16 + (int32_t) ((d * slope + ((int64_t) 1 << 31)) >> 32);
+}
+
+/**
+ * @brief  Convert a block of raw codes to Q16.16 °C.
+ * @param  c: converter
+ * @param  codes: raw ADC codes
+ * @param  out_q16: destination, n entries (may not alias codes)
+ * @param  n: number of samples
+ */
+void temp_conv_block(const temp_conv_t* c,
+                     const uint16_t* codes,
+                     int32_t* out_q16,
+                     uint32_t n);
+
+/**
+ * @brief  Q16.16 °C -> hundredths of a degree, rounded to nearest.
+ */
+static inline int32_t temp_conv_q16_to_centi(int32_t t_q16) {
+  return (int32_t) (((int64_t) t_q16 * 100 + 32768) >> 16);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEMP_CONV_H */
@@ -0,0 +1,82 @@
+/**
+ ******************************************************************************
+ * @file           : temp_lut.h
+ * @brief          : Piecewise-linear code -> temperature table built at boot
+ ******************************************************************************
+ *
+ * The calibration curve is given as a few (code, temperature) points: the
+ * factory TS_CAL1/TS_CAL2 pair plus any user points, e.g. a code read at a
+ * known ambient temperature. Between points the curve is linear, beyond
+ * the outer points it extends the nearest segment. Extra points bend the
+ * curve locally instead of tilting the whole line, which is what editing
+ * TS_CAL1_TEMP to 20 tried to do.
+ *
+ * temp_lut_build() samples that curve on a fixed grid of 2^TEMP_LUT_SHIFT
+ * codes and stores, per grid cell, the temperature at its start and the
+ * slope to the next grid point. A conversion is then
+ *
+ *   i = code >> TEMP_LUT_SHIFT
+ *   T = base[i] + ((slope[i] * (code & mask)) >> 8)      [Q16.16 deg C]
+ *
+ * one index, one 32x32 multiply, one add; no 64-bit product, no branch.
+ * The table is exact on grid points and within a few Q16 LSB (< 0.0001
+ * deg C) in between when the user points sit on the grid; otherwise the
+ * corner is smoothed over one cell (256 codes, ~5 deg C at the factory
+ * slope of ~0.02 deg C/code).
+ *
+ * 256 cells x 8 bytes = 2 KB of RAM.
+ ******************************************************************************
+ */
+#ifndef TEMP_LUT_H
+#define TEMP_LUT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEMP_LUT_SHIFT 8U
+#define TEMP_LUT_CELLS (65536U >> TEMP_LUT_SHIFT)
+#define TEMP_LUT_MASK ((1U << TEMP_LUT_SHIFT) - 1U)
+
+/* Calibration points accepted by temp_lut_build() */
+#define TEMP_LUT_MAX_POINTS 8U
+
+typedef struct {
+  uint16_t code;
+  int32_t t_q16; /* deg C, Q16.16 (TEMP_CONV_Q16) */
+} temp_lut_point_t;
+
+typedef struct {
+  int32_t base[TEMP_LUT_CELLS];  /* T at the cell start, Q16.16 */
+  int32_t slope[TEMP_LUT_CELLS]; /* Q16.16 per code, x 2^8 */
+} temp_lut_t;
+
+/**
+ * @brief  Build the table from 2..TEMP_LUT_MAX_POINTS points, any order.
+ * @retval 0 on success, -1 for too few / too many points, two points on
+ *         the same code, or a curve steeper than 1/8 deg C per code
+ *         (keeps the extrapolated ends inside Q16.16)
+ */
+int temp_lut_build(temp_lut_t* l, const temp_lut_point_t* pts, uint32_t n);
+
+/**
+ * @brief  Convert one code, Q16.16 deg C. ISR safe.
+ */
+static inline int32_t temp_lut_q16(const temp_lut_t* l, uint16_t code) {
+  uint32_t i = (uint32_t) code >> TEMP_LUT_SHIFT;
+  int32_t off = (int32_t) (code & TEMP_LUT_MASK);
+  return l->base[i] + ((l->slope[i] * off) >> 8);
+}
+
+/**
+ * @brief  Convert n codes.
+ */
+void temp_lut_block(const temp_lut_t* l, const uint16_t* codes, int32_t* out_q16, uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEMP_LUT_H */
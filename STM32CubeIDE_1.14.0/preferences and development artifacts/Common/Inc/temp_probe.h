@@ -0,0 +1,109 @@
+/**
+ ******************************************************************************
+ * @file           : temp_probe.h
+ * @brief          : ADC block -> deg C -> DAC probe codes (temp_h7_cm7_dma)
+ ******************************************************************************
+ *
+ * The per-block pipeline of temp_h7_cm7_dma without any HAL call, so the
+ * same code runs on the target and in Host/temp_probe_replay:
+ *
+ *   mean     block mean code (DMA half)
+ *   celsius  __LL_ADC_CALC_TEMPERATURE() of that mean, same integer steps
+ *            and truncations, with the calibration words passed in
+ *   dac      CH1: deg C clamped to 0..66, 50 mV/C over the 12-bit DAC
+ *            CH2: (CH1 deg C - 25) clamped to 0..33, 100 mV/C
+ *
+ * All integer. CH2 was a float expression before; (r * 4095) / 33 gives
+ * the same code for every r in 0..33, since the quotient is either exact
+ * or at least 1/33 away from the next integer.
+ *
+ * Both DAC mappings are lin_map.h kernels (multiply-shift + saturation,
+ * two samples per step on the M7) with the spans below folded in at
+ * compile time; the codes equal the clamp-then-divide form for every
+ * deg C value (Host/lin_map_bench).
+ ******************************************************************************
+ */
+#ifndef TEMP_PROBE_H
+#define TEMP_PROBE_H
+
+#include <stdint.h>
+
+#include "lin_map.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* DAC channel 1: 0..66 deg C over full scale (50 mV/C at 3.3 V) */
+#define TEMP_PROBE_CH1_SPAN_C 66
+/* DAC channel 2: room temperature offset and span (100 mV/C at 3.3 V) */
+#define TEMP_PROBE_CH2_OFFSET_C 25
+#define TEMP_PROBE_CH2_SPAN_C 33
+#define TEMP_PROBE_DAC_BITS 12
+#define TEMP_PROBE_DAC_FULL 4095U
+
+/* temp_probe_ch1(deg C) / temp_probe_ch2(deg C) and their _block forms */
+LIN_MAP_DEFINE(temp_probe_ch1, 0, TEMP_PROBE_CH1_SPAN_C, TEMP_PROBE_DAC_BITS)
+LIN_MAP_DEFINE(temp_probe_ch2,
+               TEMP_PROBE_CH2_OFFSET_C,
+               TEMP_PROBE_CH2_SPAN_C,
+               TEMP_PROBE_DAC_BITS)
+
+typedef struct {
+  uint16_t ts_cal1;     /* TEMPSENSOR_CAL1_ADDR word, 16-bit code */
+  uint16_t ts_cal2;     /* TEMPSENSOR_CAL2_ADDR word */
+  int32_t cal1_temp;    /* TEMPSENSOR_CAL1_TEMP, deg C */
+  int32_t cal2_temp;    /* TEMPSENSOR_CAL2_TEMP */
+  uint32_t cal_vref_mv; /* TEMPSENSOR_CAL_VREFANALOG */
+  uint32_t vref_mv;     /* VREF+ of the conversions */
+  uint32_t res_bits;    /* ADC resolution of the codes, 8..16 */
+} temp_probe_cal_t;
+
+typedef struct {
+  uint16_t mean;            /* block mean code */
+  int32_t temp_c;           /* deg C, truncated like the HAL macro */
+  uint32_t temp_equivalent; /* temp_c clamped to 0..CH1_SPAN */
+  uint16_t dac_temp;        /* DAC channel 1 code */
+  uint32_t roomtemp;        /* temp_equivalent - 25 clamped to 0..CH2_SPAN */
+  uint16_t dac_roomtemp;    /* DAC channel 2 code */
+} temp_probe_out_t;
+
+/**
+ * @brief  Stage 1: mean of len codes (len > 0), truncated.
+ */
+uint16_t temp_probe_mean(const uint16_t* block, uint32_t len);
+
+/**
+ * @brief  Stage 2: code -> deg C, bit-exact with __LL_ADC_CALC_TEMPERATURE.
+ */
+int32_t temp_probe_celsius(const temp_probe_cal_t* c, uint16_t code);
+
+/**
+ * @brief  Stage 3: deg C -> clamped values and both DAC codes (fills all
+ *         fields of o except mean).
+ */
+void temp_probe_dac(int32_t temp_c, temp_probe_out_t* o);
+
+/**
+ * @brief  Stages 2 and 3 per sample instead of per block mean: one code per
+ *         channel for every input code (timer-paced DAC output).
+ */
+void temp_probe_dac_block(const temp_probe_cal_t* c,
+                          const uint16_t* block,
+                          uint32_t len,
+                          uint16_t* ch1,
+                          uint16_t* ch2);
+
+/**
+ * @brief  All three stages on one block.
+ */
+void temp_probe_block(const temp_probe_cal_t* c,
+                      const uint16_t* block,
+                      uint32_t len,
+                      temp_probe_out_t* o);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEMP_PROBE_H */
@@ -0,0 +1,71 @@
+/**
+ ******************************************************************************
+ * @file           : tim_rate.h
+ * @brief          : Timer PSC/ARR solver and trigger jitter tracker
+ ******************************************************************************
+ *
+ * Update (TRGO) rate of a 16-bit STM32 timer:
+ *
+ *   f_update = f_tim / ((PSC + 1) * (ARR + 1))
+ *
+ * tim_rate_solve() picks the PSC/ARR pair closest to a target rate and
+ * reports the rate actually achieved, so the sample rate seen by the
+ * downstream filters is known instead of assumed.
+ *
+ * tim_jitter_* measures the interval between successive events (e.g. DMA
+ * half/complete callbacks) from a free-running cycle counter (DWT CYCCNT)
+ * and keeps min / max / worst deviation from the nominal interval.
+ ******************************************************************************
+ */
+#ifndef TIM_RATE_H
+#define TIM_RATE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint16_t psc;      /* prescaler register value */
+  uint16_t arr;      /* auto-reload register value */
+  uint32_t rate_mhz; /* achieved update rate, mHz */
+  int32_t error_ppm; /* (achieved - target) / target */
+} tim_rate_t;
+
+typedef struct {
+  uint32_t nominal; /* expected interval, cycles */
+  uint32_t last;    /* previous timestamp */
+  uint32_t armed;   /* 0 until the first timestamp */
+  uint32_t count;   /* intervals measured */
+  uint32_t min;     /* shortest interval, cycles */
+  uint32_t max;     /* longest interval, cycles */
+  uint32_t worst;   /* largest |interval - nominal|, cycles */
+} tim_jitter_t;
+
+/**
+ * @brief  Find PSC/ARR for a target update rate.
+ * @param  f_tim_hz: timer kernel clock
+ * @param  target_mhz: wanted update rate, mHz (1 kHz -> 1000000)
+ * @param  out: solution
+ * @retval 0 on success, -1 if the rate is out of reach of a 16-bit timer
+ *         (0, above f_tim / 2 -- ARR >= 1 -- or below f_tim / 2^32)
+ */
+int tim_rate_solve(uint32_t f_tim_hz, uint32_t target_mhz, tim_rate_t* out);
+
+/**
+ * @brief  Reset the tracker.
+ * @param  nominal_cycles: expected interval between events, in cycles
+ */
+void tim_jitter_init(tim_jitter_t* j, uint32_t nominal_cycles);
+
+/**
+ * @brief  Record an event timestamp (wrap-safe, ISR context).
+ */
+void tim_jitter_stamp(tim_jitter_t* j, uint32_t now_cycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIM_RATE_H */
@@ -0,0 +1,134 @@
+/**
+ ******************************************************************************
+ * @file           : uart_tx.h
+ * @brief          : Non-blocking UART transmit through a byte ring buffer
+ ******************************************************************************
+ *
+ * HAL_UART_Transmit(..., HAL_MAX_DELAY) keeps the CPU busy for the whole
+ * line: 20 characters at 9600 baud (10 bits each) is ~21 ms of no sampling.
+ * Here the producer only copies into a ring and returns; the UART drains it
+ * by DMA (or TXE interrupts) one contiguous span at a time.
+ *
+ *   producer (main loop)          consumer (TX complete ISR)
+ *   tx_ring_write() -> head       tx_ring_claim() / tx_ring_release() -> tail
+ *
+ * Single producer / single consumer, lock-free: head and tail are
+ * free-running 32-bit counters (used = head - tail) and each is written by
+ * one side only. The size must be a power of two.
+ *
+ * A write either fits completely or is dropped completely, so a full ring
+ * loses whole messages, never the middle of a line. Drops, the number of
+ * bytes queued and the fill high-water mark are kept for tuning the ring
+ * size against the link rate.
+ *
+ * tx_ring_* is HAL-free; uart_tx_* (uart_tx_hal.c) binds a ring to a
+ * UART_HandleTypeDef and works with any U(S)ART the HAL drives:
+ * LPUART1 (h7_temp_bluetooth), USART2 (timer), USART3 (exti_h7_m4, led_h7).
+ ******************************************************************************
+ */
+#ifndef UART_TX_H
+#define UART_TX_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint8_t* buf;
+  uint32_t mask;          /* size - 1 */
+  volatile uint32_t head; /* written by the producer only */
+  volatile uint32_t tail; /* written by the consumer only */
+  uint32_t queued;        /* bytes accepted */
+  uint32_t dropped;       /* bytes rejected, ring full */
+  uint32_t drops;         /* writes rejected */
+  uint32_t high_water;    /* largest fill level seen, bytes */
+} tx_ring_t;
+
+/**
+ * @brief  Bind a ring to its storage.
+ * @param  size: bytes, power of two
+ * @retval 0 on success, -1 if size is not a power of two
+ */
+int tx_ring_init(tx_ring_t* r, uint8_t* buf, uint32_t size);
+
+/**
+ * @brief  Bytes waiting (including a span claimed but not yet released).
+ */
+static inline uint32_t tx_ring_used(const tx_ring_t* r) {
+  return r->head - r->tail;
+}
+
+/**
+ * @brief  Bytes that a write can still take.
+ */
+static inline uint32_t tx_ring_free(const tx_ring_t* r) {
+  return r->mask + 1U - (r->head - r->tail);
+}
+
+/**
+ * @brief  Producer side: queue a whole message or nothing. Never blocks.
+ * @retval len when queued, 0 when dropped
+ */
+uint32_t tx_ring_write(tx_ring_t* r, const void* data, uint32_t len);
+
+/**
+ * @brief  Consumer side: oldest contiguous span, up to the wrap point.
+ * @param  p: start of the span
+ * @param  max: upper bound for the span length
+ * @retval span length, 0 if the ring is empty
+ */
+uint32_t tx_ring_claim(const tx_ring_t* r, const uint8_t** p, uint32_t max);
+
+/**
+ * @brief  Consumer side: drop n bytes that have been sent.
+ */
+void tx_ring_release(tx_ring_t* r, uint32_t n);
+
+#ifdef HAL_UART_MODULE_ENABLED
+/* Longest span handed to one DMA / IT transfer */
+#define UART_TX_MAX_CHUNK 256U
+
+typedef struct {
+  UART_HandleTypeDef* huart;
+  tx_ring_t ring;
+  volatile uint32_t in_flight; /* bytes of the running transfer, 0 = idle */
+  uint32_t errors;             /* transfers the HAL refused to start */
+} uart_tx_t;
+
+/**
+ * @brief  Bind a ring to an initialised UART. Uses DMA when the handle has
+ *         a linked TX stream (hdmatx), TXE interrupts otherwise; either way
+ *         the UART IRQ must be enabled.
+ * @retval HAL_OK, HAL_ERROR if size is not a power of two
+ */
+HAL_StatusTypeDef uart_tx_init(uart_tx_t* t,
+                               UART_HandleTypeDef* huart,
+                               uint8_t* buf,
+                               uint32_t size);
+
+/**
+ * @brief  Queue a message and start draining if the UART is idle.
+ * @retval len when queued, 0 when dropped (ring full)
+ */
+uint32_t uart_tx_write(uart_tx_t* t, const void* data, uint32_t len);
+
+/**
+ * @brief  Call from HAL_UART_TxCpltCallback for t->huart.
+ */
+void uart_tx_cplt_isr(uart_tx_t* t);
+
+/**
+ * @brief  Wait until everything queued has left the UART (before sleep,
+ *         reset, or a blocking transmit on the same port).
+ * @retval HAL_OK, HAL_TIMEOUT
+ */
+HAL_StatusTypeDef uart_tx_flush(uart_tx_t* t, uint32_t timeout_ms);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_TX_H */
@@ -0,0 +1,67 @@
+/**
+ ******************************************************************************
+ * @file           : vdda_comp.h
+ * @brief          : VDDA from VREFINT and ratiometric correction of ADC codes
+ ******************************************************************************
+ *
+ * Factory words are measured at VDDA = 3.3 V (H7: VREFINT_CAL at
+ * 0x1FF1E860, TS_CAL1/TS_CAL2 likewise). With VDDA drooping, every code
+ * grows by 3300 / VDDA, which the TS_CAL formula reads as temperature.
+ *
+ * Per block of an interleaved [TSENSE, VREFINT] scan:
+ *
+ *   VDDA[mV] = 3300 * VREFINT_CAL / mean(VREFINT codes)
+ *   k[Q16]   = VREFINT_CAL * 2^16 / mean(VREFINT codes)   (1 division)
+ *   ts'      = usat16((ts * k + 2^15) >> 16)              (per sample)
+ *
+ * ts' is the code the sensor would give at VDDA = 3.3 V, so it feeds the
+ * unchanged TS_CAL conversion (temp_conv). The per-sample pass stays in
+ * 32 bits: k <= 1 (VDDA <= 3.3 V) times a 16-bit code fits as is; above
+ * that k is taken in Q15, which costs at most 1 LSB at full scale. Each
+ * sample is then a 32-bit multiply, add, shift and USAT (__usat where
+ * the core has it, a compare elsewhere), with no division and no float.
+ * Host/vdda_comp_check compares it with a double reference.
+ ******************************************************************************
+ */
+#ifndef VDDA_COMP_H
+#define VDDA_COMP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* VDDA at which the factory calibration words were taken, mV */
+#define VDDA_COMP_CAL_MV 3300U
+
+typedef struct {
+  uint16_t vrefint_cal; /* factory VREFINT code at VDDA_COMP_CAL_MV */
+  uint32_t vdda_mv;     /* VDDA of the last block */
+  uint32_t k_q16;       /* 3.3 V normalisation factor of the last block */
+} vdda_comp_t;
+
+/**
+ * @brief  Bind to the factory VREFINT word (e.g. *VREFINT_CAL_ADDR).
+ */
+void vdda_comp_init(vdda_comp_t* v, uint16_t vrefint_cal);
+
+/**
+ * @brief  Process one interleaved scan block.
+ * @param  v: compensator, vdda_mv / k_q16 updated
+ * @param  scan: [ts0, vref0, ts1, vref1, ...]
+ * @param  pairs: number of [ts, vref] pairs
+ * @param  ts_out: pairs compensated TSENSE codes (3.3 V domain)
+ * @retval VDDA in mV, 0 if the block has no usable VREFINT reading (mean
+ *         below one code); v and ts_out are then left as they were
+ */
+uint32_t vdda_comp_block(vdda_comp_t* v,
+                         const uint16_t* scan,
+                         uint32_t pairs,
+                         uint16_t* ts_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VDDA_COMP_H */
@@ -0,0 +1,179 @@
+/**
+ ******************************************************************************
+ * @file           : wave_gen.h
+ * @brief          : Waveform engine for a circular, timer-paced DAC DMA
+ ******************************************************************************
+ *
+ * One period of the waveform lives in a table of len codes (the output
+ * frequency is f_trigger / len). The DAC DMA does not read the table: it
+ * plays a small ping-pong buffer that the DMA callbacks refill, each half
+ * while the other one plays:
+ *
+ *   HalfCplt -> wave_gen_fill(first half)
+ *   Cplt     -> wave_gen_fill(second half)
+ *
+ * There are two tables. The one the ISR reads is never written; a new
+ * shape, amplitude or user table is built into the other one from the
+ * main loop and committed. The ISR switches tables only where the playing
+ * period wraps to index 0, so the output never tears, never repeats a
+ * stale half and the DMA never stops. Until that boundary is reached the
+ * next build is refused (-1, try again later).
+ *
+ * Shapes: sine, triangle, square (duty in samples), saw, arbitrary
+ * (codes copied from a caller buffer, clamped to 12 bits), and the
+ * burst / gauss / sinc pulses, all between the lo and hi codes of the
+ * config. Sine, burst, gauss and sinc come from the const tables that
+ * Host/wave_tables_gen writes (wave_tables.h, in flash, no libm on the
+ * target): a full-scale config of WAVE_TABLES_N samples plays the flash
+ * table in place, anything else is resampled (integer linear
+ * interpolation) and scaled into one of the two RAM tables.
+ *
+ * Two ways through the table:
+ *   step  tuning word 0: one table entry per sample, f = fs / len
+ *   DDS   32-bit phase accumulator, phase += tw per sample, entry
+ *         (phase * len) >> 32, f = tw * fs / 2^32: one table and a fixed
+ *         fs give fs / 2^32 resolution (60 uHz at 256 kHz), any len
+ * In DDS mode a committed table takes over where the phase wraps. The
+ * tuning word may change at any time, the phase stays continuous; so do
+ * switches between step and DDS mode.
+ *
+ * Dual channel (DAC DHR12RD, one DMA stream for both outputs):
+ * wave_gen_fill_dual writes packed words, CH1 code in bits 11:0 and CH2 in
+ * 27:16, so both channels load on the same trigger. CH2 is derived from
+ * CH1's table and position: the same table offset by a fraction of the
+ * period (WAVE_CH2_PHASE, 2^30 = 90 degrees for I/Q), or CH1 mirrored
+ * about mid-scale (WAVE_CH2_INVERT, differential). Both channels switch
+ * to a committed table on the same sample, at CH1's period boundary.
+ *
+ * No HAL dependency: the same code runs on target and on the host.
+ ******************************************************************************
+ */
+#ifndef WAVE_GEN_H
+#define WAVE_GEN_H
+
+#include <stdint.h>
+
+#include "wave_tables.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef WAVE_GEN_TABLE_MAX
+#define WAVE_GEN_TABLE_MAX 256U /* samples per RAM table, at most */
+#endif
+#define WAVE_GEN_CODE_MAX 4095U /* 12-bit DAC */
+
+typedef enum {
+  WAVE_SINE = 0,
+  WAVE_TRIANGLE,
+  WAVE_SQUARE,
+  WAVE_SAW,
+  WAVE_ARB,
+  WAVE_BURST, /* 8-cycle Hann-windowed tone burst */
+  WAVE_GAUSS, /* Gaussian pulse, lo at the edges */
+  WAVE_SINC,  /* sinc, 4 lobes each side, minimum at lo */
+  WAVE_SHAPES
+} wave_shape_t;
+
+typedef enum {
+  WAVE_CH2_PHASE = 0, /* CH2 = table at CH1 position + offset / 2^32 period */
+  WAVE_CH2_INVERT,    /* CH2 = CODE_MAX - CH1 */
+  WAVE_CH2_MODES
+} wave_ch2_t;
+
+/* DHR12RD word: CH1 in bits 11:0, CH2 in bits 27:16 */
+#define WAVE_GEN_PACK(ch1, ch2) ((uint32_t) (ch1) | ((uint32_t) (ch2) << 16))
+
+typedef struct {
+  uint32_t shape;       /* wave_shape_t */
+  uint32_t len;         /* samples per period, 2..WAVE_GEN_TABLE_MAX, or
+                           WAVE_TABLES_N for a full-scale flash table */
+  uint16_t lo;          /* code at the bottom of the waveform */
+  uint16_t hi;          /* code at the top, lo <= hi <= CODE_MAX */
+  uint32_t duty;        /* WAVE_SQUARE: samples at hi, 0..len */
+  const uint16_t* arb;  /* WAVE_ARB: len codes, copied by the build */
+} wave_cfg_t;
+
+typedef struct {
+  const uint16_t* code; /* ram[] of the same index, or a flash table */
+  uint32_t len;
+  wave_cfg_t cfg; /* what the table was built from (arb not kept) */
+} wave_table_t;
+
+typedef struct {
+  wave_table_t tab[2];
+  uint16_t ram[2][WAVE_GEN_TABLE_MAX]; /* rendered tables */
+  volatile uint8_t active;  /* table the ISR plays */
+  volatile uint8_t pending; /* the other one is committed, not playing yet */
+  uint32_t idx;             /* next index into the active table (ISR) */
+  volatile uint32_t tw;     /* DDS tuning word, 0 = step mode */
+  uint32_t phase;           /* DDS phase accumulator (ISR) */
+  uint8_t dds;              /* mode of the last fill (ISR) */
+  volatile uint32_t ch2_mode;   /* wave_ch2_t, dual fills only */
+  volatile uint32_t ch2_offset; /* WAVE_CH2_PHASE: CH2 lead, 2^32 = period */
+  uint32_t swaps;           /* tables switched at a period boundary */
+  uint32_t refused;         /* builds refused while a swap was pending */
+} wave_gen_t;
+
+/**
+ * @brief  Build cfg into table 0 and play it from index 0.
+ * @retval 0, or -2 when cfg is invalid (table 0 then holds mid-scale)
+ */
+int32_t wave_gen_init(wave_gen_t* g, const wave_cfg_t* cfg);
+
+/**
+ * @brief  Build cfg into the idle table and commit it (main loop).
+ * @retval 0 committed, -1 previous swap still pending, -2 invalid cfg
+ */
+int32_t wave_gen_build(wave_gen_t* g, const wave_cfg_t* cfg);
+
+/**
+ * @brief  DDS tuning word for f_uhz (microhertz) at fs_hz, rounded.
+ *         Exact frequency: tw * fs_hz / 2^32.
+ * @retval tw, or 0 when f >= fs or f >= 274 kHz
+ */
+uint32_t wave_gen_tuning(uint32_t fs_hz, uint64_t f_uhz);
+
+/**
+ * @brief  Select DDS with tuning word tw, or step mode with 0 (any time).
+ */
+void wave_gen_set_tuning(wave_gen_t* g, uint32_t tw);
+
+/**
+ * @brief  Select how CH2 follows CH1 in dual fills (any time, next fill).
+ * @param  mode    wave_ch2_t; an invalid mode is ignored
+ * @param  offset  WAVE_CH2_PHASE: CH2 lead in 2^-32 periods
+ */
+void wave_gen_set_ch2(wave_gen_t* g, uint32_t mode, uint32_t offset);
+
+/**
+ * @brief  Next n output codes (DMA half / complete callback).
+ */
+void wave_gen_fill(wave_gen_t* g, uint16_t* out, uint32_t n);
+
+/**
+ * @brief  Next n packed CH1 | CH2 << 16 words (dual DMA callbacks).
+ */
+void wave_gen_fill_dual(wave_gen_t* g, uint32_t* out, uint32_t n);
+
+/**
+ * @brief  Next n codes in DDS mode with a tuning word per sample (FM,
+ *         sweeps); committed table at the phase wrap. A later
+ *         wave_gen_fill continues from the same phase with g->tw.
+ * @param  tw  n tuning words, none of them 0
+ */
+void wave_gen_fill_tw(wave_gen_t* g, const uint32_t* tw, uint16_t* out,
+                      uint32_t n);
+
+/**
+ * @brief  wave_gen_fill_tw into packed CH1 | CH2 << 16 words.
+ */
+void wave_gen_fill_tw_dual(wave_gen_t* g, const uint32_t* tw, uint32_t* out,
+                           uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WAVE_GEN_H */
@@ -0,0 +1,114 @@
+/**
+ ******************************************************************************
+ * @file           : wave_mod.h
+ * @brief          : Streaming AM / FM / sweep / envelope stage for wave_gen
+ ******************************************************************************
+ *
+ * Modulates the wave_gen carrier sample by sample inside the DAC DMA
+ * half / complete refills, so nothing longer than one DMA half is ever
+ * computed and no modulated table is precomputed:
+ *
+ *   HalfCplt -> wave_mod_fill(first half)
+ *   Cplt     -> wave_mod_fill(second half)
+ *
+ * A source gives m in 0..1 (Q16) per sample:
+ *   WAVE_MOD_LFO   sine, (1 + sin) / 2, at lfo_tw (DDS tuning word at the
+ *                  DAC rate), interpolated from the flash sine table
+ *   WAVE_MOD_RAMP  0 -> 1 over rise samples, back to 0 over the rest of
+ *                  period, repeating (rise == period: sawtooth)
+ * and a destination maps it linearly from a (m = 0) to b (m = 1):
+ *   WAVE_MOD_AMPLITUDE  Q16 gain (65536 = table amplitude, up to 2.0)
+ *                       about the center code, clamped to 0..4095:
+ *                       AM = LFO, a = 1 - depth, b = 1; envelope = RAMP,
+ *                       a = 0, b = 1
+ *   WAVE_MOD_FREQUENCY  DDS tuning word (wave_gen_tuning): FM = LFO,
+ *                       a / b = carrier -/+ deviation; sweep / chirp =
+ *                       RAMP from a to b
+ * The carrier's phase stays continuous through every change, and
+ * committed wave_gen tables still switch at a period boundary.
+ *
+ * Per sample: one source step and one multiply-add, no division, so a
+ * fill's cost is linear in its length and independent of the settings.
+ * wave_mod_set may run in the main loop while the ISR fills: the ISR only
+ * reads the configuration the last set completed.
+ *
+ * No HAL dependency: the same code runs on target and on the host.
+ ******************************************************************************
+ */
+#ifndef WAVE_MOD_H
+#define WAVE_MOD_H
+
+#include <stdint.h>
+
+#include "wave_gen.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WAVE_MOD_CHUNK 32U          /* samples per internal step (stack) */
+#define WAVE_MOD_GAIN_MAX 131072U   /* Q16 2.0 */
+
+typedef enum {
+  WAVE_MOD_OFF = 0, /* plain wave_gen_fill */
+  WAVE_MOD_LFO,
+  WAVE_MOD_RAMP,
+  WAVE_MOD_SRCS
+} wave_mod_src_t;
+
+typedef enum {
+  WAVE_MOD_AMPLITUDE = 0,
+  WAVE_MOD_FREQUENCY,
+  WAVE_MOD_DSTS
+} wave_mod_dst_t;
+
+typedef struct {
+  uint32_t src;     /* wave_mod_src_t */
+  uint32_t dst;     /* wave_mod_dst_t */
+  uint32_t lfo_tw;  /* LFO: tuning word of the modulating sine */
+  uint32_t period;  /* RAMP: samples per cycle, >= 1 */
+  uint32_t rise;    /* RAMP: rising samples, 0..period */
+  uint32_t a;       /* value at m = 0: Q16 gain or tuning word */
+  uint32_t b;       /* value at m = 1 */
+  uint32_t center;  /* AMPLITUDE: code the gain scales about */
+} wave_mod_cfg_t;
+
+typedef struct {
+  wave_mod_cfg_t cfg[2];
+  volatile uint32_t seq;    /* bumped by wave_mod_set; cfg[seq & 1] is live */
+  uint32_t seen;            /* seq the source state belongs to (ISR) */
+  uint32_t lfo_phase;       /* ISR source state */
+  uint32_t ramp_pos;
+  uint32_t ramp_acc;        /* m in Q32 */
+  uint32_t ramp_up;         /* per-sample steps of ramp_acc */
+  uint32_t ramp_down;
+} wave_mod_t;
+
+/**
+ * @brief  Modulation off.
+ */
+void wave_mod_init(wave_mod_t* m);
+
+/**
+ * @brief  Validate cfg and hand it to the ISR, which restarts the source
+ *         (LFO phase 0, ramp at its start) on the next fill (main loop).
+ * @retval 0, or -2 when cfg is invalid (the previous one keeps running)
+ */
+int32_t wave_mod_set(wave_mod_t* m, const wave_mod_cfg_t* cfg);
+
+/**
+ * @brief  Next n modulated codes from g (DMA half / complete callback).
+ */
+void wave_mod_fill(wave_mod_t* m, wave_gen_t* g, uint16_t* out, uint32_t n);
+
+/**
+ * @brief  Next n packed CH1 | CH2 << 16 words, both channels modulated.
+ */
+void wave_mod_fill_dual(wave_mod_t* m, wave_gen_t* g, uint32_t* out,
+                        uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WAVE_MOD_H */
@@ -0,0 +1,34 @@
+/**
+ ******************************************************************************
+ * @file           : wave_tables.h
+ * @brief          : Waveform tables in flash (generated, do not edit)
+ ******************************************************************************
+ *
+ * Written by Host/wave_tables_gen -n 1024 -b 12. One period / pulse per
+ * table, codes 0..2^bits - 1, each within 0.5 LSB of the libm value
+ * (shapes and ranges: Host/wave_tables_shapes.hpp).
+ ******************************************************************************
+ */
+#ifndef WAVE_TABLES_H
+#define WAVE_TABLES_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WAVE_TABLES_N 1024U
+#define WAVE_TABLES_BITS 12U
+#define WAVE_TABLES_FULL 4095U
+
+extern const uint16_t wave_table_sine[WAVE_TABLES_N];
+extern const uint16_t wave_table_burst[WAVE_TABLES_N];
+extern const uint16_t wave_table_gauss[WAVE_TABLES_N];
+extern const uint16_t wave_table_sinc[WAVE_TABLES_N];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WAVE_TABLES_H */
@@ -0,0 +1,36 @@
+/**
+ ******************************************************************************
+ * @file           : adc_os.c
+ * @brief          : ADC hardware oversampling profiles (H7 16-bit ADC)
+ ******************************************************************************
+ */
+#include "adc_os.h"
+
+#include <stddef.h>
+
+static const adc_os_profile_t adc_os_profiles[ADC_OS_PROFILE_COUNT] = {
+    [ADC_OS_OFF] = {"off", 1, 0, 0, 0},
+    [ADC_OS_X4] = {"x4", 4, 2, 1, 0},
+    [ADC_OS_X16] = {"x16", 16, 4, 2, 0},
+    [ADC_OS_X64] = {"x64", 64, 6, 3, 0},
+    [ADC_OS_X256] = {"x256", 256, 8, 4, 0},
+    [ADC_OS_X16_TRIG] = {"x16 trig", 16, 4, 2, 1},
+};
+
+const adc_os_profile_t* adc_os_profile(adc_os_profile_id_t id) {
+  if ((uint32_t) id >= (uint32_t) ADC_OS_PROFILE_COUNT) {
+    return NULL;
+  }
+  return &adc_os_profiles[id];
+}
+
+uint32_t adc_os_rate_mhz(const adc_os_profile_t* p,
+                         uint32_t f_adc_hz,
+                         uint32_t half_cycles) {
+  uint64_t den = (uint64_t) half_cycles * p->ratio;
+  if (den == 0) {
+    return 0;
+  }
+  /* f_adc * 2 (half cycles) * 1000 (mHz) / (half_cycles * ratio) */
+  return (uint32_t) (((uint64_t) f_adc_hz * 2000U + den / 2U) / den);
+}
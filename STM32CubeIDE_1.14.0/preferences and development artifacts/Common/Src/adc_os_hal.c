@@ -0,0 +1,46 @@
+/**
+ ******************************************************************************
+ * @file           : adc_os_hal.c
+ * @brief          : Applies an adc_os profile to an H7 ADC handle (target only)
+ ******************************************************************************
+ */
+#include "main.h"
+#include "adc_os.h"
+
+/* shift -> ADC_RIGHTBITSHIFT_x, only the shifts used by the profile table */
+static uint32_t adc_os_hal_shift(uint8_t shift) {
+  switch (shift) {
+    case 2:
+      return ADC_RIGHTBITSHIFT_2;
+    case 4:
+      return ADC_RIGHTBITSHIFT_4;
+    case 6:
+      return ADC_RIGHTBITSHIFT_6;
+    case 8:
+      return ADC_RIGHTBITSHIFT_8;
+    default:
+      return ADC_RIGHTBITSHIFT_NONE;
+  }
+}
+
+HAL_StatusTypeDef adc_os_apply(ADC_HandleTypeDef* hadc, adc_os_profile_id_t id) {
+  const adc_os_profile_t* p = adc_os_profile(id);
+
+  if (p == NULL) {
+    return HAL_ERROR;
+  }
+  if (p->ratio <= 1U) {
+    hadc->Init.OversamplingMode = DISABLE;
+    hadc->Init.Oversampling.Ratio = 1;
+  } else {
+    hadc->Init.OversamplingMode = ENABLE;
+    hadc->Init.Oversampling.Ratio = p->ratio; /* H7: ratio written as-is */
+    hadc->Init.Oversampling.RightBitShift = adc_os_hal_shift(p->shift);
+    hadc->Init.Oversampling.TriggeredMode = p->per_trigger
+        ? ADC_TRIGGEREDMODE_MULTI_TRIGGER
+        : ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+    hadc->Init.Oversampling.OversamplingStopReset = ADC_REGOVERSAMPLING_CONTINUED_MODE;
+  }
+  /* ADC is still disabled here, so HAL_ADC_Init reprograms CFGR2 */
+  return HAL_ADC_Init(hadc);
+}
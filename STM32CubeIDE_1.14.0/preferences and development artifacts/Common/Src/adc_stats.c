@@ -0,0 +1,152 @@
+/**
+ ******************************************************************************
+ * @file           : adc_stats.c
+ * @brief          : Streaming statistics over blocks of ADC codes
+ ******************************************************************************
+ */
+#include "adc_stats.h"
+
+#include <string.h>
+
+/* Host builds may force the packed kernel with ADC_STATS_USE_SIMD 1 and
+ * ADC_STATS_DSP_MODELS, supplying C models of __smlad / __smlald and of
+ * the two helpers below (Host/adc_stats_bench). */
+#ifndef ADC_STATS_USE_SIMD
+#if defined(__ARM_FEATURE_SIMD32) && __ARM_FEATURE_SIMD32
+#define ADC_STATS_USE_SIMD 1
+#else
+#define ADC_STATS_USE_SIMD 0
+#endif
+#endif
+
+#if ADC_STATS_USE_SIMD && !defined(ADC_STATS_DSP_MODELS)
+#include <arm_acle.h>
+
+/* Packed unsigned min / max. USUB16 is there only for the GE flags SEL
+ * reads, its difference is unused: both sit in one asm statement so the
+ * compiler can neither drop the USUB16 nor put another GE writer between
+ * the two. SEL Rd, Rn, Rm takes Rn where GE is set. */
+static inline uint32_t adc_stats_min16(uint32_t a, uint32_t b) {
+  uint32_t r;
+  __asm("usub16 %0, %1, %2\n\tsel %0, %2, %1" : "=&r"(r) : "r"(a), "r"(b) : "cc");
+  return r;
+}
+
+static inline uint32_t adc_stats_max16(uint32_t a, uint32_t b) {
+  uint32_t r;
+  __asm("usub16 %0, %1, %2\n\tsel %0, %1, %2" : "=&r"(r) : "r"(a), "r"(b) : "cc");
+  return r;
+}
+#endif
+
+/* Keep the compiler from moving state stores across the seq updates.
+ * Writer and reader share one core, so no DMB is needed. */
+#define ADC_STATS_BARRIER() __asm volatile("" ::: "memory")
+
+void adc_stats_init(adc_stats_t* s, uint8_t ema_shift) {
+  s->seq = 0;
+  memset(&s->st, 0, sizeof(s->st));
+  s->st.min = 0xFFFFU;
+  s->ema_shift = ema_shift;
+}
+
+void adc_stats_scan(const uint16_t* x, uint32_t n, adc_stats_block_t* out) {
+  uint32_t i = 0;
+  int32_t sum = 0;
+  int64_t sq = 0;
+  uint32_t lo = 0xFFFFU;
+  uint32_t hi = 0;
+
+#if ADC_STATS_USE_SIMD
+  uint32_t vmin = 0xFFFFFFFFU;
+  uint32_t vmax = 0;
+  for (; i + 2U <= n; i += 2U) {
+    uint32_t w;
+    uint32_t c;
+    memcpy(&w, &x[i], sizeof(w)); /* LDR, unaligned access is fine on M7 */
+    vmin = adc_stats_min16(w, vmin);
+    vmax = adc_stats_max16(w, vmax);
+    c = w ^ 0x80008000U; /* offset binary -> two signed halfwords */
+    sum = __smlad(c, 0x00010001U, sum);
+    sq = __smlald(c, c, sq);
+  }
+  lo = ((vmin & 0xFFFFU) < (vmin >> 16)) ? (vmin & 0xFFFFU) : (vmin >> 16);
+  hi = ((vmax & 0xFFFFU) > (vmax >> 16)) ? (vmax & 0xFFFFU) : (vmax >> 16);
+#endif
+
+  /* Portable path, and the odd tail of the SIMD path */
+  for (; i < n; i++) {
+    int32_t c = (int32_t) x[i] - 32768;
+    sum += c;
+    sq += (int64_t) c * c;
+    if (x[i] < lo) {
+      lo = x[i];
+    }
+    if (x[i] > hi) {
+      hi = x[i];
+    }
+  }
+
+  out->n = n;
+  out->sum_c = sum;
+  out->sumsq_c = sq;
+  out->min = (uint16_t) lo;
+  out->max = (uint16_t) hi;
+}
+
+/* Chan/Welford merge of one reduced block into the running state */
+static void adc_stats_merge(adc_stats_t* s, const adc_stats_block_t* b) {
+  adc_stats_snapshot_t* st = &s->st;
+  double nb = (double) b->n;
+  double na = (double) st->count;
+  double n = na + nb;
+  double mean_b = (double) b->sum_c / nb + 32768.0;
+  /* exact in 64 bits for n <= ADC_STATS_CHUNK */
+  double m2_b = (double) ((int64_t) b->n * b->sumsq_c - (int64_t) b->sum_c * b->sum_c) / nb;
+  double delta = mean_b - st->mean;
+
+  st->mean += delta * nb / n;
+  st->m2 += m2_b + delta * delta * na * nb / n;
+  st->count += b->n;
+  if (b->min < st->min) {
+    st->min = b->min;
+  }
+  if (b->max > st->max) {
+    st->max = b->max;
+  }
+  if (st->blocks == 0U) {
+    st->ema = mean_b;
+  } else {
+    st->ema += (mean_b - st->ema) / (double) (1UL << s->ema_shift);
+  }
+  st->blocks++;
+}
+
+void adc_stats_push_block(adc_stats_t* s, const uint16_t* x, uint32_t n) {
+  adc_stats_block_t b;
+
+  while (n > 0U) {
+    uint32_t len = (n > ADC_STATS_CHUNK) ? ADC_STATS_CHUNK : n;
+    adc_stats_scan(x, len, &b); /* reduce before opening the write window */
+
+    s->seq++; /* odd: update in progress */
+    ADC_STATS_BARRIER();
+    adc_stats_merge(s, &b);
+    ADC_STATS_BARRIER();
+    s->seq++; /* even: consistent */
+
+    x += len;
+    n -= len;
+  }
+}
+
+void adc_stats_snapshot(const adc_stats_t* s, adc_stats_snapshot_t* out) {
+  uint32_t seq;
+
+  do {
+    seq = s->seq;
+    ADC_STATS_BARRIER();
+    *out = s->st;
+    ADC_STATS_BARRIER();
+  } while ((seq & 1U) != 0U || seq != s->seq);
+}
@@ -0,0 +1,275 @@
+/**
+ ******************************************************************************
+ * @file           : cal_store.c
+ * @brief          : Persistent user calibration record, double-banked, CRC-32
+ ******************************************************************************
+ */
+#include "cal_store.h"
+
+#include <stddef.h>
+
+/* The line must be in buf before ready hands it to the main loop; both
+ * sides run on one core, so a compiler barrier is enough */
+#define CAL_LINE_BARRIER() __asm volatile("" ::: "memory")
+
+/* CRC-32 (IEEE 802.3, reflected 0xEDB88320), one nibble at a time */
+static const uint32_t cal_crc_tab[16] = {
+    0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL, 0x76DC4190UL, 0x6B6B51F4UL,
+    0x4DB26158UL, 0x5005713CUL, 0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL,
+    0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL,
+};
+
+uint32_t cal_store_crc32(const void* p, uint32_t n) {
+  const uint8_t* b = (const uint8_t*) p;
+  uint32_t crc = 0xFFFFFFFFUL;
+
+  while (n-- > 0U) {
+    crc ^= *b++;
+    crc = (crc >> 4) ^ cal_crc_tab[crc & 0xFU];
+    crc = (crc >> 4) ^ cal_crc_tab[crc & 0xFU];
+  }
+  return crc ^ 0xFFFFFFFFUL;
+}
+
+static uint32_t cal_record_crc(const cal_record_t* r) {
+  return cal_store_crc32(r, (uint32_t) offsetof(cal_record_t, crc));
+}
+
+void cal_record_clear(cal_record_t* r) {
+  uint8_t* b = (uint8_t*) r;
+
+  for (uint32_t i = 0; i < sizeof(*r); i++) {
+    b[i] = 0; /* reserved fields and unused points too: they are CRC'd */
+  }
+}
+
+int cal_record_add(cal_record_t* r, uint16_t code, int32_t t_q16) {
+  uint32_t i;
+
+  for (i = 0; i < r->npoints; i++) {
+    if (r->pt[i].code == code) {
+      break;
+    }
+  }
+  if (i == CAL_STORE_MAX_POINTS) {
+    return -1;
+  }
+  r->pt[i].code = code;
+  r->pt[i].reserved = 0;
+  r->pt[i].t_q16 = t_q16;
+  if (i == r->npoints) {
+    r->npoints++;
+  }
+  return 0;
+}
+
+int cal_record_valid(const cal_record_t* r) {
+  return r->magic == CAL_STORE_MAGIC && r->version == CAL_STORE_VERSION &&
+      r->npoints <= CAL_STORE_MAX_POINTS && r->crc == cal_record_crc(r);
+}
+
+uint32_t cal_record_points(const cal_record_t* r,
+                           const temp_lut_point_t factory[2],
+                           temp_lut_point_t* out) {
+  uint32_t n = 0;
+
+  if (r == NULL || (r->flags & CAL_REC_REPLACE_FACTORY) == 0U || r->npoints < 2U) {
+    out[n++] = factory[0];
+    out[n++] = factory[1];
+  }
+  if (r != NULL) {
+    for (uint32_t i = 0; i < r->npoints; i++) {
+      out[n].code = r->pt[i].code;
+      out[n].t_q16 = r->pt[i].t_q16;
+      n++;
+    }
+  }
+  return n;
+}
+
+int cal_store_load(const cal_record_t bank[2], cal_record_t* out) {
+  /* both CRCs always computed: load time does not depend on the contents */
+  int v0 = cal_record_valid(&bank[0]);
+  int v1 = cal_record_valid(&bank[1]);
+  int pick;
+
+  if (v0 && v1) {
+    /* wrap-safe: the newer one is less than half the range ahead */
+    pick = ((int32_t) (bank[1].seq - bank[0].seq) > 0) ? 1 : 0;
+  } else if (v0) {
+    pick = 0;
+  } else if (v1) {
+    pick = 1;
+  } else {
+    cal_record_clear(out);
+    return -1;
+  }
+  *out = bank[pick];
+  return pick;
+}
+
+int cal_store_save(cal_record_t bank[2], cal_record_t* r) {
+  cal_record_t cur;
+  int live = cal_store_load(bank, &cur);
+  int dst = (live == 0) ? 1 : 0;
+
+  r->magic = CAL_STORE_MAGIC;
+  r->version = CAL_STORE_VERSION;
+  r->seq = (live >= 0) ? cur.seq + 1U : 1U;
+  r->crc = cal_record_crc(r);
+  bank[dst] = *r; /* the live bank is untouched until this one is whole */
+  return dst;
+}
+
+/* Decimal (optional minus) at *s, advances *s; -1 if there is no digit */
+static int cal_parse_num(const char** s, int32_t* v) {
+  const char* p = *s;
+  int neg = 0;
+  int32_t x = 0;
+
+  while (*p == ' ') {
+    p++;
+  }
+  if (*p == '-') {
+    neg = 1;
+    p++;
+  }
+  if (*p < '0' || *p > '9') {
+    return -1;
+  }
+  while (*p >= '0' && *p <= '9') {
+    if (x > 99999999) {
+      return -1; /* far outside any code or milli-degree value */
+    }
+    x = x * 10 + (*p++ - '0');
+  }
+  *v = neg ? -x : x;
+  *s = p;
+  return 0;
+}
+
+/* Prefix match, returns the rest of the line or NULL */
+static const char* cal_match(const char* s, const char* word) {
+  while (*word != '\0') {
+    if (*s++ != *word++) {
+      return NULL;
+    }
+  }
+  return s;
+}
+
+static int cal_line_end(const char* s) {
+  while (*s == ' ') {
+    s++;
+  }
+  return *s == '\0';
+}
+
+int cal_cmd_parse(const char* line, cal_cmd_t* c) {
+  const char* s;
+  int32_t a;
+  int32_t b;
+
+  if ((s = cal_match(line, "CAL?")) != NULL) {
+    c->op = CAL_CMD_QUERY;
+    return cal_line_end(s) ? 0 : -1;
+  }
+  if ((s = cal_match(line, "CAL HERE ")) != NULL) {
+    if (cal_parse_num(&s, &a) != 0 || !cal_line_end(s)) {
+      return -1;
+    }
+    c->op = CAL_CMD_HERE;
+    c->t_mdeg = a;
+    return 0;
+  }
+  if ((s = cal_match(line, "CAL ADD ")) != NULL) {
+    if (cal_parse_num(&s, &a) != 0 || a < 0 || a > 0xFFFF || cal_parse_num(&s, &b) != 0 ||
+        !cal_line_end(s)) {
+      return -1;
+    }
+    c->op = CAL_CMD_ADD;
+    c->code = (uint16_t) a;
+    c->t_mdeg = b;
+    return 0;
+  }
+  if ((s = cal_match(line, "CAL CLR")) != NULL) {
+    c->op = CAL_CMD_CLEAR;
+    return cal_line_end(s) ? 0 : -1;
+  }
+  if ((s = cal_match(line, "CAL REPLACE ")) != NULL) {
+    if (cal_parse_num(&s, &a) != 0 || a < 0 || a > 1 || !cal_line_end(s)) {
+      return -1;
+    }
+    c->op = CAL_CMD_REPLACE;
+    c->flag = (uint8_t) a;
+    return 0;
+  }
+  return -1;
+}
+
+int cal_cmd_apply(const cal_cmd_t* c, cal_record_t* r, uint16_t code_now) {
+  /* milli-deg C -> Q16.16, rounded half away from zero */
+  int64_t q = (int64_t) c->t_mdeg * 65536;
+  int32_t t_q16 = (int32_t) ((q + ((q >= 0) ? 500 : -500)) / 1000);
+
+  switch (c->op) {
+    case CAL_CMD_HERE:
+      return (cal_record_add(r, code_now, t_q16) == 0) ? 1 : -1;
+    case CAL_CMD_ADD:
+      return (cal_record_add(r, c->code, t_q16) == 0) ? 1 : -1;
+    case CAL_CMD_CLEAR:
+      for (uint32_t i = 0; i < CAL_STORE_MAX_POINTS; i++) {
+        r->pt[i].code = 0;
+        r->pt[i].reserved = 0;
+        r->pt[i].t_q16 = 0;
+      }
+      r->npoints = 0;
+      return 1;
+    case CAL_CMD_REPLACE:
+      if (c->flag != 0U) {
+        r->flags |= CAL_REC_REPLACE_FACTORY;
+      } else {
+        r->flags &= (uint16_t) ~CAL_REC_REPLACE_FACTORY;
+      }
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+void cal_line_push(cal_line_t* l, uint8_t c) {
+  if (c == '\r' || c == '\n') {
+    if (l->error) {
+      l->error = 0; /* end of the broken line, start over */
+      if (!l->ready) {
+        l->len = 0;   /* buf and len are the main loop's while ready */
+      }
+    } else if (l->len > 0U && !l->ready) { /* the LF of a CRLF is no new line */
+      l->buf[l->len] = '\0';
+      CAL_LINE_BARRIER();
+      l->ready = 1;
+    }
+    return;
+  }
+  if (l->error) {
+    l->dropped++; /* rest of a broken line */
+  } else if (l->ready) {
+    l->error = 1; /* previous line not handled yet: drop this one whole, */
+    l->dropped++; /* not just the part before the release */
+  } else if (l->len < CAL_LINE_MAX - 1U) {
+    l->buf[l->len++] = (char) c;
+  } else {
+    l->error = 1; /* too long: a truncated command could still parse */
+    l->dropped++;
+  }
+}
+
+void cal_line_error(cal_line_t* l) {
+  l->error = 1; /* drop the line being received; a waiting one stays */
+  l->errors++;
+}
+
+void cal_line_release(cal_line_t* l) {
+  l->len = 0; /* both volatile: stays ahead of the store handing buf back */
+  l->ready = 0;
+}
@@ -0,0 +1,29 @@
+/**
+ ******************************************************************************
+ * @file           : cal_store_hal.c
+ * @brief          : cal_store banks in the H7 backup SRAM (target only)
+ ******************************************************************************
+ */
+#include "main.h"
+#include "cal_store.h"
+
+/* First 104 bytes of the 4 KB backup SRAM (D3 domain) */
+#define CAL_STORE_BANKS ((cal_record_t*) D3_BKPSRAM_BASE)
+
+int cal_store_hal_init(void) {
+  __HAL_RCC_BKPRAM_CLK_ENABLE();
+  HAL_PWR_EnableBkUpAccess(); /* DBP: backup domain writable */
+  /* backup regulator keeps the SRAM on VBAT when VDD is off */
+  return (HAL_PWREx_EnableBkUpReg() == HAL_OK) ? 0 : -1;
+}
+
+int cal_store_hal_load(cal_record_t* out) {
+  return cal_store_load(CAL_STORE_BANKS, out);
+}
+
+int cal_store_hal_save(cal_record_t* r) {
+  int bank = cal_store_save(CAL_STORE_BANKS, r);
+
+  __DSB(); /* the write has reached the SRAM before anything else happens */
+  return bank;
+}
@@ -0,0 +1,132 @@
+/**
+ ******************************************************************************
+ * @file           : dac_loop.c
+ * @brief          : DAC -> ADC loopback self-test analysis
+ ******************************************************************************
+ */
+#include "dac_loop.h"
+
+/* a / b rounded to nearest, b > 0 */
+static int64_t dac_loop_div(int64_t a, int64_t b) {
+  return (a >= 0) ? (a + b / 2) / b : -((-a + b / 2) / b);
+}
+
+uint16_t dac_loop_code(uint32_t k, uint32_t steps, uint16_t lo, uint16_t hi) {
+  if (steps < 2U) {
+    return lo;
+  }
+  return (uint16_t) (lo + dac_loop_div((int64_t) k * ((int32_t) hi - lo),
+                                       (int64_t) steps - 1));
+}
+
+uint32_t dac_loop_mean_q8(const uint16_t* cap, uint32_t n) {
+  uint64_t sum = 0;
+
+  for (uint32_t i = 0; i < n; i++) {
+    sum += cap[i];
+  }
+  return (uint32_t) (((sum << 8) + n / 2U) / n);
+}
+
+int32_t dac_loop_fit(const dac_loop_point_t* p, uint32_t n,
+                     dac_loop_result_t* r) {
+  int64_t sx = 0, sy = 0, sxx = 0, sxy = 0;
+  int64_t den, num;
+
+  for (uint32_t i = 0; i < n; i++) {
+    int64_t x = p[i].dac;
+    int64_t y = p[i].adc_q8;
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+  }
+  den = (int64_t) n * sxx - sx * sx;
+  if (n < 2U || den <= 0) {
+    r->fails |= DAC_LOOP_FAIL_FIT;
+    return -2;
+  }
+  /* slope in Q8 codes per code, x 256 -> Q16 */
+  num = (int64_t) n * sxy - sx * sy;
+  r->gain_q16 = (int32_t) dac_loop_div(num * 256, den);
+  r->offset_q8 = (int32_t) dac_loop_div(
+      sy - dac_loop_div((int64_t) r->gain_q16 * sx, 256), n);
+
+  r->inl_q8 = 0;
+  r->inl_at = p[0].dac;
+  for (uint32_t i = 0; i < n; i++) {
+    int64_t fit =
+        r->offset_q8 + dac_loop_div((int64_t) r->gain_q16 * p[i].dac, 256);
+    int64_t d = (int64_t) p[i].adc_q8 - fit;
+    uint32_t a = (uint32_t) ((d < 0) ? -d : d);
+    if (a > r->inl_q8) {
+      r->inl_q8 = a;
+      r->inl_at = p[i].dac;
+    }
+  }
+  return 0;
+}
+
+int32_t dac_loop_edge_q8(const uint16_t* cap, uint32_t n, uint16_t lo,
+                         uint16_t hi) {
+  /* mirror a falling step so the search is always upwards */
+  int32_t sign = (hi >= lo) ? 1 : -1;
+  int32_t mid_q8 = sign * (((int32_t) lo + hi) << 7);
+
+  if (n == 0U || lo == hi || sign * (int32_t) cap[0] * 256 >= mid_q8) {
+    return -1;
+  }
+  for (uint32_t i = 1; i < n; i++) {
+    int32_t prev = sign * (int32_t) cap[i - 1];
+    int32_t cur = sign * (int32_t) cap[i];
+    if (cur * 256 >= mid_q8) {
+      /* prev is below mid, so cur > prev */
+      return (int32_t) ((i - 1U) << 8) +
+             (int32_t) dac_loop_div(mid_q8 - prev * 256, cur - prev);
+    }
+  }
+  return -1;
+}
+
+void dac_loop_latency(dac_loop_result_t* r, int32_t edge_q8, uint32_t step_at,
+                      uint32_t cps, uint32_t t_dac, uint32_t t_adc,
+                      uint32_t adc_last) {
+  int64_t back;
+
+  if (edge_q8 < 0) {
+    r->lat_q8 = 0;
+    r->lat_cycles = 0;
+    r->dma_cycles = 0;
+    r->fails |= DAC_LOOP_FAIL_EDGE;
+    return;
+  }
+  r->lat_q8 = edge_q8 - (int32_t) (step_at << 8);
+  r->lat_cycles = (int32_t) dac_loop_div((int64_t) r->lat_q8 * cps, 256);
+  /* the ADC interrupt came (adc_last - edge) samples after the crossing */
+  back = dac_loop_div(((int64_t) adc_last * 256 - edge_q8) * cps, 256);
+  r->dma_cycles = (int32_t) (t_adc - t_dac) - (int32_t) back;
+}
+
+static uint32_t dac_loop_abs(int32_t v) {
+  return (uint32_t) ((v < 0) ? -v : v);
+}
+
+uint32_t dac_loop_check(dac_loop_result_t* r, const dac_loop_limits_t* lim) {
+  /* without a line there is nothing to hold against the static limits */
+  if ((r->fails & DAC_LOOP_FAIL_FIT) == 0U) {
+    if (dac_loop_abs(r->gain_q16 - 65536) > lim->gain_err_q16) {
+      r->fails |= DAC_LOOP_FAIL_GAIN;
+    }
+    if (dac_loop_abs(r->offset_q8) > lim->offset_q8) {
+      r->fails |= DAC_LOOP_FAIL_OFFSET;
+    }
+    if (r->inl_q8 > lim->inl_q8) {
+      r->fails |= DAC_LOOP_FAIL_INL;
+    }
+  }
+  if ((r->fails & DAC_LOOP_FAIL_EDGE) == 0U &&
+      (r->lat_q8 < 0 || r->lat_q8 > lim->lat_max_q8)) {
+    r->fails |= DAC_LOOP_FAIL_LATENCY;
+  }
+  return r->fails;
+}
@@ -0,0 +1,86 @@
+/**
+ ******************************************************************************
+ * @file           : dac_stream.c
+ * @brief          : Ping-pong block output on a circular, timer-paced DAC DMA
+ ******************************************************************************
+ */
+#include "dac_stream.h"
+
+void dac_stream_init(dac_stream_t* s, uint32_t block_len, uint32_t bin_cyc) {
+  uint8_t* b = (uint8_t*) &s->lat;
+
+  for (uint32_t i = 0; i < sizeof(s->lat); i++) {
+    b[i] = 0;
+  }
+  s->block_len = block_len;
+  s->playing = 0;
+  s->fresh[0] = 0;
+  s->fresh[1] = 0;
+  s->stamp[0] = 0;
+  s->stamp[1] = 0;
+  s->starts = 0;
+  s->acquired_at = 0;
+  s->underruns = 0;
+  s->late = 0;
+  s->blocks = 0;
+  s->lat.bin_cyc = (bin_cyc != 0U) ? bin_cyc : 1U;
+  s->lat.min = UINT32_MAX;
+}
+
+void dac_stream_hist_add(dac_stream_hist_t* h, uint32_t cycles) {
+  uint32_t k;
+
+  if (h->count == 0U) {
+    uint32_t half = (DAC_STREAM_HIST_BINS / 2U) * h->bin_cyc;
+    h->lo = (cycles > half) ? cycles - half : 0U;
+  }
+  if (cycles < h->lo) {
+    h->under++;
+  } else if ((k = (cycles - h->lo) / h->bin_cyc) >= DAC_STREAM_HIST_BINS) {
+    h->over++;
+  } else {
+    h->bins[k]++;
+  }
+  if (cycles < h->min) {
+    h->min = cycles;
+  }
+  if (cycles > h->max) {
+    h->max = cycles;
+  }
+  h->count++;
+  h->sum += cycles;
+}
+
+uint32_t dac_stream_acquire(dac_stream_t* s) {
+  s->acquired_at = s->starts;
+  return s->playing ^ 1U;
+}
+
+void dac_stream_commit(dac_stream_t* s, uint32_t half, uint32_t stamp) {
+  if (s->starts != s->acquired_at) {
+    s->late++; /* a boundary passed while writing: the half may be playing */
+  }
+  s->stamp[half] = stamp;
+  s->fresh[half] = 1; /* stamp first: the ISR reads it once fresh is set */
+  s->blocks++;
+}
+
+/* Single writer per flag: the producer sets fresh, the ISR clears it */
+static void dac_stream_start(dac_stream_t* s, uint32_t half, uint32_t now) {
+  s->playing = (uint8_t) half;
+  s->starts++;
+  if (s->fresh[half]) {
+    s->fresh[half] = 0;
+    dac_stream_hist_add(&s->lat, now - s->stamp[half]);
+  } else {
+    s->underruns++;
+  }
+}
+
+void dac_stream_half_isr(dac_stream_t* s, uint32_t now) {
+  dac_stream_start(s, 1, now);
+}
+
+void dac_stream_full_isr(dac_stream_t* s, uint32_t now) {
+  dac_stream_start(s, 0, now);
+}
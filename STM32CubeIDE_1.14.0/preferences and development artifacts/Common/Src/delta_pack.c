@@ -0,0 +1,98 @@
+/**
+ ******************************************************************************
+ * @file           : delta_pack.c
+ * @brief          : Streaming delta / zig-zag varint packing of int16 series
+ ******************************************************************************
+ */
+#include "delta_pack.h"
+
+#include "telem.h"
+
+int delta_pack_init(delta_pack_t* p, uint32_t frame_max, uint16_t first_idx) {
+  if (frame_max < DELTA_PACK_FRAME_MIN || frame_max > DELTA_PACK_FRAME_MAX) {
+    return -1;
+  }
+  p->len = 0;
+  p->cap = frame_max - 2U;
+  p->idx = first_idx;
+  p->prev = 0;
+  p->n = 0;
+  p->frames = 0;
+  p->samples = 0;
+  return 0;
+}
+
+/* CRC, then COBS into out; same framing as telem_end() */
+static uint32_t delta_pack_close(delta_pack_t* p, uint8_t* out) {
+  uint16_t crc;
+  uint32_t n;
+  uint32_t code = 0; /* index of the pending COBS code byte */
+
+  if (p->len == 0U) {
+    return 0;
+  }
+  crc = telem_crc16(p->raw, p->len);
+  p->raw[p->len] = (uint8_t) crc;
+  p->raw[p->len + 1U] = (uint8_t) (crc >> 8);
+  n = p->len + TELEM_CRC_LEN;
+
+  for (uint32_t i = 1; i <= n; i++) {
+    uint8_t b = p->raw[i - 1U];
+    if (b == 0U) {
+      out[code] = (uint8_t) (i - code);
+      code = i;
+    } else {
+      out[i] = b;
+    }
+  }
+  out[code] = (uint8_t) (n + 1U - code);
+  out[n + 1U] = 0; /* frame delimiter */
+
+  p->frames++;
+  p->samples += p->n;
+  p->len = 0;
+  p->n = 0;
+  return n + 2U;
+}
+
+uint32_t delta_pack_push(delta_pack_t* p, int16_t v, uint8_t* out) {
+  uint32_t sent = 0;
+
+  if (p->len != 0U) {
+    int32_t d = (int32_t) v - p->prev;
+    uint32_t zz = (d >= 0) ? (uint32_t) d << 1 : ((uint32_t) -d << 1) - 1U;
+    uint32_t k = (zz < 0x80U) ? 1U : (zz < 0x4000U) ? 2U : 3U;
+
+    if (p->len + k + TELEM_CRC_LEN <= p->cap) {
+      uint8_t* q = &p->raw[p->len];
+      while (zz >= 0x80U) {
+        *q++ = (uint8_t) (zz | 0x80U);
+        zz >>= 7;
+      }
+      *q = (uint8_t) zz;
+      p->len += k;
+      p->prev = v;
+      p->n++;
+      p->idx++;
+      /* full: not even a one-byte delta left */
+      return (p->len + 1U + TELEM_CRC_LEN > p->cap) ? delta_pack_close(p, out) : 0U;
+    }
+    sent = delta_pack_close(p, out);
+  }
+
+  /* v opens a frame as its base */
+  p->raw[0] = (uint8_t) ((TELEM_VERSION << 4) | TELEM_FRAME_PACKED);
+  p->raw[1] = (uint8_t) p->idx;
+  p->raw[2] = (uint8_t) (p->idx >> 8);
+  p->raw[3] = (uint8_t) (uint16_t) v;
+  p->raw[4] = (uint8_t) ((uint16_t) v >> 8);
+  p->len = DELTA_PACK_HDR_LEN;
+  p->prev = v;
+  p->n = 1;
+  p->idx++;
+  return sent;
+}
+
+uint32_t delta_pack_flush(delta_pack_t* p, uint8_t* out) {
+  return delta_pack_close(p, out);
+}
@@ -0,0 +1,131 @@
+/**
+ ******************************************************************************
+ * @file           : fmt.c
+ * @brief          : Float-free text formatting into caller buffers
+ ******************************************************************************
+ */
+#include "fmt.h"
+
+static const uint32_t fmt_pow10[FMT_DEC_MAX + 1U] = {
+    1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL,
+};
+
+void fmt_init(fmt_t* f, char* buf, uint32_t size) {
+  f->buf = buf;
+  f->cap = (size > 0U) ? size - 1U : 0U;
+  f->len = 0;
+  f->overflow = 0;
+}
+
+void fmt_char(fmt_t* f, char c) {
+  if (f->len < f->cap) {
+    f->buf[f->len++] = c;
+  } else {
+    f->overflow = 1;
+  }
+}
+
+void fmt_str(fmt_t* f, const char* s) {
+  while (*s != '\0') {
+    fmt_char(f, *s++);
+  }
+}
+
+/* Digits of v, most significant first, at least min_digits (zero padded) */
+static void fmt_digits(fmt_t* f, uint32_t v, uint8_t min_digits) {
+  char tmp[FMT_U32_MAX];
+  uint32_t n = 0;
+
+  do {
+    tmp[n++] = (char) ('0' + v % 10U); /* constant divisor: multiply + shift */
+    v /= 10U;
+  } while (v != 0U);
+  while (n < min_digits && n < sizeof(tmp)) {
+    tmp[n++] = '0';
+  }
+  while (n > 0U) {
+    fmt_char(f, tmp[--n]);
+  }
+}
+
+void fmt_u32(fmt_t* f, uint32_t v) {
+  fmt_digits(f, v, 1);
+}
+
+void fmt_i32(fmt_t* f, int32_t v) {
+  if (v < 0) {
+    fmt_char(f, '-');
+    fmt_digits(f, 0U - (uint32_t) v, 1); /* also right for INT32_MIN */
+  } else {
+    fmt_digits(f, (uint32_t) v, 1);
+  }
+}
+
+void fmt_u32_pad(fmt_t* f, uint32_t v, uint8_t width, char pad) {
+  uint32_t n = 1;
+
+  for (uint32_t t = v; t >= 10U; t /= 10U) {
+    n++;
+  }
+  while (n < width) {
+    fmt_char(f, pad);
+    n++;
+  }
+  fmt_digits(f, v, 1);
+}
+
+void fmt_hex(fmt_t* f, uint32_t v, uint8_t digits) {
+  static const char hex[16] = "0123456789ABCDEF";
+
+  if (digits > 8U) {
+    digits = 8U;
+  }
+  while (digits > 0U) {
+    digits--;
+    fmt_char(f, hex[(v >> (4U * digits)) & 0xFU]);
+  }
+}
+
+void fmt_dec(fmt_t* f, int32_t v, uint8_t decimals) {
+  uint32_t a;
+  uint32_t p;
+
+  if (decimals > FMT_DEC_MAX) {
+    decimals = FMT_DEC_MAX;
+  }
+  p = fmt_pow10[decimals];
+  if (v < 0) {
+    fmt_char(f, '-');
+    a = 0U - (uint32_t) v;
+  } else {
+    a = (uint32_t) v;
+  }
+  fmt_digits(f, a / p, 1);
+  if (decimals > 0U) {
+    fmt_char(f, '.');
+    fmt_digits(f, a % p, decimals);
+  }
+}
+
+void fmt_q16(fmt_t* f, int32_t q16, uint8_t decimals) {
+  int64_t s;
+
+  if (decimals > FMT_DEC_MAX) {
+    decimals = FMT_DEC_MAX;
+  }
+  /* |q16| * 10^d / 2^16, rounded half away from zero */
+  s = ((q16 < 0) ? -(int64_t) q16 : (int64_t) q16) * (int64_t) fmt_pow10[decimals];
+  s = (s + 32768) >> 16;
+  if (s > INT32_MAX) {
+    s = INT32_MAX; /* more decimals than 32 bits can carry */
+  }
+  if (q16 < 0 && s != 0) {
+    fmt_char(f, '-');
+  }
+  fmt_dec(f, (int32_t) s, decimals);
+}
+
+uint32_t fmt_end(fmt_t* f) {
+  f->buf[f->len] = '\0'; /* len <= cap = size - 1 */
+  return f->len;
+}
@@ -0,0 +1,84 @@
+/**
+ ******************************************************************************
+ * @file           : lp_acq.c
+ * @brief          : Sleep-between-samples main loop with residency / latency counters
+ ******************************************************************************
+ */
+#include "lp_acq.h"
+
+void lp_acq_init(lp_acq_t* a, const lp_acq_port_t* port) {
+  a->port = port;
+  a->pending = 0;
+  a->event_cyc = 0;
+  a->t_last = port->now();
+  a->total_cyc = 0;
+  a->sleep_cyc = 0;
+  a->sleeps = 0;
+  a->empty_wakes = 0;
+  a->events = 0;
+  a->lat_min = UINT32_MAX;
+  a->lat_max = 0;
+  a->lat_sum = 0;
+}
+
+void lp_acq_post(lp_acq_t* a, uint32_t ev) {
+  if (a->pending == 0U) {
+    a->event_cyc = a->port->now(); /* latency runs from the oldest event */
+  }
+  a->pending |= ev;
+}
+
+uint32_t lp_acq_wait(lp_acq_t* a) {
+  const lp_acq_port_t* p = a->port;
+  uint32_t ev;
+  uint32_t stamp;
+  uint32_t t;
+
+  p->irq_off();
+  if (a->pending == 0U) {
+    uint32_t t0 = p->now();
+    p->idle(); /* returns on a pending interrupt even though it is masked */
+    a->sleep_cyc += p->now() - t0;
+    a->sleeps++;
+    p->irq_on(); /* the handler(s) that woke us run here */
+    p->irq_off();
+  }
+  ev = a->pending;
+  stamp = a->event_cyc;
+  a->pending = 0;
+  p->irq_on();
+
+  t = p->now();
+  if (ev == 0U) {
+    a->empty_wakes++;
+  } else {
+    uint32_t lat = t - stamp;
+    if (lat < a->lat_min) {
+      a->lat_min = lat;
+    }
+    if (lat > a->lat_max) {
+      a->lat_max = lat;
+    }
+    a->lat_sum += lat;
+    a->events++;
+  }
+  a->total_cyc += t - a->t_last; /* call at least once per counter wrap */
+  a->t_last = t;
+  return ev;
+}
+
+void lp_acq_report(const lp_acq_t* a, lp_acq_report_t* r) {
+  r->residency_pm = (a->total_cyc != 0U) ? (uint32_t) (a->sleep_cyc * 1000U / a->total_cyc) : 0U;
+  r->sleeps = a->sleeps;
+  r->empty_wakes = a->empty_wakes;
+  r->events = a->events;
+  if (a->events != 0U) {
+    r->lat_min = a->lat_min;
+    r->lat_avg = (uint32_t) (a->lat_sum / a->events);
+    r->lat_max = a->lat_max;
+  } else {
+    r->lat_min = 0;
+    r->lat_avg = 0;
+    r->lat_max = 0;
+  }
+}
@@ -0,0 +1,54 @@
+/**
+ ******************************************************************************
+ * @file           : lp_acq_hal.c
+ * @brief          : Cortex-M port for lp_acq: SysTick clock, PRIMASK, WFI (target only)
+ ******************************************************************************
+ */
+#include "main.h"
+#include "lp_acq.h"
+
+/* Core cycles from the HAL tick and the SysTick down-counter. DWT CYCCNT
+ * is gated with the core clock in Sleep; SysTick keeps counting (it is
+ * what wakes the core every 1 ms), so residency stays measurable. */
+static uint32_t lp_acq_hal_now(void) {
+  uint32_t tick;
+  uint32_t ms;
+  uint32_t val;
+
+  do {
+    tick = HAL_GetTick();
+    ms = tick;
+    val = SysTick->VAL;
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0U) {
+      /* wrapped, tick handler not run yet (masked or lower priority) */
+      val = SysTick->VAL;
+      ms++;
+    }
+  } while (tick != HAL_GetTick()); /* the tick handler ran in between */
+  return ms * (SysTick->LOAD + 1U) + (SysTick->LOAD - val);
+}
+
+static void lp_acq_hal_irq_off(void) {
+  __disable_irq();
+}
+
+static void lp_acq_hal_irq_on(void) {
+  __enable_irq();
+}
+
+static void lp_acq_hal_idle(void) {
+  __DSB(); /* outstanding stores done before the clock stops */
+  __WFI();
+}
+
+static const lp_acq_port_t lp_acq_hal_port = {
+    lp_acq_hal_now,
+    lp_acq_hal_irq_off,
+    lp_acq_hal_irq_on,
+    lp_acq_hal_idle,
+};
+
+void lp_acq_hal_init(lp_acq_t* a) {
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk; /* Sleep, not Stop: peripherals keep running */
+  lp_acq_init(a, &lp_acq_hal_port);
+}
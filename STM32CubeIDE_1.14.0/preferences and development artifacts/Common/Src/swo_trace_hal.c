@@ -0,0 +1,102 @@
+/**
+ ******************************************************************************
+ * @file           : swo_trace_hal.c
+ * @brief          : Buffered, word-wide ITM/SWO trace (target only)
+ ******************************************************************************
+ */
+#include "main.h"
+#include "swo_trace.h"
+#include "dwt_cyccnt.h"
+
+#include <string.h>
+
+swo_trace_t swo_trace;
+
+static uint8_t swo_text_buf[SWO_TRACE_TEXT_RING];
+static uint8_t swo_samples_buf[SWO_TRACE_SAMPLES_RING];
+static uint8_t swo_events_buf[SWO_TRACE_EVENTS_RING];
+
+/* ITM on, and this stimulus port enabled by the debugger */
+static int swo_trace_port_on(uint32_t port) {
+  return ((ITM->TCR & ITM_TCR_ITMENA_Msk) != 0UL) && ((ITM->TER & (1UL << port)) != 0UL);
+}
+
+/* Reading a stimulus port returns FIFOREADY in bit 0 */
+static int swo_trace_ready(uint32_t port) {
+  return (ITM->PORT[port].u32 & 1UL) != 0UL;
+}
+
+/* Pop exactly n queued bytes (n <= tx_ring_used), across the wrap if needed */
+static void swo_trace_take(tx_ring_t* r, uint8_t* out, uint32_t n) {
+  while (n > 0U) {
+    const uint8_t* p;
+    uint32_t k = tx_ring_claim(r, &p, n);
+    memcpy(out, p, k);
+    tx_ring_release(r, k);
+    out += k;
+    n -= k;
+  }
+}
+
+void swo_trace_init(void) {
+  (void) tx_ring_init(&swo_trace.ring[SWO_PORT_TEXT], swo_text_buf, sizeof(swo_text_buf));
+  (void) tx_ring_init(&swo_trace.ring[SWO_PORT_SAMPLES], swo_samples_buf, sizeof(swo_samples_buf));
+  (void) tx_ring_init(&swo_trace.ring[SWO_PORT_EVENTS], swo_events_buf, sizeof(swo_events_buf));
+  swo_trace.writes = 0;
+
+  dwt_cyccnt_enable(); /* event stamps */
+}
+
+uint32_t swo_trace_write(uint32_t port, const void* data, uint32_t len) {
+  if (port >= SWO_PORT_COUNT || !swo_trace_port_on(port)) {
+    return 0;
+  }
+  return tx_ring_write(&swo_trace.ring[port], data, len);
+}
+
+uint32_t swo_trace_word(uint32_t port, uint32_t word) {
+  return swo_trace_write(port, &word, sizeof(word));
+}
+
+uint32_t swo_trace_event(uint8_t id) {
+  return swo_trace_word(SWO_PORT_EVENTS, ((uint32_t) id << 24) | (DWT->CYCCNT & 0x00FFFFFFUL));
+}
+
+uint32_t swo_trace_pump(void) {
+  static const uint8_t order[SWO_PORT_COUNT] = {SWO_PORT_EVENTS, SWO_PORT_SAMPLES, SWO_PORT_TEXT};
+  uint32_t done = 0;
+
+  for (uint32_t k = 0; k < SWO_PORT_COUNT; k++) {
+    uint32_t port = order[k];
+    tx_ring_t* r = &swo_trace.ring[port];
+
+    while (tx_ring_used(r) != 0U) {
+      uint32_t used = tx_ring_used(r);
+      uint8_t b[4];
+
+      if (!swo_trace_ready(port)) {
+        swo_trace.writes += done; /* one FIFO for all ports: come back later */
+        return done;
+      }
+      /* Little endian: the host sees the bytes of each word in order.
+       * ITM packets carry 1, 2 or 4 bytes, so a 3-byte tail goes as 2 + 1. */
+      if (used >= 4U) {
+        uint32_t w;
+        swo_trace_take(r, b, 4);
+        memcpy(&w, b, sizeof(w));
+        ITM->PORT[port].u32 = w;
+      } else if (used >= 2U) {
+        uint16_t h;
+        swo_trace_take(r, b, 2);
+        memcpy(&h, b, sizeof(h));
+        ITM->PORT[port].u16 = h;
+      } else {
+        swo_trace_take(r, b, 1);
+        ITM->PORT[port].u8 = b[0];
+      }
+      done++;
+    }
+  }
+  swo_trace.writes += done;
+  return done;
+}
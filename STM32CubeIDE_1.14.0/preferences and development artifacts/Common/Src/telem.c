@@ -0,0 +1,170 @@
+/**
+ ******************************************************************************
+ * @file           : telem.c
+ * @brief          : Binary telemetry frames: typed fields, CRC-16, COBS
+ ******************************************************************************
+ */
+#include "telem.h"
+
+/* Reserve n raw bytes, NULL (and overflow set) if they do not fit */
+static uint8_t* telem_reserve(telem_frame_t* f, uint32_t n) {
+  uint8_t* p;
+
+  if (f->overflow || f->len + n + TELEM_CRC_LEN > f->cap) {
+    f->overflow = 1;
+    return (uint8_t*) 0;
+  }
+  p = &f->buf[1U + f->len];
+  f->len += n;
+  return p;
+}
+
+static void telem_le16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t) v;
+  p[1] = (uint8_t) (v >> 8);
+}
+
+static void telem_le32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t) v;
+  p[1] = (uint8_t) (v >> 8);
+  p[2] = (uint8_t) (v >> 16);
+  p[3] = (uint8_t) (v >> 24);
+}
+
+void telem_begin(telem_frame_t* f,
+                 uint8_t* buf,
+                 uint32_t cap,
+                 uint8_t type,
+                 uint16_t seq,
+                 uint32_t t_ms) {
+  uint8_t* p;
+
+  f->buf = buf;
+  f->len = 0;
+  f->cap = (cap > TELEM_RAW_MAX) ? TELEM_RAW_MAX : cap;
+  f->overflow = 0;
+  p = telem_reserve(f, TELEM_HDR_LEN);
+  if (p != (uint8_t*) 0) {
+    p[0] = (uint8_t) ((TELEM_VERSION << 4) | (type & 0x0FU));
+    telem_le16(&p[1], seq);
+    telem_le32(&p[3], t_ms);
+  }
+}
+
+void telem_put_u8(telem_frame_t* f, uint8_t id, uint8_t v) {
+  uint8_t* p = telem_reserve(f, 2);
+  if (p != (uint8_t*) 0) {
+    p[0] = TELEM_TAG(id, TELEM_U8);
+    p[1] = v;
+  }
+}
+
+void telem_put_i16(telem_frame_t* f, uint8_t id, int16_t v) {
+  uint8_t* p = telem_reserve(f, 3);
+  if (p != (uint8_t*) 0) {
+    p[0] = TELEM_TAG(id, TELEM_I16);
+    telem_le16(&p[1], (uint16_t) v);
+  }
+}
+
+void telem_put_u16(telem_frame_t* f, uint8_t id, uint16_t v) {
+  uint8_t* p = telem_reserve(f, 3);
+  if (p != (uint8_t*) 0) {
+    p[0] = TELEM_TAG(id, TELEM_U16);
+    telem_le16(&p[1], v);
+  }
+}
+
+void telem_put_i32(telem_frame_t* f, uint8_t id, int32_t v) {
+  uint8_t* p = telem_reserve(f, 5);
+  if (p != (uint8_t*) 0) {
+    p[0] = TELEM_TAG(id, TELEM_I32);
+    telem_le32(&p[1], (uint32_t) v);
+  }
+}
+
+void telem_put_u32(telem_frame_t* f, uint8_t id, uint32_t v) {
+  uint8_t* p = telem_reserve(f, 5);
+  if (p != (uint8_t*) 0) {
+    p[0] = TELEM_TAG(id, TELEM_U32);
+    telem_le32(&p[1], v);
+  }
+}
+
+void telem_put_i16_array(telem_frame_t* f, uint8_t id, const int16_t* v, uint8_t n) {
+  uint8_t* p = telem_reserve(f, 2U + 2U * n);
+  if (p != (uint8_t*) 0) {
+    p[0] = TELEM_TAG(id, TELEM_I16_ARRAY);
+    p[1] = n;
+    for (uint32_t i = 0; i < n; i++) {
+      telem_le16(&p[2U + 2U * i], (uint16_t) v[i]);
+    }
+  }
+}
+
+uint16_t telem_crc16(const uint8_t* p, uint32_t n) {
+  /* nibble table: 32 bytes of flash, two lookups per byte */
+  static const uint16_t tab[16] = {
+      0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+      0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+  };
+  uint16_t crc = 0xFFFFU;
+
+  for (uint32_t i = 0; i < n; i++) {
+    crc = (uint16_t) ((crc << 4) ^ tab[(crc >> 12) ^ (p[i] >> 4)]);
+    crc = (uint16_t) ((crc << 4) ^ tab[(crc >> 12) ^ (p[i] & 0x0FU)]);
+  }
+  return crc;
+}
+
+uint32_t telem_end(telem_frame_t* f) {
+  uint8_t* raw = &f->buf[1];
+  uint16_t crc;
+  uint32_t n;
+  uint32_t code = 0; /* index of the pending COBS code byte */
+
+  if (f->overflow) {
+    return 0;
+  }
+  crc = telem_crc16(raw, f->len);
+  telem_le16(&raw[f->len], crc); /* room kept by telem_reserve() */
+  n = f->len + TELEM_CRC_LEN;
+
+  /* In place: every zero becomes the distance to the next one, the first
+   * distance goes into buf[0]. n <= 254, so no extra code bytes. */
+  for (uint32_t i = 1; i <= n; i++) {
+    if (f->buf[i] == 0U) {
+      f->buf[code] = (uint8_t) (i - code);
+      code = i;
+    }
+  }
+  f->buf[code] = (uint8_t) (n + 1U - code);
+  f->buf[n + 1U] = 0; /* frame delimiter */
+  return n + 2U;
+}
+
+int32_t telem_unframe(const uint8_t* in, uint32_t n, uint8_t* out) {
+  uint32_t i = 0;
+  uint32_t o = 0;
+
+  while (i < n) {
+    uint32_t code = in[i++];
+    if (code == 0U || i + code - 1U > n) {
+      return -1;
+    }
+    for (uint32_t k = 1; k < code; k++) {
+      out[o++] = in[i++];
+    }
+    if (code != 0xFFU && i < n) {
+      out[o++] = 0; /* implicit zero, except after the last group */
+    }
+  }
+  if (o < 1U + TELEM_CRC_LEN) { /* TELEM_FRAME_PACKED has a shorter header */
+    return -1;
+  }
+  o -= TELEM_CRC_LEN;
+  if (telem_crc16(out, o) != (uint16_t) (out[o] | (out[o + 1U] << 8))) {
+    return -1;
+  }
+  return (int32_t) o;
+}
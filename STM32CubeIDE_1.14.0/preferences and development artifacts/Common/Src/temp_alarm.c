@@ -0,0 +1,125 @@
+/**
+ ******************************************************************************
+ * @file           : temp_alarm.c
+ * @brief          : Temperature alarm on the ADC analog watchdog, with hysteresis
+ ******************************************************************************
+ */
+#include "temp_alarm.h"
+
+#include <stddef.h>
+
+static void temp_alarm_window(temp_alarm_t* a) {
+  switch (a->state) {
+    case TEMP_ALARM_LOW:
+      a->win_lo = 0;
+      a->win_hi = a->low_clear;
+      break;
+    case TEMP_ALARM_HIGH:
+      a->win_lo = a->high_clear;
+      a->win_hi = a->cal.code_max;
+      break;
+    default:
+      a->win_lo = a->low_trip;
+      a->win_hi = a->high_trip;
+      break;
+  }
+}
+
+int temp_alarm_init(temp_alarm_t* a, const temp_alarm_cal_t* cal, temp_alarm_cb_t cb, void* ctx) {
+  if (cal->code1 == cal->code2) {
+    return -1;
+  }
+  a->cal = *cal;
+  a->low_trip = 0;
+  a->low_clear = 0;
+  a->high_trip = cal->code_max;
+  a->high_clear = cal->code_max;
+  a->state = TEMP_ALARM_NORMAL;
+  a->last_code = 0;
+  a->events = 0;
+  a->cb = cb;
+  a->ctx = ctx;
+  temp_alarm_window(a);
+  return 0;
+}
+
+uint16_t temp_alarm_code(const temp_alarm_cal_t* cal, int32_t t_q16) {
+  int64_t dt = (int64_t) cal->t2_q16 - cal->t1_q16;
+  int64_t num = ((int64_t) t_q16 - cal->t1_q16) * ((int32_t) cal->code2 - (int32_t) cal->code1);
+  int64_t code;
+
+  if (dt < 0) {
+    dt = -dt;
+    num = -num;
+  }
+  /* round half away from zero */
+  num += (num >= 0) ? dt / 2 : -(dt / 2);
+  code = cal->code1 + num / dt;
+  if (code < 0) {
+    return 0;
+  }
+  if (code > cal->code_max) {
+    return cal->code_max;
+  }
+  return (uint16_t) code;
+}
+
+int temp_alarm_set_low(temp_alarm_t* a, int32_t trip_q16, int32_t hyst_q16) {
+  uint16_t trip = temp_alarm_code(&a->cal, trip_q16);
+  uint16_t clear = temp_alarm_code(&a->cal, trip_q16 + hyst_q16);
+
+  if (hyst_q16 <= 0 || clear <= trip || clear >= a->high_trip) {
+    return -1;
+  }
+  a->low_trip = trip;
+  a->low_clear = clear;
+  temp_alarm_window(a);
+  return 0;
+}
+
+int temp_alarm_set_high(temp_alarm_t* a, int32_t trip_q16, int32_t hyst_q16) {
+  uint16_t trip = temp_alarm_code(&a->cal, trip_q16);
+  uint16_t clear = temp_alarm_code(&a->cal, trip_q16 - hyst_q16);
+
+  if (hyst_q16 <= 0 || clear >= trip || clear <= a->low_trip) {
+    return -1;
+  }
+  a->high_trip = trip;
+  a->high_clear = clear;
+  temp_alarm_window(a);
+  return 0;
+}
+
+int temp_alarm_update(temp_alarm_t* a, uint16_t code) {
+  uint16_t lo = a->win_lo;
+  uint16_t hi = a->win_hi;
+  temp_alarm_state_t s = a->state;
+  temp_alarm_state_t next;
+
+  /* at most two steps: LOW -> NORMAL -> HIGH on a jump across both bands */
+  for (int step = 0; step < 2; step++) {
+    next = s;
+    if (s == TEMP_ALARM_NORMAL) {
+      if (code < a->low_trip) {
+        next = TEMP_ALARM_LOW;
+      } else if (code > a->high_trip) {
+        next = TEMP_ALARM_HIGH;
+      }
+    } else if ((s == TEMP_ALARM_LOW && code > a->low_clear) ||
+               (s == TEMP_ALARM_HIGH && code < a->high_clear)) {
+      next = TEMP_ALARM_NORMAL;
+    }
+    if (next == s) {
+      break;
+    }
+    s = next;
+    a->state = s;
+    a->last_code = code;
+    a->events++;
+    if (a->cb != NULL) {
+      a->cb(a->ctx, s, code);
+    }
+  }
+  temp_alarm_window(a);
+  return (a->win_lo != lo || a->win_hi != hi) ? 1 : 0;
+}
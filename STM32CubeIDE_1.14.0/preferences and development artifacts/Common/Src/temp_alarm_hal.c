@@ -0,0 +1,45 @@
+/**
+ ******************************************************************************
+ * @file           : temp_alarm_hal.c
+ * @brief          : Runs a temp_alarm on the F4 / H7 ADC analog watchdog (target only)
+ ******************************************************************************
+ */
+#include "main.h"
+#include "temp_alarm.h"
+
+/* Rewrite the AWD thresholds. Both families allow it while converting;
+ * a conversion in between sees a half-updated window at worst, and the
+ * state machine sorts that out on the next interrupt. */
+static void temp_alarm_hal_window(const temp_alarm_t* a, ADC_HandleTypeDef* hadc) {
+#if defined(STM32H7)
+  hadc->Instance->LTR1 = a->win_lo; /* 16-bit codes, no resolution shift */
+  hadc->Instance->HTR1 = a->win_hi;
+#else
+  hadc->Instance->LTR = a->win_lo;
+  hadc->Instance->HTR = a->win_hi;
+#endif
+}
+
+HAL_StatusTypeDef temp_alarm_hal_start(temp_alarm_t* a, ADC_HandleTypeDef* hadc, uint32_t channel) {
+  ADC_AnalogWDGConfTypeDef awd = {0};
+
+#if defined(STM32H7)
+  awd.WatchdogNumber = ADC_ANALOGWATCHDOG_1;
+#endif
+  awd.WatchdogMode = ADC_ANALOGWATCHDOG_SINGLE_REG;
+  awd.Channel = channel;
+  awd.ITMode = ENABLE;
+  awd.HighThreshold = a->win_hi;
+  awd.LowThreshold = a->win_lo;
+  return HAL_ADC_AnalogWDGConfig(hadc, &awd);
+}
+
+void temp_alarm_hal_isr(temp_alarm_t* a, ADC_HandleTypeDef* hadc) {
+  /* the conversion that tripped the watchdog; the HAL clears the AWD flag
+   * after this callback returns */
+  uint16_t code = (uint16_t) hadc->Instance->DR;
+
+  if (temp_alarm_update(a, code) != 0) {
+    temp_alarm_hal_window(a, hadc);
+  }
+}
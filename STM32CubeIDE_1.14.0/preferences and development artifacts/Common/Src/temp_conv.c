@@ -0,0 +1,53 @@
+/**
+ ******************************************************************************
+ * @file           : temp_conv.c
+ * @brief          : Integer-only TS_CAL temperature conversion (Q16.16 °C)
+ ******************************************************************************
+ */
+#include "temp_conv.h"
+
+int temp_conv_init(temp_conv_t* c,
+                   uint16_t cal1_code,
+                   uint16_t cal2_code,
+                   int32_t t1_q16,
+                   int32_t t2_q16) {
+  int64_t dcode = (int64_t) cal2_code - (int64_t) cal1_code;
+  int64_t dtemp = (int64_t) t2_q16 - (int64_t) t1_q16;
+  int64_t num;
+  int64_t mag;
+
+  if (dcode == 0) {
+    return -1;
+  }
+  /* |slope| < 0.5 °C/code keeps |code - cal1| * slope_q48 below 2^63 */
+  mag = (dtemp < 0 ? -dtemp : dtemp) * 2;
+  if (mag >= (dcode < 0 ? -dcode : dcode) * 65536) {
+    return -1;
+  }
+
+  /* Exact slope = num / dcode with dcode > 0. Keep both the floor and the
+   * ceiling so the per-sample product is never below the exact value:
+   * codes above TS_CAL1 use the ceiling, codes below it the floor. */
+  num = dtemp * ((int64_t) 1 << 32);
+  if (dcode < 0) {
+    num = -num;
+    dcode = -dcode;
+  }
+  c->slope_dn = num / dcode;
+  if ((num % dcode) != 0 && num < 0) {
+    c->slope_dn -= 1; /* C division truncates toward zero */
+  }
+  c->slope_up = c->slope_dn + ((num % dcode) != 0 ? 1 : 0);
+  c->cal1_code = cal1_code;
+  c->t1_q16 = t1_q16;
+  return 0;
+}
+
+void temp_conv_block(const temp_conv_t* c,
+                     const uint16_t* codes,
+                     int32_t* out_q16,
+                     uint32_t n) {
+  for (uint32_t i = 0; i < n; i++) {
+    out_q16[i] = temp_conv_q16(c, codes[i]);
+  }
+}
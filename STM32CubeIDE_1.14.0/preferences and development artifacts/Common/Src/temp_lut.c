@@ -0,0 +1,67 @@
+/**
+ ******************************************************************************
+ * @file           : temp_lut.c
+ * @brief          : Piecewise-linear code -> temperature table built at boot
+ ******************************************************************************
+ */
+#include "temp_lut.h"
+
+/* Curve through the sorted points at code c (0..65536), Q16.16, rounded */
+static int64_t temp_lut_curve(const temp_lut_point_t* p, uint32_t n, int32_t c) {
+  uint32_t k = 0;
+  int64_t dc;
+  int64_t num;
+
+  /* segment [k, k+1] holding c; the outer segments extend to the ends */
+  while (k + 2U < n && c > (int32_t) p[k + 1U].code) {
+    k++;
+  }
+  dc = (int64_t) p[k + 1U].code - p[k].code;
+  num = ((int64_t) p[k + 1U].t_q16 - p[k].t_q16) * (c - (int64_t) p[k].code);
+  /* round half away from zero */
+  num += (num >= 0) ? dc / 2 : -(dc / 2);
+  return p[k].t_q16 + num / dc;
+}
+
+int temp_lut_build(temp_lut_t* l, const temp_lut_point_t* pts, uint32_t n) {
+  temp_lut_point_t p[TEMP_LUT_MAX_POINTS];
+  int64_t t0;
+
+  if (n < 2U || n > TEMP_LUT_MAX_POINTS) {
+    return -1;
+  }
+  /* insertion sort by code, a handful of points */
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t j = i;
+    while (j > 0U && p[j - 1U].code > pts[i].code) {
+      p[j] = p[j - 1U];
+      j--;
+    }
+    p[j] = pts[i];
+  }
+  for (uint32_t i = 1; i < n; i++) {
+    int64_t dt = (int64_t) p[i].t_q16 - p[i - 1U].t_q16;
+    int64_t dc = (int64_t) p[i].code - p[i - 1U].code;
+    if (dc == 0 || (dt < 0 ? -dt : dt) * 8 > dc * 65536) {
+      return -1;
+    }
+  }
+
+  t0 = temp_lut_curve(p, n, 0);
+  for (uint32_t i = 0; i < TEMP_LUT_CELLS; i++) {
+    int64_t t1 = temp_lut_curve(p, n, (int32_t) ((i + 1U) << TEMP_LUT_SHIFT));
+    int64_t d = (t1 - t0) * 256; /* Q16.16 x 2^8 over one cell */
+    int64_t half = (int64_t) 1 << (TEMP_LUT_SHIFT - 1U);
+
+    l->base[i] = (int32_t) t0;
+    l->slope[i] = (int32_t) ((d + ((d >= 0) ? half : -half)) / ((int64_t) 1 << TEMP_LUT_SHIFT));
+    t0 = t1;
+  }
+  return 0;
+}
+
+void temp_lut_block(const temp_lut_t* l, const uint16_t* codes, int32_t* out_q16, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++) {
+    out_q16[i] = temp_lut_q16(l, codes[i]);
+  }
+}
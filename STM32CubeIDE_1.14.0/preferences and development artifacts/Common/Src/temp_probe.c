@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * @file           : temp_probe.c
+ * @brief          : ADC block -> deg C -> DAC probe codes (temp_h7_cm7_dma)
+ ******************************************************************************
+ */
+#include "temp_probe.h"
+
+/* deg C staged as int16 for the block maps (stack, not len-sized) */
+#define TEMP_PROBE_CHUNK 32U
+
+uint16_t temp_probe_mean(const uint16_t* block, uint32_t len) {
+  uint32_t sum = 0;
+
+  for (uint32_t i = 0; i < len; i++) {
+    sum += block[i];
+  }
+  return (uint16_t) (sum / len);
+}
+
+int32_t temp_probe_celsius(const temp_probe_cal_t* c, uint16_t code) {
+  /* __LL_ADC_CONVERT_DATA_RESOLUTION() to 16 bits, then rescaled from
+   * vref_mv to the calibration reference; unsigned like the macro */
+  uint32_t code16 = (uint32_t) code << (16U - c->res_bits);
+  int32_t scaled = (int32_t) ((code16 * c->vref_mv) / c->cal_vref_mv);
+
+  return ((scaled - (int32_t) c->ts_cal1) * (c->cal2_temp - c->cal1_temp)) /
+             ((int32_t) c->ts_cal2 - (int32_t) c->ts_cal1) +
+         c->cal1_temp;
+}
+
+void temp_probe_dac(int32_t temp_c, temp_probe_out_t* o) {
+  uint32_t te;
+  uint32_t room;
+
+  /* saturate to 0..66 C for the 50 mV/C channel */
+  if (temp_c < 0) {
+    te = 0;
+  } else if (temp_c > TEMP_PROBE_CH1_SPAN_C) {
+    te = TEMP_PROBE_CH1_SPAN_C;
+  } else {
+    te = (uint32_t) temp_c;
+  }
+  /* 0..33 C above the manual room offset for the 100 mV/C channel */
+  room = (te > TEMP_PROBE_CH2_OFFSET_C) ? te - TEMP_PROBE_CH2_OFFSET_C : 0U;
+  if (room > TEMP_PROBE_CH2_SPAN_C) {
+    room = TEMP_PROBE_CH2_SPAN_C;
+  }
+
+  o->temp_c = temp_c;
+  o->temp_equivalent = te;
+  o->dac_temp = temp_probe_ch1(temp_c);
+  o->roomtemp = room;
+  o->dac_roomtemp = temp_probe_ch2(temp_c);
+}
+
+void temp_probe_dac_block(const temp_probe_cal_t* c,
+                          const uint16_t* block,
+                          uint32_t len,
+                          uint16_t* ch1,
+                          uint16_t* ch2) {
+  int16_t t[TEMP_PROBE_CHUNK];
+
+  for (uint32_t i = 0; i < len; i += TEMP_PROBE_CHUNK) {
+    uint32_t n = (len - i < TEMP_PROBE_CHUNK) ? len - i : TEMP_PROBE_CHUNK;
+
+    for (uint32_t k = 0; k < n; k++) {
+      t[k] = lin_map_in(temp_probe_celsius(c, block[i + k]));
+    }
+    temp_probe_ch1_block(t, &ch1[i], n);
+    temp_probe_ch2_block(t, &ch2[i], n);
+  }
+}
+
+void temp_probe_block(const temp_probe_cal_t* c,
+                      const uint16_t* block,
+                      uint32_t len,
+                      temp_probe_out_t* o) {
+  o->mean = temp_probe_mean(block, len);
+  temp_probe_dac(temp_probe_celsius(c, o->mean), o);
+}
@@ -0,0 +1,94 @@
+/**
+ ******************************************************************************
+ * @file           : tim_rate.c
+ * @brief          : Timer PSC/ARR solver and trigger jitter tracker
+ ******************************************************************************
+ */
+#include "tim_rate.h"
+
+/* Prescaler candidates tried above the smallest one that fits; small
+ * prescalers give the finest ARR steps, so the best pair is found early. */
+#define TIM_RATE_SEARCH 1024U
+
+int tim_rate_solve(uint32_t f_tim_hz, uint32_t target_mhz, tim_rate_t* out) {
+  uint64_t f_mhz = (uint64_t) f_tim_hz * 1000U; /* timer clock in mHz */
+  uint64_t n;
+  uint64_t best_err = UINT64_MAX;
+  uint32_t p_min;
+  uint32_t p_max;
+
+  if (target_mhz == 0U) {
+    return -1;
+  }
+  n = (f_mhz + target_mhz / 2U) / target_mhz; /* total division wanted */
+  if (n < 2U || n > 65536ULL * 65536ULL) {
+    return -1;
+  }
+  p_min = (uint32_t) ((n + 65535U) / 65536U);
+  p_max = p_min + TIM_RATE_SEARCH;
+  if (p_max > 65536U) {
+    p_max = 65536U;
+  }
+
+  for (uint32_t p = p_min; p <= p_max && best_err != 0U; p++) {
+    /* the rate is 1 / division: the nearest one may be either neighbour
+     * of the exact division, not the rounded one */
+    uint64_t a0 = f_mhz / ((uint64_t) target_mhz * p);
+
+    for (uint64_t a = a0; a <= a0 + 1U; a++) {
+      uint64_t rate;
+      uint64_t err;
+      if (a < 2U || a > 65536U) {
+        continue; /* ARR 0 stops the counter */
+      }
+      rate = (f_mhz + (p * a) / 2U) / (p * a);
+      err = (rate > target_mhz) ? rate - target_mhz : target_mhz - rate;
+      if (err < best_err) {
+        best_err = err;
+        out->psc = (uint16_t) (p - 1U);
+        out->arr = (uint16_t) (a - 1U);
+        out->rate_mhz = (uint32_t) rate;
+      }
+    }
+  }
+  if (best_err == UINT64_MAX) {
+    return -1;
+  }
+  out->error_ppm = (int32_t) (((int64_t) out->rate_mhz - (int64_t) target_mhz) * 1000000 /
+                              (int64_t) target_mhz);
+  return 0;
+}
+
+void tim_jitter_init(tim_jitter_t* j, uint32_t nominal_cycles) {
+  j->nominal = nominal_cycles;
+  j->last = 0;
+  j->armed = 0;
+  j->count = 0;
+  j->min = UINT32_MAX;
+  j->max = 0;
+  j->worst = 0;
+}
+
+void tim_jitter_stamp(tim_jitter_t* j, uint32_t now_cycles) {
+  uint32_t dt;
+  uint32_t dev;
+
+  if (!j->armed) {
+    j->last = now_cycles; /* first event only arms the tracker */
+    j->armed = 1;
+    return;
+  }
+  dt = now_cycles - j->last; /* unsigned: correct across CYCCNT wrap */
+  j->last = now_cycles;
+  dev = (dt > j->nominal) ? dt - j->nominal : j->nominal - dt;
+  if (dt < j->min) {
+    j->min = dt;
+  }
+  if (dt > j->max) {
+    j->max = dt;
+  }
+  if (dev > j->worst) {
+    j->worst = dev;
+  }
+  j->count++;
+}
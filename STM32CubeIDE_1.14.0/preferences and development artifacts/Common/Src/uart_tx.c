@@ -0,0 +1,78 @@
+/**
+ ******************************************************************************
+ * @file           : uart_tx.c
+ * @brief          : Non-blocking UART transmit through a byte ring buffer
+ ******************************************************************************
+ */
+#include "uart_tx.h"
+
+#include <string.h>
+
+/* Data must be in the ring before the index that publishes it, and read
+ * before the index that frees it. Producer and consumer share one core. */
+#define TX_RING_BARRIER() __asm volatile("" ::: "memory")
+
+int tx_ring_init(tx_ring_t* r, uint8_t* buf, uint32_t size) {
+  if (size == 0U || (size & (size - 1U)) != 0U) {
+    return -1;
+  }
+  r->buf = buf;
+  r->mask = size - 1U;
+  r->head = 0;
+  r->tail = 0;
+  r->queued = 0;
+  r->dropped = 0;
+  r->drops = 0;
+  r->high_water = 0;
+  return 0;
+}
+
+uint32_t tx_ring_write(tx_ring_t* r, const void* data, uint32_t len) {
+  uint32_t head = r->head;
+  uint32_t used = head - r->tail;
+  uint32_t off = head & r->mask;
+  uint32_t first;
+
+  if (len > r->mask + 1U - used) {
+    r->dropped += len;
+    r->drops++;
+    return 0;
+  }
+
+  first = r->mask + 1U - off; /* room before the wrap */
+  if (first > len) {
+    first = len;
+  }
+  memcpy(&r->buf[off], data, first);
+  memcpy(r->buf, (const uint8_t*) data + first, len - first);
+  TX_RING_BARRIER();
+  r->head = head + len;
+
+  r->queued += len;
+  if (used + len > r->high_water) {
+    r->high_water = used + len;
+  }
+  return len;
+}
+
+uint32_t tx_ring_claim(const tx_ring_t* r, const uint8_t** p, uint32_t max) {
+  uint32_t tail = r->tail;
+  uint32_t used = r->head - tail;
+  uint32_t off = tail & r->mask;
+  uint32_t n = r->mask + 1U - off; /* bytes before the wrap */
+
+  TX_RING_BARRIER();
+  if (n > used) {
+    n = used;
+  }
+  if (n > max) {
+    n = max;
+  }
+  *p = &r->buf[off];
+  return n;
+}
+
+void tx_ring_release(tx_ring_t* r, uint32_t n) {
+  TX_RING_BARRIER();
+  r->tail += n;
+}
@@ -0,0 +1,75 @@
+/**
+ ******************************************************************************
+ * @file           : uart_tx_hal.c
+ * @brief          : Drains a tx_ring through HAL UART DMA / IT (target only)
+ ******************************************************************************
+ */
+#include "main.h"
+#include "uart_tx.h"
+
+/* Start the next span if nothing is in flight. Caller keeps the TX
+ * complete interrupt out (IRQs masked, or already inside it). */
+static void uart_tx_kick(uart_tx_t* t) {
+  const uint8_t* p;
+  uint32_t n;
+  HAL_StatusTypeDef st;
+
+  if (t->in_flight != 0U) {
+    return;
+  }
+  n = tx_ring_claim(&t->ring, &p, UART_TX_MAX_CHUNK);
+  if (n == 0U) {
+    return;
+  }
+  t->in_flight = n;
+  if (t->huart->hdmatx != NULL) {
+    st = HAL_UART_Transmit_DMA(t->huart, (uint8_t*) p, (uint16_t) n);
+  } else {
+    st = HAL_UART_Transmit_IT(t->huart, (uint8_t*) p, (uint16_t) n);
+  }
+  if (st != HAL_OK) {
+    t->in_flight = 0; /* data stays queued, the next write retries */
+    t->errors++;
+  }
+}
+
+HAL_StatusTypeDef uart_tx_init(uart_tx_t* t,
+                               UART_HandleTypeDef* huart,
+                               uint8_t* buf,
+                               uint32_t size) {
+  t->huart = huart;
+  t->in_flight = 0;
+  t->errors = 0;
+  return (tx_ring_init(&t->ring, buf, size) == 0) ? HAL_OK : HAL_ERROR;
+}
+
+uint32_t uart_tx_write(uart_tx_t* t, const void* data, uint32_t len) {
+  uint32_t queued = tx_ring_write(&t->ring, data, len);
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq(); /* a TX complete between the check and the start */
+  uart_tx_kick(t);
+  __set_PRIMASK(primask);
+  return queued;
+}
+
+void uart_tx_cplt_isr(uart_tx_t* t) {
+  tx_ring_release(&t->ring, t->in_flight);
+  t->in_flight = 0;
+  uart_tx_kick(t);
+}
+
+HAL_StatusTypeDef uart_tx_flush(uart_tx_t* t, uint32_t timeout_ms) {
+  uint32_t start = HAL_GetTick();
+
+  while (tx_ring_used(&t->ring) != 0U) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq(); /* restarts a span the HAL refused earlier */
+    uart_tx_kick(t);
+    __set_PRIMASK(primask);
+    if ((HAL_GetTick() - start) >= timeout_ms) {
+      return HAL_TIMEOUT;
+    }
+  }
+  return HAL_OK;
+}
@@ -0,0 +1,59 @@
+/**
+ ******************************************************************************
+ * @file           : vdda_comp.c
+ * @brief          : VDDA from VREFINT and ratiometric correction of ADC codes
+ ******************************************************************************
+ */
+#include "vdda_comp.h"
+
+#if defined(__ARM_FEATURE_SAT) && __ARM_FEATURE_SAT
+#include <arm_acle.h>
+#define VDDA_COMP_USAT16(x) ((uint32_t) __usat((int32_t) (x), 16))
+#else
+#define VDDA_COMP_USAT16(x) (((x) > 0xFFFFU) ? 0xFFFFU : (x))
+#endif
+
+void vdda_comp_init(vdda_comp_t* v, uint16_t vrefint_cal) {
+  v->vrefint_cal = vrefint_cal;
+  v->vdda_mv = VDDA_COMP_CAL_MV;
+  v->k_q16 = 1UL << 16;
+}
+
+uint32_t vdda_comp_block(vdda_comp_t* v,
+                         const uint16_t* scan,
+                         uint32_t pairs,
+                         uint16_t* ts_out) {
+  uint32_t vref_sum = 0;
+  uint32_t k;
+  uint32_t kq;
+  uint32_t sh;
+  uint32_t half;
+
+  for (uint32_t i = 0; i < pairs; i++) {
+    vref_sum += scan[2U * i + 1U];
+  }
+  if (pairs == 0U || vref_sum < pairs) {
+    return 0; /* VREFINT not converted (disabled / not ready): mean below 1 */
+  }
+
+  /* cal / mean = cal * pairs / sum: one division per block */
+  k = (uint32_t) (((((uint64_t) v->vrefint_cal * pairs) << 16) + vref_sum / 2U) / vref_sum);
+  v->k_q16 = k;
+  v->vdda_mv = (uint32_t) (((uint64_t) VDDA_COMP_CAL_MV * k + 32768U) >> 16);
+
+  /* k in the finest Q format whose product with a 16-bit code, rounding
+   * included, stays in 32 bits (kq <= 2^16): Q16 up to VDDA = 3.3 V, Q15
+   * up to 6.6 V. The per-sample pass is then MUL, add, shift, USAT. */
+  sh = 16U;
+  kq = k;
+  while (kq > 0x10000UL) {
+    sh--;
+    kq = (k + (1UL << (15U - sh))) >> (16U - sh);
+  }
+  half = (1UL << sh) >> 1;
+  for (uint32_t i = 0; i < pairs; i++) {
+    uint32_t c = ((uint32_t) scan[2U * i] * kq + half) >> sh;
+    ts_out[i] = (uint16_t) VDDA_COMP_USAT16(c);
+  }
+  return v->vdda_mv;
+}
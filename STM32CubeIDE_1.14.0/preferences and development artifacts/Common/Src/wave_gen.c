@@ -0,0 +1,365 @@
+/**
+ ******************************************************************************
+ * @file           : wave_gen.c
+ * @brief          : Waveform engine for a circular, timer-paced DAC DMA
+ ******************************************************************************
+ */
+#include "wave_gen.h"
+
+/* Keep the table stores ahead of the pending flag (same core as the ISR) */
+#define WAVE_GEN_BARRIER() __asm volatile("" ::: "memory")
+
+/* Generated flash table of a shape, 0 for the computed ones */
+static const uint16_t* wave_gen_flash(uint32_t shape) {
+  switch (shape) {
+    case WAVE_SINE:
+      return wave_table_sine;
+    case WAVE_BURST:
+      return wave_table_burst;
+    case WAVE_GAUSS:
+      return wave_table_gauss;
+    case WAVE_SINC:
+      return wave_table_sinc;
+    default:
+      return 0;
+  }
+}
+
+/* Played straight from flash: no copy, no RAM table */
+static int32_t wave_gen_in_place(const wave_cfg_t* c) {
+  return (wave_gen_flash(c->shape) != 0) && c->len == WAVE_TABLES_N &&
+         c->lo == 0U && c->hi == WAVE_TABLES_FULL &&
+         WAVE_TABLES_FULL == WAVE_GEN_CODE_MAX;
+}
+
+static int32_t wave_gen_valid(const wave_cfg_t* c) {
+  if (c->shape >= WAVE_SHAPES || c->len < 2U || c->lo > c->hi ||
+      c->hi > WAVE_GEN_CODE_MAX) {
+    return 0;
+  }
+  if (c->len > WAVE_GEN_TABLE_MAX && !wave_gen_in_place(c)) {
+    return 0;
+  }
+  if (c->shape == WAVE_SQUARE && c->duty > c->len) {
+    return 0;
+  }
+  return (c->shape != WAVE_ARB) || (c->arb != 0);
+}
+
+/* n entries from a flash table: linear interpolation at i * N / n in Q16
+ * (position stepped with an exact remainder, no division per entry),
+ * scaled from 0..WAVE_TABLES_FULL to lo..hi by a Q32 factor, rounded.
+ * Exact table entries when n divides WAVE_TABLES_N. */
+static void wave_gen_resample(const uint16_t* src, const wave_cfg_t* c,
+                              uint16_t* out) {
+  uint32_t n = c->len;
+  uint32_t span = (uint32_t) c->hi - c->lo;
+  uint32_t step = (WAVE_TABLES_N << 16) / n;
+  uint32_t rem = (WAVE_TABLES_N << 16) % n;
+  uint32_t scale = (span >= WAVE_TABLES_FULL)
+                       ? 0U
+                       : (uint32_t) (((uint64_t) span << 32) / WAVE_TABLES_FULL);
+  uint32_t pos = 0;
+  uint32_t acc = 0;
+
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t k = pos >> 16;
+    int32_t a = src[k];
+    int32_t b = src[(k + 1U) & (WAVE_TABLES_N - 1U)];
+    uint32_t v = (uint32_t) ((a << 16) + (b - a) * (int32_t) (pos & 0xFFFFU));
+
+    if (scale != 0U) {
+      v = (uint32_t) (((uint64_t) v * scale) >> 32);
+    }
+    out[i] = (uint16_t) (c->lo + ((v + 32768U) >> 16));
+    pos += step;
+    acc += rem;
+    if (acc >= n) {
+      acc -= n;
+      pos++;
+    }
+  }
+}
+
+/* One period of c into t, main loop only */
+static void wave_gen_render(wave_table_t* t, uint16_t* ram,
+                            const wave_cfg_t* c) {
+  uint32_t n = c->len;
+  uint32_t span = (uint32_t) c->hi - c->lo;
+  const uint16_t* src = wave_gen_flash(c->shape);
+
+  t->len = n;
+  t->cfg = *c;
+  t->cfg.arb = 0;
+  if (wave_gen_in_place(c)) {
+    t->code = src;
+    return;
+  }
+  if (src != 0) {
+    wave_gen_resample(src, c, ram);
+    t->code = ram;
+    return;
+  }
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t v;
+
+    switch (c->shape) {
+      case WAVE_TRIANGLE: /* lo at 0, hi at n/2 */
+        v = (2U * i <= n) ? c->lo + (2U * i * span) / n
+                          : c->lo + (2U * (n - i) * span) / n;
+        break;
+      case WAVE_SQUARE:
+        v = (i < c->duty) ? c->hi : c->lo;
+        break;
+      case WAVE_SAW: /* lo .. hi over the period */
+        v = c->lo + (i * span) / (n - 1U);
+        break;
+      default: /* WAVE_ARB */
+        v = (c->arb[i] > WAVE_GEN_CODE_MAX) ? WAVE_GEN_CODE_MAX : c->arb[i];
+        break;
+    }
+    ram[i] = (uint16_t) v;
+  }
+  t->code = ram;
+}
+
+int32_t wave_gen_init(wave_gen_t* g, const wave_cfg_t* cfg) {
+  int32_t ok = wave_gen_valid(cfg);
+
+  g->active = 0;
+  g->pending = 0;
+  g->idx = 0;
+  g->swaps = 0;
+  g->refused = 0;
+  g->tw = 0;
+  g->phase = 0;
+  g->dds = 0;
+  g->ch2_mode = WAVE_CH2_PHASE;
+  g->ch2_offset = 0;
+  if (ok) {
+    wave_gen_render(&g->tab[0], g->ram[0], cfg);
+  } else {
+    g->ram[0][0] = (WAVE_GEN_CODE_MAX + 1U) / 2U;
+    g->ram[0][1] = (WAVE_GEN_CODE_MAX + 1U) / 2U;
+    g->tab[0].code = g->ram[0];
+    g->tab[0].len = 2;
+  }
+  g->tab[1].code = g->ram[1];
+  g->tab[1].len = 0;
+  return ok ? 0 : -2;
+}
+
+int32_t wave_gen_build(wave_gen_t* g, const wave_cfg_t* cfg) {
+  if (!wave_gen_valid(cfg)) {
+    return -2;
+  }
+  if (g->pending) {
+    g->refused++; /* the idle table is committed, the ISR may switch to it */
+    return -1;
+  }
+  wave_gen_render(&g->tab[g->active ^ 1U], g->ram[g->active ^ 1U], cfg);
+  WAVE_GEN_BARRIER();
+  g->pending = 1;
+  return 0;
+}
+
+uint32_t wave_gen_tuning(uint32_t fs_hz, uint64_t f_uhz) {
+  /* f * 2^32 / (fs * 10^6) = f * 2^26 / (fs * 15625): 64 bits while
+   * f < 2^38 uHz (274 kHz); f >= fs is not a tone */
+  uint64_t den = (uint64_t) fs_hz * 15625U;
+
+  if (fs_hz == 0U || f_uhz >= (uint64_t) fs_hz * 1000000U ||
+      f_uhz >= (1ULL << 38)) {
+    return 0;
+  }
+  return (uint32_t) (((f_uhz << 26) + den / 2U) / den);
+}
+
+void wave_gen_set_tuning(wave_gen_t* g, uint32_t tw) {
+  g->tw = tw; /* one word store, picked up by the next fill */
+}
+
+void wave_gen_set_ch2(wave_gen_t* g, uint32_t mode, uint32_t offset) {
+  if (mode < WAVE_CH2_MODES) {
+    g->ch2_offset = offset;
+    g->ch2_mode = mode;
+  }
+}
+
+/* CH2 code of a dual word from CH1's code c1, or the offset entry c2 */
+static inline uint32_t wave_gen_ch2(uint32_t mode, uint32_t c1, uint32_t c2) {
+  return (mode == WAVE_CH2_INVERT) ? WAVE_GEN_CODE_MAX - c1 : c2;
+}
+
+/* DDS: n samples from the active table, committed table at the phase wrap.
+ * Codes into out16, or packed CH1 | CH2 words into out32 when that is set. */
+static void wave_gen_fill_dds(wave_gen_t* g, uint32_t tw, uint16_t* out16,
+                              uint32_t* out32, uint32_t n) {
+  const wave_table_t* t = &g->tab[g->active];
+  uint32_t phase = g->phase;
+  uint32_t mode = g->ch2_mode;
+  uint32_t off = g->ch2_offset;
+
+  while (n > 0U) {
+    uint32_t run = n;
+    uint32_t len = t->len;
+    uint32_t swap = 0;
+
+    if (g->pending) {
+      /* steps until phase + k * tw passes 2^32 (0: 2^32 steps, tw 1) */
+      uint32_t to_wrap = (~phase) / tw + 1U;
+      if (to_wrap != 0U && to_wrap <= n) {
+        run = to_wrap;
+        swap = 1;
+      }
+    }
+    if (out32 == 0) {
+      for (uint32_t i = 0; i < run; i++) {
+        out16[i] = t->code[(uint32_t) (((uint64_t) phase * len) >> 32)];
+        phase += tw;
+      }
+      out16 += run;
+    } else {
+      for (uint32_t i = 0; i < run; i++) {
+        uint32_t c1 = t->code[(uint32_t) (((uint64_t) phase * len) >> 32)];
+        uint32_t c2 =
+            t->code[(uint32_t) (((uint64_t) (uint32_t) (phase + off) * len) >> 32)];
+        out32[i] = WAVE_GEN_PACK(c1, wave_gen_ch2(mode, c1, c2));
+        phase += tw;
+      }
+      out32 += run;
+    }
+    n -= run;
+    if (swap) {
+      g->active ^= 1U; /* wrapped on the last step: new period, new table */
+      g->pending = 0;
+      g->swaps++;
+      t = &g->tab[g->active];
+    }
+  }
+  g->phase = phase;
+}
+
+/* Step mode: one table entry per sample, committed table at index 0. CH2
+ * reads lead = offset * len / 2^32 entries ahead, modulo len. */
+static void wave_gen_fill_step(wave_gen_t* g, uint16_t* out16,
+                               uint32_t* out32, uint32_t n) {
+  const wave_table_t* t = &g->tab[g->active];
+  uint32_t idx = g->idx;
+  uint32_t mode = g->ch2_mode;
+  uint32_t off = g->ch2_offset;
+
+  while (n > 0U) {
+    uint32_t run;
+
+    if (idx == 0U && g->pending) {
+      g->active ^= 1U; /* period boundary: switch without a tear */
+      g->pending = 0;
+      g->swaps++;
+      t = &g->tab[g->active];
+    }
+    run = t->len - idx;
+    if (run > n) {
+      run = n;
+    }
+    if (out32 == 0) {
+      for (uint32_t i = 0; i < run; i++) {
+        out16[i] = t->code[idx + i];
+      }
+      out16 += run;
+    } else {
+      uint32_t j = idx + (uint32_t) (((uint64_t) off * t->len) >> 32);
+
+      for (uint32_t i = 0; i < run; i++, j++) {
+        uint32_t c1 = t->code[idx + i];
+
+        if (j >= t->len) {
+          j -= t->len;
+        }
+        out32[i] = WAVE_GEN_PACK(c1, wave_gen_ch2(mode, c1, t->code[j]));
+      }
+      out32 += run;
+    }
+    n -= run;
+    idx += run;
+    if (idx >= t->len) {
+      idx = 0;
+    }
+  }
+  g->idx = idx;
+}
+
+static void wave_gen_fill_any(wave_gen_t* g, uint16_t* out16, uint32_t* out32,
+                              uint32_t n) {
+  uint32_t tw = g->tw;
+
+  /* mode change: carry the position over so the phase stays continuous */
+  if ((tw != 0U) != (g->dds != 0U)) {
+    uint32_t len = g->tab[g->active].len;
+    if (tw != 0U) {
+      g->phase = (uint32_t) (((uint64_t) g->idx << 32) / len);
+    } else {
+      g->idx = (uint32_t) (((uint64_t) g->phase * len) >> 32);
+    }
+    g->dds = (tw != 0U);
+  }
+  if (tw != 0U) {
+    wave_gen_fill_dds(g, tw, out16, out32, n);
+  } else {
+    wave_gen_fill_step(g, out16, out32, n);
+  }
+}
+
+void wave_gen_fill(wave_gen_t* g, uint16_t* out, uint32_t n) {
+  wave_gen_fill_any(g, out, 0, n);
+}
+
+void wave_gen_fill_dual(wave_gen_t* g, uint32_t* out, uint32_t n) {
+  wave_gen_fill_any(g, 0, out, n);
+}
+
+/* DDS with a tuning word per sample: the wrap shows as a carry */
+static void wave_gen_fill_fm(wave_gen_t* g, const uint32_t* tw,
+                             uint16_t* out16, uint32_t* out32, uint32_t n) {
+  const wave_table_t* t = &g->tab[g->active];
+  uint32_t phase;
+  uint32_t mode = g->ch2_mode;
+  uint32_t off = g->ch2_offset;
+
+  if (!g->dds) {
+    g->phase = (uint32_t) (((uint64_t) g->idx << 32) / t->len);
+    g->dds = 1;
+  }
+  phase = g->phase;
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t len = t->len;
+    uint32_t next = phase + tw[i];
+    uint32_t c1 = t->code[(uint32_t) (((uint64_t) phase * len) >> 32)];
+
+    if (out32 == 0) {
+      out16[i] = (uint16_t) c1;
+    } else {
+      uint32_t c2 =
+          t->code[(uint32_t) (((uint64_t) (uint32_t) (phase + off) * len) >> 32)];
+      out32[i] = WAVE_GEN_PACK(c1, wave_gen_ch2(mode, c1, c2));
+    }
+    if (next < phase && g->pending) {
+      g->active ^= 1U; /* this step wrapped: new period, new table */
+      g->pending = 0;
+      g->swaps++;
+      t = &g->tab[g->active];
+    }
+    phase = next;
+  }
+  g->phase = phase;
+}
+
+void wave_gen_fill_tw(wave_gen_t* g, const uint32_t* tw, uint16_t* out,
+                      uint32_t n) {
+  wave_gen_fill_fm(g, tw, out, 0, n);
+}
+
+void wave_gen_fill_tw_dual(wave_gen_t* g, const uint32_t* tw, uint32_t* out,
+                           uint32_t n) {
+  wave_gen_fill_fm(g, tw, 0, out, n);
+}
@@ -0,0 +1,193 @@
+/**
+ ******************************************************************************
+ * @file           : wave_mod.c
+ * @brief          : Streaming AM / FM / sweep / envelope stage for wave_gen
+ ******************************************************************************
+ */
+#include "wave_mod.h"
+
+#include "wave_tables.h"
+
+/* Keep the cfg stores ahead of the seq bump (same core as the ISR) */
+#define WAVE_MOD_BARRIER() __asm volatile("" ::: "memory")
+
+#define WAVE_MOD_TOP 0xFFFFFFFFU /* ramp_acc at m = 1 */
+
+/* Q16 code of the flash sine -> m in Q16: x 2^32 / full scale, >> 32 */
+#define WAVE_MOD_PER_CODE ((uint32_t) ((1ULL << 32) / WAVE_TABLES_FULL))
+
+static int32_t wave_mod_valid(const wave_mod_cfg_t* c) {
+  if (c->src >= WAVE_MOD_SRCS || c->dst >= WAVE_MOD_DSTS) {
+    return 0;
+  }
+  if (c->src == WAVE_MOD_RAMP && (c->period == 0U || c->rise > c->period)) {
+    return 0;
+  }
+  if (c->dst == WAVE_MOD_AMPLITUDE) {
+    return c->a <= WAVE_MOD_GAIN_MAX && c->b <= WAVE_MOD_GAIN_MAX &&
+           c->center <= WAVE_GEN_CODE_MAX;
+  }
+  /* a tuning word of 0 would stop the carrier */
+  return (c->src == WAVE_MOD_OFF) || (c->a != 0U && c->b != 0U);
+}
+
+void wave_mod_init(wave_mod_t* m) {
+  m->cfg[0].src = WAVE_MOD_OFF;
+  m->cfg[1].src = WAVE_MOD_OFF;
+  m->seq = 0;
+  m->seen = 0;
+  m->lfo_phase = 0;
+  m->ramp_pos = 0;
+  m->ramp_acc = 0;
+  m->ramp_up = 0;
+  m->ramp_down = 0;
+}
+
+int32_t wave_mod_set(wave_mod_t* m, const wave_mod_cfg_t* cfg) {
+  uint32_t next = m->seq + 1U;
+
+  if (!wave_mod_valid(cfg)) {
+    return -2;
+  }
+  m->cfg[next & 1U] = *cfg; /* the ISR reads cfg[seq & 1], not this one */
+  WAVE_MOD_BARRIER();
+  m->seq = next;
+  return 0;
+}
+
+/* Source state for a new cfg (ISR, once per set: the divisions live here) */
+static void wave_mod_restart(wave_mod_t* m, const wave_mod_cfg_t* c) {
+  m->lfo_phase = 0;
+  m->ramp_pos = 0;
+  if (c->src == WAVE_MOD_RAMP) {
+    m->ramp_up = (c->rise != 0U) ? WAVE_MOD_TOP / c->rise : 0U;
+    m->ramp_down =
+        (c->period > c->rise) ? WAVE_MOD_TOP / (c->period - c->rise) : 0U;
+    m->ramp_acc = (c->rise != 0U) ? 0U : WAVE_MOD_TOP;
+  }
+}
+
+/* n values of m (Q16, 0..65535) */
+static void wave_mod_source(wave_mod_t* m, const wave_mod_cfg_t* c,
+                            uint32_t* mq, uint32_t n) {
+  if (c->src == WAVE_MOD_LFO) {
+    uint32_t ph = m->lfo_phase;
+
+    for (uint32_t i = 0; i < n; i++) {
+      /* table position in Q16, linear interpolation between entries */
+      uint32_t pos = (uint32_t) (((uint64_t) ph * WAVE_TABLES_N) >> 16);
+      uint32_t k = pos >> 16;
+      int32_t a = wave_table_sine[k];
+      int32_t b = wave_table_sine[(k + 1U) & (WAVE_TABLES_N - 1U)];
+      uint32_t v = (uint32_t) ((a << 16) + (b - a) * (int32_t) (pos & 0xFFFFU));
+      uint32_t q = (uint32_t) (((uint64_t) v * WAVE_MOD_PER_CODE) >> 32);
+
+      mq[i] = (q > 0xFFFFU) ? 0xFFFFU : q;
+      ph += c->lfo_tw;
+    }
+    m->lfo_phase = ph;
+  } else {
+    uint32_t pos = m->ramp_pos;
+    uint32_t acc = m->ramp_acc;
+
+    for (uint32_t i = 0; i < n; i++) {
+      mq[i] = acc >> 16;
+      pos++;
+      if (pos >= c->period) {
+        pos = 0;
+        acc = (c->rise != 0U) ? 0U : WAVE_MOD_TOP;
+      } else if (pos < c->rise) {
+        acc += m->ramp_up;
+      } else if (pos == c->rise) {
+        acc = WAVE_MOD_TOP; /* no rounding drift into the fall */
+      } else {
+        acc -= m->ramp_down;
+      }
+    }
+    m->ramp_pos = pos;
+    m->ramp_acc = acc;
+  }
+}
+
+/* a + (b - a) * m, m in Q16 */
+static inline uint32_t wave_mod_lerp(const wave_mod_cfg_t* c, uint32_t mq) {
+  return c->a + (uint32_t) (((int64_t) c->b - (int64_t) c->a) * mq >> 16);
+}
+
+/* code scaled by a Q16 gain about center, rounded (arithmetic shift),
+ * clamped to 12 bits */
+static inline uint32_t wave_mod_scale(uint32_t code, int32_t center,
+                                      int32_t gain) {
+  int32_t v = center + ((((int32_t) code - center) * gain + 32768) >> 16);
+
+  if (v < 0) {
+    return 0;
+  }
+  return (v > (int32_t) WAVE_GEN_CODE_MAX) ? WAVE_GEN_CODE_MAX : (uint32_t) v;
+}
+
+static void wave_mod_run(wave_mod_t* m, wave_gen_t* g, uint16_t* out16,
+                         uint32_t* out32, uint32_t n) {
+  uint32_t s = m->seq;
+  const wave_mod_cfg_t* c = &m->cfg[s & 1U];
+  uint32_t mq[WAVE_MOD_CHUNK];
+
+  if (s != m->seen) {
+    wave_mod_restart(m, c);
+    m->seen = s;
+  }
+  if (c->src == WAVE_MOD_OFF) {
+    if (out32 == 0) {
+      wave_gen_fill(g, out16, n);
+    } else {
+      wave_gen_fill_dual(g, out32, n);
+    }
+    return;
+  }
+  while (n > 0U) {
+    uint32_t run = (n > WAVE_MOD_CHUNK) ? WAVE_MOD_CHUNK : n;
+
+    wave_mod_source(m, c, mq, run);
+    if (c->dst == WAVE_MOD_FREQUENCY) {
+      for (uint32_t i = 0; i < run; i++) {
+        mq[i] = wave_mod_lerp(c, mq[i]); /* tuning word, in place */
+      }
+      if (out32 == 0) {
+        wave_gen_fill_tw(g, mq, out16, run);
+      } else {
+        wave_gen_fill_tw_dual(g, mq, out32, run);
+      }
+    } else if (out32 == 0) {
+      wave_gen_fill(g, out16, run);
+      for (uint32_t i = 0; i < run; i++) {
+        out16[i] = (uint16_t) wave_mod_scale(
+            out16[i], (int32_t) c->center, (int32_t) wave_mod_lerp(c, mq[i]));
+      }
+    } else {
+      wave_gen_fill_dual(g, out32, run);
+      for (uint32_t i = 0; i < run; i++) {
+        int32_t gain = (int32_t) wave_mod_lerp(c, mq[i]);
+        uint32_t w = out32[i];
+
+        out32[i] = WAVE_GEN_PACK(
+            wave_mod_scale(w & 0xFFFFU, (int32_t) c->center, gain),
+            wave_mod_scale(w >> 16, (int32_t) c->center, gain));
+      }
+    }
+    if (out32 == 0) {
+      out16 += run;
+    } else {
+      out32 += run;
+    }
+    n -= run;
+  }
+}
+
+void wave_mod_fill(wave_mod_t* m, wave_gen_t* g, uint16_t* out, uint32_t n) {
+  wave_mod_run(m, g, out, 0, n);
+}
+
+void wave_mod_fill_dual(wave_mod_t* m, wave_gen_t* g, uint32_t* out,
+                        uint32_t n) {
+  wave_mod_run(m, g, 0, out, n);
+}
@@ -0,0 +1,431 @@
+/**
+ ******************************************************************************
+ * @file           : wave_tables.c
+ * @brief          : Waveform tables in flash (generated, do not edit)
+ ******************************************************************************
+ */
+#include "wave_tables.h"
+
+const uint16_t wave_table_sine[WAVE_TABLES_N] = {
+     2048,  2060,  2073,  2085,  2098,  2110,  2123,  2135,  2148,  2161,
+     2173,  2186,  2198,  2211,  2223,  2236,  2248,  2261,  2273,  2286,
+     2298,  2311,  2323,  2335,  2348,  2360,  2373,  2385,  2398,  2410,
+     2422,  2435,  2447,  2459,  2472,  2484,  2496,  2508,  2521,  2533,
+     2545,  2557,  2569,  2581,  2594,  2606,  2618,  2630,  2642,  2654,
+     2666,  2678,  2690,  2702,  2714,  2725,  2737,  2749,  2761,  2773,
+     2784,  2796,  2808,  2819,  2831,  2843,  2854,  2866,  2877,  2889,
+     2900,  2912,  2923,  2934,  2946,  2957,  2968,  2979,  2990,  3002,
+     3013,  3024,  3035,  3046,  3057,  3068,  3078,  3089,  3100,  3111,
+     3122,  3132,  3143,  3154,  3164,  3175,  3185,  3195,  3206,  3216,
+     3226,  3237,  3247,  3257,  3267,  3277,  3287,  3297,  3307,  3317,
+     3327,  3337,  3346,  3356,  3366,  3375,  3385,  3394,  3404,  3413,
+     3423,  3432,  3441,  3450,  3459,  3468,  3477,  3486,  3495,  3504,
+     3513,  3522,  3530,  3539,  3548,  3556,  3565,  3573,  3581,  3590,
+     3598,  3606,  3614,  3622,  3630,  3638,  3646,  3654,  3662,  3669,
+     3677,  3685,  3692,  3700,  3707,  3714,  3722,  3729,  3736,  3743,
+     3750,  3757,  3764,  3771,  3777,  3784,  3791,  3797,  3804,  3810,
+     3816,  3823,  3829,  3835,  3841,  3847,  3853,  3859,  3865,  3871,
+     3876,  3882,  3888,  3893,  3898,  3904,  3909,  3914,  3919,  3924,
+     3929,  3934,  3939,  3944,  3949,  3953,  3958,  3962,  3967,  3971,
+     3975,  3980,  3984,  3988,  3992,  3996,  3999,  4003,  4007,  4010,
+     4014,  4017,  4021,  4024,  4027,  4031,  4034,  4037,  4040,  4042,
+     4045,  4048,  4051,  4053,  4056,  4058,  4060,  4063,  4065,  4067,
+     4069,  4071,  4073,  4075,  4076,  4078,  4080,  4081,  4083,  4084,
+     4085,  4086,  4087,  4088,  4089,  4090,  4091,  4092,  4093,  4093,
+     4094,  4094,  4094,  4095,  4095,  4095,  4095,  4095,  4095,  4095,
+     4094,  4094,  4094,  4093,  4093,  4092,  4091,  4090,  4089,  4088,
+     4087,  4086,  4085,  4084,  4083,  4081,  4080,  4078,  4076,  4075,
+     4073,  4071,  4069,  4067,  4065,  4063,  4060,  4058,  4056,  4053,
+     4051,  4048,  4045,  4042,  4040,  4037,  4034,  4031,  4027,  4024,
+     4021,  4017,  4014,  4010,  4007,  4003,  3999,  3996,  3992,  3988,
+     3984,  3980,  3975,  3971,  3967,  3962,  3958,  3953,  3949,  3944,
+     3939,  3934,  3929,  3924,  3919,  3914,  3909,  3904,  3898,  3893,
+     3888,  3882,  3876,  3871,  3865,  3859,  3853,  3847,  3841,  3835,
+     3829,  3823,  3816,  3810,  3804,  3797,  3791,  3784,  3777,  3771,
+     3764,  3757,  3750,  3743,  3736,  3729,  3722,  3714,  3707,  3700,
+     3692,  3685,  3677,  3669,  3662,  3654,  3646,  3638,  3630,  3622,
+     3614,  3606,  3598,  3590,  3581,  3573,  3565,  3556,  3548,  3539,
+     3530,  3522,  3513,  3504,  3495,  3486,  3477,  3468,  3459,  3450,
+     3441,  3432,  3423,  3413,  3404,  3394,  3385,  3375,  3366,  3356,
+     3346,  3337,  3327,  3317,  3307,  3297,  3287,  3277,  3267,  3257,
+     3247,  3237,  3226,  3216,  3206,  3195,  3185,  3175,  3164,  3154,
+     3143,  3132,  3122,  3111,  3100,  3089,  3078,  3068,  3057,  3046,
+     3035,  3024,  3013,  3002,  2990,  2979,  2968,  2957,  2946,  2934,
+     2923,  2912,  2900,  2889,  2877,  2866,  2854,  2843,  2831,  2819,
+     2808,  2796,  2784,  2773,  2761,  2749,  2737,  2725,  2714,  2702,
+     2690,  2678,  2666,  2654,  2642,  2630,  2618,  2606,  2594,  2581,
+     2569,  2557,  2545,  2533,  2521,  2508,  2496,  2484,  2472,  2459,
+     2447,  2435,  2422,  2410,  2398,  2385,  2373,  2360,  2348,  2335,
+     2323,  2311,  2298,  2286,  2273,  2261,  2248,  2236,  2223,  2211,
+     2198,  2186,  2173,  2161,  2148,  2135,  2123,  2110,  2098,  2085,
+     2073,  2060,  2048,  2035,  2022,  2010,  1997,  1985,  1972,  1960,
+     1947,  1934,  1922,  1909,  1897,  1884,  1872,  1859,  1847,  1834,
+     1822,  1809,  1797,  1784,  1772,  1760,  1747,  1735,  1722,  1710,
+     1697,  1685,  1673,  1660,  1648,  1636,  1623,  1611,  1599,  1587,
+     1574,  1562,  1550,  1538,  1526,  1514,  1501,  1489,  1477,  1465,
+     1453,  1441,  1429,  1417,  1405,  1393,  1381,  1370,  1358,  1346,
+     1334,  1322,  1311,  1299,  1287,  1276,  1264,  1252,  1241,  1229,
+     1218,  1206,  1195,  1183,  1172,  1161,  1149,  1138,  1127,  1116,
+     1105,  1093,  1082,  1071,  1060,  1049,  1038,  1027,  1017,  1006,
+      995,   984,   973,   963,   952,   941,   931,   920,   910,   900,
+      889,   879,   869,   858,   848,   838,   828,   818,   808,   798,
+      788,   778,   768,   758,   749,   739,   729,   720,   710,   701,
+      691,   682,   672,   663,   654,   645,   636,   627,   618,   609,
+      600,   591,   582,   573,   565,   556,   547,   539,   530,   522,
+      514,   505,   497,   489,   481,   473,   465,   457,   449,   441,
+      433,   426,   418,   410,   403,   395,   388,   381,   373,   366,
+      359,   352,   345,   338,   331,   324,   318,   311,   304,   298,
+      291,   285,   279,   272,   266,   260,   254,   248,   242,   236,
+      230,   224,   219,   213,   207,   202,   197,   191,   186,   181,
+      176,   171,   166,   161,   156,   151,   146,   142,   137,   133,
+      128,   124,   120,   115,   111,   107,   103,    99,    96,    92,
+       88,    85,    81,    78,    74,    71,    68,    64,    61,    58,
+       55,    53,    50,    47,    44,    42,    39,    37,    35,    32,
+       30,    28,    26,    24,    22,    20,    19,    17,    15,    14,
+       12,    11,    10,     9,     8,     7,     6,     5,     4,     3,
+        2,     2,     1,     1,     1,     0,     0,     0,     0,     0,
+        0,     0,     1,     1,     1,     2,     2,     3,     4,     5,
+        6,     7,     8,     9,    10,    11,    12,    14,    15,    17,
+       19,    20,    22,    24,    26,    28,    30,    32,    35,    37,
+       39,    42,    44,    47,    50,    53,    55,    58,    61,    64,
+       68,    71,    74,    78,    81,    85,    88,    92,    96,    99,
+      103,   107,   111,   115,   120,   124,   128,   133,   137,   142,
+      146,   151,   156,   161,   166,   171,   176,   181,   186,   191,
+      197,   202,   207,   213,   219,   224,   230,   236,   242,   248,
+      254,   260,   266,   272,   279,   285,   291,   298,   304,   311,
+      318,   324,   331,   338,   345,   352,   359,   366,   373,   381,
+      388,   395,   403,   410,   418,   426,   433,   441,   449,   457,
+      465,   473,   481,   489,   497,   505,   514,   522,   530,   539,
+      547,   556,   565,   573,   582,   591,   600,   609,   618,   627,
+      636,   645,   654,   663,   672,   682,   691,   701,   710,   720,
+      729,   739,   749,   758,   768,   778,   788,   798,   808,   818,
+      828,   838,   848,   858,   869,   879,   889,   900,   910,   920,
+      931,   941,   952,   963,   973,   984,   995,  1006,  1017,  1027,
+     1038,  1049,  1060,  1071,  1082,  1093,  1105,  1116,  1127,  1138,
+     1149,  1161,  1172,  1183,  1195,  1206,  1218,  1229,  1241,  1252,
+     1264,  1276,  1287,  1299,  1311,  1322,  1334,  1346,  1358,  1370,
+     1381,  1393,  1405,  1417,  1429,  1441,  1453,  1465,  1477,  1489,
+     1501,  1514,  1526,  1538,  1550,  1562,  1574,  1587,  1599,  1611,
+     1623,  1636,  1648,  1660,  1673,  1685,  1697,  1710,  1722,  1735,
+     1747,  1760,  1772,  1784,  1797,  1809,  1822,  1834,  1847,  1859,
+     1872,  1884,  1897,  1909,  1922,  1934,  1947,  1960,  1972,  1985,
+     1997,  2010,  2022,  2035,
+};
+
+const uint16_t wave_table_burst[WAVE_TABLES_N] = {
+     2048,  2048,  2048,  2048,  2048,  2048,  2048,  2048,  2048,  2048,
+     2048,  2049,  2049,  2049,  2050,  2050,  2051,  2052,  2052,  2053,
+     2054,  2055,  2056,  2057,  2058,  2059,  2060,  2061,  2062,  2063,
+     2065,  2066,  2067,  2068,  2070,  2071,  2072,  2073,  2074,  2075,
+     2076,  2077,  2077,  2078,  2078,  2079,  2079,  2079,  2079,  2078,
+     2078,  2077,  2076,  2075,  2074,  2072,  2070,  2068,  2066,  2064,
+     2061,  2058,  2055,  2051,  2048,  2044,  2039,  2035,  2030,  2026,
+     2021,  2015,  2010,  2004,  1999,  1993,  1987,  1981,  1975,  1968,
+     1962,  1956,  1949,  1943,  1937,  1931,  1925,  1919,  1913,  1907,
+     1902,  1897,  1892,  1887,  1883,  1879,  1875,  1872,  1869,  1866,
+     1864,  1863,  1862,  1861,  1861,  1862,  1863,  1865,  1867,  1870,
+     1874,  1878,  1883,  1889,  1895,  1902,  1909,  1918,  1926,  1936,
+     1946,  1957,  1968,  1980,  1992,  2005,  2019,  2033,  2048,  2062,
+     2078,  2093,  2110,  2126,  2142,  2159,  2176,  2193,  2210,  2228,
+     2245,  2262,  2279,  2296,  2312,  2328,  2344,  2360,  2375,  2390,
+     2404,  2417,  2430,  2442,  2453,  2464,  2473,  2482,  2490,  2497,
+     2502,  2507,  2511,  2513,  2514,  2514,  2513,  2511,  2507,  2502,
+     2496,  2488,  2479,  2469,  2457,  2444,  2430,  2415,  2398,  2380,
+     2361,  2340,  2318,  2296,  2272,  2247,  2221,  2194,  2166,  2138,
+     2108,  2078,  2048,  2016,  1984,  1952,  1920,  1887,  1854,  1821,
+     1788,  1755,  1722,  1689,  1657,  1625,  1594,  1564,  1534,  1505,
+     1477,  1449,  1423,  1398,  1375,  1352,  1331,  1312,  1294,  1278,
+     1263,  1251,  1240,  1231,  1223,  1218,  1215,  1214,  1215,  1218,
+     1223,  1231,  1240,  1252,  1266,  1282,  1300,  1321,  1343,  1368,
+     1395,  1423,  1454,  1486,  1521,  1557,  1595,  1634,  1675,  1717,
+     1761,  1806,  1853,  1900,  1948,  1998,  2047,  2098,  2149,  2200,
+     2252,  2304,  2356,  2407,  2458,  2509,  2560,  2609,  2658,  2706,
+     2753,  2798,  2842,  2885,  2926,  2965,  3003,  3038,  3072,  3103,
+     3132,  3159,  3183,  3204,  3223,  3239,  3253,  3263,  3271,  3276,
+     3277,  3276,  3272,  3264,  3254,  3240,  3223,  3203,  3180,  3155,
+     3126,  3094,  3059,  3022,  2982,  2939,  2893,  2845,  2795,  2742,
+     2687,  2630,  2571,  2511,  2448,  2384,  2319,  2253,  2185,  2117,
+     2048,  1978,  1908,  1837,  1767,  1697,  1627,  1557,  1488,  1420,
+     1353,  1287,  1223,  1160,  1099,  1040,   982,   927,   875,   824,
+      777,   732,   690,   651,   615,   583,   554,   528,   506,   488,
+      473,   462,   455,   452,   452,   457,   465,   478,   494,   514,
+      538,   566,   598,   633,   673,   715,   762,   811,   864,   921,
+      980,  1042,  1107,  1175,  1245,  1318,  1393,  1469,  1548,  1628,
+     1710,  1793,  1877,  1962,  2047,  2133,  2220,  2306,  2392,  2477,
+     2562,  2647,  2730,  2811,  2892,  2970,  3047,  3122,  3194,  3264,
+     3331,  3395,  3457,  3515,  3570,  3621,  3669,  3713,  3753,  3789,
+     3821,  3849,  3872,  3892,  3906,  3917,  3922,  3924,  3920,  3912,
+     3900,  3883,  3861,  3835,  3805,  3770,  3730,  3687,  3639,  3588,
+     3532,  3473,  3410,  3343,  3273,  3200,  3124,  3045,  2964,  2880,
+     2793,  2705,  2615,  2523,  2430,  2335,  2240,  2144,  2048,  1951,
+     1854,  1757,  1661,  1566,  1472,  1379,  1287,  1197,  1109,  1022,
+      939,   857,   779,   703,   631,   562,   496,   434,   376,   322,
+      272,   226,   184,   147,   115,    87,    64,    45,    32,    23,
+       20,    21,    27,    38,    54,    75,   101,   131,   166,   206,
+      250,   299,   351,   409,   470,   535,   603,   675,   751,   830,
+      912,   996,  1083,  1173,  1264,  1358,  1453,  1550,  1648,  1747,
+     1847,  1947,  2047,  2148,  2248,  2348,  2447,  2545,  2642,  2737,
+     2831,  2922,  3012,  3099,  3183,  3265,  3344,  3420,  3492,  3560,
+     3625,  3686,  3744,  3796,  3845,  3889,  3929,  3964,  3994,  4020,
+     4041,  4057,  4068,  4074,  4075,  4072,  4063,  4050,  4031,  4008,
+     3980,  3948,  3911,  3869,  3823,  3773,  3719,  3661,  3599,  3533,
+     3464,  3392,  3316,  3238,  3156,  3073,  2986,  2898,  2808,  2716,
+     2623,  2529,  2434,  2338,  2241,  2144,  2048,  1951,  1855,  1760,
+     1665,  1572,  1480,  1390,  1302,  1215,  1131,  1050,   971,   895,
+      822,   752,   685,   622,   563,   507,   456,   408,   365,   325,
+      290,   260,   234,   212,   195,   183,   175,   171,   173,   178,
+      189,   203,   223,   246,   274,   306,   342,   382,   426,   474,
+      525,   580,   638,   700,   764,   831,   901,   973,  1048,  1125,
+     1203,  1284,  1365,  1448,  1533,  1618,  1703,  1789,  1875,  1962,
+     2047,  2133,  2218,  2302,  2385,  2467,  2547,  2626,  2702,  2777,
+     2850,  2920,  2988,  3053,  3115,  3174,  3231,  3284,  3333,  3380,
+     3422,  3462,  3497,  3529,  3557,  3581,  3601,  3617,  3630,  3638,
+     3643,  3643,  3640,  3633,  3622,  3607,  3589,  3567,  3541,  3512,
+     3480,  3444,  3405,  3363,  3318,  3271,  3220,  3168,  3113,  3055,
+     2996,  2935,  2872,  2808,  2742,  2675,  2607,  2538,  2468,  2398,
+     2328,  2258,  2187,  2117,  2048,  1978,  1910,  1842,  1776,  1711,
+     1647,  1584,  1524,  1465,  1408,  1353,  1300,  1250,  1202,  1156,
+     1113,  1073,  1036,  1001,   969,   940,   915,   892,   872,   855,
+      841,   831,   823,   819,   818,   819,   824,   832,   842,   856,
+      872,   891,   912,   936,   963,   992,  1023,  1057,  1092,  1130,
+     1169,  1210,  1253,  1297,  1342,  1389,  1437,  1486,  1535,  1586,
+     1637,  1688,  1739,  1791,  1843,  1895,  1946,  1997,  2047,  2097,
+     2147,  2195,  2242,  2289,  2334,  2378,  2420,  2461,  2500,  2538,
+     2574,  2609,  2641,  2672,  2700,  2727,  2752,  2774,  2795,  2813,
+     2829,  2843,  2855,  2864,  2872,  2877,  2880,  2881,  2880,  2877,
+     2872,  2864,  2855,  2844,  2832,  2817,  2801,  2783,  2764,  2743,
+     2720,  2697,  2672,  2646,  2618,  2590,  2561,  2531,  2501,  2470,
+     2438,  2406,  2373,  2340,  2307,  2274,  2241,  2208,  2175,  2143,
+     2111,  2079,  2047,  2017,  1987,  1957,  1929,  1901,  1874,  1848,
+     1823,  1799,  1777,  1755,  1734,  1715,  1697,  1680,  1665,  1651,
+     1638,  1626,  1616,  1607,  1599,  1593,  1588,  1584,  1582,  1581,
+     1581,  1582,  1584,  1588,  1593,  1598,  1605,  1613,  1622,  1631,
+     1642,  1653,  1665,  1678,  1691,  1705,  1720,  1735,  1751,  1767,
+     1783,  1799,  1816,  1833,  1850,  1867,  1885,  1902,  1919,  1936,
+     1953,  1969,  1985,  2002,  2017,  2033,  2047,  2062,  2076,  2090,
+     2103,  2115,  2127,  2138,  2149,  2159,  2169,  2177,  2186,  2193,
+     2200,  2206,  2212,  2217,  2221,  2225,  2228,  2230,  2232,  2233,
+     2234,  2234,  2233,  2232,  2231,  2229,  2226,  2223,  2220,  2216,
+     2212,  2208,  2203,  2198,  2193,  2188,  2182,  2176,  2170,  2164,
+     2158,  2152,  2146,  2139,  2133,  2127,  2120,  2114,  2108,  2102,
+     2096,  2091,  2085,  2080,  2074,  2069,  2065,  2060,  2056,  2051,
+     2048,  2044,  2040,  2037,  2034,  2031,  2029,  2027,  2025,  2023,
+     2021,  2020,  2019,  2018,  2017,  2017,  2016,  2016,  2016,  2016,
+     2017,  2017,  2018,  2018,  2019,  2020,  2021,  2022,  2023,  2024,
+     2025,  2027,  2028,  2029,  2030,  2032,  2033,  2034,  2035,  2036,
+     2037,  2038,  2039,  2040,  2041,  2042,  2043,  2043,  2044,  2045,
+     2045,  2046,  2046,  2046,  2047,  2047,  2047,  2047,  2047,  2047,
+     2047,  2047,  2047,  2047,
+};
+
+const uint16_t wave_table_gauss[WAVE_TABLES_N] = {
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     1,     1,
+        1,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+        1,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+        1,     1,     1,     1,     1,     2,     2,     2,     2,     2,
+        2,     2,     2,     2,     2,     2,     2,     2,     2,     3,
+        3,     3,     3,     3,     3,     3,     3,     3,     4,     4,
+        4,     4,     4,     4,     5,     5,     5,     5,     5,     5,
+        6,     6,     6,     6,     6,     7,     7,     7,     7,     8,
+        8,     8,     8,     9,     9,     9,    10,    10,    10,    11,
+       11,    12,    12,    12,    13,    13,    14,    14,    15,    15,
+       15,    16,    17,    17,    18,    18,    19,    19,    20,    21,
+       21,    22,    23,    23,    24,    25,    26,    27,    27,    28,
+       29,    30,    31,    32,    33,    34,    35,    36,    37,    38,
+       39,    41,    42,    43,    44,    46,    47,    49,    50,    51,
+       53,    54,    56,    58,    59,    61,    63,    65,    66,    68,
+       70,    72,    74,    76,    78,    81,    83,    85,    87,    90,
+       92,    95,    97,   100,   103,   106,   108,   111,   114,   117,
+      120,   123,   127,   130,   133,   137,   140,   144,   148,   151,
+      155,   159,   163,   167,   171,   176,   180,   184,   189,   194,
+      198,   203,   208,   213,   218,   223,   229,   234,   240,   245,
+      251,   257,   263,   269,   275,   281,   288,   294,   301,   308,
+      315,   322,   329,   336,   343,   351,   359,   366,   374,   382,
+      391,   399,   407,   416,   425,   434,   443,   452,   461,   471,
+      480,   490,   500,   510,   520,   531,   541,   552,   563,   574,
+      585,   596,   608,   620,   632,   644,   656,   668,   681,   693,
+      706,   719,   732,   746,   759,   773,   787,   801,   815,   829,
+      844,   859,   874,   889,   904,   919,   935,   951,   967,   983,
+      999,  1016,  1032,  1049,  1066,  1083,  1101,  1118,  1136,  1154,
+     1172,  1190,  1208,  1227,  1245,  1264,  1283,  1302,  1322,  1341,
+     1361,  1381,  1401,  1421,  1441,  1461,  1482,  1503,  1523,  1544,
+     1566,  1587,  1608,  1630,  1651,  1673,  1695,  1717,  1739,  1762,
+     1784,  1807,  1829,  1852,  1875,  1898,  1921,  1944,  1967,  1990,
+     2014,  2037,  2061,  2084,  2108,  2132,  2156,  2180,  2204,  2228,
+     2252,  2276,  2300,  2324,  2348,  2372,  2396,  2421,  2445,  2469,
+     2493,  2518,  2542,  2566,  2590,  2615,  2639,  2663,  2687,  2711,
+     2735,  2759,  2783,  2807,  2831,  2854,  2878,  2902,  2925,  2948,
+     2972,  2995,  3018,  3041,  3064,  3087,  3109,  3132,  3154,  3176,
+     3198,  3220,  3242,  3263,  3285,  3306,  3327,  3348,  3368,  3389,
+     3409,  3429,  3449,  3469,  3488,  3507,  3526,  3545,  3563,  3582,
+     3600,  3617,  3635,  3652,  3669,  3686,  3702,  3718,  3734,  3749,
+     3765,  3780,  3794,  3809,  3823,  3836,  3850,  3863,  3875,  3888,
+     3900,  3912,  3923,  3934,  3945,  3955,  3965,  3975,  3984,  3993,
+     4002,  4010,  4018,  4025,  4032,  4039,  4045,  4051,  4057,  4062,
+     4067,  4071,  4076,  4079,  4083,  4085,  4088,  4090,  4092,  4093,
+     4094,  4095,  4095,  4095,  4094,  4093,  4092,  4090,  4088,  4085,
+     4083,  4079,  4076,  4071,  4067,  4062,  4057,  4051,  4045,  4039,
+     4032,  4025,  4018,  4010,  4002,  3993,  3984,  3975,  3965,  3955,
+     3945,  3934,  3923,  3912,  3900,  3888,  3875,  3863,  3850,  3836,
+     3823,  3809,  3794,  3780,  3765,  3749,  3734,  3718,  3702,  3686,
+     3669,  3652,  3635,  3617,  3600,  3582,  3563,  3545,  3526,  3507,
+     3488,  3469,  3449,  3429,  3409,  3389,  3368,  3348,  3327,  3306,
+     3285,  3263,  3242,  3220,  3198,  3176,  3154,  3132,  3109,  3087,
+     3064,  3041,  3018,  2995,  2972,  2948,  2925,  2902,  2878,  2854,
+     2831,  2807,  2783,  2759,  2735,  2711,  2687,  2663,  2639,  2615,
+     2590,  2566,  2542,  2518,  2493,  2469,  2445,  2421,  2396,  2372,
+     2348,  2324,  2300,  2276,  2252,  2228,  2204,  2180,  2156,  2132,
+     2108,  2084,  2061,  2037,  2014,  1990,  1967,  1944,  1921,  1898,
+     1875,  1852,  1829,  1807,  1784,  1762,  1739,  1717,  1695,  1673,
+     1651,  1630,  1608,  1587,  1566,  1544,  1523,  1503,  1482,  1461,
+     1441,  1421,  1401,  1381,  1361,  1341,  1322,  1302,  1283,  1264,
+     1245,  1227,  1208,  1190,  1172,  1154,  1136,  1118,  1101,  1083,
+     1066,  1049,  1032,  1016,   999,   983,   967,   951,   935,   919,
+      904,   889,   874,   859,   844,   829,   815,   801,   787,   773,
+      759,   746,   732,   719,   706,   693,   681,   668,   656,   644,
+      632,   620,   608,   596,   585,   574,   563,   552,   541,   531,
+      520,   510,   500,   490,   480,   471,   461,   452,   443,   434,
+      425,   416,   407,   399,   391,   382,   374,   366,   359,   351,
+      343,   336,   329,   322,   315,   308,   301,   294,   288,   281,
+      275,   269,   263,   257,   251,   245,   240,   234,   229,   223,
+      218,   213,   208,   203,   198,   194,   189,   184,   180,   176,
+      171,   167,   163,   159,   155,   151,   148,   144,   140,   137,
+      133,   130,   127,   123,   120,   117,   114,   111,   108,   106,
+      103,   100,    97,    95,    92,    90,    87,    85,    83,    81,
+       78,    76,    74,    72,    70,    68,    66,    65,    63,    61,
+       59,    58,    56,    54,    53,    51,    50,    49,    47,    46,
+       44,    43,    42,    41,    39,    38,    37,    36,    35,    34,
+       33,    32,    31,    30,    29,    28,    27,    27,    26,    25,
+       24,    23,    23,    22,    21,    21,    20,    19,    19,    18,
+       18,    17,    17,    16,    15,    15,    15,    14,    14,    13,
+       13,    12,    12,    12,    11,    11,    10,    10,    10,     9,
+        9,     9,     8,     8,     8,     8,     7,     7,     7,     7,
+        6,     6,     6,     6,     6,     5,     5,     5,     5,     5,
+        5,     4,     4,     4,     4,     4,     4,     3,     3,     3,
+        3,     3,     3,     3,     3,     3,     2,     2,     2,     2,
+        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+        1,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+        1,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+        1,     1,     1,     1,     1,     1,     1,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,
+};
+
+const uint16_t wave_table_sinc[WAVE_TABLES_N] = {
+      731,   724,   718,   711,   704,   698,   691,   684,   678,   671,
+      664,   658,   651,   645,   638,   632,   625,   619,   612,   606,
+      599,   593,   587,   581,   575,   569,   563,   557,   551,   545,
+      540,   534,   529,   524,   518,   513,   508,   503,   499,   494,
+      489,   485,   481,   477,   473,   469,   465,   461,   458,   455,
+      451,   448,   446,   443,   441,   438,   436,   434,   432,   431,
+      429,   428,   427,   426,   425,   424,   424,   424,   424,   424,
+      424,   425,   425,   426,   427,   429,   430,   432,   433,   435,
+      438,   440,   443,   445,   448,   452,   455,   458,   462,   466,
+      470,   474,   479,   483,   488,   493,   498,   503,   508,   514,
+      520,   526,   532,   538,   544,   551,   557,   564,   571,   578,
+      585,   592,   600,   607,   615,   623,   630,   638,   646,   654,
+      663,   671,   679,   688,   696,   705,   713,   722,   731,   740,
+      748,   757,   766,   775,   784,   793,   802,   811,   820,   829,
+      838,   847,   856,   865,   873,   882,   891,   900,   908,   917,
+      925,   934,   942,   951,   959,   967,   975,   983,   991,   999,
+     1006,  1014,  1021,  1028,  1035,  1042,  1049,  1056,  1062,  1068,
+     1075,  1081,  1086,  1092,  1097,  1103,  1108,  1113,  1117,  1122,
+     1126,  1130,  1134,  1137,  1141,  1144,  1147,  1149,  1152,  1154,
+     1156,  1158,  1159,  1160,  1161,  1162,  1162,  1163,  1163,  1162,
+     1162,  1161,  1160,  1158,  1157,  1155,  1153,  1150,  1147,  1144,
+     1141,  1138,  1134,  1130,  1125,  1121,  1116,  1111,  1105,  1100,
+     1094,  1087,  1081,  1074,  1067,  1060,  1053,  1045,  1037,  1029,
+     1020,  1012,  1003,   994,   984,   975,   965,   955,   945,   934,
+      924,   913,   902,   891,   879,   868,   856,   844,   832,   820,
+      808,   795,   782,   770,   757,   744,   731,   718,   704,   691,
+      678,   664,   650,   637,   623,   609,   595,   582,   568,   554,
+      540,   526,   512,   498,   485,   471,   457,   443,   430,   416,
+      403,   389,   376,   363,   349,   336,   324,   311,   298,   286,
+      273,   261,   249,   237,   226,   214,   203,   192,   181,   171,
+      161,   151,   141,   131,   122,   113,   104,    96,    88,    80,
+       73,    65,    59,    52,    46,    40,    35,    30,    25,    21,
+       17,    13,    10,     8,     5,     3,     2,     1,     0,     0,
+        0,     1,     2,     4,     6,     8,    11,    15,    19,    23,
+       28,    33,    39,    46,    52,    60,    68,    76,    85,    94,
+      104,   114,   125,   136,   148,   161,   173,   187,   201,   215,
+      230,   245,   261,   277,   294,   312,   329,   348,   367,   386,
+      406,   426,   447,   468,   489,   512,   534,   557,   581,   605,
+      629,   654,   679,   705,   731,   757,   784,   811,   839,   867,
+      896,   924,   954,   983,  1013,  1043,  1074,  1105,  1136,  1167,
+     1199,  1231,  1264,  1296,  1329,  1362,  1396,  1429,  1463,  1497,
+     1531,  1566,  1600,  1635,  1670,  1705,  1740,  1776,  1811,  1847,
+     1883,  1918,  1954,  1990,  2026,  2062,  2098,  2134,  2170,  2206,
+     2242,  2278,  2314,  2350,  2385,  2421,  2457,  2492,  2528,  2563,
+     2598,  2633,  2668,  2702,  2737,  2771,  2805,  2839,  2873,  2906,
+     2939,  2972,  3004,  3037,  3068,  3100,  3131,  3162,  3193,  3223,
+     3253,  3283,  3312,  3341,  3369,  3397,  3424,  3452,  3478,  3504,
+     3530,  3555,  3580,  3604,  3628,  3651,  3674,  3696,  3718,  3739,
+     3760,  3780,  3799,  3818,  3836,  3854,  3871,  3888,  3904,  3919,
+     3934,  3948,  3962,  3974,  3987,  3998,  4009,  4020,  4029,  4038,
+     4047,  4054,  4061,  4068,  4073,  4078,  4083,  4087,  4090,  4092,
+     4094,  4095,  4095,  4095,  4094,  4092,  4090,  4087,  4083,  4078,
+     4073,  4068,  4061,  4054,  4047,  4038,  4029,  4020,  4009,  3998,
+     3987,  3974,  3962,  3948,  3934,  3919,  3904,  3888,  3871,  3854,
+     3836,  3818,  3799,  3780,  3760,  3739,  3718,  3696,  3674,  3651,
+     3628,  3604,  3580,  3555,  3530,  3504,  3478,  3452,  3424,  3397,
+     3369,  3341,  3312,  3283,  3253,  3223,  3193,  3162,  3131,  3100,
+     3068,  3037,  3004,  2972,  2939,  2906,  2873,  2839,  2805,  2771,
+     2737,  2702,  2668,  2633,  2598,  2563,  2528,  2492,  2457,  2421,
+     2385,  2350,  2314,  2278,  2242,  2206,  2170,  2134,  2098,  2062,
+     2026,  1990,  1954,  1918,  1883,  1847,  1811,  1776,  1740,  1705,
+     1670,  1635,  1600,  1566,  1531,  1497,  1463,  1429,  1396,  1362,
+     1329,  1296,  1264,  1231,  1199,  1167,  1136,  1105,  1074,  1043,
+     1013,   983,   954,   924,   896,   867,   839,   811,   784,   757,
+      731,   705,   679,   654,   629,   605,   581,   557,   534,   512,
+      489,   468,   447,   426,   406,   386,   367,   348,   329,   312,
+      294,   277,   261,   245,   230,   215,   201,   187,   173,   161,
+      148,   136,   125,   114,   104,    94,    85,    76,    68,    60,
+       52,    46,    39,    33,    28,    23,    19,    15,    11,     8,
+        6,     4,     2,     1,     0,     0,     0,     1,     2,     3,
+        5,     8,    10,    13,    17,    21,    25,    30,    35,    40,
+       46,    52,    59,    65,    73,    80,    88,    96,   104,   113,
+      122,   131,   141,   151,   161,   171,   181,   192,   203,   214,
+      226,   237,   249,   261,   273,   286,   298,   311,   324,   336,
+      349,   363,   376,   389,   403,   416,   430,   443,   457,   471,
+      485,   498,   512,   526,   540,   554,   568,   582,   595,   609,
+      623,   637,   650,   664,   678,   691,   704,   718,   731,   744,
+      757,   770,   782,   795,   808,   820,   832,   844,   856,   868,
+      879,   891,   902,   913,   924,   934,   945,   955,   965,   975,
+      984,   994,  1003,  1012,  1020,  1029,  1037,  1045,  1053,  1060,
+     1067,  1074,  1081,  1087,  1094,  1100,  1105,  1111,  1116,  1121,
+     1125,  1130,  1134,  1138,  1141,  1144,  1147,  1150,  1153,  1155,
+     1157,  1158,  1160,  1161,  1162,  1162,  1163,  1163,  1162,  1162,
+     1161,  1160,  1159,  1158,  1156,  1154,  1152,  1149,  1147,  1144,
+     1141,  1137,  1134,  1130,  1126,  1122,  1117,  1113,  1108,  1103,
+     1097,  1092,  1086,  1081,  1075,  1068,  1062,  1056,  1049,  1042,
+     1035,  1028,  1021,  1014,  1006,   999,   991,   983,   975,   967,
+      959,   951,   942,   934,   925,   917,   908,   900,   891,   882,
+      873,   865,   856,   847,   838,   829,   820,   811,   802,   793,
+      784,   775,   766,   757,   748,   740,   731,   722,   713,   705,
+      696,   688,   679,   671,   663,   654,   646,   638,   630,   623,
+      615,   607,   600,   592,   585,   578,   571,   564,   557,   551,
+      544,   538,   532,   526,   520,   514,   508,   503,   498,   493,
+      488,   483,   479,   474,   470,   466,   462,   458,   455,   452,
+      448,   445,   443,   440,   438,   435,   433,   432,   430,   429,
+      427,   426,   425,   425,   424,   424,   424,   424,   424,   424,
+      425,   426,   427,   428,   429,   431,   432,   434,   436,   438,
+      441,   443,   446,   448,   451,   455,   458,   461,   465,   469,
+      473,   477,   481,   485,   489,   494,   499,   503,   508,   513,
+      518,   524,   529,   534,   540,   545,   551,   557,   563,   569,
+      575,   581,   587,   593,   599,   606,   612,   619,   625,   632,
+      638,   645,   651,   658,   664,   671,   678,   684,   691,   698,
+      704,   711,   718,   724,
+};
@@ -2,17 +2,71 @@
 /**
   ******************************************************************************
   * @file           : main.c
-  * @brief          : 1 kHz Sine Wave on DAC1_CH1 (PA4) using TIM6 + DMA
+  * @brief          : Waveform generator on DAC1_CH1 (PA4) using TIM6 + DMA
   ******************************************************************************
+  *
+  * TIM6 TRGO (256 kHz) clocks one code per trigger out of a circular DMA
+  * ping-pong buffer; the DMA callbacks refill each half from the wave_gen
+  * engine (Common/wave_gen) while the other half plays.
+  *
+  * DAC_DUAL 1 adds DAC1_CH2 (PA5) on the same trigger: the buffer holds
+  * packed CH1 | CH2 << 16 words that one DMA stream writes to DHR12RD, so
+  * both channels load on the same TIM6 edge (no inter-channel skew) and
+  * one DMA request serves both, half of what two streams would issue.
+  * CH2 follows CH1 per wave_req_ch2_mode: WAVE_CH2_PHASE leads by
+  * wave_req_ch2_offset / 2^32 of a period (boot: 2^30, I/Q), or
+  * WAVE_CH2_INVERT mirrors CH1 about mid-scale (differential).
+  *
+  * Bench control from the debugger (Live Expressions / memory view):
+  *   1. write wave_req.shape, .len, .lo, .hi, .duty (WAVE_ARB: fill
+  *      wave_arb[0 .. len-1] first)
+  *   2. wave_req_freq_uhz: 0 plays one table entry per sample,
+  *      f_out = 256 kHz / len (len 256 -> 1 kHz); any other value selects
+  *      DDS at that frequency in microhertz (60 uHz steps at 256 kHz)
+  *   3. DAC_DUAL: wave_req_ch2_mode / wave_req_ch2_offset
+  *   4. modulation (Common/wave_mod), mod_req_src 0 = off:
+  *      mod_req_src LFO / RAMP, mod_req_dst AMPLITUDE / FREQUENCY,
+  *      mod_req_lfo_uhz, mod_req_period / mod_req_rise (samples),
+  *      mod_req_a / mod_req_b: Q16 gains (65536 = 1.0) about
+  *      mod_req_center, or carrier frequencies in microhertz
+  *   5. increment wave_req_seq
+  * The main loop builds the new period into the idle table, the output
+  * switches at the next period boundary without stopping the DMA.
+  * wave_req_status: 0 playing, -2 invalid request (an invalid modulation
+  * leaves the previous one running); wave.swaps counts applied changes,
+  * wave_tw / wave_freq_uhz the DDS frequency achieved.
+  *
+  * The modulation runs per sample inside the DMA refills. fill_cycles_max
+  * is the worst refill so far (DWT cycles, write 0 to restart), against
+  * fill_deadline_cycles, the time the DMA takes to play the other half;
+  * fill_late counts refills that overran it.
+  *
+  * Sine, burst, gauss and sinc come from const tables in flash
+  * (Common/wave_tables, generated on the host): no sinf at boot, no libm.
+  * The boot sine plays the WAVE_TABLES_N-entry flash table in place at
+  * 1 kHz in DDS mode (tw = 2^32 / 256, every 4th entry: the same codes a
+  * 256-sample step table would hold); wave_init_cycles is what that costs.
+  *
+  * LOOP_TEST 1 runs a DAC -> ADC loopback self-test at boot, before the
+  * waveform starts (Common/dac_loop, ~7 ms): ADC2 reads DAC1 OUT1 on
+  * its internal channel (LOOP_JUMPER 1: PA4 wired to PA6 instead), both
+  * paced by TIM6. loop_status 0 is a pass, otherwise DAC_LOOP_FAIL_*
+  * bits; loop_result holds gain (Q16), offset and INL (1/256 LSB) of the
+  * LOOP_STEPS-point staircase and the step latency in samples (1/256),
+  * CPU cycles and DWT cycles from the DAC DMA to the ADC DMA interrupt.
+  * It is off by default: it needs HAL_ADC_MODULE_ENABLED, which the .ioc
+  * does not set, and stops the build with an #error without it.
   */
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
-#include <math.h>
 #include "main.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "wave_gen.h"
+#include "wave_mod.h"
+#include "dac_loop.h"
+#include "dwt_cyccnt.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -23,9 +77,28 @@
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
 
-#define SAMPLES     256
+#define SAMPLES     256       /* step-mode period: 256 kHz / 256 = 1 kHz */
+#define BOOT_FREQ_UHZ 1000000000ULL /* 1 kHz boot sine */
 #define DAC_OFFSET  2048      /* 1.65 V */
 #define DAC_AMPL    50      /* ~0.8 V peak */
+#define DAC_HALF    64        /* codes per DMA half: refill every 250 us */
+#define DAC_DUAL    1         /* 1: CH1 + CH2 through DHR12RD, one DMA stream */
+
+#define LOOP_TEST   0         /* 1: DAC -> ADC2 self-test at boot */
+#define LOOP_JUMPER 0         /* 0: on-chip DAC1 OUT1 -> ADC2, 1: PA4 -> PA6 wire */
+#define LOOP_STEPS  17        /* staircase points, LOOP_FIRST .. LOOP_LAST */
+#define LOOP_FIRST  256       /* buffered DAC output: keep off the rails */
+#define LOOP_LAST   3840
+#define LOOP_SETTLE 16        /* samples dropped after each code change */
+#define LOOP_AVG    64        /* samples averaged per code */
+#define LOOP_CAP    128       /* step record, step at element LOOP_CAP / 2 */
+#define LOOP_LO     1024
+#define LOOP_HI     3072
+#define LOOP_NOT_RUN 0xFFFFFFFFU
+
+#if LOOP_TEST && !defined(HAL_ADC_MODULE_ENABLED)
+#error "LOOP_TEST needs HAL_ADC_MODULE_ENABLED in stm32h7xx_hal_conf.h"
+#endif
 
 #define VREF    3.3f      // Reference voltage
 #define VMIN    0.0f      // Desired minimum voltage
@@ -48,7 +121,61 @@ TIM_HandleTypeDef htim6;
 
 /* USER CODE BEGIN PV */
 
-uint16_t sine_table[SAMPLES];
+/* Ping-pong buffer the DMA plays; wave_gen refills one half at a time */
+#if DAC_DUAL
+uint32_t dac_buf[2 * DAC_HALF]; /* DHR12RD words: CH1 | CH2 << 16 */
+#else
+uint16_t dac_buf[2 * DAC_HALF];
+#endif
+wave_gen_t wave;
+
+/* Debugger-driven reconfiguration, see the header */
+volatile wave_cfg_t wave_req;
+volatile uint32_t wave_req_seq = 0;
+volatile int32_t wave_req_status = 0;
+volatile uint64_t wave_req_freq_uhz = 0; /* 0 = step mode */
+uint32_t dac_fs_hz;                      /* TIM6 update rate */
+volatile uint32_t wave_tw = 0;
+volatile uint64_t wave_freq_uhz = 0;     /* tw * fs / 2^32, achieved */
+uint16_t wave_arb[WAVE_GEN_TABLE_MAX]; /* user table for WAVE_ARB */
+uint32_t wave_init_cycles;             /* DWT cycles of the boot wave_gen_init */
+volatile uint32_t wave_req_ch2_mode = WAVE_CH2_PHASE; /* wave_ch2_t */
+volatile uint32_t wave_req_ch2_offset = 0x40000000U;  /* CH2 lead: 90 deg */
+
+/* Streaming modulation, see the header */
+wave_mod_t wave_mod;
+volatile uint32_t mod_req_src = WAVE_MOD_OFF;
+volatile uint32_t mod_req_dst = WAVE_MOD_AMPLITUDE;
+volatile uint64_t mod_req_lfo_uhz = 0;
+volatile uint32_t mod_req_period = 0;
+volatile uint32_t mod_req_rise = 0;
+volatile uint64_t mod_req_a = 0;
+volatile uint64_t mod_req_b = 0;
+volatile uint32_t mod_req_center = 2048;
+volatile uint32_t fill_cycles_last = 0;
+volatile uint32_t fill_cycles_max = 0;
+uint32_t fill_deadline_cycles;
+volatile uint32_t fill_late = 0;
+
+#if LOOP_TEST
+/* Loopback self-test, see the header. ADC2 and DMA1_Stream1 are not in
+ * the .ioc */
+ADC_HandleTypeDef hadc2;
+DMA_HandleTypeDef hdma_adc2;
+static uint16_t loop_cap[LOOP_CAP];
+#if DAC_DUAL
+static uint32_t loop_dac[LOOP_CAP];    /* packed, CH2 = CH1 */
+#else
+static uint16_t loop_dac[LOOP_CAP];
+#endif
+dac_loop_point_t loop_pts[LOOP_STEPS];
+dac_loop_result_t loop_result;
+volatile uint32_t loop_status = LOOP_NOT_RUN;
+uint32_t loop_cycles;                  /* DWT cycles of the whole test */
+static volatile uint32_t loop_adc_done;
+static volatile uint32_t loop_t_dac;
+static volatile uint32_t loop_t_adc;
+#endif
 
 /* USER CODE END PV */
 
@@ -59,7 +186,17 @@ static void MX_DMA_Init(void);
 static void MX_TIM6_Init(void);
 static void MX_DAC1_Init(void);
 /* USER CODE BEGIN PFP */
-static void Generate_Sine(void);
+static void Wave_Default(wave_cfg_t *cfg);
+static void Wave_Poll(void);
+static int32_t Mod_Request(wave_mod_cfg_t *mc);
+static void Wave_Fill(uint32_t half);
+#if DAC_DUAL
+static void DAC_Dual_Start(void);
+#endif
+#if LOOP_TEST
+static void Loop_Init(void);
+static void Loop_Run(void);
+#endif
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -74,7 +211,7 @@ static void Generate_Sine(void);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
-
+  wave_cfg_t cfg;
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -100,15 +237,45 @@ int main(void)
   MX_DAC1_Init();
   /* USER CODE BEGIN 2 */
 
-  Generate_Sine();
+  /* DWT CYCCNT for wave_init_cycles and the loopback stamps */
+  dwt_cyccnt_enable();
+
+  dac_fs_hz = HAL_RCC_GetPCLK1Freq() /
+              ((htim6.Init.Prescaler + 1U) * (htim6.Init.Period + 1U));
+#if LOOP_TEST
+  Loop_Init();
+  Loop_Run(); /* leaves TIM6 stopped and DAC CH1 idle */
+#endif
+
+  /* full-scale 1 kHz sine until the bench asks for something else */
+  Wave_Default(&cfg);
+  {
+    uint32_t t0 = DWT->CYCCNT;
+    wave_gen_init(&wave, &cfg);
+    wave_init_cycles = DWT->CYCCNT - t0;
+  }
+  wave_req = cfg;
+  wave_req_freq_uhz = BOOT_FREQ_UHZ;
+  wave_tw = wave_gen_tuning(dac_fs_hz, BOOT_FREQ_UHZ);
+  wave_freq_uhz = BOOT_FREQ_UHZ; /* exact: 256 kHz / 2^32 * 2^24 */
+  wave_gen_set_tuning(&wave, wave_tw);
+  wave_mod_init(&wave_mod);
+  fill_deadline_cycles = (uint32_t)(((uint64_t)DAC_HALF * SystemCoreClock) / dac_fs_hz);
+#if DAC_DUAL
+  wave_gen_set_ch2(&wave, wave_req_ch2_mode, wave_req_ch2_offset);
+  wave_gen_fill_dual(&wave, dac_buf, 2 * DAC_HALF);
+  DAC_Dual_Start();
+#else
+  wave_gen_fill(&wave, dac_buf, 2 * DAC_HALF);
 
   HAL_DAC_Start_DMA(
       &hdac1,
       DAC_CHANNEL_1,
-      (uint32_t *)sine_table,
-      SAMPLES,
+      (uint32_t *)dac_buf,
+      2 * DAC_HALF,
       DAC_ALIGN_12B_R
   );
+#endif
 
   HAL_TIM_Base_Start(&htim6);
 
@@ -123,6 +290,8 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
+    Wave_Poll();
+    __WFI(); // next DMA half interrupt at the latest
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
@@ -218,7 +387,29 @@ static void MX_DAC1_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN DAC1_Init 2 */
-
+#if DAC_DUAL
+  {
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    /* CH2 on PA5, same TIM6 trigger as CH1 */
+    if (HAL_DAC_ConfigChannel(&hdac1, &sConfig, DAC_CHANNEL_2) != HAL_OK)
+    {
+      Error_Handler();
+    }
+    GPIO_InitStruct.Pin = GPIO_PIN_5;
+    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    /* the stream moves 32-bit DHR12RD words instead of CH1 halfwords */
+    hdma_dac1_ch1.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma_dac1_ch1.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    if (HAL_DMA_Init(&hdma_dac1_ch1) != HAL_OK)
+    {
+      Error_Handler();
+    }
+  }
+#endif
   /* USER CODE END DAC1_Init 2 */
 
 }
@@ -312,23 +503,415 @@ static void MX_GPIO_Init(void)
 
 /* USER CODE BEGIN 4 */
 
-static void Generate_Sine(void)
+/* Boot waveform: full sine between VMIN and VMAX, the flash table in place
+ * when that is full scale, else resampled into a RAM table */
+static void Wave_Default(wave_cfg_t *cfg)
+{
+  cfg->shape = WAVE_SINE;
+  cfg->lo = (uint16_t)((VMIN / VREF) * DAC_RES);
+  cfg->hi = (uint16_t)((VMAX / VREF) * DAC_RES);
+  cfg->len = (cfg->lo == 0U && cfg->hi == WAVE_TABLES_FULL) ? WAVE_TABLES_N : SAMPLES;
+  /* Half Sine Wave: lo = DAC_OFFSET - DAC_AMPL, hi = DAC_OFFSET + DAC_AMPL */
+  cfg->duty = SAMPLES / 2;
+  cfg->arb = wave_arb;
+}
+
+/* Applies a new wave_req once its seq changes; a build refused because the
+ * previous change has not reached its period boundary yet is retried on
+ * the next pass */
+static void Wave_Poll(void)
+{
+  static uint32_t seen = 0;
+  wave_cfg_t cfg;
+  wave_mod_cfg_t mc;
+  int32_t rc;
+  uint64_t f_uhz;
+  uint32_t tw = 0;
+
+  if (wave_req_seq == seen)
+  {
+    return;
+  }
+  f_uhz = wave_req_freq_uhz;
+  if (f_uhz != 0U)
+  {
+    tw = wave_gen_tuning(dac_fs_hz, f_uhz);
+    if (tw == 0U)
+    {
+      seen = wave_req_seq;
+      wave_req_status = -2; /* not below fs (or 274 kHz) */
+      return;
+    }
+  }
+#if DAC_DUAL
+  if (wave_req_ch2_mode >= WAVE_CH2_MODES)
+  {
+    seen = wave_req_seq;
+    wave_req_status = -2;
+    return;
+  }
+  wave_gen_set_ch2(&wave, wave_req_ch2_mode, wave_req_ch2_offset);
+#endif
+  cfg.shape = wave_req.shape;
+  cfg.len = wave_req.len;
+  cfg.lo = wave_req.lo;
+  cfg.hi = wave_req.hi;
+  cfg.duty = wave_req.duty;
+  cfg.arb = wave_arb;
+  if (Mod_Request(&mc) != 0)
+  {
+    seen = wave_req_seq;
+    wave_req_status = -2; /* frequency not below fs */
+    return;
+  }
+  rc = wave_gen_build(&wave, &cfg);
+  if (rc != -1)
+  {
+    seen = wave_req_seq;
+    wave_req_status = rc;
+  }
+  if (rc == 0)
+  {
+    /* phase-continuous, from the next DMA half on; the new table itself
+     * takes over at the next period boundary */
+    uint64_t t = (uint64_t)tw * dac_fs_hz; /* Hz in Q32 */
+
+    wave_gen_set_tuning(&wave, tw);
+    wave_tw = tw;
+    wave_freq_uhz = (t >> 32) * 1000000U + (((t & 0xFFFFFFFFU) * 1000000U) >> 32);
+    if (wave_mod_set(&wave_mod, &mc) != 0)
+    {
+      wave_req_status = -2;
+    }
+  }
+}
+
+/* mod_req_* -> wave_mod_cfg_t: frequencies to tuning words at dac_fs_hz.
+ * -2 when one of them does not convert; the rest is checked by
+ * wave_mod_set */
+static int32_t Mod_Request(wave_mod_cfg_t *mc)
+{
+  mc->src = mod_req_src;
+  mc->dst = mod_req_dst;
+  mc->period = mod_req_period;
+  mc->rise = mod_req_rise;
+  mc->center = mod_req_center;
+  mc->lfo_tw = 0;
+  if (mc->src == WAVE_MOD_LFO)
+  {
+    mc->lfo_tw = wave_gen_tuning(dac_fs_hz, mod_req_lfo_uhz);
+    if (mc->lfo_tw == 0U)
+    {
+      return -2;
+    }
+  }
+  if (mc->dst == WAVE_MOD_FREQUENCY)
+  {
+    mc->a = wave_gen_tuning(dac_fs_hz, mod_req_a);
+    mc->b = wave_gen_tuning(dac_fs_hz, mod_req_b);
+    if (mc->src != WAVE_MOD_OFF && (mc->a == 0U || mc->b == 0U))
+    {
+      return -2;
+    }
+  }
+  else
+  {
+    /* Q16 gains; out-of-range values fail in wave_mod_set */
+    mc->a = (mod_req_a > 0xFFFFFFFFU) ? 0xFFFFFFFFU : (uint32_t)mod_req_a;
+    mc->b = (mod_req_b > 0xFFFFFFFFU) ? 0xFFFFFFFFU : (uint32_t)mod_req_b;
+  }
+  return 0;
+}
+
+/* One DMA half (0 first, 1 second) from the modulation stage, timed */
+static void Wave_Fill(uint32_t half)
+{
+  uint32_t t0 = DWT->CYCCNT;
+  uint32_t dt;
+
+#if DAC_DUAL
+  wave_mod_fill_dual(&wave_mod, &wave, &dac_buf[half * DAC_HALF], DAC_HALF);
+#else
+  wave_mod_fill(&wave_mod, &wave, &dac_buf[half * DAC_HALF], DAC_HALF);
+#endif
+  dt = DWT->CYCCNT - t0;
+  fill_cycles_last = dt;
+  if (dt > fill_cycles_max)
+  {
+    fill_cycles_max = dt;
+  }
+  if (dt > fill_deadline_cycles)
+  {
+    fill_late++;
+  }
+}
+
+/* ================= DMA CALLBACKS =================
+ * Each half is refilled while the DMA plays the other one
+ * (64 codes = 250 us of output per refill deadline).
+ */
+#if DAC_DUAL
+static void DAC_Dual_HalfCplt(DMA_HandleTypeDef *hdma)
+{
+  (void)hdma;
+  Wave_Fill(0);
+}
+
+static void DAC_Dual_Cplt(DMA_HandleTypeDef *hdma)
+{
+  (void)hdma;
+  Wave_Fill(1);
+}
+
+/* HAL_DAC_Start_DMA only targets one channel's DHR; the dual register is
+ * fed straight from the stream, CH1's DMA request paces it and TIM6 TRGO
+ * loads both DORs on the same edge */
+static void DAC_Dual_Start(void)
+{
+  hdma_dac1_ch1.XferHalfCpltCallback = DAC_Dual_HalfCplt;
+  hdma_dac1_ch1.XferCpltCallback = DAC_Dual_Cplt;
+  if (HAL_DMA_Start_IT(&hdma_dac1_ch1, (uint32_t)dac_buf,
+                       (uint32_t)&hdac1.Instance->DHR12RD,
+                       2 * DAC_HALF) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  SET_BIT(hdac1.Instance->CR, DAC_CR_DMAEN1);
+  __HAL_DAC_ENABLE(&hdac1, DAC_CHANNEL_1);
+  __HAL_DAC_ENABLE(&hdac1, DAC_CHANNEL_2);
+}
+#else
+void HAL_DAC_ConvHalfCpltCallbackCh1(DAC_HandleTypeDef *hdac)
+{
+  (void)hdac;
+  Wave_Fill(0);
+}
+
+void HAL_DAC_ConvCpltCallbackCh1(DAC_HandleTypeDef *hdac)
+{
+  (void)hdac;
+  Wave_Fill(1);
+}
+#endif
+
+#if LOOP_TEST
+/* ================= DAC -> ADC LOOPBACK SELF-TEST =================
+ * ADC2 and its DMA are not in the .ioc (HAL_ADC_MODULE_ENABLED has to be
+ * on in stm32h7xx_hal_conf.h): ADC2 converts on TIM6 TRGO, the DAC's own
+ * trigger, so sample i and DAC update i come from the same edge.
+ * DMA1_Stream1, peripheral -> memory, normal mode; its IRQ handler is
+ * below for the same reason. D-cache is off, no invalidate after the DMA.
+ */
+static void Loop_Init(void)
+{
+  ADC_ChannelConfTypeDef sConfig = {0};
+
+  __HAL_RCC_ADC12_CLK_ENABLE();
+#if LOOP_JUMPER
+  {
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    /* PA6 = ADC12_INP3, wired to PA4 = DAC1_OUT1 */
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    GPIO_InitStruct.Pin = GPIO_PIN_6;
+    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+  }
+#endif
+
+  hadc2.Instance = ADC2;
+  hadc2.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV4; /* 16 MHz */
+  hadc2.Init.Resolution = ADC_RESOLUTION_12B;
+  hadc2.Init.ScanConvMode = ADC_SCAN_DISABLE;
+  hadc2.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
+  hadc2.Init.LowPowerAutoWait = DISABLE;
+  hadc2.Init.ContinuousConvMode = DISABLE;
+  hadc2.Init.NbrOfConversion = 1;
+  hadc2.Init.DiscontinuousConvMode = DISABLE;
+  hadc2.Init.ExternalTrigConv = ADC_EXTERNALTRIG_T6_TRGO;
+  hadc2.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+  hadc2.Init.ConversionDataManagement = ADC_CONVERSIONDATA_DMA_ONESHOT;
+  hadc2.Init.Overrun = ADC_OVR_DATA_OVERWRITTEN;
+  hadc2.Init.LeftBitShift = ADC_LEFTBITSHIFT_NONE;
+  hadc2.Init.OversamplingMode = DISABLE;
+  if (HAL_ADC_Init(&hadc2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+#if LOOP_JUMPER
+  sConfig.Channel = ADC_CHANNEL_3;
+#else
+  sConfig.Channel = ADC_CHANNEL_DAC1CH1_ADC2; /* DAC_CHIPCONNECT_ENABLE */
+#endif
+  sConfig.Rank = ADC_REGULAR_RANK_1;
+  sConfig.SamplingTime = ADC_SAMPLETIME_32CYCLES_5; /* 2 us of 3.9 */
+  sConfig.SingleDiff = ADC_SINGLE_ENDED;
+  sConfig.OffsetNumber = ADC_OFFSET_NONE;
+  sConfig.Offset = 0;
+  if (HAL_ADC_ConfigChannel(&hadc2, &sConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (HAL_ADCEx_Calibration_Start(&hadc2, ADC_CALIB_OFFSET_LINEARITY,
+                                  ADC_SINGLE_ENDED) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  hdma_adc2.Instance = DMA1_Stream1;
+  hdma_adc2.Init.Request = DMA_REQUEST_ADC2;
+  hdma_adc2.Init.Direction = DMA_PERIPH_TO_MEMORY;
+  hdma_adc2.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_adc2.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_adc2.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+  hdma_adc2.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+  hdma_adc2.Init.Mode = DMA_NORMAL;
+  hdma_adc2.Init.Priority = DMA_PRIORITY_HIGH;
+  hdma_adc2.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+  if (HAL_DMA_Init(&hdma_adc2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  __HAL_LINKDMA(&hadc2, DMA_Handle, hdma_adc2);
+  HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+}
+
+/* n samples into loop_cap, TIM6 has to be running (or be started next) */
+static void Loop_Capture_Start(uint32_t n)
+{
+  loop_adc_done = 0;
+  if (HAL_ADC_Start_DMA(&hadc2, (uint32_t *)loop_cap, n) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
+/* 0, or -1 when the capture did not finish within 10 ms (no trigger) */
+static int32_t Loop_Capture_Wait(void)
+{
+  uint32_t t0 = HAL_GetTick();
+  int32_t ret = 0;
+
+  while (!loop_adc_done)
+  {
+    if (HAL_GetTick() - t0 > 10U)
+    {
+      ret = -1;
+      break;
+    }
+  }
+  HAL_ADC_Stop_DMA(&hadc2);
+  return ret;
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+  if (hadc == &hadc2)
+  {
+    loop_t_adc = DWT->CYCCNT;
+    loop_adc_done = 1;
+  }
+}
+
+/* the last LOOP_LO element has been read: the next request takes LOOP_HI */
+static void Loop_Dac_Half(DMA_HandleTypeDef *hdma)
 {
-	uint16_t DAC_MIN = (uint16_t)((VMIN / VREF) * DAC_RES);
-	uint16_t DAC_MAX = (uint16_t)((VMAX / VREF) * DAC_RES);
-  for (uint32_t i = 0; i < SAMPLES; i++)
-  {
-    /* Half Sine Wave
-	  sine_table[i] =
-      DAC_OFFSET +
-      (uint16_t)(DAC_AMPL *
-      sinf(2.0f * M_PI * i / SAMPLES));
-    */
-	// Full Sine Wave
-	float Vpp = VMAX - VMIN; // PEAK-TO-PEAK VOLTAGE (unused Variable just for debugging)
-    sine_table[i] = DAC_MIN + (uint16_t)(((sinf(2.0f * M_PI * i / SAMPLES) + 1.0f) / 2.0f) * (DAC_MAX - DAC_MIN));
+  (void)hdma;
+  loop_t_dac = DWT->CYCCNT;
+}
+
+/* ~7 ms at 256 kHz: LOOP_STEPS x (LOOP_SETTLE + LOOP_AVG) samples, then
+ * one step record. Runs once, fills loop_pts / loop_result and sets
+ * loop_status. */
+static void Loop_Run(void)
+{
+  static const dac_loop_limits_t lim = DAC_LOOP_LIMITS_DEFAULT;
+  uint32_t t0 = DWT->CYCCNT;
+  int32_t edge;
+
+  /* static: CH1 software codes, DHR -> DOR on each TIM6 edge */
+  HAL_DAC_SetValue(&hdac1, DAC_CHANNEL_1, DAC_ALIGN_12B_R, LOOP_FIRST);
+  HAL_DAC_Start(&hdac1, DAC_CHANNEL_1);
+  HAL_TIM_Base_Start(&htim6);
+  for (uint32_t k = 0; k < LOOP_STEPS; k++)
+  {
+    uint16_t code = dac_loop_code(k, LOOP_STEPS, LOOP_FIRST, LOOP_LAST);
+
+    HAL_DAC_SetValue(&hdac1, DAC_CHANNEL_1, DAC_ALIGN_12B_R, code);
+    Loop_Capture_Start(LOOP_SETTLE + LOOP_AVG);
+    if (Loop_Capture_Wait() != 0)
+    {
+      loop_result.fails |= DAC_LOOP_FAIL_CAPTURE;
+      break;
+    }
+    loop_pts[k].dac = code;
+    loop_pts[k].adc_q8 = dac_loop_mean_q8(&loop_cap[LOOP_SETTLE], LOOP_AVG);
+  }
+  if ((loop_result.fails & DAC_LOOP_FAIL_CAPTURE) == 0U)
+  {
+    dac_loop_fit(loop_pts, LOOP_STEPS, &loop_result);
   }
+
+  /* step: settle on LOOP_LO, then both DMAs armed before the first edge.
+   * The DAC DMA is circular; only its half-transfer stamp is used. */
+  HAL_DAC_SetValue(&hdac1, DAC_CHANNEL_1, DAC_ALIGN_12B_R, LOOP_LO);
+  HAL_Delay(1);
+  HAL_TIM_Base_Stop(&htim6);
+  __HAL_TIM_SET_COUNTER(&htim6, 0);
+  for (uint32_t i = 0; i < LOOP_CAP; i++)
+  {
+    uint16_t code = (i < LOOP_CAP / 2U) ? LOOP_LO : LOOP_HI;
+#if DAC_DUAL
+    loop_dac[i] = WAVE_GEN_PACK(code, code);
+#else
+    loop_dac[i] = code;
+#endif
+  }
+  Loop_Capture_Start(LOOP_CAP);
+  hdma_dac1_ch1.XferHalfCpltCallback = Loop_Dac_Half;
+  hdma_dac1_ch1.XferCpltCallback = NULL;
+  if (HAL_DMA_Start_IT(&hdma_dac1_ch1, (uint32_t)loop_dac,
+#if DAC_DUAL
+                       (uint32_t)&hdac1.Instance->DHR12RD,
+#else
+                       (uint32_t)&hdac1.Instance->DHR12R1,
+#endif
+                       LOOP_CAP) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  SET_BIT(hdac1.Instance->CR, DAC_CR_DMAEN1);
+  HAL_TIM_Base_Start(&htim6);
+  if (Loop_Capture_Wait() != 0)
+  {
+    loop_result.fails |= DAC_LOOP_FAIL_CAPTURE;
+  }
+  HAL_TIM_Base_Stop(&htim6);
+  HAL_DMA_Abort(&hdma_dac1_ch1);
+  CLEAR_BIT(hdac1.Instance->CR, DAC_CR_DMAEN1);
+  HAL_DAC_Stop(&hdac1, DAC_CHANNEL_1);
+  hdma_dac1_ch1.XferHalfCpltCallback = NULL;
+
+  if ((loop_result.fails & DAC_LOOP_FAIL_CAPTURE) == 0U)
+  {
+    edge = dac_loop_edge_q8(loop_cap, LOOP_CAP, LOOP_LO, LOOP_HI);
+    dac_loop_latency(&loop_result, edge, LOOP_CAP / 2U,
+                     SystemCoreClock / dac_fs_hz, loop_t_dac, loop_t_adc,
+                     LOOP_CAP - 1U);
+    dac_loop_check(&loop_result, &lim);
+  }
+  loop_cycles = DWT->CYCCNT - t0;
+  loop_status = loop_result.fails;
+}
+
+void DMA1_Stream1_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_adc2);
 }
+#endif
 
 /* USER CODE END 4 */
 
@@ -21,7 +21,13 @@
 #include "stdio.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "temp_conv.h"
+#include "adc_os.h"
+#include "swo_trace.h"
+#include "fmt.h"
+#include "temp_lut.h"
+#include "cal_store.h"
+#include "lp_acq.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -31,6 +37,34 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/* ADC3 hardware oversampling (see adc_os.h): 64 conversions averaged in
+ * hardware, +3 effective bits, 381 S/s -- far above the loop rate */
+#define ADC3_OS_PROFILE ADC_OS_X64
+
+/* SWV trace (see swo_trace.h): text on ITM port 0, every sample as one word
+ * on port 1 (lo16 = ADC code, hi16 = deg C x 100), line start/end events
+ * on port 2 -- the event delta is the CPU cost of one log line.
+ * TRACE_BYTEWISE 1 restores the old ITM_SendChar loop for comparison. */
+#define TRACE_BYTEWISE 0
+#define TRACE_EV_LINE_START 1U
+#define TRACE_EV_LINE_END 2U
+#define LOG_PERIOD_MS 1000U
+
+/* Code -> temperature: 1 = boot-built table (temp_lut.h), one index and one
+ * multiply-add per sample, takes the user points below; 0 = temp_conv
+ * straight line through TS_CAL1/TS_CAL2 only */
+#define TEMP_USE_LUT 1
+
+/* User calibration points on top of the factory pair: an ADC code (as
+ * printed in the log) read with a reference thermometer next to the board.
+ * One point at room temperature bends the curve there instead of moving
+ * TS_CAL1_TEMP to 20, which tilted the whole line. A valid record in the
+ * backup SRAM (cal_store.h, written by "CAL ..." commands) takes
+ * precedence over these. */
+#define TS_USER_POINTS 0
+
+/* Codes converted each way by the boot benchmark */
+#define CONV_BENCH_LEN 256U
 
 /* DUAL_CORE_BOOT_SYNC_SEQUENCE: Define for dual core boot synchronization    */
 /*                             demonstration code based on hardware semaphore */
@@ -52,10 +86,29 @@
 ADC_HandleTypeDef hadc3;
 
 /* USER CODE BEGIN PV */
-static volatile float adc_val = 0; //const means read-only!!
-static volatile float temp = 0;
-float TS_CAL1;
-float TS_CAL2;
+static volatile uint16_t adc_val = 0;
+static volatile int32_t temp_q16 = 0; // Q16.16 deg celcius
+static volatile float temp = 0;       // display copy of temp_q16
+static temp_conv_t ts_conv;           // slope/offset folded once at boot
+static temp_lut_t ts_lut;             // piecewise-linear table, built at boot
+#if TS_USER_POINTS > 0
+static const temp_lut_point_t ts_user[TS_USER_POINTS] = {
+    /* { code, TEMP_CONV_Q16(deg C) }, */
+};
+#if 2 + TS_USER_POINTS > TEMP_LUT_MAX_POINTS
+#error "TS_USER_POINTS: temp_lut_build() takes TEMP_LUT_MAX_POINTS in total"
+#endif
+#endif
+// CPU cycles for CONV_BENCH_LEN conversions, measured once at boot
+static volatile uint32_t conv_cycles_formula = 0;
+static volatile uint32_t conv_cycles_lut = 0;
+// CPU cycles between the line start and end events (format + _write), for
+// the swo_trace.h figures: compare TRACE_BYTEWISE 1 and 0 in Live Expressions
+static volatile uint32_t log_line_cycles_last = 0;
+static volatile uint32_t log_line_cycles_max = 0;
+// sleep between EOC interrupts (lp_acq.h), refreshed with every log line
+static lp_acq_t lp_acq;
+lp_acq_report_t lp_acq_dbg;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -63,6 +116,8 @@ void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_ADC3_Init(void);
 /* USER CODE BEGIN PFP */
+static void TS_BuildLut(void);
+static void TS_BenchConv(void);
 
 /* USER CODE END PFP */
 
@@ -70,11 +125,16 @@ static void MX_ADC3_Init(void);
 /* USER CODE BEGIN 0 */ // Function to print the values to SWV console
 int _write(int file, char *ptr, int len)
 {
+#if TRACE_BYTEWISE
     for (int i = 0; i < len; i++)
     {
         ITM_SendChar(ptr[i]);
     }
-    return len;
+#else
+    // queued for swo_trace_pump(), dropped whole if the ring is full
+    (void)swo_trace_write(SWO_PORT_TEXT, ptr, (uint32_t)len);
+#endif
+    return len; // never short: newlib would retry the rest
 }
 /* USER CODE END 0 */
 
@@ -86,7 +146,7 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
-
+  uint32_t log_tick;
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -95,8 +155,13 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
-  TS_CAL1 = (float)(*TS_CAL1_ADDR);
-  TS_CAL2 = (float)(*TS_CAL2_ADDR);
+  // calibration words read once, slope precomputed (no per-sample division)
+  if (temp_conv_init(&ts_conv, *TS_CAL1_ADDR, *TS_CAL2_ADDR,
+                     TEMP_CONV_Q16(TS_CAL1_TEMP), TEMP_CONV_Q16(TS_CAL2_TEMP)) != 0)
+  {
+    Error_Handler();
+  }
+  TS_BuildLut();
   /* USER CODE END Init */
 
   /* Configure the system clock */
@@ -111,29 +176,62 @@ int main(void)
   MX_GPIO_Init();
   MX_ADC3_Init();
   /* USER CODE BEGIN 2 */
-  HAL_ADC_Start(&hadc3);
+  swo_trace_init();
+  TS_BenchConv(); // after swo_trace_init: needs DWT CYCCNT running
+  HAL_EnableDBGSleepMode(); // keep the trace clock (SWO) running in Sleep
+  lp_acq_hal_init(&lp_acq);
+  // EOC interrupt per result instead of polling the flag (ADC3_IRQn in MSP)
+  HAL_ADC_Start_IT(&hadc3);
+  log_tick = HAL_GetTick();
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-	  /* 1) ALWAYS consume conversion when EOC is set
-	   * EOC is asserted for every completed conversion,
-	   *  but only advances when you read DR*/
-	  if (__HAL_ADC_GET_FLAG(&hadc3, ADC_FLAG_EOC)){
-		// reading DR ACKNOWLEDGES completion
-	    adc_val = (float) ADC3->DR; //alternate of the below
-		//adc_val = (float) HAL_ADC_GetValue(&hadc3);
-		// cast returned uint32 values to float
-		temp = ((TS_CAL2_TEMP - TS_CAL1_TEMP) /
-				(TS_CAL2 - TS_CAL1)) *
-				(adc_val -  TS_CAL1) + TS_CAL1_TEMP;
+	  /* 1) Sleep until the EOC interrupt (or SysTick) instead of spinning
+	   * on the EOC flag; the callback reads DR, which acknowledges the
+	   * conversion, and posts LP_ACQ_EV_SAMPLE */
+	  if ((lp_acq_wait(&lp_acq) & LP_ACQ_EV_SAMPLE) != 0U){
+		// integer-only conversion, same formula as the TS_CAL float version
+#if TEMP_USE_LUT
+		temp_q16 = temp_lut_q16(&ts_lut, adc_val);
+#else
+		temp_q16 = temp_conv_q16(&ts_conv, adc_val);
+#endif
+		temp = (float) temp_q16 / 65536.0f;
+		// every sample, binary: no formatting on the sample path
+		swo_trace_word(SWO_PORT_SAMPLES,
+		               ((uint32_t)(uint16_t)temp_conv_q16_to_centi(temp_q16) << 16) | adc_val);
+	  }
 
-		// Print only every 1 second
-		HAL_Delay(1000);
-		printf("ADC = %.0f  TEMP = %.2f C\n", adc_val, temp);
+	  // Print only every 1 second, sampling keeps running in between
+	  if ((HAL_GetTick() - log_tick) >= LOG_PERIOD_MS) {
+		log_tick += LOG_PERIOD_MS;
+		char line[40];
+		fmt_t f;
+		uint32_t t0;
+		swo_trace_event(TRACE_EV_LINE_START);
+		t0 = DWT->CYCCNT;
+		// was printf("ADC = %u  TEMP = %.2f C\n"): same text, no float printf
+		fmt_init(&f, line, sizeof(line));
+		fmt_str(&f, "ADC = ");
+		fmt_u32(&f, adc_val);
+		fmt_str(&f, "  TEMP = ");
+		fmt_q16(&f, temp_q16, 2);
+		fmt_str(&f, " C\n");
+		_write(1, line, (int)fmt_end(&f));
+		log_line_cycles_last = DWT->CYCCNT - t0;
+		if (log_line_cycles_last > log_line_cycles_max) {
+			log_line_cycles_max = log_line_cycles_last;
+		}
+		swo_trace_event(TRACE_EV_LINE_END);
+		lp_acq_report(&lp_acq, &lp_acq_dbg);
 	  }
+
+	  // drain the trace rings into ITM while the FIFO has room; what does
+	  // not fit goes out after the next wake-up (SysTick, at most 1 ms)
+	  swo_trace_pump();
 	  //}
 	  /* This works for single conversion mode
 	   * hadc3.Init.ContinuousConvMode = DISABLE;
@@ -282,7 +380,10 @@ static void MX_ADC3_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN ADC3_Init 2 */
-
+  if (adc_os_apply(&hadc3, ADC3_OS_PROFILE) != HAL_OK)
+  {
+    Error_Handler();
+  }
   /* USER CODE END ADC3_Init 2 */
 
 }
@@ -316,7 +417,83 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+/* ADC3_IRQn is enabled in HAL_ADC_MspInit (USER CODE ADC3_MspInit 1); the
+ * .ioc does not have it, so its handler lives here, not in stm32h7xx_it.c */
+void ADC3_IRQHandler(void)
+{
+  HAL_ADC_IRQHandler(&hadc3);
+}
+
+/* ADC3_IRQHandler -> HAL_ADC_IRQHandler, every result */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+  if (hadc->Instance == ADC3)
+  {
+    adc_val = (uint16_t)HAL_ADC_GetValue(hadc); // reading DR acknowledges EOC
+    lp_acq_post(&lp_acq, LP_ACQ_EV_SAMPLE);
+  }
+}
 
+/**
+  * @brief  Build ts_lut from the factory pair plus the stored user record,
+  *         or plus ts_user[] when the backup SRAM holds none
+  * @retval None
+  */
+static void TS_BuildLut(void)
+{
+  temp_lut_point_t pts[TEMP_LUT_MAX_POINTS];
+  temp_lut_point_t factory[2];
+  cal_record_t rec;
+  uint32_t n;
+
+  factory[0].code = *TS_CAL1_ADDR;
+  factory[0].t_q16 = TEMP_CONV_Q16(TS_CAL1_TEMP);
+  factory[1].code = *TS_CAL2_ADDR;
+  factory[1].t_q16 = TEMP_CONV_Q16(TS_CAL2_TEMP);
+  if (cal_store_hal_init() == 0 && cal_store_hal_load(&rec) >= 0)
+  {
+    n = cal_record_points(&rec, factory, pts);
+    if (temp_lut_build(&ts_lut, pts, n) == 0)
+    {
+      return;
+    }
+  }
+  pts[0] = factory[0];
+  pts[1] = factory[1];
+#if TS_USER_POINTS > 0
+  for (uint32_t i = 0; i < TS_USER_POINTS; i++)
+  {
+    pts[2U + i] = ts_user[i];
+  }
+#endif
+  if (temp_lut_build(&ts_lut, pts, 2U + TS_USER_POINTS) != 0)
+  {
+    Error_Handler(); // duplicate code or implausible point
+  }
+}
+
+/**
+  * @brief  Time CONV_BENCH_LEN conversions with temp_conv and with ts_lut
+  *         over the codes around TS_CAL1 (read conv_cycles_* in the debugger)
+  * @retval None
+  */
+static void TS_BenchConv(void)
+{
+  static uint16_t codes[CONV_BENCH_LEN];
+  static int32_t out[CONV_BENCH_LEN];
+  uint32_t t0;
+
+  for (uint32_t i = 0; i < CONV_BENCH_LEN; i++)
+  {
+    codes[i] = (uint16_t)(*TS_CAL1_ADDR + i * 7U); // spans several cells
+  }
+  t0 = DWT->CYCCNT;
+  temp_conv_block(&ts_conv, codes, out, CONV_BENCH_LEN);
+  conv_cycles_formula = DWT->CYCCNT - t0;
+  t0 = DWT->CYCCNT;
+  temp_lut_block(&ts_lut, codes, out, CONV_BENCH_LEN);
+  conv_cycles_lut = DWT->CYCCNT - t0;
+}
 /* USER CODE END 4 */
 
 /**
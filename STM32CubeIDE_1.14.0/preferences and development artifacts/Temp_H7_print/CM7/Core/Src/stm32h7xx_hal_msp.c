@@ -111,7 +111,9 @@ void HAL_ADC_MspInit(ADC_HandleTypeDef* hadc)
     /* Peripheral clock enable */
     __HAL_RCC_ADC3_CLK_ENABLE();
     /* USER CODE BEGIN ADC3_MspInit 1 */
-
+    /* EOC interrupt wakes the sleeping main loop (lp_acq) */
+    HAL_NVIC_SetPriority(ADC3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(ADC3_IRQn);
     /* USER CODE END ADC3_MspInit 1 */
 
   }
@@ -134,7 +136,7 @@ void HAL_ADC_MspDeInit(ADC_HandleTypeDef* hadc)
     /* Peripheral clock disable */
     __HAL_RCC_ADC3_CLK_DISABLE();
     /* USER CODE BEGIN ADC3_MspDeInit 1 */
-
+    HAL_NVIC_DisableIRQ(ADC3_IRQn);
     /* USER CODE END ADC3_MspDeInit 1 */
   }
 
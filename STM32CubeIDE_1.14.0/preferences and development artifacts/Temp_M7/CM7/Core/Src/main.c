@@ -10,7 +10,7 @@
   * @brief          : STM32H745 ADC3 internal temperature sensor example
   *
   * This example demonstrates:
-  * - ADC3 continuous conversion mode
+  * - ADC3 triggered by TIM6 TRGO at SAMPLE_RATE_HZ
   * - Internal temperature sensor (TSENSE) usage
   * - 16-bit ADC resolution matched to factory calibration values
   * - ADC clock derived from PLL2P (20 MHz) via CubeMX
@@ -18,8 +18,8 @@
   * - Junction temperature measurement (not ambient temperature)
   *
   * Key notes:
-  * - ADC is started once; conversions run continuously in hardware
-  * - EOC flag is polled to read updated samples
+  * - ADC is started once; TIM6 starts each (oversampled) conversion
+  * - The EOC interrupt reads DR and wakes the sleeping main loop
   * - Factory calibration values are used directly (no shifting needed)
   * - Temperature reflects MCU die temperature under load/debug
   *
@@ -41,7 +41,12 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "temp_conv.h"
+#include "adc_os.h"
+#include "adc_stats.h"
+#include "temp_alarm.h"
+#include "lp_acq.h"
+#include "tim_rate.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -51,6 +56,21 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/* ADC3 hardware oversampling (see adc_os.h): 64 conversions averaged in
+ * hardware, +3 effective bits; burst profile, so each TIM6 trigger runs
+ * all 64 back to back (~2.6 ms) and gives one result */
+#define ADC3_OS_PROFILE ADC_OS_X64
+
+/* Die temperature alarm on the ADC3 analog watchdog (see temp_alarm.h):
+ * trips outside ALARM_LOW_C..ALARM_HIGH_C, clears ALARM_HYST_C back inside */
+#define ALARM_LOW_C    18
+#define ALARM_HIGH_C   70
+#define ALARM_HYST_C   2
+
+/* Sample rate: TIM6 TRGO starts one conversion (64 oversampled, ~2.6 ms)
+ * per period. Between results the ADC is idle and the core sleeps
+ * (lp_acq.h) until the EOC interrupt posts the sample */
+#define SAMPLE_RATE_HZ 10U
 
 /* DUAL_CORE_BOOT_SYNC_SEQUENCE: Define for dual core boot synchronization    */
 /*                             demonstration code based on hardware semaphore */
@@ -82,15 +102,39 @@
 ADC_HandleTypeDef hadc3;
 
 /* USER CODE BEGIN PV */
+TIM_HandleTypeDef htim6; /* ADC3 trigger, TRGO only (no interrupt) */
+static tim_rate_t adc_trig; /* PSC/ARR solved at boot, achieved rate */
+
+/* ================= FIXED-POINT CONVERSION =================
+   Slope/offset folded once from TS_CAL1/TS_CAL2 in USER CODE Init,
+   per sample: integer multiply + shift only (Q16.16 °C).
+   ============================================================ */
+static temp_conv_t ts_conv;
+
 /* ================= DEBUG VARIABLES ================= */
 volatile uint16_t adc_raw_dbg;
-volatile float  temperature_c_dbg;
+volatile int32_t temperature_q16_dbg;
+volatile float  temperature_c_dbg;  /* display copy of temperature_q16_dbg */
+/* noise / drift / extremes of adc_raw_dbg since boot (debugger view) */
+static adc_stats_t adc_stats;
+adc_stats_snapshot_t adc_stats_dbg;
+
+/* ================= TEMPERATURE ALARM ================= */
+static temp_alarm_t ts_alarm;
+volatile temp_alarm_state_t alarm_state_dbg;  /* written from the AWD IRQ */
+
+/* ================= SLEEP BETWEEN SAMPLES ================= */
+static lp_acq_t lp_acq;
+lp_acq_report_t lp_acq_dbg;  /* sleep residency, refreshed every sample */
+static volatile uint16_t adc_sample;  /* DR, read in the EOC callback */
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_ADC3_Init(void);
 /* USER CODE BEGIN PFP */
+static void Alarm_Init(void);
+static void ADC3_TriggerTimer_Init(void);
 
 /* USER CODE END PFP */
 
@@ -118,6 +162,11 @@ int main(void)
   /* USER CODE BEGIN Init */
   /* ---- HERE. ONLY HERE. ---- */
  // ADC123_COMMON->CCR |= ADC_CCR_TSEN | ADC_CCR_VREFEN;
+  if (temp_conv_init(&ts_conv, *TS_CAL1_ADDR, *TS_CAL2_ADDR,
+                     TEMP_CONV_Q16(TS_CAL1_TEMP), TEMP_CONV_Q16(TS_CAL2_TEMP)) != 0)
+  {
+    Error_Handler();
+  }
   /* USER CODE END Init */
 
   /* Configure the system clock */
@@ -131,8 +180,14 @@ int main(void)
   MX_ADC3_Init();
   /* USER CODE BEGIN 2 */
 
-  /* ---- CONTINUOUS MODE: START ONCE ---- */
-  HAL_ADC_Start(&hadc3);
+  /* ---- TIMER-TRIGGERED MODE: START ONCE ---- */
+  ADC3_TriggerTimer_Init();
+  adc_stats_init(&adc_stats, 3); /* EMA over ~8 readings */
+  Alarm_Init();                  /* AWD armed before the first conversion */
+  lp_acq_hal_init(&lp_acq);
+  /* ADC armed with the EOC interrupt first, then TIM6 starts pacing it */
+  HAL_ADC_Start_IT(&hadc3);
+  HAL_TIM_Base_Start(&htim6);
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -140,10 +195,13 @@ int main(void)
   while (1)
   {
     /* USER CODE END WHILE */
-	  //if (HAL_ADC_PollForConversion(&hadc3, HAL_MAX_DELAY) == HAL_OK) /// not needed
-	  if (__HAL_ADC_GET_FLAG(&hadc3, ADC_FLAG_EOC))
+	  /* was: spin on EOC + HAL_Delay(100), 100 % CPU for a 10 Hz reading.
+	   * Now WFI until the EOC interrupt posts LP_ACQ_EV_SAMPLE; SysTick
+	   * and watchdog wake-ups return 0 and count as empty wakes.
+	   * Residency lands in lp_acq_dbg */
+	  if ((lp_acq_wait(&lp_acq) & LP_ACQ_EV_SAMPLE) != 0U)
 	          {
-	              adc_raw_dbg = HAL_ADC_GetValue(&hadc3);
+	              adc_raw_dbg = adc_sample;
 	              /* ---- RAW ADC → TEMPERATURE (RM FORMULA) ---- */
 /*/// needed when 12 bits is needed shifting 4 bits to the right from 16 to 12 , basically bit division
 	              temperature_c_dbg =
@@ -152,15 +210,14 @@ int main(void)
 	                  ((float)(TS_CAL2_RAW - TS_CAL1_RAW)) +
 	                  TS_CAL1_TEMP;
 */
-	              temperature_c_dbg =
-	                          ((float)(adc_raw_dbg - *TS_CAL1_ADDR) *
-	                          (TS_CAL2_TEMP - TS_CAL1_TEMP)) /
-	                          ((float)(*TS_CAL2_ADDR - *TS_CAL1_ADDR)) +
-	                          TS_CAL1_TEMP;
-
+	              /* same formula, slope precomputed: integer-only */
+	              temperature_q16_dbg = temp_conv_q16(&ts_conv, adc_raw_dbg);
+	              temperature_c_dbg = (float)temperature_q16_dbg / 65536.0f;
+	              uint16_t raw = adc_raw_dbg;
+	              adc_stats_push_block(&adc_stats, &raw, 1);
+	              adc_stats_snapshot(&adc_stats, &adc_stats_dbg);
+	              lp_acq_report(&lp_acq, &lp_acq_dbg);
 	          }
-
-	          HAL_Delay(100);   /* 10 Hz update — sensor is slow */
     /* USER CODE BEGIN 3 */
   }
   /* USER CODE END 3 */
@@ -317,13 +374,113 @@ static void MX_ADC3_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN ADC3_Init 2 */
-
+  /* one conversion per TIM6 TRGO rising edge instead of free running;
+     the analog watchdog checks each of them in hardware */
+  hadc3.Init.ContinuousConvMode = DISABLE;
+  hadc3.Init.ExternalTrigConv = ADC_EXTERNALTRIG_T6_TRGO;
+  hadc3.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+  /* a late DR read must not stop the conversions (PRESERVED stops at the
+     overrun and the watchdog with it) */
+  hadc3.Init.Overrun = ADC_OVR_DATA_OVERWRITTEN;
+  /* re-runs HAL_ADC_Init, so the trigger settings above apply as well */
+  if (adc_os_apply(&hadc3, ADC3_OS_PROFILE) != HAL_OK)
+  {
+    Error_Handler();
+  }
   /* USER CODE END ADC3_Init 2 */
 
 }
 
 /* USER CODE BEGIN 4 */
+static void Alarm_Cb(void *ctx, temp_alarm_state_t state, uint16_t code)
+{
+  (void)ctx;
+  (void)code;
+  alarm_state_dbg = state;
+}
+
+/**
+  * @brief  Convert the alarm levels to codes with TS_CAL1/TS_CAL2 and arm
+  *         the ADC3 analog watchdog 1 on the sensor channel
+  * @retval None
+  */
+static void Alarm_Init(void)
+{
+  temp_alarm_cal_t cal = {
+      .code1 = *TS_CAL1_ADDR,
+      .code2 = *TS_CAL2_ADDR,
+      .t1_q16 = TEMP_CONV_Q16(TS_CAL1_TEMP),
+      .t2_q16 = TEMP_CONV_Q16(TS_CAL2_TEMP),
+      .code_max = 0xFFFF, /* 16-bit, same domain as DR with adc_os */
+  };
+
+  if (temp_alarm_init(&ts_alarm, &cal, Alarm_Cb, NULL) != 0 ||
+      temp_alarm_set_low(&ts_alarm, TEMP_CONV_Q16(ALARM_LOW_C), TEMP_CONV_Q16(ALARM_HYST_C)) != 0 ||
+      temp_alarm_set_high(&ts_alarm, TEMP_CONV_Q16(ALARM_HIGH_C), TEMP_CONV_Q16(ALARM_HYST_C)) != 0 ||
+      temp_alarm_hal_start(&ts_alarm, &hadc3, ADC_CHANNEL_TEMPSENSOR) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
 
+/* ================= ADC3 TRIGGER TIMER =================
+ * TIM6 (basic timer) on APB1: f_tim = PCLK1 = 20 MHz (APB1 /1).
+ * PSC/ARR solved for SAMPLE_RATE_HZ, the achieved rate and its error are
+ * left in adc_trig (10 Hz -> PSC 30, ARR 64515, 0 ppm).
+ * Needs HAL_TIM_MODULE_ENABLED in stm32h7xx_hal_conf.h (TIM6 is not in
+ * the .ioc, so it is set up here instead of an MX_TIM6_Init).
+ */
+static void ADC3_TriggerTimer_Init(void)
+{
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  if (tim_rate_solve(HAL_RCC_GetPCLK1Freq(), SAMPLE_RATE_HZ * 1000U, &adc_trig) != 0)
+  {
+    Error_Handler();
+  }
+  __HAL_RCC_TIM6_CLK_ENABLE();
+  htim6.Instance = TIM6;
+  htim6.Init.Prescaler = adc_trig.psc;
+  htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim6.Init.Period = adc_trig.arr;
+  htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim6) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim6, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
+/* ADC3_IRQn is enabled in HAL_ADC_MspInit (USER CODE ADC3_MspInit 1); the
+ * .ioc does not have it, so its handler lives here, not in stm32h7xx_it.c */
+void ADC3_IRQHandler(void)
+{
+  HAL_ADC_IRQHandler(&hadc3);
+}
+
+/* ADC3_IRQHandler -> HAL_ADC_IRQHandler, every result */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+  if (hadc->Instance == ADC3)
+  {
+    adc_sample = (uint16_t)HAL_ADC_GetValue(hadc); /* reading DR acknowledges EOC */
+    lp_acq_post(&lp_acq, LP_ACQ_EV_SAMPLE);
+  }
+}
+
+/* ADC3_IRQHandler -> HAL_ADC_IRQHandler on an AWD1 hit */
+void HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef *hadc)
+{
+  if (hadc->Instance == ADC3)
+  {
+    temp_alarm_hal_isr(&ts_alarm, hadc);
+  }
+}
 /* USER CODE END 4 */
 
 /**
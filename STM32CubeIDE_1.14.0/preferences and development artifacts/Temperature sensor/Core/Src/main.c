@@ -21,7 +21,8 @@
 #include <stdio.h>
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "fmt.h"
+#include "temp_alarm.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -31,6 +32,11 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/* Cold alarm on PA5 (see temp_alarm.h): the ADC analog watchdog trips
+ * below ALARM_LOW_C and clears above ALARM_LOW_C + ALARM_HYST_C. One code
+ * is ~0.32 C here, so the band is about three codes wide. */
+#define ALARM_LOW_C 18
+#define ALARM_HYST_C 1
 
 /* USER CODE END PD */
 
@@ -55,6 +61,7 @@ static void MX_DMA_Init(void);
 static void MX_ADC1_Init(void);
 static void MX_I2C1_Init(void);
 /* USER CODE BEGIN PFP */
+static void Alarm_Init(void);
 
 /* USER CODE END PFP */
 
@@ -64,9 +71,15 @@ static void MX_I2C1_Init(void);
 #define Avg_slope .0025 // V/C
 #define V25 0.76 //V
 #define Vsense 3.3/4096 // 12 bit resolution
+/* Same line in integers, deg C x 10^4 (the .4f of the old printf):
+ *   T = (ADC * 3300 / 4096 mV - 760 mV) / 2.5 mV/C + 25
+ *   T * 10^4 = ADC * 103125 / 32 - 2790000     (ADC * 103125 < 2^31) */
+#define TEMP_E4(adc) ((int32_t)(((adc) * 103125UL + 16UL) / 32UL) - 2790000L)
 uint32_t ADC_vAL = 0;
-float Temp = 0;
+float Temp = 0;      // display copy of temp_e4
+int32_t temp_e4 = 0; // deg C x 10^4
 uint8_t k = 0;
+static temp_alarm_t cold_alarm;
 
 /*void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc) //this works as well! but only in debugger mode
 {
@@ -114,6 +127,7 @@ int main(void)
 	MX_ADC1_Init();
 	MX_I2C1_Init();
 	/* USER CODE BEGIN 2 */
+	Alarm_Init(); // watchdog armed before the first conversion
 
 	HAL_ADC_Start_DMA(&hadc1, &ADC_vAL, 1);
 
@@ -125,13 +139,28 @@ int main(void)
 	{
 		/* USER CODE END WHILE */
 		ADC_vAL = HAL_ADC_GetValue(&hadc1);
-		Temp = ((Vsense * ADC_vAL - V25) / Avg_slope) + 25;
-		printf("Time: %ds, ADC: %lu, Temperature: %.4f %cC\n", k, ADC_vAL, Temp, 176); // Using the ASCII code for the degree symbol (176)
-		// lu stands for long unsigned int which is for uint32_t
+		// integer math replaces ((Vsense * ADC_vAL - V25) / Avg_slope) + 25 in double
+		temp_e4 = TEMP_E4(ADC_vAL);
+		Temp = (float)temp_e4 / 10000.0f;
+		{
+			// was printf("Time: %ds, ADC: %lu, Temperature: %.4f %cC\n", ...)
+			char line[48];
+			fmt_t f;
+			fmt_init(&f, line, sizeof(line));
+			fmt_str(&f, "Time: ");
+			fmt_u32(&f, k);
+			fmt_str(&f, "s, ADC: ");
+			fmt_u32(&f, ADC_vAL);
+			fmt_str(&f, ", Temperature: ");
+			fmt_dec(&f, temp_e4, 4);
+			fmt_char(&f, ' ');
+			fmt_char(&f, (char)176); // Using the ASCII code for the degree symbol (176)
+			fmt_str(&f, "C\n");
+			_write(1, line, (int)fmt_end(&f));
+		}
 		HAL_Delay(1E3); // 1 second delay for sampling ADC Value
 		k++;
-		// configured pin PA5 at line 325
-		(Temp < 18) ? HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, 1) : HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, 0); // condition ? expression-true : expression-false
+		// PA5 is driven by the analog watchdog alarm, see Alarm_Cb()
 		/* USER CODE BEGIN 3 */
 	}
 	/* USER CODE END 3 */
@@ -336,7 +365,45 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+/* PA5 on while colder than ALARM_LOW_C (was the polled temp_e4 < 180000) */
+static void Alarm_Cb(void *ctx, temp_alarm_state_t state, uint16_t code)
+{
+	(void)ctx;
+	(void)code;
+	HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, (state == TEMP_ALARM_LOW) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
+/**
+ * @brief  Convert the alarm levels to ADC codes and arm the ADC1 watchdog
+ * @retval None
+ */
+static void Alarm_Init(void)
+{
+	/* two ends of the TEMP_E4 line, deg C x 10^4 -> Q16.16 */
+	temp_alarm_cal_t cal = {
+		.code1 = 0,
+		.code2 = 4095,
+		.t1_q16 = (int32_t)(((int64_t)TEMP_E4(0) * 65536) / 10000),
+		.t2_q16 = (int32_t)(((int64_t)TEMP_E4(4095) * 65536) / 10000),
+		.code_max = 4095,
+	};
+
+	if (temp_alarm_init(&cold_alarm, &cal, Alarm_Cb, NULL) != 0 ||
+			temp_alarm_set_low(&cold_alarm, ALARM_LOW_C * 65536L, ALARM_HYST_C * 65536L) != 0 ||
+			temp_alarm_hal_start(&cold_alarm, &hadc1, ADC_CHANNEL_TEMPSENSOR) != HAL_OK)
+	{
+		Error_Handler();
+	}
+}
 
+/* ADC_IRQHandler -> HAL_ADC_IRQHandler (stm32f4xx_it.c) on an AWD hit */
+void HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef *hadc)
+{
+	if (hadc->Instance == ADC1)
+	{
+		temp_alarm_hal_isr(&cold_alarm, hadc);
+	}
+}
 /* USER CODE END 4 */
 
 /**
@@ -22,7 +22,14 @@
 #include "string.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "temp_conv.h"
+#include "temp_lut.h"
+#include "cal_store.h"
+#include "adc_os.h"
+#include "uart_tx.h"
+#include "telem.h"
+#include "delta_pack.h"
+#include "dwt_cyccnt.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -32,6 +39,25 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/* ADC3 hardware oversampling (see adc_os.h): 64 conversions averaged in
+ * hardware, +3 effective bits, 381 S/s -- far above the loop rate */
+#define ADC3_OS_PROFILE ADC_OS_X64
+
+/* LPUART1 TX ring: one telem frame is 39 bytes (~41 ms at 9600 baud), so
+ * 256 bytes absorb 6 frames (12 delta-packed ones) while the link is busy */
+#define BLE_TX_RING_SIZE 256U
+
+/* Binary telemetry (see telem.h): one temperature every 100 ms, 10 per
+ * frame -> 39 bytes/s. 3.9 bytes/sample against ~20 for the old text
+ * line, so the 960 bytes/s of 9600 baud carry 5x the samples */
+#define TELEM_SAMPLE_PERIOD_MS 100U
+#define TELEM_SAMPLES_PER_FRAME 10U
+
+/* 1 = temperatures as delta-packed frames (see delta_pack.h) of one BLE
+ * notification each: 12 samples per 20 bytes on slow thermal data, 1.7
+ * bytes/sample. 0 = TELEM_FRAME_TEMP above. Decode either with
+ * Common/Host/telem_decode */
+#define BLE_DELTA_PACK 1
 
 /* DUAL_CORE_BOOT_SYNC_SEQUENCE: Define for dual core boot synchronization    */
 /*                             demonstration code based on hardware semaphore */
@@ -45,8 +71,8 @@
 #define TS_CAL1_ADDR ((uint16_t*) 0x1FF1E820) // address of the calibration values stored
 #define TS_CAL2_ADDR ((uint16_t*) 0x1FF1E840)
 
-#define TS_CAL1_TEMP 30.0f  // deg celcius ///changing it to 20 makes it to work for ambient temperature
-#define TS_CAL2_TEMP 130.0f /// changing it to 40 makes it to work for ambient temperaturee
+#define TS_CAL1_TEMP 30.0f  // deg celcius, factory points; ambient correction is
+#define TS_CAL2_TEMP 130.0f // done at runtime with "CAL HERE <mdegC>" (cal_store.h)
 /* USER CODE END PM */
 
 /* Private variables ---------------------------------------------------------*/
@@ -55,10 +81,30 @@ ADC_HandleTypeDef hadc3;
 UART_HandleTypeDef hlpuart1;
 
 /* USER CODE BEGIN PV */
-static volatile float adc_val = 0; // const means read-only!!
-static volatile float temp = 0;
-float TS_CAL1;
-float TS_CAL2;
+static volatile uint16_t adc_val = 0;
+static volatile int32_t temp_q16 = 0; // Q16.16 deg celcius
+static volatile float temp = 0;       // display copy of temp_q16
+static temp_lut_t ts_lut;            // factory pair + stored user points, built at boot
+
+static cal_record_t cal_rec; // live copy of the backup SRAM record
+static cal_line_t cal_line;  // command line assembled by the RX interrupt
+static uint8_t cal_rx_byte;
+
+static uint8_t ble_tx_buf[BLE_TX_RING_SIZE];
+static uart_tx_t ble_tx; // LPUART1 -> HM10, drained by TXE interrupts
+
+static uint16_t telem_seq = 0;
+
+#if !BLE_DELTA_PACK
+static int16_t telem_temp[TELEM_SAMPLES_PER_FRAME]; // deg C x 100
+static uint32_t telem_count = 0;
+static uint32_t telem_t0 = 0;   // tick of telem_temp[0]
+#else
+static delta_pack_t ble_pack;
+// DWT cycles of one delta_pack_push(), frame close (CRC + COBS) included
+static volatile uint32_t pack_cycles_last = 0;
+static volatile uint32_t pack_cycles_max = 0;
+#endif
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -67,7 +113,11 @@ static void MX_GPIO_Init(void);
 static void MX_ADC3_Init(void);
 static void MX_LPUART1_UART_Init(void);
 /* USER CODE BEGIN PFP */
-
+#if !BLE_DELTA_PACK
+static void Telem_SendFrame(void);
+#endif
+static int Cal_Build(const cal_record_t* r);
+static void Cal_HandleLine(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -87,7 +137,7 @@ int _write(int file, char* ptr, int len) {
 int main(void) {
 
   /* USER CODE BEGIN 1 */
-
+  uint32_t sample_tick;
   /* USER CODE END 1 */
   /* MCU Configuration--------------------------------------------------------*/
 
@@ -95,8 +145,14 @@ int main(void) {
   HAL_Init();
 
   /* USER CODE BEGIN Init */
-  TS_CAL1 = (float) (*TS_CAL1_ADDR);
-  TS_CAL2 = (float) (*TS_CAL2_ADDR);
+  // user points from the backup SRAM (none on first boot), table built once
+  if (cal_store_hal_init() != 0) {
+    Error_Handler();
+  }
+  cal_store_hal_load(&cal_rec);
+  if (Cal_Build(&cal_rec) != 0 && Cal_Build(NULL) != 0) {
+    Error_Handler();
+  }
   /* USER CODE END Init */
 
   /* Configure the system clock */
@@ -110,7 +166,21 @@ int main(void) {
   MX_ADC3_Init();
   MX_LPUART1_UART_Init();
   /* USER CODE BEGIN 2 */
+  /* LPUART1 sits in D3, where only BDMA (SRAM4) can reach it, so the ring
+   * drains by interrupt instead of DMA (hdmatx left NULL) */
+  if (uart_tx_init(&ble_tx, &hlpuart1, ble_tx_buf, sizeof(ble_tx_buf)) != HAL_OK) {
+    Error_Handler();
+  }
+  // CAL commands from the HM10, one byte per RX interrupt
+  if (HAL_UART_Receive_IT(&hlpuart1, &cal_rx_byte, 1) != HAL_OK) {
+    Error_Handler();
+  }
+#if BLE_DELTA_PACK
+  delta_pack_init(&ble_pack, DELTA_PACK_BLE_FRAME, 0);
+  dwt_cyccnt_enable(); // for pack_cycles_*
+#endif
   HAL_ADC_Start(&hadc3);
+  sample_tick = HAL_GetTick();
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -121,31 +191,48 @@ int main(void) {
      *  but only advances when you read DR*/
     if (__HAL_ADC_GET_FLAG(&hadc3, ADC_FLAG_EOC)) {
       // reading DR ACKNOWLEDGES completion
-      adc_val = (float) ADC3->DR; // alternate of the below
-      // adc_val = (float) HAL_ADC_GetValue(&hadc3);
-      //  cast returned uint32 values to float
-      temp = ((TS_CAL2_TEMP - TS_CAL1_TEMP) / (TS_CAL2 - TS_CAL1)) * (adc_val - TS_CAL1) +
-          TS_CAL1_TEMP;
-
-      // Print only every 1 second
-      HAL_Delay(1000);
+      adc_val = (uint16_t) ADC3->DR; // alternate of the below
+      // adc_val = (uint16_t) HAL_ADC_GetValue(&hadc3);
+      // one table lookup, user points included
+      temp_q16 = temp_lut_q16(&ts_lut, adc_val);
+      temp = (float) temp_q16 / 65536.0f;
+    }
+
+    if (cal_line.ready) {
+      Cal_HandleLine();
+    }
+
+    // Telemetry sample every 100 ms, sampling keeps running in between
+    if ((HAL_GetTick() - sample_tick) >= TELEM_SAMPLE_PERIOD_MS) {
       /*HM10 Bluetooth module printing start*/
-      char temp_str[64] = ""; // MUST be large enough
-      int len = snprintf(
-          temp_str,
-          sizeof(temp_str),
-          "u=%.2f,r=%.2f|°C", // send both MCU and approximate room with 20 chars limit from lightblue
-          temp,
-		  temp - 32.0f // approximate room temperature conversion
-      );
-
-      if (len > 0) { // transmit only if len is not a null char array!
-        HAL_UART_Transmit(
-            &hlpuart1,
-            (uint8_t*) temp_str,
-            len,
-            HAL_MAX_DELAY);
+#if BLE_DELTA_PACK
+      sample_tick += TELEM_SAMPLE_PERIOD_MS;
+      {
+        uint8_t frame[DELTA_PACK_BLE_FRAME];
+        uint32_t t0 = DWT->CYCCNT;
+        // room temperature (~ MCU - 32 C) is left to the host side
+        uint32_t len =
+            delta_pack_push(&ble_pack, (int16_t) temp_conv_q16_to_centi(temp_q16), frame);
+        pack_cycles_last = DWT->CYCCNT - t0;
+        if (pack_cycles_last > pack_cycles_max) {
+          pack_cycles_max = pack_cycles_last;
+        }
+        if (len > 0U) {
+          uart_tx_write(&ble_tx, frame, len); // one notification per frame
+        }
       }
+#else
+      if (telem_count == 0U) {
+        telem_t0 = sample_tick;
+      }
+      sample_tick += TELEM_SAMPLE_PERIOD_MS;
+      // room temperature (~ MCU - 32 C) is left to the host side
+      telem_temp[telem_count++] = (int16_t) temp_conv_q16_to_centi(temp_q16);
+      if (telem_count == TELEM_SAMPLES_PER_FRAME) {
+        Telem_SendFrame();
+        telem_count = 0;
+      }
+#endif
       /*HM10 Bluetooth module printing end*/
 
       // HAL_UART_Transmit(&hlpuart1, (uint8_t *)"hd\n", 3, HAL_MAX_DELAY);
@@ -286,7 +373,9 @@ static void MX_ADC3_Init(void) {
     Error_Handler();
   }
   /* USER CODE BEGIN ADC3_Init 2 */
-
+  if (adc_os_apply(&hadc3, ADC3_OS_PROFILE) != HAL_OK) {
+    Error_Handler();
+  }
   /* USER CODE END ADC3_Init 2 */
 }
 
@@ -361,6 +450,114 @@ static void MX_GPIO_Init(void) {
 }
 
 /* USER CODE BEGIN 4 */
+#if !BLE_DELTA_PACK
+/**
+ * @brief  Builds one TELEM_FRAME_TEMP frame in place and queues it.
+ *         Decode captures with Common/Host/telem_decode.
+ */
+static void Telem_SendFrame(void) {
+  uint8_t frame[TELEM_FRAME_MAX];
+  telem_frame_t f;
+  uint32_t len;
+
+  telem_begin(&f, frame, TELEM_RAW_MAX, TELEM_FRAME_TEMP, telem_seq++, telem_t0);
+  telem_put_u16(&f, TELEM_F_PERIOD_MS, TELEM_SAMPLE_PERIOD_MS);
+  telem_put_i16_array(&f, TELEM_F_TEMP_CENTI, telem_temp, TELEM_SAMPLES_PER_FRAME);
+  telem_put_u16(&f, TELEM_F_ADC_CODE, adc_val);
+  len = telem_end(&f);
+  if (len > 0U) {
+    // queued whole or dropped whole (ble_tx.ring.drops), never waits
+    uart_tx_write(&ble_tx, frame, len);
+  }
+}
+#endif
+
+/* LPUART1 is not in stm32h7xx_it.c: its NVIC line is enabled in
+ * HAL_UART_MspInit, USER CODE LPUART1_MspInit 1 */
+void LPUART1_IRQHandler(void) {
+  HAL_UART_IRQHandler(&hlpuart1);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+  if (huart->Instance == LPUART1) {
+    uart_tx_cplt_isr(&ble_tx); // next span of the ring, if any
+  }
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart) {
+  if (huart->Instance == LPUART1) {
+    cal_line_push(&cal_line, cal_rx_byte);
+    HAL_UART_Receive_IT(&hlpuart1, &cal_rx_byte, 1);
+  }
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart) {
+  if (huart->Instance == LPUART1) {
+    // an overrun or noise error ends the reception; the line being
+    // received is dropped, a line the main loop is handling is left alone
+    cal_line_error(&cal_line);
+    HAL_UART_Receive_IT(&hlpuart1, &cal_rx_byte, 1);
+  }
+}
+
+/**
+ * @brief  Rebuilds ts_lut from the factory pair and the points of r
+ *         (factory only for NULL). ts_lut is untouched on failure.
+ * @retval 0, or -1 if temp_lut_build() rejects the points
+ */
+static int Cal_Build(const cal_record_t* r) {
+  temp_lut_point_t factory[2];
+  temp_lut_point_t pts[TEMP_LUT_MAX_POINTS];
+  uint32_t n;
+
+  factory[0].code = *TS_CAL1_ADDR;
+  factory[0].t_q16 = TEMP_CONV_Q16(TS_CAL1_TEMP);
+  factory[1].code = *TS_CAL2_ADDR;
+  factory[1].t_q16 = TEMP_CONV_Q16(TS_CAL2_TEMP);
+  n = cal_record_points(r, factory, pts);
+  return temp_lut_build(&ts_lut, pts, n);
+}
+
+/**
+ * @brief  Runs one CAL command line and answers with a TELEM_FRAME_CAL
+ *         frame. Status: 0 ok, -1 parse error, -2 no free point, -3 the
+ *         curve was rejected (record and table unchanged).
+ */
+static void Cal_HandleLine(void) {
+  uint8_t frame[TELEM_FRAME_MAX];
+  telem_frame_t f;
+  cal_cmd_t cmd;
+  cal_record_t next = cal_rec;
+  uint16_t code = adc_val;
+  int16_t status = 0;
+  int rc;
+  uint32_t len;
+
+  if (cal_cmd_parse(cal_line.buf, &cmd) != 0) {
+    status = -1;
+  } else if ((rc = cal_cmd_apply(&cmd, &next, code)) < 0) {
+    status = -2;
+  } else if (rc > 0) {
+    // table first: a record the table rejects is never stored
+    if (Cal_Build(&next) != 0) {
+      status = -3;
+    } else {
+      cal_store_hal_save(&next);
+      cal_rec = next;
+    }
+  }
+  cal_line_release(&cal_line);
+
+  telem_begin(&f, frame, TELEM_RAW_MAX, TELEM_FRAME_CAL, telem_seq++, HAL_GetTick());
+  telem_put_i16(&f, TELEM_F_CAL_STATUS, status);
+  telem_put_u32(&f, TELEM_F_CAL_SEQ, cal_rec.seq);
+  telem_put_u8(&f, TELEM_F_CAL_POINTS, (uint8_t) cal_rec.npoints);
+  telem_put_u16(&f, TELEM_F_CAL_CODE, code);
+  len = telem_end(&f);
+  if (len > 0U) {
+    uart_tx_write(&ble_tx, frame, len);
+  }
+}
 
 /* USER CODE END 4 */
 
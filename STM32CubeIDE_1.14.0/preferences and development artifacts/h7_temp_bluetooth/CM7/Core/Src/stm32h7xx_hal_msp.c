@@ -169,6 +169,9 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart) {
     HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 
     /* USER CODE BEGIN LPUART1_MspInit 1 */
+    /* LPUART1 interrupt Init: uart_tx drain and cal_store RX, not in the .ioc */
+    HAL_NVIC_SetPriority(LPUART1_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(LPUART1_IRQn);
 
     /* USER CODE END LPUART1_MspInit 1 */
   }
@@ -195,6 +198,8 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef *huart) {
     HAL_GPIO_DeInit(GPIOB, GPIO_PIN_6 | GPIO_PIN_7);
 
     /* USER CODE BEGIN LPUART1_MspDeInit 1 */
+    /* LPUART1 interrupt DeInit */
+    HAL_NVIC_DisableIRQ(LPUART1_IRQn);
 
     /* USER CODE END LPUART1_MspDeInit 1 */
   }
@@ -149,7 +149,14 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include <math.h>
+#include "adc_stream.h"
+#include "adc_os.h"
+#include "adc_stats.h"
+#include "tim_rate.h"
+#include "temp_probe.h"
+#include "dac_stream.h"
+#include "dwt_cyccnt.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -159,6 +166,32 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/* ADC3 pacing:
+ *   1 -> TIM6 TRGO starts every conversion at ADC3_TRIGGER_HZ (fixed fs)
+ *   0 -> software start + continuous mode (fs set by ADC clock/sampling)
+ * 16 kHz trigger > 40.95 us conversion, x16 per-trigger oversampling
+ * gives exactly 1 kS/s into the DMA blocks (+2 effective bits).
+ */
+#define ADC3_TIMER_TRIGGER 1
+#define ADC3_TRIGGER_HZ 16000U
+
+/* ADC3 hardware oversampling (see adc_os.h) */
+#if ADC3_TIMER_TRIGGER
+#define ADC3_OS_PROFILE ADC_OS_X16_TRIG
+#else
+#define ADC3_OS_PROFILE ADC_OS_X16 // 1.53 kS/s free running
+#endif
+
+/* DAC output pacing:
+ *   1 -> TIM7 TRGO plays one code per ADC sample from a circular DMA at
+ *        the ADC output rate, fixed ADC -> DAC latency (half a block after
+ *        the ADC block completes, see DAC_Output_Start)
+ *   0 -> HAL_DAC_SetValue once per block from the main loop
+ */
+#define DAC_TIMER_PACED 1
+#if DAC_TIMER_PACED && !ADC3_TIMER_TRIGGER
+#error "DAC_TIMER_PACED needs the timer-paced ADC3 (same clock, same rate)"
+#endif
 
 /* USER CODE END PD */
 
@@ -173,13 +206,60 @@ DMA_HandleTypeDef hdma_adc3;
 DAC_HandleTypeDef hdac1;
 
 /* USER CODE BEGIN PV */
-// HAL_ADC_Start_DMA requires pData as uint32_t*
-static volatile uint16_t adc = 0;
+TIM_HandleTypeDef htim6; // ADC3 trigger, TRGO only (no interrupt)
+/* Achieved trigger rate (PSC/ARR solved at boot) and block-interval
+ * jitter from DWT CYCCNT stamped in the DMA callbacks */
+static tim_rate_t adc_trig;
+static tim_jitter_t adc_jitter;
+/* ================= BLOCK ACQUISITION =================
+ * ADC3 circular DMA fills two halves of ADC_STREAM_BLOCK_LEN samples.
+ * HalfCplt/Cplt callbacks flag a half, the main loop consumes it once.
+ *
+ * Nominal rate:
+ *   timer : fs = ADC3_TRIGGER_HZ / ratio = 16 kHz / 16 = 1 kS/s
+ *           → 64-sample block every 64 ms
+ *   free  : fs = f_adc / ((810.5 sampling + 8.5 conversion cycles) * ratio)
+ *           = 20 MHz / (819 * 16) ≈ 1.53 kS/s
+ * adc_rate_sps holds the rate actually measured over the last second.
+ */
+static uint16_t adc_buf[2 * ADC_STREAM_BLOCK_LEN]; // DMA target (D1 RAM)
+static adc_stream_t adc_stream;
+static volatile uint32_t adc_rate_sps = 0;
+static volatile uint16_t adc = 0; // mean code of the last processed block
+/* Noise / drift / extremes of every sample, fed from the DMA ISR,
+ * adc_stats_view refreshed once per second for the debugger */
+static adc_stats_t adc_stats;
+static adc_stats_snapshot_t adc_stats_view;
+static volatile float adc_stddev = 0; // codes
+/* Block -> deg C -> DAC codes (temp_probe.h, replayable on the host with
+ * Common/Host/temp_probe_replay); the results below are for the debugger */
+static temp_probe_cal_t probe_cal;
 static volatile int32_t temp = 0;
 static volatile uint16_t dac_temp_voltage = 0;
 static volatile uint16_t dac_roomtemp_voltage = 0;
 static volatile uint32_t temp_equivalent = 0;
-static volatile float roomtemp = 0;
+static volatile uint32_t roomtemp = 0;
+#if DAC_TIMER_PACED
+/* ================= TIMER-PACED DAC OUTPUT =================
+ * Each ADC block becomes N codes per channel in the half of the DAC DMA
+ * buffers that is not playing (dac_stream.h). TIM7 runs from the same
+ * PCLK1 as TIM6 at the ADC output rate, so the output never drifts
+ * against the input. dac_out.lat is the histogram of ADC block complete
+ * (DWT stamp in the ADC callback) -> first code of that block on the pin,
+ * dac_out.underruns / late count missed deadlines.
+ */
+TIM_HandleTypeDef htim7;         // DAC trigger, TRGO only (no interrupt)
+DMA_HandleTypeDef hdma_dac1_ch1; // DMA1_Stream1, half/complete IRQ
+DMA_HandleTypeDef hdma_dac1_ch2; // DMA1_Stream2, no IRQ (same trigger)
+static tim_rate_t dac_trig;
+static uint16_t dac_ch1_buf[2 * ADC_STREAM_BLOCK_LEN]; // 50 mV/C codes
+static uint16_t dac_ch2_buf[2 * ADC_STREAM_BLOCK_LEN]; // 100 mV/C codes
+static volatile uint32_t adc_block_cyc[2]; // DWT stamp per ADC half
+static dac_stream_t dac_out;
+/* DWT cycles of one temp_probe_dac_block call (64 samples, 2 channels) */
+static volatile uint32_t probe_cycles_last = 0;
+static volatile uint32_t probe_cycles_max = 0;
+#endif
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -189,7 +269,12 @@ static void MX_DMA_Init(void);
 static void MX_ADC3_Init(void);
 static void MX_DAC1_Init(void);
 /* USER CODE BEGIN PFP */
-
+static void ADC_ProcessBlock(const uint16_t *block, uint32_t len, void *ctx);
+static void ADC3_TriggerTimer_Init(void);
+#if DAC_TIMER_PACED
+static void DAC_Output_Init(void);
+static void DAC_Output_Start(void);
+#endif
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -204,7 +289,8 @@ static void MX_DAC1_Init(void);
 int main(void) {
 
   /* USER CODE BEGIN 1 */
-
+  uint32_t rate_tick = 0;
+  uint32_t rate_samples = 0;
   /* USER CODE END 1 */
 
   /* Reset of all peripherals, Initializes the Flash interface and the Systick.
@@ -229,88 +315,81 @@ int main(void) {
   MX_DAC1_Init();
   /* USER CODE BEGIN 2 */
   /* ENABLE DAC OUTPUTS */
+#if DAC_TIMER_PACED
+  DAC_Output_Init(); // started together with ADC3 below
+#else
   HAL_DAC_Start(&hdac1, DAC_CHANNEL_1);
   HAL_DAC_Start(&hdac1, DAC_CHANNEL_2);
-  /* (uint32_t *) used since it was declared as volatile!!
-   * read 1 value into adc in circular mode only valid recent value
+#endif
+  /* HAL_ADC_Start_DMA requires pData as uint32_t*, length is in samples
+   * circular DMA over both halves, callbacks hand out one half at a time
    */
-  HAL_ADC_Start_DMA(&hadc3, (uint32_t *)&adc,
-                    1); // read 1 value into adc in circular mode recent values
+  probe_cal.ts_cal1 = *TEMPSENSOR_CAL1_ADDR;
+  probe_cal.ts_cal2 = *TEMPSENSOR_CAL2_ADDR;
+  probe_cal.cal1_temp = TEMPSENSOR_CAL1_TEMP;
+  probe_cal.cal2_temp = TEMPSENSOR_CAL2_TEMP;
+  probe_cal.cal_vref_mv = TEMPSENSOR_CAL_VREFANALOG;
+  probe_cal.vref_mv = 3300U;
+  probe_cal.res_bits = 16U; // ADC_RESOLUTION_16B, oversampling shifted back
+  adc_stream_init(&adc_stream, adc_buf, ADC_STREAM_BLOCK_LEN, ADC_ProcessBlock,
+                  NULL);
+  adc_stats_init(&adc_stats, 4); // EMA over ~16 blocks
+  dwt_cyccnt_enable(); // CPU cycle counter for the jitter stamps
+#if ADC3_TIMER_TRIGGER
+  ADC3_TriggerTimer_Init();
+  /* expected block interval = BLOCK * ratio / f_trigger, in CPU cycles */
+  tim_jitter_init(&adc_jitter,
+                  (uint32_t)((uint64_t)SystemCoreClock * 1000U *
+                             ADC_STREAM_BLOCK_LEN *
+                             adc_os_profile(ADC3_OS_PROFILE)->ratio /
+                             adc_trig.rate_mhz));
+#else
+  tim_jitter_init(&adc_jitter,
+                  (uint32_t)((uint64_t)SystemCoreClock * 1000U *
+                             ADC_STREAM_BLOCK_LEN /
+                             adc_os_rate_mhz(adc_os_profile(ADC3_OS_PROFILE),
+                                             20000000U,
+                                             ADC_OS_TSENSE_HALF_CYCLES)));
+#endif
+  /* ADC armed first, then the trigger source starts pacing it */
+  HAL_ADC_Start_DMA(&hadc3, (uint32_t *)adc_buf, 2 * ADC_STREAM_BLOCK_LEN);
+#if ADC3_TIMER_TRIGGER
+  HAL_TIM_Base_Start(&htim6);
+#endif
+#if DAC_TIMER_PACED
+  DAC_Output_Start(); // waits until ADC3 is half way into block 0
+#endif
+  rate_tick = HAL_GetTick();
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
   while (1) {
-    /* Snapshot DMA-updated value */
-    temp = __HAL_ADC_CALC_TEMPERATURE(3300, (int32_t)adc,
-                                      ADC_GET_RESOLUTION(&hadc3));
-    // saturate temp to 0 to 100 c for voltage equivalent
-    if (temp < 0) {
-      temp_equivalent = 0;
-    } else if (temp > 66) {
-      temp_equivalent = 66;
-    } else {
-      temp_equivalent = temp;
+    /* The newest complete half is processed once; older ones are counted
+     * in adc_stream.overruns */
+    if (adc_stream_poll(&adc_stream) == 0) {
+      /* Check-then-sleep with PRIMASK set: a half completing after the
+       * poll stays pending and makes WFI return at once, instead of
+       * waiting for the next interrupt (lost wakeup). */
+      __disable_irq();
+      if (!adc_stream_pending(&adc_stream)) {
+        __DSB();
+        __WFI();
+      }
+      __enable_irq(); // the pending DMA callback runs here
+    }
+
+    /* Achieved sample rate over the last second */
+    if ((HAL_GetTick() - rate_tick) >= 1000U) {
+      rate_tick += 1000U;
+      adc_rate_sps = adc_stream.samples - rate_samples;
+      rate_samples = adc_stream.samples;
+      adc_stats_snapshot(&adc_stats, &adc_stats_view); // ISR keeps feeding
+      adc_stddev = sqrtf((float)adc_stats_variance(&adc_stats_view));
     }
-    // HAL_Delay(1E3); // 1 second delay
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
-    /* Set DAC output to temperature equivalent voltage */
-    dac_temp_voltage = (temp_equivalent * 4095) / 66;
-    HAL_DAC_SetValue(&hdac1, DAC_CHANNEL_1, DAC_ALIGN_12B_R, dac_temp_voltage);
-
-    /* --- Clamp for 100 mV / °C (0–33 °C → 0–3.3 V) --- */
-    roomtemp = (float)temp_equivalent - 25.0f; // manual calibration
-    if (roomtemp < 0.0f)
-      roomtemp = 0.0f;
-    else if (roomtemp > 33.0f)
-      roomtemp = 33.0f;
-    // 100mV / degC
-    dac_roomtemp_voltage = (uint16_t)((roomtemp * 4095.0f) / 33.0f);
-    HAL_DAC_SetValue(&hdac1, DAC_CHANNEL_2, DAC_ALIGN_12B_R,
-                     dac_roomtemp_voltage);
-    /* =======================================================================
-     * LINEAR TEMPERATURE → DAC VOLTAGE MAPPING (50 mV / °C)
-     *
-     * Design choice:
-     *   - Use the DAC as an analog probe to visualize temperature on a scope
-     *   - Keep the signal linear, monotonic, and within DAC headroom
-     *
-     * Electrical constraints:
-     *   - DAC reference (VDDA) ≈ 3.3 V
-     *   - 12-bit DAC → codes 0 … 4095
-     *
-     * Selected scale:
-     *   - 0 … 66 °C  →  0 … 3.3 V
-     *   - Slope = 3.3 V / 66 °C ≈ 50 mV / °C
-     *
-     * Rationale:
-     *   - Avoid saturation at normal operating temperatures
-     *   - Preserve full DAC resolution across a useful thermal range
-     *   - Simple integer math, no floating point
-     *
-     * -----------------------------------------------------------------------
-     * Runtime values (example shown in debugger):
-     *   temp            = 54 °C
-     *   temp_equivalent = 54 (within clamp range)
-     *
-     * DAC computation:
-     *   dac_code = (temp_equivalent / 66) × 4095
-     *            = (54 × 4095) / 66
-     *            ≈ 3350
-     *
-     * Electrical output:
-     *   Vout = (3350 / 4095) × 3.3 V ≈ 2.7 V
-     *   Which matches:
-     *   54 °C × 50 mV/°C = 2.7 V
-     *
-     * This confirms:
-     *   - Correct linear mapping
-     *   - Correct clamping
-     *   - Correct DAC behavior
-     * =======================================================================
-     */
   }
   /* USER CODE END 3 */
 }
@@ -402,7 +481,7 @@ static void MX_ADC3_Init(void) {
   hadc3.Init.ExternalTrigConv = ADC_SOFTWARE_START;
   hadc3.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
   hadc3.Init.ConversionDataManagement =
-      ADC_CONVERSIONDATA_DMA_CIRCULAR; // DMA mode no callbacks necessary!
+      ADC_CONVERSIONDATA_DMA_CIRCULAR; // half/complete callbacks drive blocks
   hadc3.Init.Overrun = ADC_OVR_DATA_PRESERVED;
   hadc3.Init.LeftBitShift = ADC_LEFTBITSHIFT_NONE;
   hadc3.Init.OversamplingMode = DISABLE;
@@ -424,7 +503,16 @@ static void MX_ADC3_Init(void) {
     Error_Handler();
   }
   /* USER CODE BEGIN ADC3_Init 2 */
-
+#if ADC3_TIMER_TRIGGER
+  /* one conversion per TIM6 TRGO rising edge instead of free running */
+  hadc3.Init.ContinuousConvMode = DISABLE;
+  hadc3.Init.ExternalTrigConv = ADC_EXTERNALTRIG_T6_TRGO;
+  hadc3.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+#endif
+  /* re-runs HAL_ADC_Init, so the trigger settings above apply as well */
+  if (adc_os_apply(&hadc3, ADC3_OS_PROFILE) != HAL_OK) {
+    Error_Handler();
+  }
   /* USER CODE END ADC3_Init 2 */
 }
 
@@ -469,7 +557,16 @@ static void MX_DAC1_Init(void) {
     Error_Handler();
   }
   /* USER CODE BEGIN DAC1_Init 2 */
-
+#if DAC_TIMER_PACED
+  /* both channels load DHR on TIM7 TRGO instead of on every write */
+  sConfig.DAC_Trigger = DAC_TRIGGER_T7_TRGO;
+  if (HAL_DAC_ConfigChannel(&hdac1, &sConfig, DAC_CHANNEL_1) != HAL_OK) {
+    Error_Handler();
+  }
+  if (HAL_DAC_ConfigChannel(&hdac1, &sConfig, DAC_CHANNEL_2) != HAL_OK) {
+    Error_Handler();
+  }
+#endif
   /* USER CODE END DAC1_Init 2 */
 }
 
@@ -516,14 +613,244 @@ static void MX_GPIO_Init(void) {
 }
 
 /* USER CODE BEGIN 4 */
-/* ================= DMA CALLBACK ================= */
-/*
+/* ================= BLOCK PROCESSING =================
+ * Runs in main-loop context once per DMA half (never from the ISR).
+ * The block mean replaces the single DMA word that was re-read before.
+ */
+static void ADC_ProcessBlock(const uint16_t *block, uint32_t len, void *ctx) {
+  temp_probe_out_t o;
+  (void)ctx;
+
+  /* mean, __HAL_ADC_CALC_TEMPERATURE(3300, mean, 16 bit), saturate to
+   * 0..66 C for the 50 mV/C channel and 0..33 C above the manual 25 C
+   * room offset for the 100 mV/C channel */
+  temp_probe_block(&probe_cal, block, len, &o);
+  adc = o.mean;
+  temp = o.temp_c;
+  temp_equivalent = o.temp_equivalent;
+  roomtemp = o.roomtemp;
+  dac_temp_voltage = o.dac_temp;
+  dac_roomtemp_voltage = o.dac_roomtemp;
+
+#if DAC_TIMER_PACED
+  /* every sample of the block, into the half the DAC DMA is not reading;
+   * same mapping as the block mean above, TIM7 plays it out */
+  {
+    uint32_t half = dac_stream_acquire(&dac_out);
+    uint32_t in = (block == adc_buf) ? 0U : 1U;
+    uint32_t t0 = DWT->CYCCNT;
+
+    temp_probe_dac_block(&probe_cal, block, len, &dac_ch1_buf[half * len],
+                         &dac_ch2_buf[half * len]);
+    probe_cycles_last = DWT->CYCCNT - t0;
+    if (probe_cycles_last > probe_cycles_max) {
+      probe_cycles_max = probe_cycles_last;
+    }
+    dac_stream_commit(&dac_out, half, adc_block_cyc[in]);
+  }
+#else
+  /* Set DAC output to temperature equivalent voltage */
+  HAL_DAC_SetValue(&hdac1, DAC_CHANNEL_1, DAC_ALIGN_12B_R, dac_temp_voltage);
+  // 100mV / degC
+  HAL_DAC_SetValue(&hdac1, DAC_CHANNEL_2, DAC_ALIGN_12B_R,
+                   dac_roomtemp_voltage);
+#endif
+  /* =======================================================================
+   * LINEAR TEMPERATURE → DAC VOLTAGE MAPPING (50 mV / °C)
+   *
+   * Design choice:
+   *   - Use the DAC as an analog probe to visualize temperature on a scope
+   *   - Keep the signal linear, monotonic, and within DAC headroom
+   *
+   * Electrical constraints:
+   *   - DAC reference (VDDA) ≈ 3.3 V
+   *   - 12-bit DAC → codes 0 … 4095
+   *
+   * Selected scale:
+   *   - 0 … 66 °C  →  0 … 3.3 V
+   *   - Slope = 3.3 V / 66 °C ≈ 50 mV / °C
+   *
+   * Rationale:
+   *   - Avoid saturation at normal operating temperatures
+   *   - Preserve full DAC resolution across a useful thermal range
+   *   - Simple integer math, no floating point
+   *
+   * -----------------------------------------------------------------------
+   * Runtime values (example shown in debugger):
+   *   temp            = 54 °C
+   *   temp_equivalent = 54 (within clamp range)
+   *
+   * DAC computation:
+   *   dac_code = (temp_equivalent / 66) × 4095
+   *            = (54 × 4095) / 66
+   *            ≈ 3350
+   *
+   * Electrical output:
+   *   Vout = (3350 / 4095) × 3.3 V ≈ 2.7 V
+   *   Which matches:
+   *   54 °C × 50 mV/°C = 2.7 V
+   *
+   * This confirms:
+   *   - Correct linear mapping
+   *   - Correct clamping
+   *   - Correct DAC behavior
+   * =======================================================================
+   */
+}
+
+/* ================= ADC3 TRIGGER TIMER =================
+ * TIM6 (basic timer) on APB1: f_tim = PCLK1 = 20 MHz (APB1 /1).
+ * PSC/ARR solved for ADC3_TRIGGER_HZ, the achieved rate and its error
+ * are left in adc_trig (16 kHz -> PSC 0, ARR 1249, 0 ppm).
+ * Needs HAL_TIM_MODULE_ENABLED in stm32h7xx_hal_conf.h (TIM6 is not in
+ * the .ioc, so it is set up here instead of an MX_TIM6_Init).
+ */
+static void ADC3_TriggerTimer_Init(void) {
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  if (tim_rate_solve(HAL_RCC_GetPCLK1Freq(), ADC3_TRIGGER_HZ * 1000U,
+                     &adc_trig) != 0) {
+    Error_Handler();
+  }
+  __HAL_RCC_TIM6_CLK_ENABLE();
+  htim6.Instance = TIM6;
+  htim6.Init.Prescaler = adc_trig.psc;
+  htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim6.Init.Period = adc_trig.arr;
+  htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim6) != HAL_OK) {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim6, &sMasterConfig) != HAL_OK) {
+    Error_Handler();
+  }
+}
+
+#if DAC_TIMER_PACED
+/* ================= DAC OUTPUT TIMER + DMA =================
+ * TIM7 (basic timer, PCLK1 = 20 MHz) at the ADC3 output rate,
+ * ADC3_TRIGGER_HZ / ratio = 1 kHz -> PSC 0, ARR 19999, 0 ppm (adc_trig and
+ * dac_trig share the clock, so the rates are locked, not just close).
+ * DAC DMA is not in the .ioc either: DMA1_Stream1/2, memory -> DAC,
+ * circular over both halves. DMA1_Stream1_IRQHandler is below for the
+ * same reason (not generated into stm32h7xx_it.c).
+ * D-cache is off in this project, so no clean before the DMA reads.
+ */
+static void DAC_Output_Init(void) {
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+  uint32_t ratio = adc_os_profile(ADC3_OS_PROFILE)->ratio;
+
+  if (tim_rate_solve(HAL_RCC_GetPCLK1Freq(),
+                     ADC3_TRIGGER_HZ * 1000U / ratio, &dac_trig) != 0) {
+    Error_Handler();
+  }
+  __HAL_RCC_TIM7_CLK_ENABLE();
+  htim7.Instance = TIM7;
+  htim7.Init.Prescaler = dac_trig.psc;
+  htim7.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim7.Init.Period = dac_trig.arr;
+  htim7.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim7) != HAL_OK) {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim7, &sMasterConfig) != HAL_OK) {
+    Error_Handler();
+  }
+
+  hdma_dac1_ch1.Instance = DMA1_Stream1;
+  hdma_dac1_ch1.Init.Request = DMA_REQUEST_DAC1;
+  hdma_dac1_ch1.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  hdma_dac1_ch1.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_dac1_ch1.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_dac1_ch1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+  hdma_dac1_ch1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+  hdma_dac1_ch1.Init.Mode = DMA_CIRCULAR;
+  hdma_dac1_ch1.Init.Priority = DMA_PRIORITY_LOW;
+  hdma_dac1_ch1.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+  hdma_dac1_ch2 = hdma_dac1_ch1;
+  hdma_dac1_ch2.Instance = DMA1_Stream2;
+  hdma_dac1_ch2.Init.Request = DMA_REQUEST_DAC2;
+  if (HAL_DMA_Init(&hdma_dac1_ch1) != HAL_OK ||
+      HAL_DMA_Init(&hdma_dac1_ch2) != HAL_OK) {
+    Error_Handler();
+  }
+  __HAL_LINKDMA(&hdac1, DMA_Handle1, hdma_dac1_ch1);
+  __HAL_LINKDMA(&hdac1, DMA_Handle2, hdma_dac1_ch2);
+  HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+
+  /* 10 us bins: the expected spread is the ADC ISR entry jitter */
+  dac_stream_init(&dac_out, ADC_STREAM_BLOCK_LEN, SystemCoreClock / 100000U);
+}
+
+/* Arms both DAC DMAs, then starts TIM7 half a block into ADC3 block 0:
+ *
+ *   ADC block k done        t
+ *   DAC half for k starts   t + N/2 samples (32 ms) -- the producer has
+ *                           half a block to fill it, and the half it
+ *                           writes is never the one playing
+ *
+ * The first DAC half plays zeros (nothing committed yet) and is not
+ * counted. After that latency = N/2 sample periods + ISR entry, fixed.
+ */
+static void DAC_Output_Start(void) {
+  if (HAL_DAC_Start_DMA(&hdac1, DAC_CHANNEL_1, (uint32_t *)dac_ch1_buf,
+                        2 * ADC_STREAM_BLOCK_LEN, DAC_ALIGN_12B_R) != HAL_OK ||
+      HAL_DAC_Start_DMA(&hdac1, DAC_CHANNEL_2, (uint32_t *)dac_ch2_buf,
+                        2 * ADC_STREAM_BLOCK_LEN, DAC_ALIGN_12B_R) != HAL_OK) {
+    Error_Handler();
+  }
+  /* NDTR counts down from 2N over the circular ADC buffer */
+  while (__HAL_DMA_GET_COUNTER(&hdma_adc3) >
+         (3U * ADC_STREAM_BLOCK_LEN) / 2U) {
+  }
+  HAL_TIM_Base_Start(&htim7);
+}
+
+void HAL_DAC_ConvHalfCpltCallbackCh1(DAC_HandleTypeDef *hdac) {
+  (void)hdac;
+  dac_stream_half_isr(&dac_out, DWT->CYCCNT); // dac_ch1_buf[N ..] plays
+}
+
+void HAL_DAC_ConvCpltCallbackCh1(DAC_HandleTypeDef *hdac) {
+  (void)hdac;
+  dac_stream_full_isr(&dac_out, DWT->CYCCNT); // dac_ch1_buf[0 ..] plays
+}
+
+void DMA1_Stream1_IRQHandler(void) { HAL_DMA_IRQHandler(&hdma_dac1_ch1); }
+#endif
+
+/* ================= DMA CALLBACKS ================= */
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc) {
+  if (hadc->Instance == ADC3) {
+    uint32_t now = DWT->CYCCNT;
+
+    tim_jitter_stamp(&adc_jitter, now);
+#if DAC_TIMER_PACED
+    adc_block_cyc[0] = now;
+#endif
+    adc_stats_push_block(&adc_stats, &adc_buf[0], ADC_STREAM_BLOCK_LEN);
+    adc_stream_half_isr(&adc_stream); // adc_buf[0 .. N-1] is complete
+  }
+}
+
 void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc) {
   if (hadc->Instance == ADC3) {
-    adc_ready = 1;
+    uint32_t now = DWT->CYCCNT;
+
+    tim_jitter_stamp(&adc_jitter, now);
+#if DAC_TIMER_PACED
+    adc_block_cyc[1] = now;
+#endif
+    adc_stats_push_block(&adc_stats, &adc_buf[ADC_STREAM_BLOCK_LEN],
+                         ADC_STREAM_BLOCK_LEN);
+    adc_stream_full_isr(&adc_stream); // adc_buf[N .. 2N-1] is complete
   }
 }
-*/
 /* USER CODE END 4 */
 
 /**
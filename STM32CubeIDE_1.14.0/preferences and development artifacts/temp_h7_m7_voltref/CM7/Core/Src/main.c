@@ -21,7 +21,11 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "adc_os.h"
+#include "adc_stream.h"
+#include "lp_acq.h"
+#include "temp_conv.h"
+#include "vdda_comp.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -31,6 +35,15 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/* ADC3 hardware oversampling (see adc_os.h): 64 conversions averaged in
+ * hardware, +3 effective bits, 381 S/s -- far above the loop rate */
+#define ADC3_OS_PROFILE ADC_OS_X64
+
+/* Scan order of ADC3, one DMA word per rank: [TSENSE, VREFINT, ...]
+ * 2 ranks x 64 x 819 cycles at 20 MHz = 5.24 ms per pair, so one
+ * ADC_STREAM_BLOCK_LEN half (32 pairs) lands every ~168 ms */
+#define ADC3_SCAN_RANKS 2U
+#define ADC3_BLOCK_PAIRS (ADC_STREAM_BLOCK_LEN / ADC3_SCAN_RANKS)
 
 /* DUAL_CORE_BOOT_SYNC_SEQUENCE: Define for dual core boot synchronization    */
 /*                             demonstration code based on hardware semaphore */
@@ -49,8 +62,22 @@
 ADC_HandleTypeDef hadc3;
 
 /* USER CODE BEGIN PV */
-volatile int32_t adc; // because __HAL_ADC_CALC_TEMPERATURE returns int32_t
-volatile int32_t temp;
+/* DMA1_Stream0 for ADC3 is not in the .ioc: set up in HAL_ADC_MspInit */
+DMA_HandleTypeDef hdma_adc3;
+
+volatile int32_t adc;      // block mean TSENSE code, normalised to VDDA = 3.3 V
+volatile int32_t temp;     // deg C, rounded
+volatile int32_t temp_q16; // deg C, Q16.16
+volatile uint32_t vdda_mv; // VDDA measured from VREFINT, every block
+
+static uint16_t adc_buf[2 * ADC_STREAM_BLOCK_LEN]; // interleaved DMA target
+static adc_stream_t adc_stream;
+static temp_conv_t ts_conv;
+static vdda_comp_t vdda_comp;
+static uint16_t ts_code[ADC3_BLOCK_PAIRS];  // compensated TSENSE codes
+static int32_t ts_temp[ADC3_BLOCK_PAIRS];   // per-pair temperature, Q16.16
+static lp_acq_t lp_acq;                     // sleep between DMA blocks
+lp_acq_report_t lp_acq_dbg;                 // residency / wake latency, per block
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -58,6 +85,7 @@ void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_ADC3_Init(void);
 /* USER CODE BEGIN PFP */
+static void ADC_ProcessBlock(const uint16_t *block, uint32_t len, void *ctx);
 
 /* USER CODE END PFP */
 
@@ -81,7 +109,14 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
-
+  /* Factory words, all taken at VDDA = 3.3 V (see vdda_comp.h) */
+  if (temp_conv_init(&ts_conv, *TEMPSENSOR_CAL1_ADDR, *TEMPSENSOR_CAL2_ADDR,
+                     TEMP_CONV_Q16(TEMPSENSOR_CAL1_TEMP),
+                     TEMP_CONV_Q16(TEMPSENSOR_CAL2_TEMP)) != 0)
+  {
+    Error_Handler();
+  }
+  vdda_comp_init(&vdda_comp, *VREFINT_CAL_ADDR);
   /* USER CODE END Init */
 
   /* Configure the system clock */
@@ -95,7 +130,12 @@ int main(void)
   MX_GPIO_Init();
   MX_ADC3_Init();
   /* USER CODE BEGIN 2 */
-  HAL_ADC_Start(&hadc3);
+  /* Circular DMA over both halves; a block always starts on a TSENSE rank
+   * because ADC_STREAM_BLOCK_LEN is a multiple of ADC3_SCAN_RANKS */
+  adc_stream_init(&adc_stream, adc_buf, ADC_STREAM_BLOCK_LEN, ADC_ProcessBlock,
+                  NULL);
+  lp_acq_hal_init(&lp_acq); // before the first DMA callback can post
+  HAL_ADC_Start_DMA(&hadc3, (uint32_t *)adc_buf, 2 * ADC_STREAM_BLOCK_LEN);
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -103,22 +143,16 @@ int main(void)
   while (1)
   {
     /* USER CODE END WHILE */
-	  if __HAL_ADC_GET_FLAG(&hadc3, ADC_FLAG_EOC) {// must be removed when using HAL_ADC_GetValue!!
-	  /* Read ADC data register (all equivalent ways) */
-	  //adc = hadc3.Instance->DR;        // via HAL handle instance
-	  //adc = HAL_ADC_GetValue(&hadc3);  // via HAL API
-	  adc = ADC3->DR; // implicit casting when passed to macro
-	  /* Temperature calculation using HAL macro */
-      /* 3300 is Analog reference voltage (unit: mV)
-       * measured using oscilloscope
-	  */
-      temp = __HAL_ADC_CALC_TEMPERATURE(3300, adc, ADC_GET_RESOLUTION(&hadc3));
-      // temp = __HAL_ADC_CALC_TEMPERATURE(3300, adc, ADC_RESOLUTION_16B);
-      // temp = __HAL_ADC_CALC_TEMPERATURE(3300, adc, LL_ADC_GetResolution(ADC3));
-	  }
-               // direct register access
-
-	  /* Temperature calculation using HAL macro */
+    /* VDDA is no longer assumed to be 3300 mV: every block measures it
+     * from VREFINT and rescales the TSENSE codes before TS_CAL math */
+    /* Sleep until a DMA half/complete posts; the check and the WFI run
+     * with interrupts masked, so a block landing in between is not left
+     * waiting for the next SysTick. SysTick wakes return 0. */
+    if ((lp_acq_wait(&lp_acq) & LP_ACQ_EV_SAMPLE) != 0U &&
+        adc_stream_poll(&adc_stream) != 0U)
+    {
+      lp_acq_report(&lp_acq, &lp_acq_dbg);
+    }
 
 	  /* USER CODE BEGIN 3 */
 
@@ -265,7 +299,24 @@ static void MX_ADC3_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN ADC3_Init 2 */
-
+  /* Rank 2 = VREFINT, scanned after TSENSE into a circular DMA buffer.
+   * VREFINT also needs a long sampling time (> 4.3 us), same setting as
+   * TSENSE keeps both ranks at 819 cycles */
+  sConfig.Channel = ADC_CHANNEL_VREFINT;
+  sConfig.Rank = ADC_REGULAR_RANK_2;
+  sConfig.SamplingTime = ADC_SAMPLETIME_810CYCLES_5;
+  if (HAL_ADC_ConfigChannel(&hadc3, &sConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  hadc3.Init.ScanConvMode = ADC_SCAN_ENABLE;
+  hadc3.Init.NbrOfConversion = ADC3_SCAN_RANKS;
+  hadc3.Init.ConversionDataManagement = ADC_CONVERSIONDATA_DMA_CIRCULAR;
+  /* Re-runs HAL_ADC_Init, which also takes the scan settings above */
+  if (adc_os_apply(&hadc3, ADC3_OS_PROFILE) != HAL_OK)
+  {
+    Error_Handler();
+  }
   /* USER CODE END ADC3_Init 2 */
 
 }
@@ -300,7 +351,63 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+/**
+  * @brief  One half of the interleaved scan buffer, main-loop context.
+  *         VDDA comes from the VREFINT ranks of this very block, so the
+  *         correction tracks supply droop at the block rate.
+  * @param  block: [ts0, vref0, ts1, vref1, ...]
+  * @param  len: samples in the block (ranks x pairs)
+  */
+static void ADC_ProcessBlock(const uint16_t *block, uint32_t len, void *ctx)
+{
+  uint32_t pairs = len / ADC3_SCAN_RANKS;
+  int64_t sum_q16 = 0;
+  uint32_t sum_code = 0;
+  uint32_t mv;
+  (void)ctx;
+
+  mv = vdda_comp_block(&vdda_comp, block, pairs, ts_code);
+  if (mv == 0U)
+  {
+    return; // VREFINT rank read 0: keep the last good values
+  }
+  temp_conv_block(&ts_conv, ts_code, ts_temp, pairs);
+
+  for (uint32_t i = 0; i < pairs; i++)
+  {
+    sum_q16 += ts_temp[i];
+    sum_code += ts_code[i];
+  }
+  vdda_mv = mv;
+  adc = (int32_t)((sum_code + pairs / 2U) / pairs);
+  temp_q16 = (int32_t)(sum_q16 / (int32_t)pairs);
+  temp = (temp_q16 + 32768) >> 16;
+}
+
+/* ================= DMA CALLBACKS ================= */
+void DMA1_Stream0_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_adc3);
+}
+
 
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+  if (hadc->Instance == ADC3)
+  {
+    adc_stream_half_isr(&adc_stream); // first half is now stable
+    lp_acq_post(&lp_acq, LP_ACQ_EV_SAMPLE);
+  }
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+  if (hadc->Instance == ADC3)
+  {
+    adc_stream_full_isr(&adc_stream); // second half is now stable
+    lp_acq_post(&lp_acq, LP_ACQ_EV_SAMPLE);
+  }
+}
 /* USER CODE END 4 */
 
  /* MPU Configuration */
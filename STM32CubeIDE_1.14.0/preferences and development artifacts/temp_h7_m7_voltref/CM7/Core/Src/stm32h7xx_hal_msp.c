@@ -41,6 +41,7 @@
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN PV */
+extern DMA_HandleTypeDef hdma_adc3; /* main.c, not in the .ioc */
 
 /* USER CODE END PV */
 
@@ -167,6 +168,27 @@ void HAL_ADC_MspInit(ADC_HandleTypeDef* hadc)
     HAL_SYSCFG_AnalogSwitchConfig(SYSCFG_SWITCH_PC3, SYSCFG_SWITCH_PC3_OPEN);
 
     /* USER CODE BEGIN ADC3_MspInit 1 */
+    /* ADC3 DMA Init: DMA1_Stream0, circular over both halves of adc_buf */
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    hdma_adc3.Instance = DMA1_Stream0;
+    hdma_adc3.Init.Request = DMA_REQUEST_ADC3;
+    hdma_adc3.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_adc3.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_adc3.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_adc3.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_adc3.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_adc3.Init.Mode = DMA_CIRCULAR;
+    hdma_adc3.Init.Priority = DMA_PRIORITY_LOW;
+    hdma_adc3.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&hdma_adc3) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(hadc,DMA_Handle,hdma_adc3);
+
+    HAL_NVIC_SetPriority(DMA1_Stream0_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream0_IRQn);
 
     /* USER CODE END ADC3_MspInit 1 */
 
@@ -191,6 +213,9 @@ void HAL_ADC_MspDeInit(ADC_HandleTypeDef* hadc)
     __HAL_RCC_ADC3_CLK_DISABLE();
 
     /* USER CODE BEGIN ADC3_MspDeInit 1 */
+    /* ADC3 DMA DeInit */
+    HAL_NVIC_DisableIRQ(DMA1_Stream0_IRQn);
+    HAL_DMA_DeInit(hadc->DMA_Handle);
 
     /* USER CODE END ADC3_MspDeInit 1 */
   }